@@ -0,0 +1,125 @@
+#include "CheckpointWriter.h"
+
+#include <algorithm>
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		CheckpointWriter::CheckpointWriter(BackendSystem::OpenCLBackend& backend, const size_t numStaging, const size_t stagingSize) :
+			backend(backend), entries(), staging(numStaging, std::vector<float>(stagingSize / sizeof(float))), readEvents(numStaging),
+			packed(sizeof(ModelPackedBlock) + stagingSize), shuffled(stagingSize), stagingSize(stagingSize / sizeof(float) * sizeof(float)), blocks(), thread(), error(0)
+		{
+		}
+
+		CheckpointWriter::~CheckpointWriter()
+		{
+			Wait();
+		}
+
+		void CheckpointWriter::AddTensor(const std::string& name, const BufferIdx buffer, const SizeVec& shape)
+		{
+			Entry entry;
+			entry.name = name;
+			entry.buffer = buffer;
+			entry.shape = shape;
+			entry.size = shape.sizeX * shape.sizeY * shape.sizeZ * shape.sizeW * sizeof(float);
+			entry.snapshot = backend.CreateBuffer(entry.size, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			entry.packed = true;
+
+			//Each block fits into a staging buffer.
+			for (size_t offset = 0; offset < entry.size; offset += stagingSize)
+				blocks.push_back(std::make_pair(entries.size(), std::make_pair(offset, std::min(stagingSize, entry.size - offset))));
+			entries.push_back(entry);
+		}
+
+		void CheckpointWriter::AddBlob(const std::string& name, const BufferIdx buffer, const size_t size)
+		{
+			Entry entry;
+			entry.name = name;
+			entry.buffer = buffer;
+			entry.shape = SizeVec(size);
+			entry.size = size;
+			entry.snapshot = backend.CreateBuffer(size, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			entry.packed = false;
+
+			for (size_t offset = 0; offset < entry.size; offset += stagingSize)
+				blocks.push_back(std::make_pair(entries.size(), std::make_pair(offset, std::min(stagingSize, entry.size - offset))));
+			entries.push_back(entry);
+		}
+
+		void CheckpointWriter::Write(const std::string& fileName, const std::vector<std::pair<std::string, std::string>>& hostBlobs)
+		{
+			Wait();
+
+			//The copies are the only part of the checkpoint executed in the compute queue.
+			//The thread only uses copies of the handles, since the list of buffers of the backend may grow while it runs.
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				backend.CopyBuffer(entries[i].buffer, entries[i].snapshot, entries[i].size);
+				entries[i].snapshotBuffer = backend.GetBuffer(entries[i].snapshot);
+			}
+			backend.EnqueueMarker(&copyEvent);
+
+			thread = std::thread(&CheckpointWriter::Run, this, fileName, hostBlobs);
+		}
+
+		DeepCLError CheckpointWriter::Wait()
+		{
+			if (thread.joinable())
+				thread.join();
+			return error;
+		}
+
+		void CheckpointWriter::ReadBlock(const size_t block, const size_t slot)
+		{
+			const Entry& entry = entries[blocks[block].first];
+			backend.ReadDataBufferAsync(entry.snapshotBuffer, staging[slot].data(), blocks[block].second.first, blocks[block].second.second, &copyEvent, &readEvents[slot]);
+		}
+
+		void CheckpointWriter::Run(const std::string fileName, const std::vector<std::pair<std::string, std::string>> hostBlobs)
+		{
+			ModelFileStreamWriter file;
+			error = file.Open(fileName, entries.size() + hostBlobs.size());
+			const size_t numStaging = staging.size();
+
+			//Fill the ring before the first block is written.
+			for (size_t i = 0; i < blocks.size() && i < numStaging; ++i)
+				ReadBlock(i, i);
+
+			for (size_t i = 0; i < blocks.size(); ++i)
+			{
+				const size_t slot = i % numStaging;
+				const Entry& entry = entries[blocks[i].first];
+				const size_t size = blocks[i].second.second;
+				readEvents[slot].wait();
+
+				if (error == 0)
+				{
+					if (blocks[i].second.first == 0 && !file.BeginTensor(entry.name, entry.packed ? MODEL_FLOAT32_PACKED : MODEL_BYTES, entry.shape))
+						error = NN_MODEL_FILE_ERROR;
+					else if (entry.packed)
+						file.Append(packed.data(), PackFloats(staging[slot].data(), size / sizeof(float), packed.data(), shuffled.data()));
+					else
+						file.Append(reinterpret_cast<const char*>(staging[slot].data()), size);
+				}
+
+				//The staging buffer is free again. The reads are still performed after an error, since the events of the ring must finish.
+				if (i + numStaging < blocks.size())
+					ReadBlock(i + numStaging, slot);
+			}
+
+			for (size_t i = 0; i < hostBlobs.size() && error == 0; ++i)
+			{
+				if (!file.BeginTensor(hostBlobs[i].first, MODEL_BYTES, SizeVec(hostBlobs[i].second.size())))
+					error = NN_MODEL_FILE_ERROR;
+				else
+					file.Append(hostBlobs[i].second.data(), hostBlobs[i].second.size());
+			}
+
+			DeepCLError closeError = file.Close();
+			if (error == 0)
+				error = closeError;
+		}
+	}
+}
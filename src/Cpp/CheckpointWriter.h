@@ -0,0 +1,72 @@
+#pragma once
+
+#include <thread>
+
+#include "OpenCLBackend.h"
+#include "ModelFile.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Writes checkpoints in the background. Each buffer of the checkpoint is copied into a snapshot buffer on the device, afterwards training can continue.
+		//A thread reads the snapshots in blocks through a ring of staging buffers, packs them and writes them into the file. A new block is only read
+		//once a staging buffer was written, therefore the host memory is bounded and a slow disk throttles the reads instead of the training.
+		class CheckpointWriter
+		{
+		public:
+			CheckpointWriter(BackendSystem::OpenCLBackend& backend, const size_t numStaging = 4, const size_t stagingSize = 1 << 22);
+			~CheckpointWriter();
+
+			//Adds a buffer to each checkpoint and creates its snapshot buffer. Float tensors are packed, blobs are stored unchanged.
+			//Must not be called while a checkpoint is written.
+			void AddTensor(const std::string& name, const BufferIdx buffer, const SizeVec& shape);
+			void AddBlob(const std::string& name, const BufferIdx buffer, const size_t size);
+
+			//Copies the buffers into the snapshots and starts writing them together with the host blobs (Name and data).
+			//Waits for the previous checkpoint to be written first, since its snapshots are still in use.
+			void Write(const std::string& fileName, const std::vector<std::pair<std::string, std::string>>& hostBlobs);
+			//Waits until the last checkpoint was written and returns the result.
+			DeepCLError Wait();
+
+			bool Empty() const { return entries.empty(); }
+
+		private:
+			CheckpointWriter(const CheckpointWriter& other);
+			const CheckpointWriter& operator=(const CheckpointWriter& other);
+
+			struct Entry
+			{
+				std::string name;
+				BufferIdx buffer;
+				BufferIdx snapshot;
+				cl::Buffer snapshotBuffer; //Handle of snapshot used by the thread, set by Write
+				SizeVec shape;
+				size_t size;
+				bool packed;
+			};
+
+			//Reads the snapshots and writes the file. Run by the thread.
+			void Run(const std::string fileName, const std::vector<std::pair<std::string, std::string>> hostBlobs);
+			//Enqueues the read of the block into a staging buffer.
+			void ReadBlock(const size_t block, const size_t slot);
+
+			BackendSystem::OpenCLBackend& backend;
+			std::vector<Entry> entries;
+
+			//Ring of staging buffers, the reads filling them and the buffer the packed blocks are created in
+			std::vector<std::vector<float>> staging;
+			std::vector<cl::Event> readEvents;
+			std::vector<char> packed;
+			std::vector<char> shuffled;
+			size_t stagingSize;
+
+			//Blocks of all entries (Index of the entry, offset and size in bytes)
+			std::vector<std::pair<size_t, std::pair<size_t, size_t>>> blocks;
+
+			cl::Event copyEvent; //Finishes once the snapshots were copied
+			std::thread thread;
+			DeepCLError error; //Result of the last finished write
+		};
+	}
+}
@@ -0,0 +1,291 @@
+#include "DataAugmentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace DeepCL
+{
+	namespace DataSystem
+	{
+		unsigned long long SampleRandom::Mix(unsigned long long z)
+		{
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		unsigned long long SampleRandom::Next()
+		{
+			return Mix(state += 0x9E3779B97F4A7C15ull);
+		}
+
+		float SampleRandom::Uniform(const float minValue, const float maxValue)
+		{
+			//The 24 highest bits fill the mantissa of a float
+			const float u = static_cast<float>(Next() >> 40) * (1.f / 16777216.f);
+			return minValue + (maxValue - minValue) * u;
+		}
+
+		int SampleRandom::UniformInt(const int minValue, const int maxValue)
+		{
+			const unsigned long long range = static_cast<unsigned long long>(maxValue - minValue) + 1;
+			return minValue + static_cast<int>((Next() >> 32) % range);
+		}
+
+		bool SampleRandom::Bernoulli(const float probability)
+		{
+			return Uniform(0.f, 1.f) < probability;
+		}
+
+		//Sets n values starting at target to value.
+		static void FillRow(float* target, const size_t n, const float value)
+		{
+			const __m128 v = _mm_set1_ps(value);
+			size_t x = 0;
+			for (; x + 4 <= n; x += 4)
+				_mm_storeu_ps(target + x, v);
+			for (; x < n; ++x)
+				target[x] = value;
+		}
+
+		//Computes target = source * scale + offset for n values.
+		static void ScaleRow(float* target, const float* source, const size_t n, const float scale, const float offset)
+		{
+			const __m128 s = _mm_set1_ps(scale);
+			const __m128 o = _mm_set1_ps(offset);
+			size_t x = 0;
+			for (; x + 4 <= n; x += 4)
+				_mm_storeu_ps(target + x, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + x), s), o));
+			for (; x < n; ++x)
+				target[x] = source[x] * scale + offset;
+		}
+
+		//Stores the values of source in reversed order in target.
+		static void ReverseRow(float* target, const float* source, const size_t n)
+		{
+			size_t x = 0;
+			for (; x + 4 <= n; x += 4)
+			{
+				const __m128 v = _mm_loadu_ps(source + n - x - 4);
+				_mm_storeu_ps(target + x, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)));
+			}
+			for (; x < n; ++x)
+				target[x] = source[n - x - 1];
+		}
+
+		static float SumRow(const float* source, const size_t n)
+		{
+			__m128 sum = _mm_setzero_ps();
+			size_t x = 0;
+			for (; x + 4 <= n; x += 4)
+				sum = _mm_add_ps(sum, _mm_loadu_ps(source + x));
+			float parts[4];
+			_mm_storeu_ps(parts, sum);
+			float result = parts[0] + parts[1] + parts[2] + parts[3];
+			for (; x < n; ++x)
+				result += source[x];
+			return result;
+		}
+
+		void AugmentRandomCrop::Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd)
+		{
+			const int width = static_cast<int>(size.sizeX);
+			const int height = static_cast<int>(size.sizeY);
+			const size_t planes = size.sizeZ * size.sizeW;
+			const int dx = rnd.UniformInt(-static_cast<int>(pad), static_cast<int>(pad));
+			const int dy = rnd.UniformInt(-static_cast<int>(pad), static_cast<int>(pad));
+
+			//The pixel (x, y) of the result is the pixel (x + dx, y + dy) of the padded source. Only the columns [begin, end) lie inside of the source.
+			const int begin = std::min(width, std::max(0, -dx));
+			const int end = std::max(begin, std::min(width, width - dx));
+
+			for (size_t z = 0; z < planes; ++z)
+			{
+				const float* source = image + z * width * height;
+				float* target = scratch + z * width * height;
+				for (int y = 0; y < height; ++y)
+				{
+					float* row = target + y * width;
+					const int sourceY = y + dy;
+					if (sourceY < 0 || sourceY >= height)
+					{
+						FillRow(row, width, value);
+						continue;
+					}
+					FillRow(row, begin, value);
+					std::memcpy(row + begin, source + sourceY * width + begin + dx, (end - begin) * sizeof(float));
+					FillRow(row + end, width - end, value);
+				}
+			}
+			std::memcpy(image, scratch, planes * width * height * sizeof(float));
+		}
+
+		void AugmentFlip::Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd)
+		{
+			const size_t width = size.sizeX;
+			const size_t height = size.sizeY;
+			const size_t planes = size.sizeZ * size.sizeW;
+			//Both random numbers are drawn to keep the numbers of the following augmentations independent of the result.
+			const bool flipX = rnd.Bernoulli(probabilityX);
+			const bool flipY = rnd.Bernoulli(probabilityY);
+			if (!flipX && !flipY)
+				return;
+
+			for (size_t z = 0; z < planes; ++z)
+			{
+				for (size_t y = 0; y < height; ++y)
+				{
+					const float* source = image + (z * height + (flipY ? height - y - 1 : y)) * width;
+					float* target = scratch + (z * height + y) * width;
+					if (flipX)
+						ReverseRow(target, source, width);
+					else
+						std::memcpy(target, source, width * sizeof(float));
+				}
+			}
+			std::memcpy(image, scratch, planes * width * height * sizeof(float));
+		}
+
+		void AugmentAffine::Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd)
+		{
+			const int width = static_cast<int>(size.sizeX);
+			const int height = static_cast<int>(size.sizeY);
+			const size_t planeSize = size.sizeX * size.sizeY;
+			const size_t planes = size.sizeZ * size.sizeW;
+			const float angle = rnd.Uniform(-maxAngle, maxAngle);
+			const float scale = 1.f + rnd.Uniform(-maxScale, maxScale);
+			const float shiftX = rnd.Uniform(-maxShift, maxShift);
+			const float shiftY = rnd.Uniform(-maxShift, maxShift);
+
+			//Each pixel of the result samples the source at the inverse transformation of its position. Along a row the position in the source changes by (stepX, stepY).
+			const float centerX = 0.5f * (width - 1);
+			const float centerY = 0.5f * (height - 1);
+			const float stepX = std::cos(angle) / scale;
+			const float stepY = -std::sin(angle) / scale;
+
+			const __m128 offsets = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+			const __m128 one = _mm_set1_ps(1.f);
+			int indices[4];
+			float weightsX[4];
+			float weightsY[4];
+			float corners[4][4];
+
+			for (int y = 0; y < height; ++y)
+			{
+				//Source position of the first pixel of the row
+				const float py = y - centerY - shiftY;
+				const float px = -centerX - shiftX;
+				const float rowX = centerX + stepX * px - stepY * py;
+				const float rowY = centerY + stepY * px + stepX * py;
+
+				for (int x = 0; x < width; x += 4)
+				{
+					//Positions, integral parts and fractions of four pixels. The conversion truncates, therefore one is subtracted from negative positions.
+					const __m128 xs = _mm_set1_ps(static_cast<float>(x));
+					const __m128 sx = _mm_add_ps(_mm_set1_ps(rowX), _mm_mul_ps(_mm_add_ps(xs, offsets), _mm_set1_ps(stepX)));
+					const __m128 sy = _mm_add_ps(_mm_set1_ps(rowY), _mm_mul_ps(_mm_add_ps(xs, offsets), _mm_set1_ps(stepY)));
+					__m128 fx = _mm_cvtepi32_ps(_mm_cvttps_epi32(sx));
+					fx = _mm_sub_ps(fx, _mm_and_ps(_mm_cmpgt_ps(fx, sx), one));
+					__m128 fy = _mm_cvtepi32_ps(_mm_cvttps_epi32(sy));
+					fy = _mm_sub_ps(fy, _mm_and_ps(_mm_cmpgt_ps(fy, sy), one));
+					_mm_storeu_ps(weightsX, _mm_sub_ps(sx, fx));
+					_mm_storeu_ps(weightsY, _mm_sub_ps(sy, fy));
+					float floorX[4];
+					float floorY[4];
+					_mm_storeu_ps(floorX, fx);
+					_mm_storeu_ps(floorY, fy);
+
+					const int count = std::min(4, width - x);
+					for (int i = 0; i < 4; ++i)
+						indices[i] = i < count ? static_cast<int>(floorX[i]) + static_cast<int>(floorY[i]) * width : 0;
+
+					for (size_t z = 0; z < planes; ++z)
+					{
+						const float* source = image + z * planeSize;
+						//The four neighbours of each position, neighbours outside of the source are set to value.
+						for (int i = 0; i < 4; ++i)
+						{
+							const int ix = static_cast<int>(floorX[i]);
+							const int iy = static_cast<int>(floorY[i]);
+							const bool inX0 = i < count && ix >= 0 && ix < width;
+							const bool inX1 = i < count && ix + 1 >= 0 && ix + 1 < width;
+							const bool inY0 = iy >= 0 && iy < height;
+							const bool inY1 = iy + 1 >= 0 && iy + 1 < height;
+							corners[0][i] = inX0 && inY0 ? source[indices[i]] : value;
+							corners[1][i] = inX1 && inY0 ? source[indices[i] + 1] : value;
+							corners[2][i] = inX0 && inY1 ? source[indices[i] + width] : value;
+							corners[3][i] = inX1 && inY1 ? source[indices[i] + width + 1] : value;
+						}
+
+						const __m128 wx = _mm_loadu_ps(weightsX);
+						const __m128 c0 = _mm_loadu_ps(corners[0]);
+						const __m128 c2 = _mm_loadu_ps(corners[2]);
+						const __m128 top = _mm_add_ps(c0, _mm_mul_ps(wx, _mm_sub_ps(_mm_loadu_ps(corners[1]), c0)));
+						const __m128 bottom = _mm_add_ps(c2, _mm_mul_ps(wx, _mm_sub_ps(_mm_loadu_ps(corners[3]), c2)));
+						float result[4];
+						_mm_storeu_ps(result, _mm_add_ps(top, _mm_mul_ps(_mm_loadu_ps(weightsY), _mm_sub_ps(bottom, top))));
+
+						float* target = scratch + z * planeSize + y * width + x;
+						for (int i = 0; i < count; ++i)
+							target[i] = result[i];
+					}
+				}
+			}
+			std::memcpy(image, scratch, planes * planeSize * sizeof(float));
+		}
+
+		void AugmentBrightnessContrast::Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd)
+		{
+			const size_t planeSize = size.sizeX * size.sizeY;
+			const size_t planes = size.sizeZ * size.sizeW;
+			const float brightness = rnd.Uniform(-maxBrightness, maxBrightness);
+			const float contrast = 1.f + rnd.Uniform(-maxContrast, maxContrast);
+
+			//(v - mean) * contrast + mean + brightness is computed with one multiplication and one addition.
+			for (size_t z = 0; z < planes; ++z)
+			{
+				float* plane = image + z * planeSize;
+				const float mean = SumRow(plane, planeSize) / static_cast<float>(planeSize);
+				ScaleRow(plane, plane, planeSize, contrast, mean * (1.f - contrast) + brightness);
+			}
+		}
+
+		void AugmentNormalize::Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd)
+		{
+			const size_t planeSize = size.sizeX * size.sizeY;
+			const size_t planes = size.sizeZ * size.sizeW;
+
+			//If a single mean and standard deviation are given they are used for all channels.
+			for (size_t z = 0; z < planes; ++z)
+			{
+				const size_t c = std::min(z, mean.size() - 1);
+				const float scale = 1.f / stddev[std::min(z, stddev.size() - 1)];
+				ScaleRow(image + z * planeSize, image + z * planeSize, planeSize, scale, -mean[c] * scale);
+			}
+		}
+
+		void AugmentCutout::Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd)
+		{
+			const int width = static_cast<int>(size.sizeX);
+			const int height = static_cast<int>(size.sizeY);
+			const size_t planes = size.sizeZ * size.sizeW;
+			const bool apply = rnd.Bernoulli(probability);
+			const int centerX = rnd.UniformInt(0, width - 1);
+			const int centerY = rnd.UniformInt(0, height - 1);
+			if (!apply)
+				return;
+
+			const int half = static_cast<int>(cutSize) / 2;
+			const int beginX = std::max(0, centerX - half);
+			const int endX = std::min(width, centerX - half + static_cast<int>(cutSize));
+			const int beginY = std::max(0, centerY - half);
+			const int endY = std::min(height, centerY - half + static_cast<int>(cutSize));
+
+			for (size_t z = 0; z < planes; ++z)
+				for (int y = beginY; y < endY; ++y)
+					FillRow(image + (z * height + y) * width + beginX, endX - beginX, value);
+		}
+	}
+}
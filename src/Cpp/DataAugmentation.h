@@ -0,0 +1,213 @@
+#pragma once
+
+#include <vector>
+
+#include "DataTransformer.h"
+
+namespace DeepCL
+{
+	namespace DataSystem
+	{
+		//Random numbers of one sample. The generator (SplitMix64) is seeded with the seed of the augmentation and the index of the sample in the stream read by a loader thread,
+		//therefore the augmentations don't depend on the timing of the threads. The streams of the threads start at offsets depending on the number of threads (See BatchManager),
+		//a sample is only augmented the same way by runs using the same number of threads.
+		//The index is hashed before it is combined with the seed, otherwise the sequences of neighbouring samples would overlap.
+		class SampleRandom
+		{
+		public:
+			SampleRandom(const unsigned long long seed, const unsigned long long sample) :
+				state(Mix(seed ^ Mix(sample)))
+			{}
+
+			unsigned long long Next();
+			//Uniform in [minValue, maxValue)
+			float Uniform(const float minValue, const float maxValue);
+			//Uniform in [minValue, maxValue]
+			int UniformInt(const int minValue, const int maxValue);
+			bool Bernoulli(const float probability);
+
+		private:
+			//Output function of SplitMix64
+			static unsigned long long Mix(unsigned long long z);
+
+			unsigned long long state;
+		};
+
+		//Base class of the augmentations. An augmentation changes one image in place. The images are stored like the buffers of the network: x is the fastest dimension followed by y
+		//and the channel z. The rows of an image are processed with SSE. scratch points to memory of the size of the image which may be used for intermediate results.
+		class AugmentOp
+		{
+		public:
+			virtual ~AugmentOp()
+			{}
+
+			virtual void Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd) = 0;
+
+			//Used to create a copy for each loader thread.
+			virtual AugmentOp* AllocateCopy() const = 0;
+		};
+
+		//Pads the image with value by pad pixels and crops an image of the original size at a random position.
+		class AugmentRandomCrop : public AugmentOp
+		{
+		public:
+			AugmentRandomCrop(const size_t pad, const float value = 0.f) :
+				pad(pad), value(value)
+			{}
+
+			virtual void Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd);
+			virtual AugmentOp* AllocateCopy() const { return new AugmentRandomCrop(*this); }
+
+		protected:
+			const size_t pad;
+			const float value;
+		};
+
+		//Mirrors the image horizontally (x) or vertically (y), each with the given probability.
+		class AugmentFlip : public AugmentOp
+		{
+		public:
+			AugmentFlip(const float probabilityX, const float probabilityY = 0.f) :
+				probabilityX(probabilityX), probabilityY(probabilityY)
+			{}
+
+			virtual void Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd);
+			virtual AugmentOp* AllocateCopy() const { return new AugmentFlip(*this); }
+
+		protected:
+			const float probabilityX;
+			const float probabilityY;
+		};
+
+		//Rotates (angle in radians), scales and translates (in pixels) the image around its center by random amounts up to the given limits. The image is sampled bilinearly,
+		//pixels outside of the source image are set to value.
+		class AugmentAffine : public AugmentOp
+		{
+		public:
+			AugmentAffine(const float maxAngle, const float maxScale = 0.f, const float maxShift = 0.f, const float value = 0.f) :
+				maxAngle(maxAngle), maxScale(maxScale), maxShift(maxShift), value(value)
+			{}
+
+			virtual void Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd);
+			virtual AugmentOp* AllocateCopy() const { return new AugmentAffine(*this); }
+
+		protected:
+			const float maxAngle;
+			const float maxScale;
+			const float maxShift;
+			const float value;
+		};
+
+		//Adds a random brightness offset in [-maxBrightness, maxBrightness] and scales the distance of each value to the mean of its channel by a factor in [1 - maxContrast, 1 + maxContrast].
+		class AugmentBrightnessContrast : public AugmentOp
+		{
+		public:
+			AugmentBrightnessContrast(const float maxBrightness, const float maxContrast) :
+				maxBrightness(maxBrightness), maxContrast(maxContrast)
+			{}
+
+			virtual void Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd);
+			virtual AugmentOp* AllocateCopy() const { return new AugmentBrightnessContrast(*this); }
+
+		protected:
+			const float maxBrightness;
+			const float maxContrast;
+		};
+
+		//Subtracts the mean and divides by the standard deviation of each channel. It uses no random numbers and is usually the last augmentation.
+		class AugmentNormalize : public AugmentOp
+		{
+		public:
+			AugmentNormalize(const std::vector<float>& mean, const std::vector<float>& stddev) :
+				mean(mean), stddev(stddev)
+			{}
+
+			virtual void Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd);
+			virtual AugmentOp* AllocateCopy() const { return new AugmentNormalize(*this); }
+
+		protected:
+			const std::vector<float> mean;
+			const std::vector<float> stddev;
+		};
+
+		//Sets a square of edge length cutSize at a random position to value in all channels (Cutout). The square may be partially outside of the image.
+		class AugmentCutout : public AugmentOp
+		{
+		public:
+			AugmentCutout(const size_t cutSize, const float probability = 1.f, const float value = 0.f) :
+				cutSize(cutSize), probability(probability), value(value)
+			{}
+
+			virtual void Apply(float* image, float* scratch, const NNSystem::SizeVec& size, SampleRandom& rnd);
+			virtual AugmentOp* AllocateCopy() const { return new AugmentCutout(*this); }
+
+		protected:
+			const size_t cutSize;
+			const float probability;
+			const float value;
+		};
+
+		//Transformer which applies a chain of augmentations to the data part imageArg after the transformer it wraps. The data part must be of type float and all its elements must be of
+		//the same size after the wrapped transformer ran. Each loader thread of the BatchManager uses its own copy, thereby the augmentation runs in parallel on the loader threads.
+		//The transformer takes ownership of the wrapped transformer and of the augmentations.
+		template<size_t imageArg, typename... varT>
+		class AugmentationTransformer : public BaseDataTransformer<varT...>
+		{
+		public:
+			AugmentationTransformer(const size_t batchSize, BaseDataTransformer<varT...>* transformer, const unsigned long long seed) :
+				BaseDataTransformer<varT...>(batchSize), transformer(transformer), seed(seed), ops(), scratch()
+			{}
+
+			virtual ~AugmentationTransformer()
+			{
+				delete transformer;
+				for (size_t i = 0; i < ops.size(); ++i)
+					delete ops[i];
+			}
+
+			//The augmentations are applied in the order in which they were added.
+			void AddAugmentation(AugmentOp* op)
+			{ ops.push_back(op); }
+
+			virtual void Transform(BackendSystem::Tuple<std::vector<varT>...>& dataOutput, std::vector<NNSystem::SizeVec>& newSizes, BackendSystem::Tuple<std::vector<varT>...>& data,
+				std::vector<std::vector<size_t>>& offsets, std::vector<std::vector<NNSystem::SizeVec>>& sizes);
+
+			virtual BaseDataTransformer<varT...>* AllocateCopy();
+
+		protected:
+			BaseDataTransformer<varT...>* transformer;
+			unsigned long long seed;
+			std::vector<AugmentOp*> ops;
+			std::vector<float> scratch;
+		};
+
+		template<size_t imageArg, typename... varT>
+		void AugmentationTransformer<imageArg, varT...>::Transform(BackendSystem::Tuple<std::vector<varT>...>& dataOutput, std::vector<NNSystem::SizeVec>& newSizes,
+			BackendSystem::Tuple<std::vector<varT>...>& data, std::vector<std::vector<size_t>>& offsets, std::vector<std::vector<NNSystem::SizeVec>>& sizes)
+		{
+			transformer->Transform(dataOutput, newSizes, data, offsets, sizes);
+
+			std::vector<float>& images = BackendSystem::get<imageArg>(dataOutput);
+			const NNSystem::SizeVec& size = newSizes[imageArg];
+			const size_t imageSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW;
+			scratch.resize(imageSize);
+
+			for (size_t i = 0; i < this->batchSize; ++i)
+			{
+				SampleRandom rnd(seed, this->sampleIndex + i);
+				for (size_t o = 0; o < ops.size(); ++o)
+					ops[o]->Apply(images.data() + i * imageSize, scratch.data(), size, rnd);
+			}
+			this->sampleIndex += this->batchSize;
+		}
+
+		template<size_t imageArg, typename... varT>
+		BaseDataTransformer<varT...>* AugmentationTransformer<imageArg, varT...>::AllocateCopy()
+		{
+			AugmentationTransformer<imageArg, varT...>* copy = new AugmentationTransformer<imageArg, varT...>(this->batchSize, transformer->AllocateCopy(), seed);
+			for (size_t i = 0; i < ops.size(); ++i)
+				copy->AddAugmentation(ops[i]->AllocateCopy());
+			return copy;
+		}
+	}
+}
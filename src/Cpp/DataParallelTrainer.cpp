@@ -0,0 +1,199 @@
+#include "DataParallelTrainer.h"
+
+#include <thread>
+#include <algorithm>
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		DataParallelTrainer::DataParallelTrainer(const std::vector<cl::Device>& devices) :
+			devices(devices), replicas(), batchSize(0), shards(), gradients(), barrierCount(0), barrierGeneration(0)
+		{
+			for (size_t i = 0; i < devices.size(); ++i)
+				replicas.push_back(new NeuralNetwork());
+		}
+
+		DataParallelTrainer::~DataParallelTrainer()
+		{
+			for (size_t i = 0; i < replicas.size(); ++i)
+				delete replicas[i];
+		}
+
+		DeepCLError DataParallelTrainer::InitSystem()
+		{
+			for (size_t i = 0; i < replicas.size(); ++i)
+			{
+				DeepCLError err = replicas[i]->InitSystem(devices[i]);
+				if (err != 0)
+					return err;
+			}
+			return 0;
+		}
+
+		void DataParallelTrainer::BuildGraph(const std::function<void(NeuralNetwork&)>& build)
+		{
+			for (size_t i = 0; i < replicas.size(); ++i)
+			{
+				OPManager::SetActiveNN(replicas[i]);
+				build(*replicas[i]);
+			}
+		}
+
+		DeepCLError DataParallelTrainer::InitliazeGraph(const size_t batchSize)
+		{
+			if (batchSize < replicas.size())
+			{
+				std::cout << "Error the batch must contain at least one element for each device!" << std::endl;
+				return NN_INVALID_BATCH_SIZE;
+			}
+
+			this->batchSize = batchSize;
+			const size_t replicaBatch = (batchSize + replicas.size() - 1) / replicas.size();
+			for (size_t i = 0; i < replicas.size(); ++i)
+			{
+				DeepCLError err = replicas[i]->InitliazeGraph(replicaBatch);
+				if (err != 0)
+					return err;
+			}
+
+			//All devices start with the parameters of the first device.
+			for (size_t i = 1; i < replicas.size(); ++i)
+			{
+				DeepCLError err = replicas[i]->CopyParameters(*replicas[0]);
+				if (err != 0)
+					return err;
+			}
+
+			gradients.assign(replicas.size(), std::vector<std::vector<float>>());
+			for (size_t i = 0; i < replicas.size(); ++i)
+				for (size_t p = 0; p < replicas[i]->GetNumParameters(); ++p)
+				{
+					SizeVec size = replicas[i]->GetSize(replicas[i]->GetParameterBuffer(p));
+					gradients[i].push_back(std::vector<float>(size.sizeX * size.sizeY * size.sizeZ * size.sizeW));
+				}
+
+			return 0;
+		}
+
+		void DataParallelTrainer::ComputeShards(const size_t curBatchSize)
+		{
+			const size_t numReplicas = replicas.size();
+			shards.clear();
+			size_t start = 0;
+			for (size_t i = 0; i < numReplicas; ++i)
+			{
+				const size_t count = curBatchSize / numReplicas + (i < curBatchSize % numReplicas ? 1 : 0);
+				shards.push_back(std::pair<size_t, size_t>(start, count));
+				start += count;
+			}
+		}
+
+		DeepCLError DataParallelTrainer::RunStep(const size_t curBatchSize)
+		{
+			std::vector<DeepCLError> errors(replicas.size(), 0);
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < replicas.size(); ++i)
+			{
+				//Each device computes the mean gradient of its part. Weighting them with the size of the parts results in the mean of the batch.
+				const float weight = static_cast<float>(shards[i].second) / static_cast<float>(curBatchSize);
+				threads.push_back(std::thread(&DataParallelTrainer::ReplicaStep, this, i, weight, std::ref(errors)));
+			}
+			for (size_t i = 0; i < threads.size(); ++i)
+				threads[i].join();
+
+			for (size_t i = 0; i < errors.size(); ++i)
+				if (errors[i] != 0)
+					return errors[i];
+			return 0;
+		}
+
+		void DataParallelTrainer::ReplicaStep(const size_t replica, const float weight, std::vector<DeepCLError>& errors)
+		{
+			NeuralNetwork& nn = *replicas[replica];
+			nn.SetActiveBatch(shards[replica].second);
+
+			DeepCLError& err = errors[replica];
+			err = nn.Forward();
+			std::vector<std::pair<size_t, cl::Event>> gradientEvents;
+			if (err == 0)
+				err = nn.BackwardAsync(gradientEvents);
+
+			//No device starts the all-reduce if one of them failed.
+			Barrier();
+			for (size_t i = 0; i < errors.size(); ++i)
+				if (errors[i] != 0)
+					return;
+
+			std::vector<cl::Event> writeEvents(gradientEvents.size());
+			for (size_t i = 0; i < gradientEvents.size(); ++i)
+			{
+				const size_t parameter = gradientEvents[i].first;
+				std::vector<float>& gradient = gradients[replica][parameter];
+
+				//Waits only for the part of the backward pass computing this gradient.
+				cl::Event readEvent;
+				nn.ReadGradientAsync(parameter, gradient.data(), &gradientEvents[i].second, &readEvent);
+				readEvent.wait();
+				for (size_t j = 0; j < gradient.size(); ++j)
+					gradient[j] *= weight;
+
+				AllReduce(replica, parameter);
+
+				nn.WriteGradientAsync(parameter, gradient.data(), &writeEvents[i]);
+			}
+
+			//The update waits for the uploads and finishes before the host memory is used again.
+			err = nn.Step(writeEvents);
+		}
+
+		void DataParallelTrainer::AllReduce(const size_t replica, const size_t parameter)
+		{
+			const size_t numReplicas = replicas.size();
+			if (numReplicas < 2)
+				return;
+
+			std::vector<float>& own = gradients[replica][parameter];
+			const std::vector<float>& left = gradients[(replica + numReplicas - 1) % numReplicas][parameter];
+			const size_t size = own.size();
+
+			//All devices read their gradient.
+			Barrier();
+
+			//Reduce-scatter: In step s the chunk replica - s - 1 of the left neighbour is added. Afterwards the chunk replica + 1 contains the complete sum.
+			for (size_t s = 0; s + 1 < numReplicas; ++s)
+			{
+				const size_t chunk = (replica + 2 * numReplicas - s - 1) % numReplicas;
+				const size_t begin = chunk * size / numReplicas;
+				const size_t end = (chunk + 1) * size / numReplicas;
+				for (size_t i = begin; i < end; ++i)
+					own[i] += left[i];
+				Barrier();
+			}
+
+			//All-gather: In step s the complete chunk replica - s is copied from the left neighbour.
+			for (size_t s = 0; s + 1 < numReplicas; ++s)
+			{
+				const size_t chunk = (replica + numReplicas - s) % numReplicas;
+				const size_t begin = chunk * size / numReplicas;
+				const size_t end = (chunk + 1) * size / numReplicas;
+				std::copy(left.begin() + begin, left.begin() + end, own.begin() + begin);
+				Barrier();
+			}
+		}
+
+		void DataParallelTrainer::Barrier()
+		{
+			std::unique_lock<std::mutex> lock(barrierMutex);
+			const size_t generation = barrierGeneration;
+			if (++barrierCount == replicas.size())
+			{
+				barrierCount = 0;
+				++barrierGeneration;
+				barrierCondition.notify_all();
+			}
+			else
+				barrierCondition.wait(lock, [this, generation]() { return generation != barrierGeneration; });
+		}
+	}
+}
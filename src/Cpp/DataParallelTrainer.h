@@ -0,0 +1,114 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+#include "OPManager.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Trains one copy of the graph on each device. Each batch is split into one part for each device and the parameter gradients are averaged
+		//using a ring all-reduce over host memory before the update. The gradients are reduced in the order they are completed by the backward pass,
+		//therefore the reduction overlaps with the remaining backward operations.
+		//Several CPU devices or the NUMA nodes of one CPU (See OpenCLBackend::SplitByNUMA) allow testing the scaling on one machine.
+		//The loss scale of mixed precision is not synchronized between the devices, therefore mixed precision should not be used.
+		class DataParallelTrainer
+		{
+		public:
+			DataParallelTrainer(const std::vector<cl::Device>& devices);
+			~DataParallelTrainer();
+
+			DeepCLError InitSystem();
+
+			//Calls build once for each device with the network of the device set as active network of the OPManager. build must create the same graph each time
+			//including the weight initalizers and the optimizer.
+			void BuildGraph(const std::function<void(NeuralNetwork&)>& build);
+
+			//Initalizes the graph of each device for its part of the batch and copies the parameters of the first device to the other devices.
+			DeepCLError InitliazeGraph(const size_t batchSize);
+
+			//Performs the forward pass, the backward pass and the update on all devices. Works like the variadic Forward function of the NeuralNetwork.
+			//The batch must contain at least one element for each device.
+			template<typename... T1>
+			DeepCLError TrainingStep(std::vector<T1>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize);
+
+			size_t GetNumReplicas() const { return replicas.size(); }
+			//The network of a device. The parameters of all networks are equal after each step.
+			NeuralNetwork& GetReplica(const size_t replica) { return *replicas[replica]; }
+
+		private:
+			DataParallelTrainer(const DataParallelTrainer& other);
+			const DataParallelTrainer& operator=(const DataParallelTrainer& other);
+
+			std::vector<cl::Device> devices;
+			std::vector<NeuralNetwork*> replicas;
+
+			size_t batchSize;
+			std::vector<std::pair<size_t, size_t>> shards; //First batch element and number of batch elements of each device in the current step
+			std::vector<std::vector<std::vector<float>>> gradients; //Host copy of the gradient of each parameter of each device
+
+			//Barrier the threads of the devices synchronize at during the all-reduce
+			std::mutex barrierMutex;
+			std::condition_variable barrierCondition;
+			size_t barrierCount;
+			size_t barrierGeneration;
+			void Barrier();
+
+			//Splits the batch evenly over the devices.
+			void ComputeShards(const size_t curBatchSize);
+			//Runs the step on all devices using one thread for each device.
+			DeepCLError RunStep(const size_t curBatchSize);
+			void ReplicaStep(const size_t replica, const float weight, std::vector<DeepCLError>& errors);
+			//Sums the gradients of the parameter over all devices. Each device sends one part of the gradient to the next device in each step.
+			void AllReduce(const size_t replica, const size_t parameter);
+		};
+
+		//Uploads the part of each input belonging to a device. Works like UnrollFwd.
+		template<size_t from, class... Ts>
+		struct UploadShard
+		{
+		public:
+			inline static void apply(std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t start, const size_t count, NeuralNetwork& nn)
+			{
+			}
+		};
+
+		template<size_t from, class T1, class... Ts>
+		struct UploadShard < from, T1, Ts... >
+		{
+		public:
+			inline static void apply(std::vector<T1>& curBuffer, std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t start, const size_t count, NeuralNetwork& nn)
+			{
+				//The time steps of each batch element are stored behind each other, therefore the part of a device is contiguous.
+				const SizeVec& size = sizes[from];
+				const size_t timeSteps = size.sizeW > 1 ? size.sizeW : 1;
+				const T1* data = curBuffer.data() + start * size.sizeX * size.sizeY * size.sizeZ * timeSteps;
+				if (timeSteps > 1)
+					nn.WriteDataBuffer<T1>(bufferIndices[from], data, size.sizeX, size.sizeY, size.sizeZ, count, 0, timeSteps);
+				else
+					nn.WriteDataBuffer<T1>(bufferIndices[from], data, size.sizeX, size.sizeY, size.sizeZ, count);
+
+				UploadShard<from + 1, Ts...>::apply(buffer..., bufferIndices, sizes, start, count, nn);
+			}
+		};
+
+		template<typename... T1>
+		DeepCLError DataParallelTrainer::TrainingStep(std::vector<T1>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize)
+		{
+			if (curBatchSize < replicas.size() || curBatchSize > batchSize)
+			{
+				std::cout << "Error the batch must contain between " << replicas.size() << " and " << batchSize << " elements!" << std::endl;
+				return NN_INVALID_BATCH_SIZE;
+			}
+
+			ComputeShards(curBatchSize);
+			for (size_t i = 0; i < replicas.size(); ++i)
+				UploadShard<0, T1...>::apply(buffer..., bufferIndices, sizes, shards[i].first, shards[i].second, *replicas[i]);
+
+			return RunStep(curBatchSize);
+		}
+	}
+}
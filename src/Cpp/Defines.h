@@ -1,48 +1,59 @@
-#pragma once
-
-#include <climits>
-
-namespace DeepCL
-{
-	//This file contains some defines and namespaces used by the system. 
-//#define PROFILING_ENABLED
-	typedef int DeepCLError;
-
-	namespace BackendSystem
-	{
-		//Defines for indices of operations, buffers and kernels in the backend.
-		typedef unsigned int KernelIdx;
-		typedef unsigned int OperationIdx;
-		typedef unsigned int BufferIdx;
-		
-		//Flags for how the memory should be created.
-		enum MEM_FLAG
-		{
-			READ_ONLY,
-			WRITE_ONLY,
-			READ_WRITE
-		};
-	}
-
-	//Used to initalize indices. Index was not initalized.
-	const unsigned int MAX_UNSIGNED_INT = UINT_MAX;
-
-	namespace NNSystem
-	{
-		using namespace BackendSystem;
-	}
-
-	//Defines of indices of operations and buffer in the Neural Network system
-	typedef unsigned int NNBufferIdx;
-	typedef unsigned int NNOperationIdx;
-
-	//Used for passing kernel arguments
-	typedef std::pair<size_t, int> dataPair;
-
-	//Error codes of the Neural Network System. Propably more are necessary.
-	const DeepCLError NN_DOES_NOT_EXIST = 9999999;
-	const DeepCLError NN_SYSTEM_NOT_INITIALIZED = -251;
-	const DeepCLError NN_GRAPH_NOT_INITIALIZED = -252;
-	const DeepCLError NN_BATCH_MANAGER_NOT_INITIALIZED = -253;
-
+#pragma once
+
+#include <climits>
+
+namespace DeepCL
+{
+	//This file contains some defines and namespaces used by the system. 
+//#define PROFILING_ENABLED
+	typedef int DeepCLError;
+
+	namespace BackendSystem
+	{
+		//Defines for indices of operations, buffers and kernels in the backend.
+		typedef unsigned int KernelIdx;
+		typedef unsigned int OperationIdx;
+		typedef unsigned int BufferIdx;
+		
+		//Flags for how the memory should be created.
+		enum MEM_FLAG
+		{
+			READ_ONLY,
+			WRITE_ONLY,
+			READ_WRITE
+		};
+	}
+
+	//Used to initalize indices. Index was not initalized.
+	const unsigned int MAX_UNSIGNED_INT = UINT_MAX;
+
+	namespace NNSystem
+	{
+		using namespace BackendSystem;
+	}
+
+	//Defines of indices of operations and buffer in the Neural Network system
+	typedef unsigned int NNBufferIdx;
+	typedef unsigned int NNOperationIdx;
+
+	//Used for passing kernel arguments
+	typedef std::pair<size_t, int> dataPair;
+
+	//Error codes of the Neural Network System. Propably more are necessary.
+	const DeepCLError NN_DOES_NOT_EXIST = 9999999;
+	const DeepCLError NN_SYSTEM_NOT_INITIALIZED = -251;
+	const DeepCLError NN_GRAPH_NOT_INITIALIZED = -252;
+	const DeepCLError NN_BATCH_MANAGER_NOT_INITIALIZED = -253;
+	const DeepCLError NN_GRAPH_QUANTIZED = -254;
+	const DeepCLError NN_NOT_CALIBRATED = -255;
+	const DeepCLError NN_GRAPH_NOT_QUANTIZED = -256;
+	const DeepCLError NN_MODEL_FILE_ERROR = -257;
+	const DeepCLError NN_GRAPH_MISMATCH = -258;
+	const DeepCLError NN_INVALID_BATCH_SIZE = -259;
+	const DeepCLError NN_COMMUNICATION_ERROR = -260;
+	const DeepCLError NN_INVALID_SEQUENCE_LENGTHS = -261;
+	const DeepCLError NN_CARRY_STATE_NOT_SUPPORTED = -262;
+	const DeepCLError NN_RECOMPUTE_NOT_SUPPORTED = -263;
+	const DeepCLError NN_INVALID_INPUT_STORAGE = -264;
+
 }
\ No newline at end of file
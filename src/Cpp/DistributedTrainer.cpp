@@ -0,0 +1,241 @@
+#include "DistributedTrainer.h"
+
+#include <chrono>
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		DistributedTrainer::DistributedTrainer(NeuralNetwork& nn, const size_t bucketSize) :
+			nn(nn), ring(), bucketSize(bucketSize), buckets(), communicationTime(0.0), bytesSent(0)
+		{
+		}
+
+		DeepCLError DistributedTrainer::Connect(const std::vector<std::string>& hosts, const size_t rank, const unsigned int timeoutSeconds)
+		{
+			DeepCLError err = ring.Connect(hosts, rank, timeoutSeconds);
+			if (err != 0)
+				return err;
+
+			//All processes start with the parameters of the first process.
+			std::vector<float> parameters;
+			err = nn.ReadParameters(parameters);
+			if (err != 0)
+				return err;
+			unsigned long long numValues = parameters.size();
+			if (!ring.Broadcast(reinterpret_cast<char*>(&numValues), sizeof(numValues)))
+				return NN_COMMUNICATION_ERROR;
+			if (numValues != parameters.size())
+			{
+				std::cout << "Error DistributedTrainer: The graphs of the processes are different" << std::endl;
+				return NN_GRAPH_MISMATCH;
+			}
+			if (!ring.Broadcast(reinterpret_cast<char*>(parameters.data()), parameters.size() * sizeof(float)))
+				return NN_COMMUNICATION_ERROR;
+
+			GradientCompressor* compressor = nn.GetGradientCompressor();
+			if (compressor != nullptr)
+				compressor->Initialize(ring.GetNumProcesses());
+			return nn.WriteParameters(parameters);
+		}
+
+		void DistributedTrainer::CreateBuckets(const std::vector<std::pair<size_t, cl::Event>>& gradientEvents)
+		{
+			buckets.clear();
+			for (size_t i = 0; i < gradientEvents.size(); ++i)
+			{
+				if (buckets.empty() || buckets.back().data.size() * sizeof(float) >= bucketSize)
+				{
+					buckets.push_back(Bucket());
+					buckets.back().first = i;
+					buckets.back().count = 0;
+				}
+
+				Bucket& bucket = buckets.back();
+				SizeVec size = nn.GetSize(nn.GetParameterBuffer(gradientEvents[i].first));
+				bucket.offsets.push_back(bucket.data.size());
+				bucket.data.resize(bucket.data.size() + size.sizeX * size.sizeY * size.sizeZ * size.sizeW);
+				++bucket.count;
+			}
+
+			//The last value of the first bucket contains the batch size of the process. Its sum is the size of the batch of all processes.
+			if (buckets.empty())
+				buckets.push_back(Bucket());
+			buckets[0].data.push_back(0.f);
+
+			for (size_t i = 0; i < buckets.size(); ++i)
+				buckets[i].readEvents.resize(buckets[i].count);
+		}
+
+		void DistributedTrainer::ReadBucket(const size_t bucket, std::vector<std::pair<size_t, cl::Event>>& gradientEvents)
+		{
+			Bucket& current = buckets[bucket];
+			for (size_t i = 0; i < current.count; ++i)
+			{
+				std::pair<size_t, cl::Event>& gradient = gradientEvents[current.first + i];
+				nn.ReadGradientAsync(gradient.first, current.data.data() + current.offsets[i], &gradient.second, &current.readEvents[i]);
+			}
+		}
+
+		void DistributedTrainer::CompressBucket(const size_t bucket, std::vector<std::pair<size_t, cl::Event>>& gradientEvents)
+		{
+			GradientCompressor* compressor = nn.GetGradientCompressor();
+			Bucket& current = buckets[bucket];
+			for (size_t i = 0; i < current.count; ++i)
+			{
+				std::pair<size_t, cl::Event>& gradient = gradientEvents[current.first + i];
+				compressor->Compress(gradient.first, &gradient.second, &current.readEvents[i]);
+			}
+		}
+
+		DeepCLError DistributedTrainer::RunStep(const size_t curBatchSize)
+		{
+			std::vector<std::pair<size_t, cl::Event>> gradientEvents;
+			DeepCLError err = nn.BackwardAsync(gradientEvents);
+			if (err != 0)
+				return err;
+			if (buckets.empty())
+				CreateBuckets(gradientEvents);
+
+			communicationTime = 0.0;
+			const unsigned long long bytesBefore = ring.GetBytesSent();
+			if (nn.GetGradientCompressor() != nullptr)
+			{
+				err = RunCompressedStep(curBatchSize, gradientEvents);
+				bytesSent = ring.GetBytesSent() - bytesBefore;
+				return err;
+			}
+
+			float totalBatchSize = 1.f;
+			std::vector<cl::Event> writeEvents(gradientEvents.size());
+			ReadBucket(0, gradientEvents);
+			for (size_t b = 0; b < buckets.size(); ++b)
+			{
+				Bucket& bucket = buckets[b];
+				for (size_t i = 0; i < bucket.count; ++i)
+					bucket.readEvents[i].wait();
+
+				//The next bucket is read while this one is reduced.
+				if (b + 1 < buckets.size())
+					ReadBucket(b + 1, gradientEvents);
+
+				//Each process computed the mean gradient of its batch. Weighting them with the batch sizes and dividing the sum by the total batch size
+				//results in the mean over the batches of all processes.
+				const float weight = static_cast<float>(curBatchSize);
+				for (size_t i = 0; i < bucket.data.size(); ++i)
+					bucket.data[i] *= weight;
+				if (b == 0)
+					bucket.data.back() = weight;
+
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				const bool reduced = ring.AllReduce(bucket.data.data(), bucket.data.size());
+				communicationTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (!reduced)
+				{
+					//The reads into the next bucket must finish before its memory is used again.
+					if (b + 1 < buckets.size())
+						for (size_t i = 0; i < buckets[b + 1].count; ++i)
+							buckets[b + 1].readEvents[i].wait();
+					return NN_COMMUNICATION_ERROR;
+				}
+
+				if (b == 0)
+					totalBatchSize = bucket.data.back();
+				const float scale = 1.f / totalBatchSize;
+				for (size_t i = 0; i < bucket.data.size(); ++i)
+					bucket.data[i] *= scale;
+
+				for (size_t i = 0; i < bucket.count; ++i)
+					nn.WriteGradientAsync(gradientEvents[bucket.first + i].first, bucket.data.data() + bucket.offsets[i], &writeEvents[bucket.first + i]);
+			}
+
+			bytesSent = ring.GetBytesSent() - bytesBefore;
+
+			//The update waits for the uploads and finishes before the buckets are used again.
+			return nn.Step(writeEvents);
+		}
+
+		DeepCLError DistributedTrainer::RunCompressedStep(const size_t curBatchSize, std::vector<std::pair<size_t, cl::Event>>& gradientEvents)
+		{
+			GradientCompressor* compressor = nn.GetGradientCompressor();
+
+			//The weights are applied before the compression, therefore the total batch size is exchanged first. The backward pass continues meanwhile.
+			float totalBatchSize = static_cast<float>(curBatchSize);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			const bool reduced = ring.AllReduce(&totalBatchSize, 1);
+			communicationTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (!reduced)
+				return NN_COMMUNICATION_ERROR;
+			compressor->SetWeight(static_cast<float>(curBatchSize) / totalBatchSize);
+
+			std::vector<cl::Event> writeEvents(gradientEvents.size());
+			std::vector<const char*> parts;
+			CompressBucket(0, gradientEvents);
+			for (size_t b = 0; b < buckets.size(); ++b)
+			{
+				Bucket& bucket = buckets[b];
+				for (size_t i = 0; i < bucket.count; ++i)
+					bucket.readEvents[i].wait();
+
+				bucket.message.clear();
+				bucket.messageOffsets.resize(bucket.count);
+				for (size_t i = 0; i < bucket.count; ++i)
+				{
+					bucket.messageOffsets[i] = bucket.message.size();
+					compressor->Finish(gradientEvents[bucket.first + i].first, bucket.message);
+				}
+
+				//The compression of the next bucket is enqueued after the selection of top-k, otherwise the selection would wait for the next gradients.
+				if (b + 1 < buckets.size())
+					CompressBucket(b + 1, gradientEvents);
+
+				start = std::chrono::steady_clock::now();
+				bool exchanged;
+				if (compressor->Gathers())
+					exchanged = ring.AllGather(bucket.message, bucket.gathered);
+				else
+					exchanged = ring.AllReduceHalf(reinterpret_cast<unsigned short*>(bucket.message.data()), bucket.message.size() / sizeof(unsigned short));
+				communicationTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (!exchanged)
+				{
+					//The reads of the next bucket must finish before the memory of the compressor is used again.
+					if (b + 1 < buckets.size())
+						for (size_t i = 0; i < buckets[b + 1].count; ++i)
+							buckets[b + 1].readEvents[i].wait();
+					return NN_COMMUNICATION_ERROR;
+				}
+
+				if (compressor->Gathers())
+				{
+					//The gradients of each process follow each other in the order of the bucket.
+					std::vector<const char*> position(bucket.gathered.size());
+					for (size_t p = 0; p < bucket.gathered.size(); ++p)
+						position[p] = bucket.gathered[p].data();
+					parts.resize(bucket.gathered.size());
+					for (size_t i = 0; i < bucket.count; ++i)
+					{
+						const size_t parameter = gradientEvents[bucket.first + i].first;
+						for (size_t p = 0; p < bucket.gathered.size(); ++p)
+						{
+							parts[p] = position[p];
+							position[p] += compressor->GetPartSize(parameter, position[p]);
+						}
+						compressor->Decompress(parameter, parts, &writeEvents[bucket.first + i]);
+					}
+				}
+				else
+				{
+					parts.resize(1);
+					for (size_t i = 0; i < bucket.count; ++i)
+					{
+						parts[0] = bucket.message.data() + bucket.messageOffsets[i];
+						compressor->Decompress(gradientEvents[bucket.first + i].first, parts, &writeEvents[bucket.first + i]);
+					}
+				}
+			}
+
+			//The update waits for the decompressions and finishes before the messages are used again.
+			return nn.Step(writeEvents);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "NeuralNetwork.h"
+#include "RingCommunicator.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Trains with one process for each worker (For example one process for each machine). Each process trains the same graph on its own batches and the
+		//parameter gradients are averaged with a ring all-reduce over TCP (See RingCommunicator) before the update. The gradients are grouped into buckets in the
+		//order they are completed by the backward pass. The all-reduce of a bucket starts as soon as its gradients were read, therefore it overlaps with the
+		//remaining backward operations and with the read of the next bucket.
+		//If a gradient compression was set on the network (See NeuralNetwork::SetGradientCompression) the gradients are compressed on the device before they are read.
+		//fp16 gradients are summed by the ring all-reduce, top-k and sign compressed gradients of all processes are collected and summed on the device.
+		//All processes can run on one machine using localhost addresses (127.0.0.1:5000, 127.0.0.1:5001, ...).
+		//The loss scale of mixed precision is not synchronized between the processes, therefore mixed precision should not be used.
+		class DistributedTrainer
+		{
+		public:
+			//A bucket is closed once it contains at least bucketSize bytes. Bigger buckets need fewer messages, smaller buckets start earlier.
+			DistributedTrainer(NeuralNetwork& nn, const size_t bucketSize = 1 << 22);
+
+			//Connects the processes (See RingCommunicator::Connect) and copies the parameters of the first process to the other processes.
+			//Must be called by all processes after InitliazeGraph.
+			DeepCLError Connect(const std::vector<std::string>& hosts, const size_t rank, const unsigned int timeoutSeconds = 60);
+
+			//Performs the forward pass, the backward pass and the update on the batch of this process. Works like the variadic Forward function of the NeuralNetwork.
+			//The processes may use different batch sizes, the gradients are weighted by them.
+			template<typename... T1>
+			DeepCLError TrainingStep(std::vector<T1>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize)
+			{
+				DeepCLError err = nn.Forward<T1...>(buffer..., bufferIndices, sizes, curBatchSize);
+				if (err != 0)
+					return err;
+				return RunStep(curBatchSize);
+			}
+
+			size_t GetRank() const { return ring.GetRank(); }
+			size_t GetNumProcesses() const { return ring.GetNumProcesses(); }
+			size_t GetNumBuckets() const { return buckets.size(); }
+			//The ring connecting the processes. Can be used to exchange other values between the processes (For example the loss) outside of a step.
+			RingCommunicator& GetCommunicator() { return ring; }
+			//Time the last step spent in the all-reduce in seconds. This is the part of the communication which is not hidden behind the backward pass.
+			double GetCommunicationTime() const { return communicationTime; }
+			//Number of bytes the last step sent to the next process.
+			unsigned long long GetBytesSent() const { return bytesSent; }
+
+		private:
+			DistributedTrainer(const DistributedTrainer& other);
+			const DistributedTrainer& operator=(const DistributedTrainer& other);
+
+			struct Bucket
+			{
+				size_t first; //First gradient in the order returned by BackwardAsync
+				size_t count;
+				std::vector<size_t> offsets; //Position of each gradient in data
+				std::vector<float> data;
+				std::vector<cl::Event> readEvents;
+				std::vector<char> message; //Compressed gradients of this process
+				std::vector<size_t> messageOffsets; //Position of each compressed gradient in message
+				std::vector<std::vector<char>> gathered; //Compressed gradients of all processes (Top-k and sign)
+			};
+
+			//Groups the gradients into buckets. All processes build the same graph, therefore they create the same buckets.
+			void CreateBuckets(const std::vector<std::pair<size_t, cl::Event>>& gradientEvents);
+			//Enqueues the reads of the gradients of a bucket. Each read waits for the part of the backward pass computing its gradient.
+			void ReadBucket(const size_t bucket, std::vector<std::pair<size_t, cl::Event>>& gradientEvents);
+			//Enqueues the compression of the gradients of a bucket followed by their reads.
+			void CompressBucket(const size_t bucket, std::vector<std::pair<size_t, cl::Event>>& gradientEvents);
+			DeepCLError RunStep(const size_t curBatchSize);
+			DeepCLError RunCompressedStep(const size_t curBatchSize, std::vector<std::pair<size_t, cl::Event>>& gradientEvents);
+
+			NeuralNetwork& nn;
+			RingCommunicator ring;
+			size_t bucketSize;
+			std::vector<Bucket> buckets;
+			double communicationTime;
+			unsigned long long bytesSent;
+		};
+	}
+}
@@ -0,0 +1,238 @@
+#include "GradientCompressor.h"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Must match the defines of GradientCompression.cl
+		const int COMPRESSION_WORK_GROUP_SIZE = 256;
+		const size_t TOPK_BINS = 1024;
+
+		static cl::NDRange RoundUp(const size_t size, const size_t workGroupSize)
+		{
+			return cl::NDRange(((size + workGroupSize - 1) / workGroupSize) * workGroupSize);
+		}
+
+		GradientCompressor::GradientCompressor(BackendSystem::OpenCLBackend& backend, const GradientCompression mode, const float density) :
+			backend(backend), mode(mode), density(density), weight(1.f), numProcesses(0), parameters()
+		{
+		}
+
+		void GradientCompressor::AddParameter(const BufferIdx gradient, const BufferIdx residual, const size_t size)
+		{
+			Parameter parameter;
+			parameter.gradient = gradient;
+			parameter.residual = residual;
+			parameter.size = size;
+			parameter.threshold = 0;
+			parameter.numPairs = 0;
+			parameter.scale = 0.f;
+			parameters.push_back(parameter);
+		}
+
+		void GradientCompressor::Initialize(const size_t numProcesses)
+		{
+			if (this->numProcesses != 0)
+				return;
+			this->numProcesses = numProcesses;
+
+			const int WORK_GROUP_SIZE_X = 64;
+			const BackendSystem::MEM_FLAG rw = BackendSystem::MEM_FLAG::READ_WRITE;
+
+			//The operations read host values of the parameters, therefore the vector must not change afterwards.
+			for (size_t i = 0; i < parameters.size(); ++i)
+			{
+				Parameter& p = parameters[i];
+				const int n = static_cast<int>(p.size);
+				if (mode == COMPRESSION_FP16)
+				{
+					p.capacity = p.size;
+					p.compressed = backend.CreateBuffer(p.size * sizeof(cl_half), rw, 1);
+					p.read.resize((p.size + 1) / 2);
+
+					Tuple<BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair> compress(p.gradient, p.compressed, std::pair<size_t, const float*>(sizeof(float), &weight), dataPair(sizeof(int), n));
+					p.compressOp = backend.AddStandaloneOperation<4, BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair>(backend.GetKernelIdx("CompressHalf"), compress, cl::NullRange, RoundUp(p.size, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X));
+					Tuple<BufferIdx, BufferIdx, dataPair> decompress(p.compressed, p.gradient, dataPair(sizeof(int), n));
+					p.decompressOp = backend.AddStandaloneOperation<3, BufferIdx, BufferIdx, dataPair>(backend.GetKernelIdx("DecompressHalf"), decompress, cl::NullRange, RoundUp(p.size, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X));
+				}
+				else if (mode == COMPRESSION_TOPK)
+				{
+					//Twice the number of values are selected at most, since the threshold is only found up to the width of a bin.
+					p.capacity = std::min(p.size, 2 * static_cast<size_t>(std::ceil(density * p.size)));
+					p.compressed = backend.CreateBuffer((1 + 2 * p.capacity) * sizeof(unsigned int), rw, 1);
+					p.histogram = backend.CreateBuffer(TOPK_BINS * sizeof(unsigned int), rw, 1);
+					p.received = backend.CreateBuffer(2 * numProcesses * p.capacity * sizeof(unsigned int), rw, 1);
+					backend.ResetBuffer(p.histogram, TOPK_BINS * sizeof(unsigned int));
+					p.read.resize(std::max(TOPK_BINS, 1 + 2 * p.capacity));
+					p.upload.resize(2 * numProcesses * p.capacity);
+
+					Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair> histogram(p.gradient, p.residual, p.histogram, p.compressed,
+						std::pair<size_t, const float*>(sizeof(float), &weight), dataPair(sizeof(int), n));
+					p.compressOp = backend.AddStandaloneOperation<6, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair>(backend.GetKernelIdx("TopKHistogram"), histogram, cl::NullRange,
+						RoundUp(p.size, COMPRESSION_WORK_GROUP_SIZE), cl::NDRange(COMPRESSION_WORK_GROUP_SIZE));
+					Tuple<BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, const int*>, dataPair, dataPair> select(p.residual, p.histogram, p.compressed,
+						std::pair<size_t, const int*>(sizeof(int), &p.threshold), dataPair(sizeof(int), static_cast<int>(p.capacity)), dataPair(sizeof(int), n));
+					p.finishOp = backend.AddStandaloneOperation<6, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, const int*>, dataPair, dataPair>(backend.GetKernelIdx("TopKSelect"), select, cl::NullRange,
+						RoundUp(std::max(p.size, TOPK_BINS), WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X));
+					Tuple<BufferIdx, dataPair> zero(p.gradient, dataPair(sizeof(int), n));
+					p.zeroOp = backend.AddStandaloneOperation<2, BufferIdx, dataPair>(backend.GetKernelIdx("SetZero"), zero, cl::NullRange, RoundUp(p.size, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X));
+					Tuple<BufferIdx, BufferIdx, std::pair<size_t, const int*>> scatter(p.received, p.gradient, std::pair<size_t, const int*>(sizeof(int), &p.numPairs));
+					p.decompressOp = backend.AddStandaloneOperation<3, BufferIdx, BufferIdx, std::pair<size_t, const int*>>(backend.GetKernelIdx("ScatterAdd"), scatter, cl::NullRange,
+						RoundUp(numProcesses * p.capacity, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X));
+				}
+				else if (mode == COMPRESSION_SIGN)
+				{
+					//Each work group packs the signs of COMPRESSION_WORK_GROUP_SIZE * 32 values.
+					p.capacity = (p.size + 31) / 32;
+					p.numGroups = (p.capacity + COMPRESSION_WORK_GROUP_SIZE - 1) / COMPRESSION_WORK_GROUP_SIZE;
+					p.compressed = backend.CreateBuffer(p.capacity * sizeof(unsigned int), rw, 1);
+					p.histogram = backend.CreateBuffer(p.numGroups * sizeof(float), rw, 1);
+					p.received = backend.CreateBuffer(numProcesses * p.capacity * sizeof(unsigned int), rw, 1);
+					p.scales = backend.CreateBuffer(numProcesses * sizeof(float), rw, 1);
+					p.read.resize(p.capacity + p.numGroups);
+					p.upload.resize(numProcesses * p.capacity);
+					p.uploadScales.resize(numProcesses);
+
+					Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair> compress(p.gradient, p.residual, p.compressed, p.histogram,
+						std::pair<size_t, const float*>(sizeof(float), &weight), dataPair(sizeof(int), n));
+					p.compressOp = backend.AddStandaloneOperation<6, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair>(backend.GetKernelIdx("SignCompress"), compress, cl::NullRange,
+						cl::NDRange(p.numGroups * COMPRESSION_WORK_GROUP_SIZE), cl::NDRange(COMPRESSION_WORK_GROUP_SIZE));
+					Tuple<BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair> feedback(p.residual, p.compressed, std::pair<size_t, const float*>(sizeof(float), &p.scale), dataPair(sizeof(int), n));
+					p.finishOp = backend.AddStandaloneOperation<4, BufferIdx, BufferIdx, std::pair<size_t, const float*>, dataPair>(backend.GetKernelIdx("SignFeedback"), feedback, cl::NullRange,
+						RoundUp(p.size, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X));
+					Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> decompress(p.received, p.scales, p.gradient,
+						dataPair(sizeof(int), static_cast<int>(numProcesses)), dataPair(sizeof(int), static_cast<int>(p.capacity)), dataPair(sizeof(int), n));
+					p.decompressOp = backend.AddStandaloneOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(backend.GetKernelIdx("SignDecompress"), decompress, cl::NullRange,
+						RoundUp(p.size, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X));
+				}
+			}
+		}
+
+		void GradientCompressor::Compress(const size_t parameter, const cl::Event* waitEvent, cl::Event* readEvent)
+		{
+			Parameter& p = parameters[parameter];
+			backend.RunOperation(p.compressOp, waitEvent, nullptr);
+
+			//The reads follow the compression in the download queue.
+			if (mode == COMPRESSION_FP16)
+				backend.ReadDataBufferAsync(p.compressed, p.read.data(), 0, p.size * sizeof(cl_half), nullptr, readEvent);
+			else if (mode == COMPRESSION_TOPK)
+				backend.ReadDataBufferAsync(p.histogram, p.read.data(), 0, TOPK_BINS * sizeof(unsigned int), nullptr, readEvent);
+			else
+			{
+				backend.ReadDataBufferAsync(p.compressed, p.read.data(), 0, p.capacity * sizeof(unsigned int), nullptr, nullptr);
+				backend.ReadDataBufferAsync(p.histogram, p.read.data() + p.capacity, 0, p.numGroups * sizeof(float), nullptr, readEvent);
+			}
+		}
+
+		void GradientCompressor::Finish(const size_t parameter, std::vector<char>& message)
+		{
+			Parameter& p = parameters[parameter];
+			const char* read = reinterpret_cast<const char*>(p.read.data());
+			if (mode == COMPRESSION_FP16)
+			{
+				message.insert(message.end(), read, read + p.size * sizeof(cl_half));
+			}
+			else if (mode == COMPRESSION_TOPK)
+			{
+				//The threshold is the highest bin for which the bins above contain at least k values.
+				const size_t k = std::max<size_t>(1, static_cast<size_t>(std::ceil(density * p.size)));
+				size_t count = 0;
+				p.threshold = static_cast<int>(TOPK_BINS) - 1;
+				for (; p.threshold > 0; --p.threshold)
+				{
+					count += p.read[p.threshold];
+					if (count >= k)
+						break;
+				}
+
+				cl::Event selectEvent;
+				backend.RunOperation(p.finishOp, nullptr, nullptr);
+				backend.ReadDataBufferAsync(p.compressed, p.read.data(), 0, (1 + 2 * p.capacity) * sizeof(unsigned int), nullptr, &selectEvent);
+				selectEvent.wait();
+
+				//Number of values followed by their indices and values
+				const unsigned int numSelected = std::min<unsigned int>(p.read[0], static_cast<unsigned int>(p.capacity));
+				message.insert(message.end(), reinterpret_cast<const char*>(&numSelected), reinterpret_cast<const char*>(&numSelected) + sizeof(unsigned int));
+				message.insert(message.end(), read + sizeof(unsigned int), read + (1 + numSelected) * sizeof(unsigned int));
+				message.insert(message.end(), read + (1 + p.capacity) * sizeof(unsigned int), read + (1 + p.capacity + numSelected) * sizeof(unsigned int));
+			}
+			else if (mode == COMPRESSION_SIGN)
+			{
+				//The scale is the mean magnitude. The residual keeps the difference to the scaled signs.
+				const float* partialSums = reinterpret_cast<const float*>(p.read.data() + p.capacity);
+				double sum = 0.0;
+				for (size_t i = 0; i < p.numGroups; ++i)
+					sum += partialSums[i];
+				p.scale = static_cast<float>(sum / static_cast<double>(p.size));
+				backend.RunOperation(p.finishOp, nullptr, nullptr);
+
+				message.insert(message.end(), reinterpret_cast<const char*>(&p.scale), reinterpret_cast<const char*>(&p.scale) + sizeof(float));
+				message.insert(message.end(), read, read + p.capacity * sizeof(unsigned int));
+			}
+		}
+
+		size_t GradientCompressor::GetPartSize(const size_t parameter, const char* data) const
+		{
+			const Parameter& p = parameters[parameter];
+			if (mode == COMPRESSION_FP16)
+				return p.size * sizeof(cl_half);
+			if (mode == COMPRESSION_SIGN)
+				return sizeof(float) + p.capacity * sizeof(unsigned int);
+
+			unsigned int numSelected;
+			std::memcpy(&numSelected, data, sizeof(unsigned int));
+			return (1 + 2 * static_cast<size_t>(numSelected)) * sizeof(unsigned int);
+		}
+
+		void GradientCompressor::Decompress(const size_t parameter, const std::vector<const char*>& parts, cl::Event* event)
+		{
+			Parameter& p = parameters[parameter];
+			cl::Event uploadEvent;
+			if (mode == COMPRESSION_FP16)
+			{
+				backend.WriteDataBufferAsync(p.compressed, parts[0], 0, p.size * sizeof(cl_half), nullptr, &uploadEvent);
+				backend.RunOperation(p.decompressOp, &uploadEvent, event);
+			}
+			else if (mode == COMPRESSION_TOPK)
+			{
+				//The indices of all processes are followed by their values.
+				p.numPairs = 0;
+				for (size_t i = 0; i < parts.size(); ++i)
+				{
+					unsigned int numSelected;
+					std::memcpy(&numSelected, parts[i], sizeof(unsigned int));
+					numSelected = std::min<unsigned int>(numSelected, static_cast<unsigned int>(p.capacity));
+					std::memcpy(p.upload.data() + p.numPairs, parts[i] + sizeof(unsigned int), numSelected * sizeof(unsigned int));
+					std::memcpy(p.upload.data() + numProcesses * p.capacity + p.numPairs, parts[i] + (1 + numSelected) * sizeof(unsigned int), numSelected * sizeof(unsigned int));
+					p.numPairs += static_cast<int>(numSelected);
+				}
+				std::memmove(p.upload.data() + p.numPairs, p.upload.data() + numProcesses * p.capacity, p.numPairs * sizeof(unsigned int));
+
+				backend.RunOperation(p.zeroOp, nullptr, p.numPairs == 0 ? event : nullptr);
+				if (p.numPairs > 0)
+				{
+					backend.WriteDataBufferAsync(p.received, p.upload.data(), 0, 2 * p.numPairs * sizeof(unsigned int), nullptr, &uploadEvent);
+					backend.RunOperation(p.decompressOp, &uploadEvent, event);
+				}
+			}
+			else if (mode == COMPRESSION_SIGN)
+			{
+				for (size_t i = 0; i < parts.size(); ++i)
+				{
+					std::memcpy(&p.uploadScales[i], parts[i], sizeof(float));
+					std::memcpy(p.upload.data() + i * p.capacity, parts[i] + sizeof(float), p.capacity * sizeof(unsigned int));
+				}
+
+				//The upload queue is in order, therefore the decompression only waits for the second upload.
+				backend.WriteDataBufferAsync(p.received, p.upload.data(), 0, p.upload.size() * sizeof(unsigned int), nullptr, nullptr);
+				backend.WriteDataBufferAsync(p.scales, p.uploadScales.data(), 0, p.uploadScales.size() * sizeof(float), nullptr, &uploadEvent);
+				backend.RunOperation(p.decompressOp, &uploadEvent, event);
+			}
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "OpenCLBackend.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Compression of the parameter gradients exchanged between processes (See DistributedTrainer).
+		enum GradientCompression
+		{
+			COMPRESSION_NONE,
+			COMPRESSION_FP16, //The gradients are sent as half and summed in float
+			COMPRESSION_TOPK, //Only the values with the largest magnitude are sent
+			COMPRESSION_SIGN //Only the signs and the mean magnitude of each gradient are sent
+		};
+
+		//Compresses the parameter gradients on the device before they are read and decompresses the exchanged gradients on the device.
+		//The kernels run in the download queue, therefore a gradient is compressed as soon as it is complete while the backward pass continues.
+		//Top-k and sign compression add the part of a gradient which was not sent to the gradient of the next step (Error feedback).
+		//This residual is stored in an additional auxiliary buffer of each parameter buffer.
+		class GradientCompressor
+		{
+		public:
+			//density is the fraction of the values of a gradient sent by top-k compression.
+			GradientCompressor(BackendSystem::OpenCLBackend& backend, const GradientCompression mode, const float density);
+
+			//Adds a parameter. residual is the auxiliary buffer storing the error feedback (Not used by fp16).
+			void AddParameter(const BufferIdx gradient, const BufferIdx residual, const size_t size);
+			//Creates the buffers and operations of all parameters. Must be called once after all parameters were added.
+			void Initialize(const size_t numProcesses);
+
+			GradientCompression GetMode() const { return mode; }
+			//Returns true if the compressed gradients of all processes are collected and decompressed together (Top-k and sign). fp16 gradients are summed while they are exchanged.
+			bool Gathers() const { return mode == COMPRESSION_TOPK || mode == COMPRESSION_SIGN; }
+			//Sets the factor the gradients are multiplied with by the following calls of Compress.
+			void SetWeight(const float weight) { this->weight = weight; }
+
+			//Enqueues the compression of the gradient after waitEvent finished and the read of the result.
+			void Compress(const size_t parameter, const cl::Event* waitEvent, cl::Event* readEvent);
+			//Appends the compressed gradient to message. The read of Compress must have finished.
+			void Finish(const size_t parameter, std::vector<char>& message);
+			//Returns the size of the compressed gradient of the parameter starting at data.
+			size_t GetPartSize(const size_t parameter, const char* data) const;
+			//Uploads the compressed gradients of all processes (Top-k and sign) or their sum (fp16) and enqueues the decompression into the gradient buffer.
+			//event finishes once the gradient was written. The parts must stay valid until then.
+			void Decompress(const size_t parameter, const std::vector<const char*>& parts, cl::Event* event);
+
+		private:
+			GradientCompressor(const GradientCompressor& other);
+			const GradientCompressor& operator=(const GradientCompressor& other);
+
+			struct Parameter
+			{
+				BufferIdx gradient;
+				BufferIdx residual;
+				size_t size;
+				size_t capacity; //Top-k: Maximal number of values sent. Sign: Number of words storing the signs
+				size_t numGroups; //Sign: Number of work groups of the compression
+
+				BufferIdx compressed; //Half values, selected values or signs
+				BufferIdx histogram; //Top-k: Histogram of the magnitudes. Sign: Sum of the magnitudes of each work group
+				BufferIdx received; //Compressed gradients of all processes
+				BufferIdx scales; //Sign: Scale of each process
+
+				OperationIdx compressOp;
+				OperationIdx finishOp; //Top-k: Selection. Sign: Update of the residual
+				OperationIdx zeroOp;
+				OperationIdx decompressOp;
+
+				std::vector<unsigned int> read; //Results read by Compress and Finish
+				std::vector<unsigned int> upload; //Compressed gradients of all processes
+				std::vector<float> uploadScales;
+
+				//Host values read by the operations each time they are executed
+				int threshold;
+				int numPairs;
+				float scale;
+			};
+
+			BackendSystem::OpenCLBackend& backend;
+			GradientCompression mode;
+			float density;
+			float weight;
+			size_t numProcesses;
+			std::vector<Parameter> parameters;
+		};
+	}
+}
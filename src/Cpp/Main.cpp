@@ -1,218 +1,541 @@
-#include <CL\cl.hpp>
-#include <fstream>
-
-#include "NeuralNetwork.h"
-#include "TestOperations.h"
-#include "BatchManager.h"
-
-using namespace DeepCL;
-
-int main(void)
-{
-	const int BATCH_SIZE = 100;
-
-	// LeNet:
-
-
-	NNSystem::NeuralNetwork nnTest;
-	DeepCLError error = nnTest.InitSystem();
-	if (error != 0) {
-		std::cout << "Error encountered in Init System!" << std::endl << "Error Code: " << error;
-		return 0;
-	}
-	// Parameters:
-	//The input variables of the Neural Network
-	//Input image
-	NNBufferIdx i = nnTest.CreateInputBuffer(28, 28, 1);
-	//Label
-	NNBufferIdx l = nnTest.CreateInputBuffer(1);
-
-	//The parameters of the Convolutional Neural Network
-	NNBufferIdx wc1 = nnTest.CreateParameterBuffer(3, 3, 1, 32);
-	NNBufferIdx bc1 = nnTest.CreateParameterBuffer(32);
-	NNBufferIdx wc2 = nnTest.CreateParameterBuffer(3, 3, 32, 64);
-	NNBufferIdx bc2 = nnTest.CreateParameterBuffer(64);
-
-	//The parameters of the fully connected layers.
-	//The complete output volume must be reduced to a fixed number of Neurons. 
-	//This results in a relatively big matrix multiplication if the image is bigger.
-	NNBufferIdx wf1 = nnTest.CreateParameterBuffer(1024, 7*7*64);
-	NNBufferIdx bf1 = nnTest.CreateParameterBuffer(1024);
-	NNBufferIdx wf2 = nnTest.CreateParameterBuffer(10, 1024);
-	NNBufferIdx bf2 = nnTest.CreateParameterBuffer(10);
-	
-	// Modell:
-	
-	//First convolutional Layer with ReLU activation function
-	NNBufferIdx hPreBias = OP::Conv2d(i, wc1, 1);
-	NNBufferIdx hconv1 = OP::ReLU(OP::AddBiasConv(hPreBias, bc1));
-	//First maxpooling
-	NNBufferIdx hpool1 = OP::MaxPooling(hconv1, 0, 0, 2, 2);
-	
-	//Second convolutional Layer with ReLU activation function
-	NNBufferIdx hPreBias2 = OP::Conv2d(hpool1, wc2, 1);
-	NNBufferIdx hconv2Tmp = OP::AddBiasConv(hPreBias2, bc2);
-	NNBufferIdx hconv2 = OP::ReLU(hconv2Tmp);
-	//Second maxpooling
-	NNBufferIdx hpool2 = OP::MaxPooling(hconv2, 0, 0, 2, 2);
-
-	//First fully connected layer. The image must be flattened too an 1D array. This is done automatically in MultiplyFlattened.
-	NNBufferIdx hf1tmp = OP::MultiplyFlattened(hpool2, wf1);
-	NNBufferIdx hf1tmptmp = OP::AddBias(hf1tmp, bf1);
-	NNBufferIdx hf1 = OP::ReLU(hf1tmptmp);
-
-	//Second fully connected layer
-	NNBufferIdx hf2tmp = OP::Multiply(hf1, wf2);
-	NNBufferIdx hf2tmptmp = OP::AddBias(hf2tmp, bf2);
-	NNBufferIdx hf2 = hf2tmptmp;
-
-	//Softmax function
-	NNBufferIdx soft = OP::Softmax(hf2);
-
-	//Application of the Cross Entropy loss.
-	NNBufferIdx loss = OP::CrossEntropy(soft, l);
-
-	//Used for storing the model (Unnecessary for the current model)
-	std::map<NNBufferIdx, char*> parameterBufferMap;
-	//Add the index of the buffer and a name which should be used to store/load the model.
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wc1, "wc1"));
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wc2, "wc2"));
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wf1, "wf1"));
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wf1, "wf1"));
-
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bc1, "bc1"));
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bc1, "bc2"));
-
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bf1, "bf1"));
-	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bf1, "bf2"));
-
-	
-	//Create a loader for the MNIST dataset.
-	//This must contain the relative or absolute path of the training files of the MNIST dataset.
-	DataSystem::IDXReader idxReader("./train-images.idx3-ubyte", "./train-labels.idx1-ubyte", BATCH_SIZE);
-	//Chck for an error during initalization.
-	//If an error occured stop executing the program!
-	if (!idxReader.Initalized())
-		return -1;
-	//Create a Transformer object for the MNIST dataset
-	DataSystem::MNISTTransformer idxTransformer(BATCH_SIZE);
-	//Create the BatchManager for the before created loader and transformer.
-	DataSystem::BatchManager<2, int, float> batchManager(BATCH_SIZE, 1, 25, &idxReader, &idxTransformer);
-	
-	//Do the same to load test examples which will be used to evaluate the performance of the system.
-	//This must contain the relative or absolute path of the test files of the MNIST dataset.
-	DataSystem::IDXReader idxReader2("./t10k-images.idx3-ubyte", "./t10k-labels.idx1-ubyte", BATCH_SIZE);
-	//Chck for an error during initalization.
-	//If an error occured stop executing the program!
-	if (!idxReader2.Initalized())
-		return -1;
-	DataSystem::MNISTTransformer idxTransformer2(BATCH_SIZE);
-	DataSystem::BatchManager<2, int, float> testManager(BATCH_SIZE, 1, 5, &idxReader2, &idxTransformer2);
-	
-	//Use the Adam optimizer as optimizer.
-	nnTest.AddOptimizer(new NNSystem::NNAdam(0.0001f*0.7f, 0.9f, 0.999f, 10e-8f));
-	
-
-	//Init the parameters using truncated normal distributions
-	OP::InitWeightTruncatedNormalRnd(wc1, 0.0f, 0.1f);
-	OP::InitWeightTruncatedNormalRnd(wc2, 0.0f, 0.1f);
-	OP::InitWeightTruncatedNormalRnd(wf1, 0.0f, 0.1f);
-	OP::InitWeightTruncatedNormalRnd(wf2, 0.0f, 0.1f);
-	
-	//Init the bias parameters with zero.
-	OP::InitWeightUniform(bc1, 0.0f);
-	OP::InitWeightUniform(bc2, 0.0f);
-	OP::InitWeightUniform(bf1, 0.0f);
-	OP::InitWeightUniform(bf2, 0.0f);
-	
-	//Initalize the graph.
-	nnTest.InitliazeGraph(BATCH_SIZE);
-	
-	//Temporary variable for loading the softmax results of a batch into host memory.
-	float* results = new float[10 * BATCH_SIZE];
-	
-	
-	//List of buffers into which the data should be loaded.
-	std::vector<NNBufferIdx> buffer;
-	buffer.push_back(l);
-	buffer.push_back(i);
-
-	std::cout << "Start training" << std::endl;
-	
-	//Training should reach something around 99%
-	for (int c = 0; c <= 40000; ++c)
-	{
-		//Query batch
-		DataSystem::Batch<int, float>* batch = batchManager.GetBatch();
-		
-		//Perform the forward path using the data in the batch->data element.
-		nnTest.Forward<int, float>(BackendSystem::get<0>(batch->data), BackendSystem::get<1>(batch->data), buffer, batch->sizes, batch->batchSize);
-		//Perform the backward path calculating the gradients with respect to the parameters. Uses the results of the last call of forward.
-		nnTest.Backward();
-
-		//Perform parameter update step and perform clean up.
-		nnTest.BatchDone();
-
-		//Calculates the accuracy on a test set every 20 steps.
-		if (c % 20 == 0 && c != 0)
-		{
-
-			size_t numTest = 1000;
-
-			//At step 500 the model will be tested on 10000 examples.
-			size_t pointOfFullTest = 500;
-			if ((c % pointOfFullTest) == 0 && c != 0)
-			{
-				numTest = 10000;
-			}
-
-			size_t numCorrect = 0;
-
-			//Perform all necessary steps.
-			for (size_t j = 0; j < numTest; j += BATCH_SIZE)
-			{
-				//Read test batch.
-				DataSystem::Batch<int, float>* testBatch = testManager.GetBatch();
-				//Perform only the forward pass.
-				nnTest.Forward<int, float>(BackendSystem::get<0>(testBatch->data), BackendSystem::get<1>(testBatch->data), buffer, testBatch->sizes, testBatch->batchSize);
-
-				//Store the softmax results and the label.
-				int* label = BackendSystem::get<0>(testBatch->data).data();
-				nnTest.ReadDataBuffer(soft, results);
-
-				//Calculate if the NN computed the right result.
-				for (int i = 0; i < BATCH_SIZE; ++i)
-				{
-					int maxProp = 0;
-					float currentProp = 0;
-					for (int x = 0; x < 10; ++x)
-					{
-						if (currentProp < results[i * 10 + x])
-						{
-							maxProp = x;
-							currentProp = results[i * 10 + x];
-						}
-					}
-
-					//If the result of the NN is correct increase the number of correct examples by one.
-					if (label[i] == maxProp)
-						++numCorrect;
-				}
-			}
-
-			//Calculate the accuracy by divinding the number of correct examples by the number of total examples.
-			int realNum = ((numTest + BATCH_SIZE - 1) / BATCH_SIZE)*BATCH_SIZE;
-			if (c % pointOfFullTest == 0 && c != 0)
-			{
-				std::cout << std::endl << "Test Correct(Full Test Batch): " << static_cast<float>(numCorrect) / static_cast<float>(realNum) << " at Step " << c << std::endl << std::endl;
-			}
-			else
-				std::cout << "Test Correct: " << static_cast<float>(numCorrect) / static_cast<float>(realNum) << " at Step " << c << std::endl;
-		}
-	}
-
-	delete[] results;
-
-	system("PAUSE");
-	return 0;
+#include <CL\cl.hpp>
+#include <fstream>
+
+#include "NeuralNetwork.h"
+#include "TestOperations.h"
+#include "BatchManager.h"
+#include "DistributedTrainer.h"
+
+#include <random>
+#include <chrono>
+#include <sstream>
+
+using namespace DeepCL;
+
+//Creates the parameters and the graph of a model used by the distributed benchmarks and returns the output before the softmax.
+static NNBufferIdx CreateBenchmarkModel(NNSystem::NeuralNetwork& nn, const std::string& model, const NNBufferIdx i, std::vector<NNBufferIdx>& weights, std::vector<NNBufferIdx>& biases)
+{
+	if (model == "mlp")
+	{
+		//Fully connected network with about 20 million parameters. The communication is dominated by the size of the gradients.
+		weights.push_back(nn.CreateParameterBuffer(4096, 28 * 28));
+		biases.push_back(nn.CreateParameterBuffer(4096));
+		weights.push_back(nn.CreateParameterBuffer(4096, 4096));
+		biases.push_back(nn.CreateParameterBuffer(4096));
+		weights.push_back(nn.CreateParameterBuffer(10, 4096));
+		biases.push_back(nn.CreateParameterBuffer(10));
+
+		NNBufferIdx h1 = OP::ReLU(OP::AddBias(OP::MultiplyFlattened(i, weights[0]), biases[0]));
+		NNBufferIdx h2 = OP::ReLU(OP::AddBias(OP::Multiply(h1, weights[1]), biases[1]));
+		return OP::AddBias(OP::Multiply(h2, weights[2]), biases[2]);
+	}
+
+	//LeNet of the example
+	weights.push_back(nn.CreateParameterBuffer(3, 3, 1, 32));
+	biases.push_back(nn.CreateParameterBuffer(32));
+	weights.push_back(nn.CreateParameterBuffer(3, 3, 32, 64));
+	biases.push_back(nn.CreateParameterBuffer(64));
+	weights.push_back(nn.CreateParameterBuffer(1024, 7 * 7 * 64));
+	biases.push_back(nn.CreateParameterBuffer(1024));
+	weights.push_back(nn.CreateParameterBuffer(10, 1024));
+	biases.push_back(nn.CreateParameterBuffer(10));
+
+	NNBufferIdx hpool1 = OP::MaxPooling(OP::ReLU(OP::AddBiasConv(OP::Conv2d(i, weights[0], 1), biases[0])), 0, 0, 2, 2);
+	NNBufferIdx hpool2 = OP::MaxPooling(OP::ReLU(OP::AddBiasConv(OP::Conv2d(hpool1, weights[1], 1), biases[1])), 0, 0, 2, 2);
+	NNBufferIdx hf1 = OP::ReLU(OP::AddBias(OP::MultiplyFlattened(hpool2, weights[2]), biases[2]));
+	return OP::AddBias(OP::Multiply(hf1, weights[3]), biases[3]);
+}
+
+static NNSystem::GradientCompression ParseCompression(const std::string& name)
+{
+	if (name == "fp16")
+		return NNSystem::COMPRESSION_FP16;
+	if (name == "topk")
+		return NNSystem::COMPRESSION_TOPK;
+	if (name == "sign")
+		return NNSystem::COMPRESSION_SIGN;
+	return NNSystem::COMPRESSION_NONE;
+}
+
+//Measures the scaling of the distributed training on synthetic data. Each process is started with
+//	DeepCL distributed <rank> <host:port,host:port,...> [lenet|mlp] [device] [steps] [none|fp16|topk|sign] [density]
+//using the same host list, for example for two processes on one machine:
+//	DeepCL distributed 0 127.0.0.1:5000,127.0.0.1:5001
+//	DeepCL distributed 1 127.0.0.1:5000,127.0.0.1:5001
+//The efficiency is the time of a step of a single process divided by the time of a distributed step (Each process uses its own batch of the same size).
+//The bytes of a step are the bytes each process sent to the next one.
+int RunDistributedBenchmark(int argc, char** argv)
+{
+	const int BATCH_SIZE = 100;
+	if (argc < 4)
+	{
+		std::cout << "Usage: DeepCL distributed <rank> <host:port,host:port,...> [lenet|mlp] [device] [steps] [none|fp16|topk|sign] [density]" << std::endl;
+		return -1;
+	}
+
+	const size_t rank = std::stoul(argv[2]);
+	std::vector<std::string> hosts;
+	std::istringstream hostList(argv[3]);
+	for (std::string host; std::getline(hostList, host, ',');)
+		hosts.push_back(host);
+	const std::string model = argc > 4 ? argv[4] : "lenet";
+	const size_t deviceIdx = argc > 5 ? std::stoul(argv[5]) : 0;
+	const int numSteps = argc > 6 ? std::stoi(argv[6]) : 100;
+	const std::string compression = argc > 7 ? argv[7] : "none";
+	const float density = argc > 8 ? std::stof(argv[8]) : 0.01f;
+
+	std::vector<cl::Device> devices = BackendSystem::OpenCLBackend::GetDevices();
+	if (deviceIdx >= devices.size())
+	{
+		std::cout << "Error device " << deviceIdx << " does not exist!" << std::endl;
+		return -1;
+	}
+
+	NNSystem::NeuralNetwork nn;
+	DeepCLError error = nn.InitSystem(devices[deviceIdx]);
+	if (error != 0)
+	{
+		std::cout << "Error encountered in Init System!" << std::endl << "Error Code: " << error;
+		return -1;
+	}
+
+	//The images are uploaded as bytes and scaled to [0, 1] on the device.
+	NNBufferIdx i = nn.CreateInputBuffer(28, 28, 1, 1, 1, 1, NNSystem::INPUT_UINT8);
+	NNBufferIdx l = nn.CreateInputBuffer(1);
+	std::vector<NNBufferIdx> weights;
+	std::vector<NNBufferIdx> biases;
+	NNBufferIdx out = CreateBenchmarkModel(nn, model, OP::Dequantize(i, 1.f / 255.f), weights, biases);
+	OP::CrossEntropy(OP::Softmax(out), l);
+
+	nn.AddOptimizer(new NNSystem::NNAdam(0.0001f*0.7f, 0.9f, 0.999f, 10e-8f));
+	for (size_t w = 0; w < weights.size(); ++w)
+	{
+		OP::InitWeightTruncatedNormalRnd(weights[w], 0.0f, 0.1f);
+		OP::InitWeightUniform(biases[w], 0.0f);
+	}
+	nn.SetGradientCompression(ParseCompression(compression), density);
+	nn.InitliazeGraph(BATCH_SIZE);
+
+	//Synthetic batch. Only the time of a step is measured, therefore the values don't matter.
+	std::mt19937 generator(static_cast<unsigned int>(rank));
+	std::vector<int> labels(BATCH_SIZE);
+	std::vector<unsigned char> images(BATCH_SIZE * 28 * 28);
+	for (size_t j = 0; j < labels.size(); ++j)
+		labels[j] = static_cast<int>(generator() % 10);
+	for (size_t j = 0; j < images.size(); ++j)
+		images[j] = static_cast<unsigned char>(generator() % 256);
+	std::vector<NNBufferIdx> buffer;
+	buffer.push_back(l);
+	buffer.push_back(i);
+	std::vector<NNSystem::SizeVec> sizes;
+	sizes.push_back(NNSystem::SizeVec(1));
+	sizes.push_back(NNSystem::SizeVec(28, 28, 1));
+
+	NNSystem::DistributedTrainer trainer(nn);
+	error = trainer.Connect(hosts, rank, 600);
+	if (error != 0)
+	{
+		std::cout << "Error connecting the processes!" << std::endl << "Error Code: " << error;
+		return -1;
+	}
+	NNSystem::RingCommunicator& ring = trainer.GetCommunicator();
+	float barrier = 0.f;
+
+	//Time of a step without communication. The processes measure one after another while the others wait in the all-reduce,
+	//therefore a process measured alone does not share the device or the machine with the other processes.
+	double singleTime = 0.0;
+	for (size_t r = 0; r < hosts.size(); ++r)
+	{
+		if (r == rank)
+		{
+			for (int s = 0; s < numSteps + 5; ++s)
+			{
+				//The first steps are not measured.
+				if (s == 5)
+					singleTime = -std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+				nn.Forward<int, unsigned char>(labels, images, buffer, sizes, BATCH_SIZE);
+				nn.Backward();
+				nn.Step();
+			}
+			singleTime += std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			singleTime /= numSteps;
+		}
+		ring.AllReduce(&barrier, 1);
+	}
+
+	double distributedTime = 0.0;
+	double communicationTime = 0.0;
+	double bytesSent = 0.0;
+	for (int s = 0; s < numSteps + 5; ++s)
+	{
+		if (s == 5)
+		{
+			ring.AllReduce(&barrier, 1);
+			distributedTime = -std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+		error = trainer.TrainingStep<int, unsigned char>(labels, images, buffer, sizes, BATCH_SIZE);
+		if (error != 0)
+		{
+			std::cout << "Error in the distributed step!" << std::endl << "Error Code: " << error;
+			return -1;
+		}
+		if (s >= 5)
+		{
+			communicationTime += trainer.GetCommunicationTime();
+			bytesSent += static_cast<double>(trainer.GetBytesSent());
+		}
+	}
+	distributedTime += std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	distributedTime /= numSteps;
+	communicationTime /= numSteps;
+	bytesSent /= numSteps;
+
+	//Mean over all processes
+	float times[4] = { static_cast<float>(singleTime), static_cast<float>(distributedTime), static_cast<float>(communicationTime), static_cast<float>(bytesSent) };
+	ring.AllReduce(times, 4);
+	if (rank == 0)
+	{
+		const float numProcesses = static_cast<float>(hosts.size());
+		for (size_t t = 0; t < 4; ++t)
+			times[t] /= numProcesses;
+		std::cout << "Model: " << model << ", processes: " << hosts.size() << ", buckets: " << trainer.GetNumBuckets() << ", compression: " << compression << std::endl;
+		std::cout << "Single process step: " << times[0] * 1000.f << " ms (" << BATCH_SIZE / times[0] << " examples/s)" << std::endl;
+		std::cout << "Distributed step: " << times[1] * 1000.f << " ms (" << numProcesses * BATCH_SIZE / times[1] << " examples/s), all-reduce wait: " << times[2] * 1000.f << " ms" << std::endl;
+		std::cout << "Scaling efficiency: " << times[0] / times[1] * 100.f << "%" << std::endl;
+		std::cout << "Sent per step and process: " << times[3] / (1024.f * 1024.f) << " MB" << std::endl;
+	}
+	return 0;
+}
+
+//Measures the time to accuracy of the distributed training of LeNet on MNIST with a gradient compression. Each process is started with
+//	DeepCL distributed-mnist <rank> <host:port,host:port,...> [none|fp16|topk|sign] [device] [accuracy] [density]
+//The processes train on their own batches. The first process tests the model on the 10000 test examples every 100 steps and stops the training
+//once the accuracy is reached. The time does not include the tests.
+int RunTimeToAccuracy(int argc, char** argv)
+{
+	const int BATCH_SIZE = 100;
+	const int TEST_INTERVAL = 100;
+	const int MAX_STEPS = 40000;
+	if (argc < 4)
+	{
+		std::cout << "Usage: DeepCL distributed-mnist <rank> <host:port,host:port,...> [none|fp16|topk|sign] [device] [accuracy] [density]" << std::endl;
+		return -1;
+	}
+
+	const size_t rank = std::stoul(argv[2]);
+	std::vector<std::string> hosts;
+	std::istringstream hostList(argv[3]);
+	for (std::string host; std::getline(hostList, host, ',');)
+		hosts.push_back(host);
+	const std::string compression = argc > 4 ? argv[4] : "none";
+	const size_t deviceIdx = argc > 5 ? std::stoul(argv[5]) : 0;
+	const float targetAccuracy = argc > 6 ? std::stof(argv[6]) : 0.98f;
+	const float density = argc > 7 ? std::stof(argv[7]) : 0.01f;
+
+	std::vector<cl::Device> devices = BackendSystem::OpenCLBackend::GetDevices();
+	if (deviceIdx >= devices.size())
+	{
+		std::cout << "Error device " << deviceIdx << " does not exist!" << std::endl;
+		return -1;
+	}
+
+	DataSystem::IDXReaderUInt8 idxReader("./train-images.idx3-ubyte", "./train-labels.idx1-ubyte", BATCH_SIZE);
+	if (!idxReader.Initalized())
+		return -1;
+	DataSystem::MNISTTransformerUInt8 idxTransformer(BATCH_SIZE);
+	DataSystem::BatchManager<2, int, unsigned char> batchManager(BATCH_SIZE, 1, 25, &idxReader, &idxTransformer);
+	DataSystem::IDXReaderUInt8 idxReader2("./t10k-images.idx3-ubyte", "./t10k-labels.idx1-ubyte", BATCH_SIZE);
+	if (!idxReader2.Initalized())
+		return -1;
+	DataSystem::MNISTTransformerUInt8 idxTransformer2(BATCH_SIZE);
+	DataSystem::BatchManager<2, int, unsigned char> testManager(BATCH_SIZE, 1, 5, &idxReader2, &idxTransformer2);
+
+	NNSystem::NeuralNetwork nn;
+	DeepCLError error = nn.InitSystem(devices[deviceIdx]);
+	if (error != 0)
+	{
+		std::cout << "Error encountered in Init System!" << std::endl << "Error Code: " << error;
+		return -1;
+	}
+
+	NNBufferIdx i = nn.CreateInputBuffer(28, 28, 1, 1, 1, 1, NNSystem::INPUT_UINT8);
+	NNBufferIdx l = nn.CreateInputBuffer(1);
+	std::vector<NNBufferIdx> weights;
+	std::vector<NNBufferIdx> biases;
+	NNBufferIdx soft = OP::Softmax(CreateBenchmarkModel(nn, "lenet", OP::Dequantize(i, 1.f / 255.f), weights, biases));
+	OP::CrossEntropy(soft, l);
+	NNBufferIdx correct = OP::CountCorrect(soft, l);
+
+	nn.AddOptimizer(new NNSystem::NNAdam(0.0001f*0.7f, 0.9f, 0.999f, 10e-8f));
+	for (size_t w = 0; w < weights.size(); ++w)
+	{
+		OP::InitWeightTruncatedNormalRnd(weights[w], 0.0f, 0.1f);
+		OP::InitWeightUniform(biases[w], 0.0f);
+	}
+	nn.SetGradientCompression(ParseCompression(compression), density);
+	nn.InitliazeGraph(BATCH_SIZE);
+
+	NNSystem::DistributedTrainer trainer(nn);
+	error = trainer.Connect(hosts, rank, 600);
+	if (error != 0)
+	{
+		std::cout << "Error connecting the processes!" << std::endl << "Error Code: " << error;
+		return -1;
+	}
+	NNSystem::RingCommunicator& ring = trainer.GetCommunicator();
+
+	std::vector<NNBufferIdx> buffer;
+	buffer.push_back(l);
+	buffer.push_back(i);
+
+	double trainingTime = 0.0;
+	double bytesSent = 0.0;
+	float accuracy = 0.f;
+	int step = 0;
+	while (step < MAX_STEPS)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int s = 0; s < TEST_INTERVAL; ++s, ++step)
+		{
+			DataSystem::Batch<int, unsigned char>* batch = batchManager.GetBatch();
+			error = trainer.TrainingStep<int, unsigned char>(BackendSystem::get<0>(batch->data), BackendSystem::get<1>(batch->data), buffer, batch->sizes, batch->batchSize);
+			if (error != 0)
+			{
+				std::cout << "Error in the distributed step!" << std::endl << "Error Code: " << error;
+				return -1;
+			}
+			bytesSent += static_cast<double>(trainer.GetBytesSent());
+		}
+		trainingTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		//All processes have the same parameters, therefore the first one tests alone.
+		char done = 0;
+		if (rank == 0)
+		{
+			nn.ResetCorrect();
+			for (size_t j = 0; j < 10000; j += BATCH_SIZE)
+			{
+				DataSystem::Batch<int, unsigned char>* testBatch = testManager.GetBatch();
+				nn.Forward<int, unsigned char>(BackendSystem::get<0>(testBatch->data), BackendSystem::get<1>(testBatch->data), buffer, testBatch->sizes, testBatch->batchSize);
+			}
+			size_t numCorrect = 0;
+			nn.ReadCorrect(correct, numCorrect);
+			accuracy = static_cast<float>(numCorrect) / 10000.f;
+			std::cout << "Test Correct: " << accuracy << " at Step " << step << " after " << trainingTime << " s" << std::endl;
+			done = accuracy >= targetAccuracy ? 1 : 0;
+		}
+		if (!ring.Broadcast(&done, 1))
+			return -1;
+		if (done != 0)
+			break;
+	}
+
+	//Total over all processes
+	float total = static_cast<float>(bytesSent);
+	ring.AllReduce(&total, 1);
+	if (rank == 0)
+	{
+		std::cout << "Compression: " << compression << ", processes: " << hosts.size() << std::endl;
+		std::cout << "Accuracy " << accuracy << " after " << step << " steps and " << trainingTime << " s" << std::endl;
+		std::cout << "Sent by all processes: " << total / (1024.f * 1024.f) << " MB (" << total / (1024.f * 1024.f) / step << " MB per step)" << std::endl;
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1 && std::string(argv[1]) == "distributed")
+		return RunDistributedBenchmark(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "distributed-mnist")
+		return RunTimeToAccuracy(argc, argv);
+
+	const int BATCH_SIZE = 100;
+
+	// LeNet:
+
+
+	NNSystem::NeuralNetwork nnTest;
+	DeepCLError error = nnTest.InitSystem();
+	if (error != 0) {
+		std::cout << "Error encountered in Init System!" << std::endl << "Error Code: " << error;
+		return 0;
+	}
+	// Parameters:
+	//The input variables of the Neural Network
+	//Input image (Two slots allow the next batch to be uploaded while the current one is processed)
+	//The reader delivers the raw bytes of the images, which are uploaded as they are and scaled to [0, 1] on the device.
+	NNBufferIdx i = nnTest.CreateInputBuffer(28, 28, 1, 1, 1, 2, NNSystem::INPUT_UINT8);
+	//Label
+	NNBufferIdx l = nnTest.CreateInputBuffer(1, 1, 1, 1, 1, 2);
+
+	//The parameters of the Convolutional Neural Network
+	NNBufferIdx wc1 = nnTest.CreateParameterBuffer(3, 3, 1, 32);
+	NNBufferIdx bc1 = nnTest.CreateParameterBuffer(32);
+	NNBufferIdx wc2 = nnTest.CreateParameterBuffer(3, 3, 32, 64);
+	NNBufferIdx bc2 = nnTest.CreateParameterBuffer(64);
+
+	//The parameters of the fully connected layers.
+	//The complete output volume must be reduced to a fixed number of Neurons. 
+	//This results in a relatively big matrix multiplication if the image is bigger.
+	NNBufferIdx wf1 = nnTest.CreateParameterBuffer(1024, 7*7*64);
+	NNBufferIdx bf1 = nnTest.CreateParameterBuffer(1024);
+	NNBufferIdx wf2 = nnTest.CreateParameterBuffer(10, 1024);
+	NNBufferIdx bf2 = nnTest.CreateParameterBuffer(10);
+	
+	// Modell:
+	
+	//Conversion of the bytes into float
+	NNBufferIdx image = OP::Dequantize(i, 1.f / 255.f);
+
+	//First convolutional Layer with ReLU activation function
+	NNBufferIdx hPreBias = OP::Conv2d(image, wc1, 1);
+	NNBufferIdx hconv1 = OP::ReLU(OP::AddBiasConv(hPreBias, bc1));
+	//First maxpooling
+	NNBufferIdx hpool1 = OP::MaxPooling(hconv1, 0, 0, 2, 2);
+	
+	//Second convolutional Layer with ReLU activation function
+	NNBufferIdx hPreBias2 = OP::Conv2d(hpool1, wc2, 1);
+	NNBufferIdx hconv2Tmp = OP::AddBiasConv(hPreBias2, bc2);
+	NNBufferIdx hconv2 = OP::ReLU(hconv2Tmp);
+	//Second maxpooling
+	NNBufferIdx hpool2 = OP::MaxPooling(hconv2, 0, 0, 2, 2);
+
+	//First fully connected layer. The image must be flattened too an 1D array. This is done automatically in MultiplyFlattened.
+	NNBufferIdx hf1tmp = OP::MultiplyFlattened(hpool2, wf1);
+	NNBufferIdx hf1tmptmp = OP::AddBias(hf1tmp, bf1);
+	NNBufferIdx hf1 = OP::ReLU(hf1tmptmp);
+
+	//Second fully connected layer
+	NNBufferIdx hf2tmp = OP::Multiply(hf1, wf2);
+	NNBufferIdx hf2tmptmp = OP::AddBias(hf2tmp, bf2);
+	NNBufferIdx hf2 = hf2tmptmp;
+
+	//Softmax function
+	NNBufferIdx soft = OP::Softmax(hf2);
+
+	//Application of the Cross Entropy loss.
+	NNBufferIdx loss = OP::CrossEntropy(soft, l);
+
+	//Counts the correctly classified test examples on the device.
+	NNBufferIdx correct = OP::CountCorrect(soft, l);
+
+	//Used for storing the model (Unnecessary for the current model)
+	std::map<NNBufferIdx, char*> parameterBufferMap;
+	//Add the index of the buffer and a name which should be used to store/load the model.
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wc1, "wc1"));
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wc2, "wc2"));
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wf1, "wf1"));
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(wf2, "wf2"));
+
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bc1, "bc1"));
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bc2, "bc2"));
+
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bf1, "bf1"));
+	parameterBufferMap.insert(std::pair<NNBufferIdx, char*>(bf2, "bf2"));
+
+	
+	//Create a loader for the MNIST dataset.
+	//This must contain the relative or absolute path of the training files of the MNIST dataset.
+	DataSystem::IDXReaderUInt8 idxReader("./train-images.idx3-ubyte", "./train-labels.idx1-ubyte", BATCH_SIZE);
+	//Chck for an error during initalization.
+	//If an error occured stop executing the program!
+	if (!idxReader.Initalized())
+		return -1;
+	//Create a Transformer object for the MNIST dataset
+	DataSystem::MNISTTransformerUInt8 idxTransformer(BATCH_SIZE);
+	//Create the BatchManager for the before created loader and transformer.
+	DataSystem::BatchManager<2, int, unsigned char> batchManager(BATCH_SIZE, 1, 25, &idxReader, &idxTransformer);
+	
+	//Do the same to load test examples which will be used to evaluate the performance of the system.
+	//This must contain the relative or absolute path of the test files of the MNIST dataset.
+	DataSystem::IDXReaderUInt8 idxReader2("./t10k-images.idx3-ubyte", "./t10k-labels.idx1-ubyte", BATCH_SIZE);
+	//Chck for an error during initalization.
+	//If an error occured stop executing the program!
+	if (!idxReader2.Initalized())
+		return -1;
+	DataSystem::MNISTTransformerUInt8 idxTransformer2(BATCH_SIZE);
+	DataSystem::BatchManager<2, int, unsigned char> testManager(BATCH_SIZE, 1, 5, &idxReader2, &idxTransformer2);
+	
+	//Use the Adam optimizer as optimizer.
+	nnTest.AddOptimizer(new NNSystem::NNAdam(0.0001f*0.7f, 0.9f, 0.999f, 10e-8f));
+	
+
+	//Init the parameters using truncated normal distributions
+	OP::InitWeightTruncatedNormalRnd(wc1, 0.0f, 0.1f);
+	OP::InitWeightTruncatedNormalRnd(wc2, 0.0f, 0.1f);
+	OP::InitWeightTruncatedNormalRnd(wf1, 0.0f, 0.1f);
+	OP::InitWeightTruncatedNormalRnd(wf2, 0.0f, 0.1f);
+	
+	//Init the bias parameters with zero.
+	OP::InitWeightUniform(bc1, 0.0f);
+	OP::InitWeightUniform(bc2, 0.0f);
+	OP::InitWeightUniform(bf1, 0.0f);
+	OP::InitWeightUniform(bf2, 0.0f);
+	
+	//Run independent operations (For example the weight and input gradients of the convolutions) on two queues.
+	nnTest.SetNumQueues(2);
+
+	//Initalize the graph.
+	nnTest.InitliazeGraph(BATCH_SIZE);
+
+	//Record the commands of a training step once. Each iteration replays them.
+	nnTest.RecordTrainingStep();
+	
+	//List of buffers into which the data should be loaded.
+	std::vector<NNBufferIdx> buffer;
+	buffer.push_back(l);
+	buffer.push_back(i);
+
+	std::cout << "Start training" << std::endl;
+	
+	//Query the first batch and upload it into the input buffers.
+	DataSystem::Batch<int, unsigned char>* batch = batchManager.GetBatch();
+	nnTest.Prefetch<int, unsigned char>(BackendSystem::get<0>(batch->data), BackendSystem::get<1>(batch->data), buffer, batch->sizes, batch->batchSize);
+
+	//Training should reach something around 99%
+	for (int c = 0; c <= 40000; ++c)
+	{
+		//Perform the forward pass, the backward pass and the parameter update using the prefetched batch.
+		nnTest.TrainingStep();
+
+		//Query the next batch and upload it while the current batch is computed.
+		batch = batchManager.GetBatch();
+		nnTest.Prefetch<int, unsigned char>(BackendSystem::get<0>(batch->data), BackendSystem::get<1>(batch->data), buffer, batch->sizes, batch->batchSize);
+
+		//Calculates the accuracy on a test set every 20 steps.
+		if (c % 20 == 0 && c != 0)
+		{
+
+			size_t numTest = 1000;
+
+			//At step 500 the model will be tested on 10000 examples.
+			size_t pointOfFullTest = 500;
+			if ((c % pointOfFullTest) == 0 && c != 0)
+			{
+				numTest = 10000;
+			}
+
+			//Perform only the forward pass. The correct examples are counted on the device and read once at the end.
+			nnTest.ResetCorrect();
+			for (size_t j = 0; j < numTest; j += BATCH_SIZE)
+			{
+				DataSystem::Batch<int, unsigned char>* testBatch = testManager.GetBatch();
+				nnTest.Forward<int, unsigned char>(BackendSystem::get<0>(testBatch->data), BackendSystem::get<1>(testBatch->data), buffer, testBatch->sizes, testBatch->batchSize);
+			}
+			size_t numCorrect = 0;
+			nnTest.ReadCorrect(correct, numCorrect);
+
+			//Calculate the accuracy by divinding the number of correct examples by the number of total examples.
+			int realNum = ((numTest + BATCH_SIZE - 1) / BATCH_SIZE)*BATCH_SIZE;
+			if (c % pointOfFullTest == 0 && c != 0)
+			{
+				std::cout << std::endl << "Test Correct(Full Test Batch): " << static_cast<float>(numCorrect) / static_cast<float>(realNum) << " at Step " << c << std::endl << std::endl;
+			}
+			else
+				std::cout << "Test Correct: " << static_cast<float>(numCorrect) / static_cast<float>(realNum) << " at Step " << c << std::endl;
+		}
+	}
+
+	system("PAUSE");
+	return 0;
 }
\ No newline at end of file
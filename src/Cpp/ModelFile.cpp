@@ -0,0 +1,463 @@
+#include "ModelFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Table of the reflected polynomial 0xEDB88320.
+		struct Crc32Table
+		{
+			unsigned int values[256];
+
+			Crc32Table()
+			{
+				for (unsigned int i = 0; i < 256; ++i)
+				{
+					unsigned int value = i;
+					for (int j = 0; j < 8; ++j)
+						value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+					values[i] = value;
+				}
+			}
+		};
+
+		unsigned int Crc32(const char* data, const size_t size, const unsigned int crc)
+		{
+			//Created once at the first call. The initialization of a local static is thread safe, the checkpoint thread and the main thread may compute checksums at the same time.
+			static const Crc32Table table;
+
+			unsigned int result = ~crc;
+			for (size_t i = 0; i < size; ++i)
+				result = table.values[(result ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (result >> 8);
+			return ~result;
+		}
+
+		//Run length encoding of bytes: A control byte below 128 is followed by control + 1 literal bytes. Otherwise the next byte is repeated control - 126 times.
+		static size_t RunLengthEncode(const unsigned char* data, const size_t size, char* encoded, const size_t maxSize)
+		{
+			size_t i = 0;
+			size_t o = 0;
+			while (i < size)
+			{
+				size_t run = 1;
+				while (i + run < size && run < 129 && data[i + run] == data[i])
+					++run;
+
+				if (run >= 3)
+				{
+					if (o + 2 > maxSize)
+						return maxSize + 1;
+					encoded[o++] = static_cast<char>(run + 126);
+					encoded[o++] = static_cast<char>(data[i]);
+					i += run;
+					continue;
+				}
+
+				//Literal bytes until the next run of at least three equal bytes
+				size_t start = i;
+				while (i < size && i - start < 128 && !(i + 2 < size && data[i] == data[i + 1] && data[i] == data[i + 2]))
+					++i;
+				if (o + 1 + i - start > maxSize)
+					return maxSize + 1;
+				encoded[o++] = static_cast<char>(i - start - 1);
+				std::memcpy(encoded + o, data + start, i - start);
+				o += i - start;
+			}
+			return o;
+		}
+
+		static bool RunLengthDecode(const char* encoded, const size_t size, unsigned char* data, const size_t dataSize)
+		{
+			size_t p = 0;
+			size_t o = 0;
+			while (p < size)
+			{
+				const unsigned int control = static_cast<unsigned char>(encoded[p++]);
+				if (control < 128)
+				{
+					const size_t length = control + 1;
+					if (p + length > size || o + length > dataSize)
+						return false;
+					std::memcpy(data + o, encoded + p, length);
+					p += length;
+					o += length;
+				}
+				else
+				{
+					const size_t length = control - 126;
+					if (p >= size || o + length > dataSize)
+						return false;
+					std::memset(data + o, static_cast<unsigned char>(encoded[p++]), length);
+					o += length;
+				}
+			}
+			return o == dataSize;
+		}
+
+		size_t PackFloats(const float* values, const size_t count, char* packed, char* shuffled)
+		{
+			//The exponents and the high bits of the mantissas of similar values are often equal, which results in long runs after grouping.
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+			const size_t rawSize = count * sizeof(float);
+			for (size_t i = 0; i < count; ++i)
+				for (size_t b = 0; b < sizeof(float); ++b)
+					shuffled[b * count + i] = bytes[i * sizeof(float) + b];
+
+			ModelPackedBlock block;
+			block.rawSize = static_cast<unsigned int>(rawSize);
+			size_t packedSize = RunLengthEncode(reinterpret_cast<const unsigned char*>(shuffled), rawSize, packed + sizeof(ModelPackedBlock), rawSize);
+			if (packedSize >= rawSize)
+			{
+				packedSize = rawSize;
+				std::memcpy(packed + sizeof(ModelPackedBlock), values, rawSize);
+			}
+			block.packedSize = static_cast<unsigned int>(packedSize);
+			std::memcpy(packed, &block, sizeof(block));
+			return sizeof(ModelPackedBlock) + packedSize;
+		}
+
+		bool UnpackFloats(const char* payload, const size_t size, float* values, const size_t count)
+		{
+			std::vector<unsigned char> shuffled;
+			size_t p = 0;
+			size_t o = 0;
+			while (p < size)
+			{
+				ModelPackedBlock block;
+				if (p + sizeof(block) > size)
+					return false;
+				std::memcpy(&block, payload + p, sizeof(block));
+				p += sizeof(block);
+
+				const size_t blockCount = block.rawSize / sizeof(float);
+				if (block.rawSize % sizeof(float) != 0 || block.packedSize > size - p || blockCount > count - o)
+					return false;
+
+				if (block.packedSize == block.rawSize)
+					std::memcpy(values + o, payload + p, block.rawSize);
+				else
+				{
+					shuffled.resize(block.rawSize);
+					if (!RunLengthDecode(payload + p, block.packedSize, shuffled.data(), block.rawSize))
+						return false;
+					unsigned char* bytes = reinterpret_cast<unsigned char*>(values + o);
+					for (size_t i = 0; i < blockCount; ++i)
+						for (size_t b = 0; b < sizeof(float); ++b)
+							bytes[i * sizeof(float) + b] = shuffled[b * blockCount + i];
+				}
+				p += block.packedSize;
+				o += blockCount;
+			}
+			return o == count;
+		}
+
+		static bool InitEntry(ModelTensorEntry& entry, const std::string& name, const ModelDataType dataType, const SizeVec& shape)
+		{
+			if (name.size() >= MODEL_FILE_NAME_LENGTH)
+			{
+				std::cerr << "Error model file: name " << name << " is longer than " << MODEL_FILE_NAME_LENGTH - 1 << " characters" << std::endl;
+				return false;
+			}
+
+			std::memset(&entry, 0, sizeof(entry));
+			std::memcpy(entry.name, name.c_str(), name.size());
+			entry.dataType = dataType;
+			entry.shape[0] = shape.sizeX;
+			entry.shape[1] = shape.sizeY;
+			entry.shape[2] = shape.sizeZ;
+			entry.shape[3] = shape.sizeW;
+			entry.numChannels = 1;
+			entry.channelStride = 1;
+			return true;
+		}
+
+		bool ModelFileWriter::AddEntry(const std::string& name, const ModelDataType dataType, const SizeVec& shape)
+		{
+			ModelTensorEntry entry;
+			if (!InitEntry(entry, name, dataType, shape))
+				return false;
+
+			entries.push_back(entry);
+			payloads.push_back(std::vector<std::pair<const char*, size_t>>());
+			return true;
+		}
+
+		bool ModelFileWriter::AddTensor(const std::string& name, const float* data, const SizeVec& shape)
+		{
+			if (!AddEntry(name, MODEL_FLOAT32, shape))
+				return false;
+
+			payloads.back().push_back(std::pair<const char*, size_t>(reinterpret_cast<const char*>(data), shape.sizeX * shape.sizeY * shape.sizeZ * shape.sizeW * sizeof(float)));
+			return true;
+		}
+
+		bool ModelFileWriter::AddQuantizedTensor(const std::string& name, const QuantizedBuffer& buffer, const SizeVec& shape)
+		{
+			if (!AddEntry(name, MODEL_INT8, shape))
+				return false;
+
+			entries.back().numChannels = buffer.numChannels;
+			entries.back().channelStride = buffer.channelStride;
+			payloads.back().push_back(std::pair<const char*, size_t>(reinterpret_cast<const char*>(buffer.scales.data()), buffer.scales.size() * sizeof(float)));
+			payloads.back().push_back(std::pair<const char*, size_t>(buffer.values.data(), buffer.values.size()));
+			return true;
+		}
+
+		bool ModelFileWriter::AddBlob(const std::string& name, const char* data, const size_t size)
+		{
+			if (!AddEntry(name, MODEL_BYTES, SizeVec(size, 1, 1, 1)))
+				return false;
+
+			payloads.back().push_back(std::pair<const char*, size_t>(data, size));
+			return true;
+		}
+
+		DeepCLError ModelFileWriter::Write(const std::string& fileName)
+		{
+			//Compute the position and the checksum of each payload.
+			unsigned long long position = sizeof(ModelFileHeader) + entries.size() * sizeof(ModelTensorEntry);
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				position = (position + MODEL_FILE_ALIGNMENT - 1) / MODEL_FILE_ALIGNMENT * MODEL_FILE_ALIGNMENT;
+				entries[i].offset = position;
+				entries[i].size = 0;
+				entries[i].checksum = 0;
+				for (size_t j = 0; j < payloads[i].size(); ++j)
+				{
+					entries[i].size += payloads[i][j].second;
+					entries[i].checksum = Crc32(payloads[i][j].first, payloads[i][j].second, entries[i].checksum);
+				}
+				position += entries[i].size;
+			}
+
+			std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+			if (!file.is_open())
+			{
+				std::cerr << "Error model file: " << fileName << " could not be opened" << std::endl;
+				return NN_MODEL_FILE_ERROR;
+			}
+
+			ModelFileHeader header;
+			header.magic = MODEL_FILE_MAGIC;
+			header.version = MODEL_FILE_VERSION;
+			header.numTensors = entries.size();
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			if (!entries.empty())
+				file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ModelTensorEntry));
+
+			//The gaps between the payloads are filled with zeros.
+			const char padding[MODEL_FILE_ALIGNMENT] = { 0 };
+			position = sizeof(ModelFileHeader) + entries.size() * sizeof(ModelTensorEntry);
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				file.write(padding, static_cast<std::streamsize>(entries[i].offset - position));
+				for (size_t j = 0; j < payloads[i].size(); ++j)
+					file.write(payloads[i][j].first, payloads[i][j].second);
+				position = entries[i].offset + entries[i].size;
+			}
+
+			if (!file.good())
+			{
+				std::cerr << "Error model file: writing " << fileName << " failed" << std::endl;
+				return NN_MODEL_FILE_ERROR;
+			}
+			return 0;
+		}
+
+		DeepCLError ModelFileStreamWriter::Open(const std::string& fileName, const size_t numTensors)
+		{
+			this->fileName = fileName;
+			entries.clear();
+			entries.reserve(numTensors);
+
+			file.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				std::cerr << "Error model file: " << fileName << " could not be opened" << std::endl;
+				return NN_MODEL_FILE_ERROR;
+			}
+
+			//The header and the table are filled in by Close.
+			position = sizeof(ModelFileHeader) + numTensors * sizeof(ModelTensorEntry);
+			std::vector<char> placeholder(static_cast<size_t>(position), 0);
+			file.write(placeholder.data(), placeholder.size());
+			return 0;
+		}
+
+		bool ModelFileStreamWriter::BeginTensor(const std::string& name, const ModelDataType dataType, const SizeVec& shape)
+		{
+			if (entries.size() == entries.capacity())
+			{
+				std::cerr << "Error model file: more tensors than announced in " << fileName << std::endl;
+				return false;
+			}
+
+			ModelTensorEntry entry;
+			if (!InitEntry(entry, name, dataType, shape))
+				return false;
+
+			const char padding[MODEL_FILE_ALIGNMENT] = { 0 };
+			unsigned long long aligned = (position + MODEL_FILE_ALIGNMENT - 1) / MODEL_FILE_ALIGNMENT * MODEL_FILE_ALIGNMENT;
+			file.write(padding, static_cast<std::streamsize>(aligned - position));
+			position = aligned;
+			entry.offset = position;
+			entries.push_back(entry);
+			return true;
+		}
+
+		void ModelFileStreamWriter::Append(const char* data, const size_t size)
+		{
+			ModelTensorEntry& entry = entries.back();
+			entry.checksum = Crc32(data, size, entry.checksum);
+			entry.size += size;
+			position += size;
+			file.write(data, static_cast<std::streamsize>(size));
+		}
+
+		DeepCLError ModelFileStreamWriter::Close()
+		{
+			ModelFileHeader header;
+			header.magic = MODEL_FILE_MAGIC;
+			header.version = MODEL_FILE_VERSION;
+			header.numTensors = entries.size();
+
+			//Unused entries of the table stay zero, they are not part of the file.
+			file.seekp(0);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			if (!entries.empty())
+				file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ModelTensorEntry));
+
+			const bool good = file.good();
+			file.close();
+			if (!good)
+			{
+				std::cerr << "Error model file: writing " << fileName << " failed" << std::endl;
+				return NN_MODEL_FILE_ERROR;
+			}
+			return 0;
+		}
+
+		bool ModelFileReader::IsModelFile(const std::string& fileName)
+		{
+			std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+			unsigned int magic = 0;
+			file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+			return file.good() && magic == MODEL_FILE_MAGIC;
+		}
+
+		DeepCLError ModelFileReader::Open(const std::string& fileName)
+		{
+			Close();
+
+			//Map the complete file. The handles can be closed once the view exists.
+#ifdef _WIN32
+			HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				std::cerr << "Error model file: " << fileName << " could not be opened" << std::endl;
+				return NN_MODEL_FILE_ERROR;
+			}
+			LARGE_INTEGER fileSize;
+			GetFileSizeEx(file, &fileSize);
+			size = static_cast<size_t>(fileSize.QuadPart);
+			HANDLE mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+			if (mapping != nullptr)
+			{
+				data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+			CloseHandle(file);
+#else
+			int file = open(fileName.c_str(), O_RDONLY);
+			if (file < 0)
+			{
+				std::cerr << "Error model file: " << fileName << " could not be opened" << std::endl;
+				return NN_MODEL_FILE_ERROR;
+			}
+			struct stat fileStat;
+			fstat(file, &fileStat);
+			size = static_cast<size_t>(fileStat.st_size);
+			if (size > 0)
+			{
+				void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+				data = mapping == MAP_FAILED ? nullptr : static_cast<const char*>(mapping);
+			}
+			close(file);
+#endif
+			if (data == nullptr)
+			{
+				std::cerr << "Error model file: " << fileName << " could not be mapped" << std::endl;
+				size = 0;
+				return NN_MODEL_FILE_ERROR;
+			}
+
+			//Validate the header and the table before any payload is used.
+			const ModelFileHeader* header = reinterpret_cast<const ModelFileHeader*>(data);
+			if (size < sizeof(ModelFileHeader) || header->magic != MODEL_FILE_MAGIC || header->version > MODEL_FILE_VERSION
+				|| header->numTensors > (size - sizeof(ModelFileHeader)) / sizeof(ModelTensorEntry))
+			{
+				std::cerr << "Error model file: " << fileName << " is not a valid model file" << std::endl;
+				Close();
+				return NN_MODEL_FILE_ERROR;
+			}
+
+			entries = reinterpret_cast<const ModelTensorEntry*>(data + sizeof(ModelFileHeader));
+			for (size_t i = 0; i < header->numTensors; ++i)
+			{
+				const ModelTensorEntry& entry = entries[i];
+				if (entry.offset > size || entry.size > size - entry.offset || entry.name[MODEL_FILE_NAME_LENGTH - 1] != 0)
+				{
+					std::cerr << "Error model file: " << fileName << " is truncated or corrupt" << std::endl;
+					Close();
+					return NN_MODEL_FILE_ERROR;
+				}
+				tensorIndex[std::string(entry.name)] = i;
+			}
+
+			return 0;
+		}
+
+		void ModelFileReader::Close()
+		{
+			if (data != nullptr)
+			{
+#ifdef _WIN32
+				UnmapViewOfFile(data);
+#else
+				munmap(const_cast<char*>(data), size);
+#endif
+			}
+			data = nullptr;
+			size = 0;
+			entries = nullptr;
+			tensorIndex.clear();
+		}
+
+		const ModelTensorEntry* ModelFileReader::Find(const std::string& name) const
+		{
+			std::map<std::string, size_t>::const_iterator it = tensorIndex.find(name);
+			return it == tensorIndex.end() ? nullptr : &entries[it->second];
+		}
+
+		bool ModelFileReader::VerifyChecksum(const ModelTensorEntry& entry) const
+		{
+			return Crc32(Payload(entry), static_cast<size_t>(entry.size)) == entry.checksum;
+		}
+	}
+}
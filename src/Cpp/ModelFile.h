@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+
+#include "NNBuffer.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Layout of a model file: The header is followed by a table with one entry for each tensor. The payloads start at multiples of MODEL_FILE_ALIGNMENT
+		//and can be used directly from a mapping of the file. Values are stored in the byte order of the host.
+		const unsigned int MODEL_FILE_MAGIC = 0x4D4C4344; //"DCLM"
+		const unsigned int MODEL_FILE_VERSION = 2;
+		const size_t MODEL_FILE_ALIGNMENT = 64;
+		const size_t MODEL_FILE_NAME_LENGTH = 64;
+
+		enum ModelDataType
+		{
+			MODEL_FLOAT32 = 0, MODEL_INT8 = 1, MODEL_BYTES = 2, //Raw data without a shape (Used for the training state of checkpoints)
+			MODEL_FLOAT32_PACKED = 3 //Float values stored as blocks compressed by PackFloats (Version 2)
+		};
+
+		struct ModelFileHeader
+		{
+			unsigned int magic;
+			unsigned int version;
+			unsigned long long numTensors;
+		};
+
+		struct ModelTensorEntry
+		{
+			char name[MODEL_FILE_NAME_LENGTH]; //Zero terminated
+			unsigned int dataType; //ModelDataType
+			unsigned int checksum; //CRC-32 of the payload
+			unsigned long long shape[4];
+			unsigned long long numChannels; //Int8 tensors: The payload starts with numChannels float scales followed by the values (See QuantizedBuffer)
+			unsigned long long channelStride;
+			unsigned long long offset; //Position of the payload in the file
+			unsigned long long size; //Size of the payload in bytes
+		};
+
+		//CRC-32 of the data. Passing the result of the previous call as crc continues the checksum.
+		unsigned int Crc32(const char* data, const size_t size, const unsigned int crc = 0);
+
+		//Packed tensors consist of blocks each starting with a ModelPackedBlock. In a block the bytes of the values are grouped by their significance
+		//and the groups are run length encoded. Blocks which can't be compressed are stored unchanged (packedSize == rawSize).
+		struct ModelPackedBlock
+		{
+			unsigned int rawSize;
+			unsigned int packedSize;
+		};
+
+		//Packs count values into packed (Including the block header). packed needs room for sizeof(ModelPackedBlock) + count * sizeof(float) bytes and
+		//shuffled for count * sizeof(float) bytes. Returns the size of the block.
+		size_t PackFloats(const float* values, const size_t count, char* packed, char* shuffled);
+		//Unpacks the blocks of a packed payload into values. Returns false if the payload does not contain exactly count values.
+		bool UnpackFloats(const char* payload, const size_t size, float* values, const size_t count);
+
+		//Collects the tensors of a model and writes them into a file.
+		class ModelFileWriter
+		{
+		public:
+			//Adds a tensor. The data must stay valid until Write returned.
+			bool AddTensor(const std::string& name, const float* data, const SizeVec& shape);
+			bool AddQuantizedTensor(const std::string& name, const QuantizedBuffer& buffer, const SizeVec& shape);
+			bool AddBlob(const std::string& name, const char* data, const size_t size);
+
+			DeepCLError Write(const std::string& fileName);
+
+		private:
+			bool AddEntry(const std::string& name, const ModelDataType dataType, const SizeVec& shape);
+
+			std::vector<ModelTensorEntry> entries;
+			//The parts the payload of each tensor consists of.
+			std::vector<std::vector<std::pair<const char*, size_t>>> payloads;
+		};
+
+		//Writes the tensors one after another without knowing the size of the payloads in advance (Used for packed tensors).
+		//The table is written when the file is closed.
+		class ModelFileStreamWriter
+		{
+		public:
+			DeepCLError Open(const std::string& fileName, const size_t numTensors);
+			//Starts the next tensor. The data appended afterwards forms its payload.
+			bool BeginTensor(const std::string& name, const ModelDataType dataType, const SizeVec& shape);
+			void Append(const char* data, const size_t size);
+			DeepCLError Close();
+
+		private:
+			std::ofstream file;
+			std::string fileName;
+			std::vector<ModelTensorEntry> entries;
+			unsigned long long position;
+		};
+
+		//Maps a model file into memory. The payloads stay valid until the file is closed.
+		class ModelFileReader
+		{
+		public:
+			ModelFileReader() : data(nullptr), size(0), entries(nullptr), tensorIndex() {}
+			~ModelFileReader() { Close(); }
+
+			//Returns true if the file starts with the magic number (Files written by older versions of SaveModel don't).
+			static bool IsModelFile(const std::string& fileName);
+
+			DeepCLError Open(const std::string& fileName);
+			void Close();
+
+			//Returns the entry of the tensor with the name or a nullptr.
+			const ModelTensorEntry* Find(const std::string& name) const;
+			const char* Payload(const ModelTensorEntry& entry) const { return data + entry.offset; }
+			bool VerifyChecksum(const ModelTensorEntry& entry) const;
+
+		private:
+			ModelFileReader(const ModelFileReader& other);
+			const ModelFileReader& operator=(const ModelFileReader& other);
+
+			const char* data;
+			size_t size;
+			const ModelTensorEntry* entries;
+			std::map<std::string, size_t> tensorIndex;
+		};
+	}
+}
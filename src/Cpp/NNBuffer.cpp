@@ -1,135 +1,250 @@
-#include "NNBuffer.h"
-
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-		size_t NNParamBuffer::numAuxBuffer = 0;
-
-		void NNBuffer::SetBatchSize(const size_t batchSize)
-		{
-			size.sizeW = batchSize;
-		}
-
-		void NNBuffer::Reset(BackendSystem::OpenCLBackend& backend)
-		{
-			//Sets all backward buffers to zero
-			for (size_t i = 0; i < backwardBuffer.size(); ++i)
-				backend.ResetBuffer(backwardBuffer[i], size.sizeX * size.sizeY * size.sizeZ * size.sizeW * sizeof(float));
-		}
-
-		void NNInputBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
-		{
-			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
-
-			//Create the necessary forward and backward buffer
-			BufferIdx newForwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_ONLY, sequenceSize);
-			baseFwdBuffer = newForwardBuffer;
-
-			BufferIdx newBackwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize);
-			baseBwdBuffer = newBackwardBuffer;
-
-			//Create for each time step one sub buffer
-			for (size_t j = 0; j < sequenceSize; ++j)
-			{
-				BufferIdx newBuffer = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_ONLY, j);
-				forwardBuffer[j] = newBuffer;
-
-				newBuffer = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
-				backwardBuffer[j] = newBuffer;
-			}
-		}
-
-		void NNIntBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
-		{
-			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
-
-			//Create the necessary forward and backward buffer
-			BufferIdx newForwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize);
-			baseFwdBuffer = newForwardBuffer;
-
-			BufferIdx newBackwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize);
-			baseBwdBuffer = newBackwardBuffer;
-
-			//Create for each time step one sub buffer
-			for (size_t j = 0; j < sequenceSize; ++j)
-			{
-				BufferIdx newBuffer = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
-				forwardBuffer[j] = newBuffer;
-
-				newBuffer = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
-				backwardBuffer[j] = newBuffer;
-			}
-		}
-
-		void NNParamBuffer::SetNumAuxBuffer(const size_t numAuxBuffer)
-		{
-			NNParamBuffer::numAuxBuffer = numAuxBuffer;
-		}
-
-		void NNParamBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
-		{
-			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
-
-			//Create the necessary forward and backward buffer
-			//The sub buffers are created to stay consistend with the rest of the buffers.
-			BufferIdx newBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
-			baseFwdBuffer = newBuffer;
-			forwardBuffer[0] = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 0);
-			
-
-			newBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
-			baseBwdBuffer = newBuffer;
-			backwardBuffer[0] = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 0);;
-			
-			//Create the necessary auxilary buffers and store them in the auxBuffer vector.
-			for (size_t j = 0; j < numAuxBuffer; ++j)
-			{
-				BufferIdx newBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
-				auxBuffer.push_back(newBuffer);
-			}
-		}
-
-		void NNStateBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
-		{
-			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
-
-			//Creates base buffers that can contain an additioanl sub buffer
-			BufferIdx newForwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize + 1);
-			baseFwdBuffer = newForwardBuffer;
-
-			BufferIdx newBackwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize + 1);
-			baseBwdBuffer = newBackwardBuffer;
-
-			//Create all necessary sub buffers.
-			for (size_t j = 0; j < sequenceSize + 1; ++j)
-			{
-				BufferIdx newBuffer = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
-				forwardBuffer[j] = newBuffer;
-
-				newBuffer = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
-				backwardBuffer[j] = newBuffer;
-			}
-		}
-
-		//Resets all sub buffers.
-		void NNStateBuffer::Reset(BackendSystem::OpenCLBackend& backend)
-		{
-			for (size_t i = 0; i < backwardBuffer.size(); ++i)
-				backend.ResetBuffer(backwardBuffer[i], size.sizeX * size.sizeY * size.sizeZ * size.sizeW * sizeof(float));
-			for (size_t i = 0; i < forwardBuffer.size(); ++i)
-				backend.ResetBuffer(forwardBuffer[i], size.sizeX * size.sizeY * size.sizeZ * size.sizeW * sizeof(float));
-		}
-		
-		void NNTmpBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
-		{
-			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
-
-			//Needs only one forward Buffer, since they are only used to store intermediate results and don't need to store data for another pass. 
-			BufferIdx newForwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
-			baseFwdBuffer = newForwardBuffer;
-			forwardBuffer[0] = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 0);;
-		}
-	}
+#include "NNBuffer.h"
+
+#include <cstring>
+
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		size_t NNParamBuffer::numAuxBuffer = 0;
+
+		void NNBuffer::SetBatchSize(const size_t batchSize)
+		{
+			size.sizeW = batchSize;
+		}
+
+		void NNBuffer::Reset(BackendSystem::OpenCLBackend& backend)
+		{
+			//Sets all backward buffers to zero. Buffers overwritten by the first operation of the backward pass are skipped.
+			for (size_t i = 0; i < backwardBuffer.size(); ++i)
+				if (backend.RequiresReset(backwardBuffer[i]))
+					backend.ResetBuffer(backwardBuffer[i], size.sizeX * size.sizeY * size.sizeZ * size.sizeW * ElementSize());
+		}
+
+		void NNInputBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
+		{
+			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
+			//The forward buffers store the uploaded type, the gradients are always float.
+			const size_t inputSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * InputStorageSize(storage);
+
+			//Create the necessary forward and backward buffer
+			BufferIdx newForwardBuffer = backend.CreateBuffer(inputSize, BackendSystem::MEM_FLAG::READ_ONLY, sequenceSize);
+			baseFwdBuffer = newForwardBuffer;
+
+			BufferIdx newBackwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize);
+			baseBwdBuffer = newBackwardBuffer;
+
+			//Create for each time step one sub buffer
+			for (size_t j = 0; j < sequenceSize; ++j)
+			{
+				BufferIdx newBuffer = backend.CreateSubBuffer(baseFwdBuffer, inputSize, BackendSystem::MEM_FLAG::READ_ONLY, j);
+				forwardBuffer[j] = newBuffer;
+
+				newBuffer = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
+				backwardBuffer[j] = newBuffer;
+			}
+
+			if (numSlots < 2)
+				return;
+
+			//The first slot uses the buffer created above. The other slots get their own hardware buffer.
+			slotBuffer[0] = forwardBuffer;
+			for (size_t k = 1; k < numSlots; ++k)
+			{
+				newForwardBuffer = backend.CreateBuffer(inputSize, BackendSystem::MEM_FLAG::READ_ONLY, sequenceSize);
+				for (size_t j = 0; j < sequenceSize; ++j)
+					slotBuffer[k].push_back(backend.CreateSubBuffer(newForwardBuffer, inputSize, BackendSystem::MEM_FLAG::READ_ONLY, j));
+			}
+
+			//The operations use aliases which are rebound to the current slot.
+			for (size_t j = 0; j < sequenceSize; ++j)
+				forwardBuffer[j] = backend.CreateBufferAlias(slotBuffer[0][j]);
+		}
+
+		bool NNInputBuffer::Prefetch(BackendSystem::OpenCLBackend& backend, const void* data, const size_t stepSize, const size_t batchSize, const size_t numSubBuffer)
+		{
+			if (numSlots < 2)
+			{
+				std::cerr << "ERROR Prefetch: the input buffer has only one slot" << std::endl;
+				return false;
+			}
+			if (stagedSlot != MAX_UNSIGNED_INT)
+			{
+				std::cerr << "ERROR Prefetch: the previously prefetched data was not used yet" << std::endl;
+				return false;
+			}
+
+			size_t slot = (curSlot + 1) % numSlots;
+
+			//The slot may still be read by operations of an earlier batch.
+			const cl::Event* waitEvent = releasePending[slot] ? &releaseEvent[slot] : nullptr;
+
+			const char* source = reinterpret_cast<const char*>(data);
+			if (numSubBuffer > 1)
+			{
+				//Each time step is stored in its own sub buffer therefore the data is reordered first.
+				if (uploadPending[slot])
+					uploadEvent[slot].wait();
+
+				std::vector<char>& staging = stagingMemory[slot];
+				staging.resize(stepSize * batchSize * numSubBuffer);
+				for (size_t i = 0; i < numSubBuffer; ++i)
+					for (size_t j = 0; j < batchSize; ++j)
+						memcpy(&staging[(i * batchSize + j) * stepSize], source + (j * numSubBuffer + i) * stepSize, stepSize);
+				source = staging.data();
+			}
+
+			//The upload queue is in order therefore the event of the last transfer marks the end of the whole upload.
+			for (size_t i = 0; i < numSubBuffer; ++i)
+				backend.WriteDataBufferAsync(slotBuffer[slot][i], source + i * stepSize * batchSize, 0, stepSize * batchSize, waitEvent, &uploadEvent[slot]);
+
+			uploadPending[slot] = true;
+			stagedSlot = slot;
+			return true;
+		}
+
+		bool NNInputBuffer::SwapSlot(BackendSystem::OpenCLBackend& backend)
+		{
+			if (stagedSlot == MAX_UNSIGNED_INT)
+				return false;
+
+			//The old slot can be overwritten once everything enqueued so far (including the backward pass) finished.
+			backend.EnqueueMarker(&releaseEvent[curSlot]);
+			releasePending[curSlot] = true;
+
+			curSlot = stagedSlot;
+			stagedSlot = MAX_UNSIGNED_INT;
+
+			for (size_t j = 0; j < sequenceSize; ++j)
+				backend.BindBuffer(forwardBuffer[j], slotBuffer[curSlot][j]);
+
+			backend.WaitForEvent(uploadEvent[curSlot]);
+			return true;
+		}
+
+		void NNInputBuffer::WaitForUpload()
+		{
+			if (!uploadPending[curSlot])
+				return;
+
+			uploadEvent[curSlot].wait();
+			uploadPending[curSlot] = false;
+		}
+
+		void NNIntBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
+		{
+			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * ElementSize();
+
+			//Create the necessary forward and backward buffer
+			//The forward sub buffers of a recomputed buffer are placed in the arena instead.
+			if (IsRecomputed())
+				baseFwdBuffer = MAX_UNSIGNED_INT;
+			else
+				baseFwdBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize);
+
+			BufferIdx newBackwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize);
+			baseBwdBuffer = newBackwardBuffer;
+
+			//Create for each time step one sub buffer
+			for (size_t j = 0; j < sequenceSize; ++j)
+			{
+				BufferIdx newBuffer = IsRecomputed() ? backend.CreateSubBufferAt(arena, arenaOffset[j], totalSize, BackendSystem::MEM_FLAG::READ_WRITE) :
+					backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
+				forwardBuffer[j] = newBuffer;
+
+				newBuffer = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
+				backwardBuffer[j] = newBuffer;
+
+				if (halfStorage)
+				{
+					backend.SetHalfStorage(forwardBuffer[j]);
+					backend.SetHalfStorage(backwardBuffer[j]);
+				}
+			}
+		}
+
+		void NNParamBuffer::SetNumAuxBuffer(const size_t numAuxBuffer)
+		{
+			NNParamBuffer::numAuxBuffer = numAuxBuffer;
+		}
+
+		void NNParamBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
+		{
+			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
+
+			//Create the necessary forward and backward buffer
+			//The sub buffers are created to stay consistend with the rest of the buffers.
+			BufferIdx newBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			baseFwdBuffer = newBuffer;
+			forwardBuffer[0] = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 0);
+			
+
+			newBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			baseBwdBuffer = newBuffer;
+			backwardBuffer[0] = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 0);;
+			
+			//Create the necessary auxilary buffers and store them in the auxBuffer vector.
+			for (size_t j = 0; j < numAuxBuffer; ++j)
+			{
+				BufferIdx newBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+				auxBuffer.push_back(newBuffer);
+			}
+		}
+
+		void NNStateBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
+		{
+			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
+
+			//Creates base buffers that can contain an additioanl sub buffer
+			BufferIdx newForwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize + 1);
+			baseFwdBuffer = newForwardBuffer;
+
+			BufferIdx newBackwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, sequenceSize + 1);
+			baseBwdBuffer = newBackwardBuffer;
+
+			//Create all necessary sub buffers.
+			for (size_t j = 0; j < sequenceSize + 1; ++j)
+			{
+				BufferIdx newBuffer = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
+				forwardBuffer[j] = newBuffer;
+
+				newBuffer = backend.CreateSubBuffer(baseBwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, j);
+				backwardBuffer[j] = newBuffer;
+			}
+		}
+
+		//Resets all sub buffers.
+		void NNStateBuffer::Reset(BackendSystem::OpenCLBackend& backend)
+		{
+			for (size_t i = 0; i < backwardBuffer.size(); ++i)
+				if (backend.RequiresReset(backwardBuffer[i]))
+					backend.ResetBuffer(backwardBuffer[i], size.sizeX * size.sizeY * size.sizeZ * size.sizeW * sizeof(float));
+
+			//The copy is enqueued before the last sub buffer is set to zero
+			if (carryState)
+				ResetState(backend, true);
+			for (size_t i = carryState ? 1 : 0; i < forwardBuffer.size(); ++i)
+				backend.ResetBuffer(forwardBuffer[i], size.sizeX * size.sizeY * size.sizeZ * size.sizeW * sizeof(float));
+		}
+
+		void NNStateBuffer::ResetState(BackendSystem::OpenCLBackend& backend, const bool carry)
+		{
+			const size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW * sizeof(float);
+			if (carry)
+				backend.CopyBuffer(forwardBuffer[sequenceSize], forwardBuffer[0], totalSize);
+			else
+				backend.ResetBuffer(forwardBuffer[0], totalSize);
+		}
+		
+		void NNTmpBuffer::Instantiate(BackendSystem::OpenCLBackend& backend)
+		{
+			size_t totalSize = size.sizeW*size.sizeZ*size.sizeY*size.sizeX * sizeof(float);
+
+			//Needs only one forward Buffer, since they are only used to store intermediate results and don't need to store data for another pass. 
+			BufferIdx newForwardBuffer = backend.CreateBuffer(totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			baseFwdBuffer = newForwardBuffer;
+			forwardBuffer[0] = backend.CreateSubBuffer(baseFwdBuffer, totalSize, BackendSystem::MEM_FLAG::READ_WRITE, 0);;
+		}
+	}
 }
\ No newline at end of file
@@ -1,297 +1,458 @@
-#pragma once
-
-#include "OpenCLBackend.h"
-
-//Contains different objects which represent the edges in the computation graph.
-//Those objects represent data that is transfered between operations
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-
-		//Used to store the size of an buffer and to pass a size as parameter.
-		//The number of time steps is not included in this vector.
-		struct SizeVec
-		{
-		public:
-			size_t sizeX;
-			size_t sizeY;
-			size_t sizeZ;
-			size_t sizeW;
-
-			SizeVec() : sizeX(0), sizeY(0), sizeZ(0), sizeW(0)
-			{}
-
-			SizeVec(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1) :
-				sizeX(sizeX), sizeY(sizeY), sizeZ(sizeZ), sizeW(sizeW)
-			{}
-
-			SizeVec Max(const SizeVec& other)
-			{
-				SizeVec result = other;
-				result.sizeX = other.sizeX >= sizeX ? other.sizeX : sizeX;
-				result.sizeY = other.sizeY >= sizeY ? other.sizeY : sizeY;
-				result.sizeZ = other.sizeZ >= sizeZ ? other.sizeZ : sizeZ;
-				result.sizeW = other.sizeW >= sizeW ? other.sizeW : sizeW;
-
-				return result;
-			}
-		};
-
-		//Basic buffer object from which all other buffer objects derive.
-		class NNBuffer
-		{
-		public:
-			//The operation that leads calculates this buffer.
-			NNOperationIdx from;
-
-			//An operation that uses this buffer. (Should be adapted to be a vector since multiple operations can use this buffer due to implicit copying).
-			NNOperationIdx to;
-
-			//The size of this buffer.
-			SizeVec size;
-
-			//The time offset for when this buffer is used
-			size_t timeOffset;
-
-			//The length of the sequence
-			const size_t sequenceSize;
-
-			//All indices that are not set to a specific real object are set to the maximal possible unsigned integer, thereby hinting at that the index is uninialized.
-			NNBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
-				size(sizeX, sizeY, sizeZ, sizeW), sequenceSize(sequenceSize), timeStep(0), forwardBuffer(), backwardBuffer(),
-				from(MAX_UNSIGNED_INT), to(MAX_UNSIGNED_INT), timeOffset(timeOffset)
-			{
-				//This buffer contains a indices on a hardware sub buffer for each time step in forward and backward direction.
-				for (size_t i = 0; i < sequenceSize; ++i)
-				{
-					forwardBuffer.push_back(MAX_UNSIGNED_INT);
-					backwardBuffer.push_back(MAX_UNSIGNED_INT);
-				}
-			}
-
-			NNBuffer(const NNBuffer &other) :
-				size(other.size), forwardBuffer(other.forwardBuffer), backwardBuffer(other.backwardBuffer),
-				from(other.from), to(other.to), sequenceSize(other.sequenceSize), timeStep(other.timeStep), timeOffset(other.timeOffset), baseFwdBuffer(other.baseFwdBuffer), baseBwdBuffer(other.baseBwdBuffer)
-			{}
-
-			const NNBuffer& operator=(const NNBuffer& other)
-			{
-				forwardBuffer = other.forwardBuffer;
-				backwardBuffer = other.backwardBuffer;
-				from = other.from;
-				to = other.to;
-
-				baseFwdBuffer = other.baseFwdBuffer;
-				baseBwdBuffer = other.baseBwdBuffer;
-
-				size = other.size;
-				timeStep = other.timeStep;
-				timeOffset = other.timeOffset;
-
-				return *this;
-			}
-
-			//Returns a specific forward/backward sub buffer indice. ForwardBuffer is virtual since some buffers require a specific access.
-			virtual inline BufferIdx& ForwardBuffer(const size_t num){ return forwardBuffer[num]; }
-			inline BufferIdx& BackwardBuffer(const size_t num){ return backwardBuffer[num]; }
-
-			//Returns the forward/backward sub buffer of the current time step. This way the operation don't needs any explicit information about the time step since only the buffer need this information
-			inline BufferIdx& ForwardBuffer(){ return forwardBuffer[timeStep]; }
-			inline BufferIdx& BackwardBuffer(){ return backwardBuffer[timeStep]; }
-
-			inline void UpdateStep(){ timeStep = (timeStep + 1) % sequenceSize; } //Increases the current time step by one thereby returning the sub buffer for the next time step when ForwardBuffer/BackwardBuffer is called.
-			inline void Reset(){ timeStep = 0; };
-
-			//Returns references on the vector of forward/backward buffers.
-			inline std::vector<BufferIdx>& GetCompleteBackwardBuffer(){ return backwardBuffer; }
-			inline std::vector<BufferIdx>& GetCompleteForwardBuffer(){ return forwardBuffer; }
-
-			//Returns the current time step.
-			inline size_t GetCurTimeStep() const { return timeStep; }
-
-			//Returns the base hardware buffer which contains all sub buffers.
-			inline BufferIdx BaseForwardBuffer() const { return baseFwdBuffer; }
-			inline BufferIdx BaseBackwardBuffer() const { return baseBwdBuffer; }
-
-			//Sets the base hardware buffer.
-			inline void BaseFwdBuffer(BufferIdx fwdBuffer) { baseFwdBuffer = fwdBuffer; }
-			inline void BaseBwdBuffer(BufferIdx bwdBuffer) { baseBwdBuffer = bwdBuffer; }
-
-			//Creates the necessary hardware buffer and sub buffers.
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend){}
-
-			//Sets the w component of the size to be equal to the batchSize
-			virtual void SetBatchSize(const size_t batchSize);
-			
-			//Sets each backward buffer to zero. (Not all buffers need to do this)
-			virtual void Reset(BackendSystem::OpenCLBackend& backend);
-
-
-		protected:
-			//Stores the indices on the hardware buffer that contains all sub buffers
-			BufferIdx baseFwdBuffer; 
-			BufferIdx baseBwdBuffer;
-
-			//Stores the indices on all hardware sub buffers.
-			std::vector<BufferIdx> forwardBuffer;
-			std::vector<BufferIdx> backwardBuffer;
-
-			//Stores the current time step.
-			size_t timeStep;
-
-		};
-
-		class NNInputBuffer : public NNBuffer
-		{
-		public:
-			NNInputBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
-				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
-			{}
-
-			NNInputBuffer(const NNInputBuffer& other) :
-				NNBuffer(other)
-			{}
-
-			const NNInputBuffer& operator=(const NNInputBuffer& other)
-			{
-				NNBuffer::operator=(other);
-
-				return *this;
-			}
-			//Specific memory access. Forward input only needs read access
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
-		};
-
-		class NNIntBuffer : public NNBuffer
-		{
-		public:
-			NNIntBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
-				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
-			{}
-
-			NNIntBuffer(const NNIntBuffer& other) :
-				NNBuffer(other)
-			{}
-
-			const NNIntBuffer& operator=(const NNIntBuffer& other)
-			{
-				NNBuffer::operator=(other);
-
-				return *this;
-			}
-			//All buffers have read write access.
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
-		};
-
-		class NNParamBuffer : public NNBuffer
-		{
-		public:
-			NNParamBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
-				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
-			{}
-
-			NNParamBuffer(const NNParamBuffer& other) :
-				NNBuffer(other)
-			{}
-
-			const NNParamBuffer& operator=(const NNParamBuffer& other)
-			{
-				NNBuffer::operator=(other);
-
-				return *this;
-			}
-
-			//This function is used to access auxilary buffers. Since parameter buffers otherwise only contain a buffer for one time step.
-			virtual inline BufferIdx& ForwardBuffer(const size_t num)
-			{
-				if (num < numAuxBuffer)
-					return auxBuffer[num];
-
-				std::cerr << "ERROR in GetAuxBuffer! num to high." << std::endl;
-				return	baseFwdBuffer;
-			}
-
-			//Used to set the number of auxilary buffers. All parameter buffers need the same number of auxilary buffers therefore this function is static.
-			static void SetNumAuxBuffer(const size_t numAuxBuffer);
-
-			//This function needs the number of auxilary buffers to be set. It creates a base forward buffer that can contain the normal forward.
-			//Only the base backward buffer is created since only the normal buffer has a backward component.
-			//The auxilary buffers are its own buffers and not hardware buffers.
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
-
-			//The parameter buffers are independent of the batch size.
-			virtual void SetBatchSize(const size_t batchSize)
-			{}
-
-			virtual BufferIdx GetAuxBuffer(const size_t num)
-			{
-				return auxBuffer[num];
-			}
-
-		private:
-			static size_t numAuxBuffer;
-			//Stores the indices of the hardware auxilary buffers.
-			std::vector<BufferIdx> auxBuffer;
-		};
-
-		class NNStateBuffer : public NNBuffer
-		{
-		public:
-			NNStateBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
-				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
-			{
-				//The state needs one additional buffer since when the output is computed, the next state is also computed, Thereby one more state is computed. The state at time step zero is often zero but there might be situations where it is initalized different from zero.
-				//Therefore the total number of sub buffers needed is the sequence size plus one.
-				forwardBuffer.push_back(MAX_UNSIGNED_INT);
-				backwardBuffer.push_back(MAX_UNSIGNED_INT);
-			}
-
-			NNStateBuffer(const NNStateBuffer& other) :
-				NNBuffer(other)
-			{}
-
-			const NNStateBuffer& operator=(const NNStateBuffer& other)
-			{
-				NNBuffer::operator=(other);
-
-				return *this;
-			}
-			//It is the same as intermediate buffer but with an additional sub buffer for both passes
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
-			//Sets all buffers to zero. (Forward and backward)
-			virtual void Reset(BackendSystem::OpenCLBackend& backend);
-		};
-
-		class NNTmpBuffer : public NNBuffer
-		{
-		public:
-			NNTmpBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
-				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
-			{
-			}
-
-			NNTmpBuffer(const NNTmpBuffer& other) :
-				NNBuffer(other)
-			{}
-
-			const NNTmpBuffer& operator=(const NNTmpBuffer& other)
-			{
-				NNBuffer::operator=(other);
-
-				return *this;
-			}
-			//Nothing needs to be done when reset is called
-			virtual void Reset(BackendSystem::OpenCLBackend& backend)
-			{}
-
-			//Creates only one sub buffer.
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
-
-			//Batch size is already contained in its size when it is created.
-			virtual void SetBatchSize(const size_t batchSize)
-			{}
-		};
-	}
-}
+#pragma once
+
+#include "OpenCLBackend.h"
+
+//Contains different objects which represent the edges in the computation graph.
+//Those objects represent data that is transfered between operations
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+
+		//Used to store the size of an buffer and to pass a size as parameter.
+		//The number of time steps is not included in this vector.
+		struct SizeVec
+		{
+		public:
+			size_t sizeX;
+			size_t sizeY;
+			size_t sizeZ;
+			size_t sizeW;
+
+			SizeVec() : sizeX(0), sizeY(0), sizeZ(0), sizeW(0)
+			{}
+
+			SizeVec(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1) :
+				sizeX(sizeX), sizeY(sizeY), sizeZ(sizeZ), sizeW(sizeW)
+			{}
+
+			SizeVec Max(const SizeVec& other)
+			{
+				SizeVec result = other;
+				result.sizeX = other.sizeX >= sizeX ? other.sizeX : sizeX;
+				result.sizeY = other.sizeY >= sizeY ? other.sizeY : sizeY;
+				result.sizeZ = other.sizeZ >= sizeZ ? other.sizeZ : sizeZ;
+				result.sizeW = other.sizeW >= sizeW ? other.sizeW : sizeW;
+
+				return result;
+			}
+		};
+
+		//Parameters quantized to int8 with one scale per channel. The channel of the element e is (e / channelStride) % numChannels.
+		struct QuantizedBuffer
+		{
+		public:
+			size_t numChannels;
+			size_t channelStride;
+			std::vector<float> scales;
+			std::vector<char> values;
+
+			QuantizedBuffer() : numChannels(1), channelStride(1), scales(), values()
+			{}
+		};
+
+		//Type of the data uploaded into an input buffer. Compact types are converted into float by OP::Dequantize.
+		enum InputStorage
+		{
+			INPUT_FLOAT,
+			INPUT_UINT8,
+			INPUT_INT16,
+			INPUT_HALF
+		};
+
+		//Size in bytes of one element of the type.
+		inline size_t InputStorageSize(const InputStorage storage)
+		{
+			return storage == INPUT_UINT8 ? sizeof(cl_uchar) : (storage == INPUT_INT16 ? sizeof(cl_short) : (storage == INPUT_HALF ? sizeof(cl_half) : sizeof(float)));
+		}
+
+		//Storage of an input buffer receiving data of type T. Types without a compact storage, like the int labels, are written into buffers storing float.
+		template<typename T>
+		struct InputStorageOf
+		{
+			static const InputStorage storage = INPUT_FLOAT;
+		};
+		template<>
+		struct InputStorageOf<cl_uchar>
+		{
+			static const InputStorage storage = INPUT_UINT8;
+		};
+		template<>
+		struct InputStorageOf<cl_short>
+		{
+			static const InputStorage storage = INPUT_INT16;
+		};
+		template<>
+		struct InputStorageOf<cl_half>
+		{
+			static const InputStorage storage = INPUT_HALF;
+		};
+
+		//Basic buffer object from which all other buffer objects derive.
+		class NNBuffer
+		{
+		public:
+			//The operation that leads calculates this buffer.
+			NNOperationIdx from;
+
+			//An operation that uses this buffer. (Should be adapted to be a vector since multiple operations can use this buffer due to implicit copying).
+			NNOperationIdx to;
+
+			//The size of this buffer.
+			SizeVec size;
+
+			//The time offset for when this buffer is used
+			size_t timeOffset;
+
+			//The length of the sequence
+			const size_t sequenceSize;
+
+			//All indices that are not set to a specific real object are set to the maximal possible unsigned integer, thereby hinting at that the index is uninialized.
+			NNBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
+				size(sizeX, sizeY, sizeZ, sizeW), sequenceSize(sequenceSize), timeStep(0), forwardBuffer(), backwardBuffer(),
+				from(MAX_UNSIGNED_INT), to(MAX_UNSIGNED_INT), timeOffset(timeOffset), halfStorage(false), arena(MAX_UNSIGNED_INT), arenaOffset()
+			{
+				//This buffer contains a indices on a hardware sub buffer for each time step in forward and backward direction.
+				for (size_t i = 0; i < sequenceSize; ++i)
+				{
+					forwardBuffer.push_back(MAX_UNSIGNED_INT);
+					backwardBuffer.push_back(MAX_UNSIGNED_INT);
+				}
+			}
+
+			NNBuffer(const NNBuffer &other) :
+				size(other.size), forwardBuffer(other.forwardBuffer), backwardBuffer(other.backwardBuffer),
+				from(other.from), to(other.to), sequenceSize(other.sequenceSize), timeStep(other.timeStep), timeOffset(other.timeOffset), baseFwdBuffer(other.baseFwdBuffer), baseBwdBuffer(other.baseBwdBuffer),
+				halfStorage(other.halfStorage), arena(other.arena), arenaOffset(other.arenaOffset)
+			{}
+
+			const NNBuffer& operator=(const NNBuffer& other)
+			{
+				forwardBuffer = other.forwardBuffer;
+				backwardBuffer = other.backwardBuffer;
+				from = other.from;
+				to = other.to;
+
+				baseFwdBuffer = other.baseFwdBuffer;
+				baseBwdBuffer = other.baseBwdBuffer;
+
+				size = other.size;
+				timeStep = other.timeStep;
+				timeOffset = other.timeOffset;
+				halfStorage = other.halfStorage;
+				arena = other.arena;
+				arenaOffset = other.arenaOffset;
+
+				return *this;
+			}
+
+			//Returns a specific forward/backward sub buffer indice. ForwardBuffer is virtual since some buffers require a specific access.
+			virtual inline BufferIdx& ForwardBuffer(const size_t num){ return forwardBuffer[num]; }
+			inline BufferIdx& BackwardBuffer(const size_t num){ return backwardBuffer[num]; }
+
+			//Returns the forward/backward sub buffer of the current time step. This way the operation don't needs any explicit information about the time step since only the buffer need this information
+			inline BufferIdx& ForwardBuffer(){ return forwardBuffer[timeStep]; }
+			inline BufferIdx& BackwardBuffer(){ return backwardBuffer[timeStep]; }
+
+			inline void UpdateStep(){ timeStep = (timeStep + 1) % sequenceSize; } //Increases the current time step by one thereby returning the sub buffer for the next time step when ForwardBuffer/BackwardBuffer is called.
+			inline void Reset(){ timeStep = 0; };
+
+			//Returns references on the vector of forward/backward buffers.
+			inline std::vector<BufferIdx>& GetCompleteBackwardBuffer(){ return backwardBuffer; }
+			inline std::vector<BufferIdx>& GetCompleteForwardBuffer(){ return forwardBuffer; }
+
+			//Returns the current time step.
+			inline size_t GetCurTimeStep() const { return timeStep; }
+
+			//Returns the base hardware buffer which contains all sub buffers.
+			inline BufferIdx BaseForwardBuffer() const { return baseFwdBuffer; }
+			inline BufferIdx BaseBackwardBuffer() const { return baseBwdBuffer; }
+
+			//Sets the base hardware buffer.
+			inline void BaseFwdBuffer(BufferIdx fwdBuffer) { baseFwdBuffer = fwdBuffer; }
+			inline void BaseBwdBuffer(BufferIdx bwdBuffer) { baseBwdBuffer = bwdBuffer; }
+
+			//Creates the necessary hardware buffer and sub buffers.
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend){}
+
+			//Sets the w component of the size to be equal to the batchSize
+			virtual void SetBatchSize(const size_t batchSize);
+			
+			//Sets each backward buffer to zero. (Not all buffers need to do this)
+			virtual void Reset(BackendSystem::OpenCLBackend& backend);
+
+			//Returns true if the buffer can store its elements as half. Must be set before Instantiate is called.
+			virtual bool SupportsHalfStorage() const { return false; }
+			inline void SetHalfStorage(const bool halfStorage) { this->halfStorage = halfStorage && SupportsHalfStorage(); }
+			inline bool IsHalfStorage() const { return halfStorage; }
+
+			//Returns the size in bytes of one element in the hardware buffers.
+			inline size_t ElementSize() const { return halfStorage ? sizeof(cl_half) : sizeof(float); }
+			//Returns the size in bytes of one element in the forward buffers. Differs from ElementSize for input buffers storing a compact type.
+			virtual size_t ForwardElementSize() const { return ElementSize(); }
+
+			//Returns true if the forward sub buffers of all time steps lie behind each other in the base forward buffer. Operations can then process several time steps with one kernel.
+			virtual bool ContiguousTimeSteps() const { return true; }
+
+			//Returns the type of the data written into the forward buffers. Only input buffers store other types than float.
+			virtual InputStorage GetInputStorage() const { return INPUT_FLOAT; }
+			//Returns true if the host writes all time steps before the forward pass (See NNInputBuffer). State buffers aren't produced by an operation either, but their time steps are written during the pass.
+			virtual bool IsInput() const { return false; }
+
+			//Returns true if the forward sub buffers can be placed in a buffer shared with other buffers and be recomputed in the backward pass (See NeuralNetwork::SetAutomaticCheckpointing).
+			virtual bool SupportsRecompute() const { return false; }
+			//Places the forward sub buffer of time step t at offsets[t] bytes in arena. Must be set before Instantiate is called.
+			inline void SetRecompute(const BufferIdx arena, const std::vector<size_t>& offsets) { this->arena = arena; arenaOffset = offsets; }
+			inline bool IsRecomputed() const { return arena != MAX_UNSIGNED_INT; }
+
+
+		protected:
+			//Stores the indices on the hardware buffer that contains all sub buffers
+			BufferIdx baseFwdBuffer; 
+			BufferIdx baseBwdBuffer;
+
+			//Stores the indices on all hardware sub buffers.
+			std::vector<BufferIdx> forwardBuffer;
+			std::vector<BufferIdx> backwardBuffer;
+
+			//Stores the current time step.
+			size_t timeStep;
+
+			//True if the forward and backward buffers store half instead of float.
+			bool halfStorage;
+
+			//Buffer shared by the recomputed forward sub buffers and the offset in bytes of each time step in it (MAX_UNSIGNED_INT if the buffer is kept).
+			BufferIdx arena;
+			std::vector<size_t> arenaOffset;
+
+		};
+
+		class NNInputBuffer : public NNBuffer
+		{
+		public:
+			//numSlots specifies the number of hardware buffers the input rotates through. With more than one slot the next batch can be uploaded while the current batch is processed.
+			//storage is the type of the uploaded data, the forward buffers are only as big as needed for it.
+			NNInputBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0, const size_t numSlots = 1, const InputStorage storage = INPUT_FLOAT) :
+				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset), numSlots(numSlots), storage(storage), curSlot(0), stagedSlot(MAX_UNSIGNED_INT),
+				slotBuffer(numSlots), stagingMemory(numSlots), uploadEvent(numSlots), releaseEvent(numSlots), uploadPending(numSlots, false), releasePending(numSlots, false)
+			{}
+
+			NNInputBuffer(const NNInputBuffer& other) :
+				NNBuffer(other), numSlots(other.numSlots), storage(other.storage), curSlot(other.curSlot), stagedSlot(other.stagedSlot),
+				slotBuffer(other.slotBuffer), stagingMemory(other.stagingMemory), uploadEvent(other.uploadEvent), releaseEvent(other.releaseEvent), uploadPending(other.uploadPending), releasePending(other.releasePending)
+			{}
+
+			const NNInputBuffer& operator=(const NNInputBuffer& other)
+			{
+				NNBuffer::operator=(other);
+
+				numSlots = other.numSlots;
+				storage = other.storage;
+				curSlot = other.curSlot;
+				stagedSlot = other.stagedSlot;
+				slotBuffer = other.slotBuffer;
+				stagingMemory = other.stagingMemory;
+				uploadEvent = other.uploadEvent;
+				releaseEvent = other.releaseEvent;
+				uploadPending = other.uploadPending;
+				releasePending = other.releasePending;
+
+				return *this;
+			}
+			//Specific memory access. Forward input only needs read access
+			//If more than one slot is used each slot gets its own hardware buffer and the forward sub buffers are aliases which are bound to the slot currently in use.
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
+
+			//Uploads data into the next free slot using the upload queue of the backend. data contains numSubBuffer time steps behind each other for each batch element.
+			//stepSize is the size in bytes of one time step of one batch element. If only one time step is uploaded data must stay valid until the slot was swapped in.
+			bool Prefetch(BackendSystem::OpenCLBackend& backend, const void* data, const size_t stepSize, const size_t batchSize, const size_t numSubBuffer);
+
+			//Binds the slot filled by the last call of Prefetch to the forward sub buffers. The operations in the compute queue wait for the upload to finish.
+			//Returns false if nothing was prefetched.
+			bool SwapSlot(BackendSystem::OpenCLBackend& backend);
+
+			//Blocks until the data of the current slot was uploaded. Afterwards the host memory passed to Prefetch can be reused.
+			void WaitForUpload();
+
+			inline size_t GetNumSlots() const { return numSlots; }
+
+			//With more than one slot the forward sub buffers are aliases of the slot in use.
+			virtual bool ContiguousTimeSteps() const { return numSlots < 2; }
+
+			virtual InputStorage GetInputStorage() const { return storage; }
+			virtual bool IsInput() const { return true; }
+			virtual size_t ForwardElementSize() const { return InputStorageSize(storage); }
+
+		private:
+			size_t numSlots;
+			InputStorage storage;
+
+			//Slot currently bound to the forward sub buffers and the slot which was filled by Prefetch but not yet used.
+			size_t curSlot;
+			size_t stagedSlot;
+
+			//Sub buffers of each slot for each time step.
+			std::vector<std::vector<BufferIdx>> slotBuffer;
+
+			//Host memory used to reorder sequences before uploading them. Must stay alive until the upload finished.
+			std::vector<std::vector<char>> stagingMemory;
+
+			//uploadEvent finishes when the data of a slot was uploaded. releaseEvent finishes when the last operation reading the slot finished.
+			std::vector<cl::Event> uploadEvent;
+			std::vector<cl::Event> releaseEvent;
+			std::vector<bool> uploadPending;
+			std::vector<bool> releasePending;
+		};
+
+		class NNIntBuffer : public NNBuffer
+		{
+		public:
+			NNIntBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
+				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
+			{}
+
+			NNIntBuffer(const NNIntBuffer& other) :
+				NNBuffer(other)
+			{}
+
+			const NNIntBuffer& operator=(const NNIntBuffer& other)
+			{
+				NNBuffer::operator=(other);
+
+				return *this;
+			}
+			//All buffers have read write access.
+			//With half storage the sub buffers are registered at the backend, which selects the kernel variants reading and writing half.
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
+
+			//Intermediate buffers are only used by operations, therefore they can store half when the operations support it.
+			virtual bool SupportsHalfStorage() const { return true; }
+
+			//The forward sub buffers of a recomputed buffer lie in the arena and have no base buffer.
+			virtual bool SupportsRecompute() const { return true; }
+			virtual bool ContiguousTimeSteps() const { return !IsRecomputed(); }
+		};
+
+		class NNParamBuffer : public NNBuffer
+		{
+		public:
+			NNParamBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
+				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
+			{}
+
+			NNParamBuffer(const NNParamBuffer& other) :
+				NNBuffer(other)
+			{}
+
+			const NNParamBuffer& operator=(const NNParamBuffer& other)
+			{
+				NNBuffer::operator=(other);
+
+				return *this;
+			}
+
+			//This function is used to access auxilary buffers. Since parameter buffers otherwise only contain a buffer for one time step.
+			virtual inline BufferIdx& ForwardBuffer(const size_t num)
+			{
+				if (num < numAuxBuffer)
+					return auxBuffer[num];
+
+				std::cerr << "ERROR in GetAuxBuffer! num to high." << std::endl;
+				return	baseFwdBuffer;
+			}
+
+			//Used to set the number of auxilary buffers. All parameter buffers need the same number of auxilary buffers therefore this function is static.
+			static void SetNumAuxBuffer(const size_t numAuxBuffer);
+
+			//This function needs the number of auxilary buffers to be set. It creates a base forward buffer that can contain the normal forward.
+			//Only the base backward buffer is created since only the normal buffer has a backward component.
+			//The auxilary buffers are its own buffers and not hardware buffers.
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
+
+			//The parameter buffers are independent of the batch size.
+			virtual void SetBatchSize(const size_t batchSize)
+			{}
+
+			virtual BufferIdx GetAuxBuffer(const size_t num)
+			{
+				return auxBuffer[num];
+			}
+
+		private:
+			static size_t numAuxBuffer;
+			//Stores the indices of the hardware auxilary buffers.
+			std::vector<BufferIdx> auxBuffer;
+		};
+
+		class NNStateBuffer : public NNBuffer
+		{
+		public:
+			NNStateBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0, const bool carryState = false) :
+				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset), carryState(carryState)
+			{
+				//The state needs one additional buffer since when the output is computed, the next state is also computed, Thereby one more state is computed. The state at time step zero is often zero but there might be situations where it is initalized different from zero.
+				//Therefore the total number of sub buffers needed is the sequence size plus one.
+				forwardBuffer.push_back(MAX_UNSIGNED_INT);
+				backwardBuffer.push_back(MAX_UNSIGNED_INT);
+			}
+
+			NNStateBuffer(const NNStateBuffer& other) :
+				NNBuffer(other), carryState(other.carryState)
+			{}
+
+			const NNStateBuffer& operator=(const NNStateBuffer& other)
+			{
+				NNBuffer::operator=(other);
+				carryState = other.carryState;
+
+				return *this;
+			}
+			//It is the same as intermediate buffer but with an additional sub buffer for both passes
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
+			//Sets all buffers to zero. (Forward and backward)
+			//A buffer carrying its state copies the last forward sub buffer into the first one instead of setting it to zero. The gradient of the first sub buffer is discarded.
+			virtual void Reset(BackendSystem::OpenCLBackend& backend);
+
+			//Sets the first forward sub buffer to the last one if carry is true, otherwise to zero (Start of a new sequence). Only the first sub buffer is changed.
+			void ResetState(BackendSystem::OpenCLBackend& backend, const bool carry);
+
+			inline bool CarriesState() const { return carryState; }
+
+		private:
+			//True if the graph processes a long sequence in chunks of sequenceSize steps (Truncated backpropagation through time).
+			//The last state of a chunk is the first state of the next chunk.
+			bool carryState;
+		};
+
+		class NNTmpBuffer : public NNBuffer
+		{
+		public:
+			NNTmpBuffer(size_t sizeX, size_t sizeY, size_t sizeZ, size_t sizeW, const size_t sequenceSize = 1, const size_t timeOffset = 0) :
+				NNBuffer(sizeX, sizeY, sizeZ, sizeW, sequenceSize, timeOffset)
+			{
+			}
+
+			NNTmpBuffer(const NNTmpBuffer& other) :
+				NNBuffer(other)
+			{}
+
+			const NNTmpBuffer& operator=(const NNTmpBuffer& other)
+			{
+				NNBuffer::operator=(other);
+
+				return *this;
+			}
+			//Nothing needs to be done when reset is called
+			virtual void Reset(BackendSystem::OpenCLBackend& backend)
+			{}
+
+			//Creates only one sub buffer.
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend);
+
+			//Batch size is already contained in its size when it is created.
+			virtual void SetBatchSize(const size_t batchSize)
+			{}
+		};
+	}
+}
@@ -1,783 +1,1312 @@
-#include "NNOperations.h"
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-
-		void NNOp::SetBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
-		{
-			size_t size = input.size();
-			size_t i;
-			
-			//Set the to variable in each input buffer to point on this operation
-			for (i = 0; i < size; ++i)
-			{
-				NNBuffer* localBuffer = bufferList[input[i]];
-				localBuffer->to = op;
-				bufferList[input[i]] = localBuffer;
-			}
-
-			size = output.size();
-
-			//Set the from variable in each output buffer to point on this operation
-			for (i = 0; i < size; ++i)
-			{
-				NNBuffer* localBuffer = bufferList[output[i]];
-				localBuffer->from = op;
-				bufferList[output[i]] = localBuffer;
-			}
-		}
-
-		//In most cases the default time transformation does not change the sequence length. The output has the same length as the input.
-		size_t NNOp::GetTimeTransform(std::vector<NNBuffer*>& bufferList)
-		{
-			size_t maxTime = bufferList[input[0]]->sequenceSize;
-			const size_t numinputs = input.size() - timeOffset;
-			for (size_t i = 1; i < numinputs; ++i)
-			{
-				if (bufferList[input[i]]->sequenceSize > maxTime)
-					maxTime = bufferList[input[i]]->sequenceSize - timeOffset + bufferList[input[i]]->timeOffset;
-			}
-
-			timeSteps = maxTime;
-			return maxTime;
-		}
-
-		void NNMatMulOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			//The size of the work group that should be used by this function. In future a more general work group assigned should be employed.
-			const int WORK_GROUP_SIZE_X = 8;
-			const int WORK_GROUP_SIZE_Y = 8;
-
-			//Work per thread in x/y direction that each thread should perform.
-			const int WPTX = 1;
-			const int WPTY = 1;
-
-			//Store all input output buffers.
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferB = *bufferList[input[1]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			NNBuffer tmpBufferOBj = *bufferList[tmpBuffer[0]];
-
-			//Get the indices for the matrix multiplication kernel, matrix multiplication addition kernel (The result is added to the current buffer value) and the transpose kernel. 
-			KernelIdx matrixKernel = backend.GetKernelIdx("MatrixMul");
-			KernelIdx matrixKernelAdd = backend.GetKernelIdx("MatrixMulAdd");
-
-			KernelIdx transpose = backend.GetKernelIdx("Transpose");
-
-			//Create the tuple for the forward operation
-			//The ForwardBuffer function returns the sub buffer indice of the current time step that needs to be initalized. The backward behaves equivalent.
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeW), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeX));
-	
-			//Each gradient calculation requries an transposition which will be stored in the temporary buffer.
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleXTranspose(bufferA.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tupleXMatMul(tmpBufferOBj.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			const int bX = (bufferB.size.sizeX + WPTX - 1) / WPTX;
-			const int aY = (bufferA.size.sizeW + WPTY - 1) / WPTY;
-
-			//Add operations to the graph.
-			OperationIdx  matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(matrixKernel, tuple, cl::NullRange, cl::NDRange(((bX) + (WORK_GROUP_SIZE_X - (bX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (aY + (WORK_GROUP_SIZE_Y - (aY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-
-			const int cX = (bufferC.size.sizeX + WPTX - 1) / WPTX;
-			const int aXY = (bufferA.size.sizeX + WPTY - 1) / WPTY;
-			
-			//The backward operations must be added in oposite order, in which they should be executed, since the vector will perform the operations starting at the last operation.
-			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(matrixKernelAdd, tupleXMatMul, cl::NullRange, cl::NDRange(((cX)+(WORK_GROUP_SIZE_X - (cX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (aXY + (WORK_GROUP_SIZE_Y - (aXY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(transpose, tupleXTranspose, cl::NullRange, cl::NDRange(((bufferA.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferA.size.sizeW + (WORK_GROUP_SIZE_Y - (bufferA.size.sizeW%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleYTranspose(bufferB.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
-				dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tupleYMatMul(bufferC.BackwardBuffer(), tmpBufferOBj.ForwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), bufferC.size.sizeW), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeX));
-
-			const int bYX = (bufferB.size.sizeY + WPTX - 1) / WPTX;
-			const int cY = (bufferC.size.sizeW + WPTY - 1) / WPTY;
-
-			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(matrixKernelAdd, tupleYMatMul, cl::NullRange, cl::NDRange(((bYX) + (WORK_GROUP_SIZE_X - (bYX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (cY + (WORK_GROUP_SIZE_Y - (cY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(transpose, tupleYTranspose, cl::NullRange, cl::NDRange(((bufferB.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeY + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNMatMulOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			//Calculate the output sizes of the matrix multiplication given the input
-			return SizeVec(bufferList[input[1]]->size.sizeX, bufferList[input[0]]->size.sizeW);
-		}
-
-		void NNMatMulOp::SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
-		{
-			//The matrix multiplication needs a temporary buffer to store the results of the transposition.
-			size_t input0 = bufferList[input[0]]->size.sizeX * bufferList[input[0]]->size.sizeY *bufferList[input[0]]->size.sizeZ*bufferList[input[0]]->size.sizeW;
-			size_t input1 = bufferList[input[1]]->size.sizeX * bufferList[input[1]]->size.sizeY *bufferList[input[1]]->size.sizeZ*bufferList[input[1]]->size.sizeW;
-
-			tmpSizes.push_back(SizeVec(input0 > input1 ? input0 : input1));
-		}
-
-		void NNMatMulFlatOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 8;
-			const int WORK_GROUP_SIZE_Y = 8;
-
-			const int WPTX = 1;
-			const int WPTY = 1;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferB = *bufferList[input[1]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			NNBuffer tmpBufferOBj = *bufferList[tmpBuffer[0]];
-
-			KernelIdx matrixKernel = backend.GetKernelIdx("MatrixMul");
-			KernelIdx matrixKernelAdd = backend.GetKernelIdx("MatrixMulAdd");
-
-			KernelIdx transpose = backend.GetKernelIdx("Transpose");
-
-			const int flattenedSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeW), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), flattenedSize));
-		
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleXTranspose(bufferA.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
-				dataPair(sizeof(int), flattenedSize), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tupleXMatMul(tmpBufferOBj.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
- 				dataPair(sizeof(int), flattenedSize), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			const int bX = (bufferB.size.sizeX + WPTX - 1) / WPTX;
-			const int aW = (bufferA.size.sizeW + WPTY - 1) / WPTY;
-
-			OperationIdx  matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(matrixKernel, tuple, cl::NullRange, cl::NDRange(((bX) + (WORK_GROUP_SIZE_X - (bX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (aW + (WORK_GROUP_SIZE_Y - (aW%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-
-			const int cX = (bufferC.size.sizeW + WPTX - 1) / WPTX;
-			const int fY = (flattenedSize + WPTY - 1) / WPTY;
-
-			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(matrixKernelAdd, tupleXMatMul, cl::NullRange, cl::NDRange(((cX) + (WORK_GROUP_SIZE_X - (cX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (fY + (WORK_GROUP_SIZE_Y - (fY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(transpose, tupleXTranspose, cl::NullRange, cl::NDRange(((flattenedSize)+(WORK_GROUP_SIZE_X - (flattenedSize) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferA.size.sizeW + (WORK_GROUP_SIZE_Y - (bufferA.size.sizeW%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-
-			const int bYX = (bufferB.size.sizeY + WPTX - 1) / WPTX;
-			const int cY = (bufferC.size.sizeW + WPTY - 1) / WPTY;
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleYTranspose(bufferB.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
-				dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tupleYMatMul(bufferC.BackwardBuffer(), tmpBufferOBj.ForwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), bufferC.size.sizeW), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeX * bufferC.size.sizeY * bufferC.size.sizeZ));
-
-			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(matrixKernelAdd, tupleYMatMul, cl::NullRange, cl::NDRange(((bYX)+(WORK_GROUP_SIZE_X - (bYX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (cY + (WORK_GROUP_SIZE_Y - (cY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(transpose, tupleYTranspose, cl::NullRange, cl::NDRange(((bufferB.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeY + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNMatMulFlatOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return SizeVec(bufferList[input[1]]->size.sizeX, bufferList[input[0]]->size.sizeW);
-		}
-
-		void NNMatMulFlatOp::SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
-		{
-			size_t input0 = bufferList[input[0]]->size.sizeX * bufferList[input[0]]->size.sizeY *bufferList[input[0]]->size.sizeZ*bufferList[input[0]]->size.sizeW;
-			size_t input1 = bufferList[input[1]]->size.sizeX * bufferList[input[1]]->size.sizeY *bufferList[input[1]]->size.sizeZ*bufferList[input[1]]->size.sizeW;
-
-			tmpSizes.push_back(SizeVec(input0 > input1 ? input0 : input1));
-		}
-
-		void NNConvOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 8;
-			const int WORK_GROUP_SIZE_Y = 8;
-
-			//const int WORK_GROUP_SIZE_X = 8;
-			//const int WORK_GROUP_SIZE_Y = 8;
-			//const int WORK_GROUP_SIZE_Z = 4;
-
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferB = *bufferList[input[1]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			NNBuffer tmpBufferOBj = *bufferList[tmpBuffer[0]];
-
-			if (pad == -1)
-				pad = ConvType::VALID == convType ? 0 : (convType == ConvType::SAME ? bufferB.size.sizeX >> 1 : bufferB.size.sizeX - 1);
-
-			KernelIdx kernel = backend.GetKernelIdx("Convolution");//, "WIDTH_KERNEL=" + std::to_string(bufferB.size.sizeX) + " HEIGHT_KERNEL=" + std::to_string(bufferB.size.sizeY) + " STRIDE_X=" + std::to_string(strideX) + " STRIDE_Y=" + std::to_string(strideY) + " TILE_WIDTH=" + std::to_string(WORK_GROUP_SIZE_X) + " TILE_HEIGHT=" + std::to_string(WORK_GROUP_SIZE_Y)); // +" TILE_DEPTH=" + std::to_string(WORK_GROUP_SIZE_Z));
-			KernelIdx kernelConvAdd = backend.GetKernelIdx("ConvolutionAdd");
-			KernelIdx kernelGradWgt = backend.GetKernelIdx("ConvolutionWeightGrad");
-			KernelIdx kernelReorder = backend.GetKernelIdx("RotateAndReorder");
-
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeZ), dataPair(sizeof(int), bufferB.size.sizeW), dataPair(sizeof(int), pad), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			size_t numOutputs = ((bufferC.size.sizeX + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X)*WORK_GROUP_SIZE_X * (bufferC.size.sizeY);
-
-			//size_t sizeX = ((bufferC.size.sizeX + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X)*WORK_GROUP_SIZE_X;
-			//size_t sizeY = ((bufferC.size.sizeY + WORK_GROUP_SIZE_Y - 1) / WORK_GROUP_SIZE_Y)*WORK_GROUP_SIZE_Y;
-			//size_t sizeZ = ((bufferC.size.sizeZ + WORK_GROUP_SIZE_Z - 1) / WORK_GROUP_SIZE_Z)*WORK_GROUP_SIZE_Z*bufferC.size.sizeW;
-
-			OperationIdx  op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange(numOutputs, (bufferB.size.sizeW + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeW %WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y), (bufferA.size.sizeW + (2 - (bufferA.size.sizeW % 2)) % 2)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			//OperationIdx  op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange(sizeX, sizeY, sizeZ), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, WORK_GROUP_SIZE_Z), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-
-
-			forwardOpIdx.push_back(op);
-			//size_t tmp = ((bufferC.size.sizeX + 2 * pad + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferC.size.sizeY + 2 * pad) * WORK_GROUP_SIZE_X) + (WORK_GROUP_SIZE_X - ((((bufferC.size.sizeX + 2 * pad + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferC.size.sizeY + 2 * pad) * WORK_GROUP_SIZE_X)) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X);
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair> tupleGradWgt(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), dataPair(sizeof(int), bufferC.size.sizeZ), dataPair(sizeof(int), pad), dataPair(sizeof(int), bufferA.size.sizeW));
-			op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(kernelGradWgt, tupleGradWgt, cl::NullRange, cl::NDRange(((bufferB.size.sizeX * bufferB.size.sizeY * bufferA.size.sizeZ) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX * bufferB.size.sizeY * bufferA.size.sizeZ) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), ((bufferB.size.sizeW) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeW) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(op);
-
-			const int gradPadding = bufferB.size.sizeX - 1 - pad;
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair> tupleGradImg(bufferC.BackwardBuffer(), tmpBufferOBj.ForwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeW), dataPair(sizeof(int), bufferB.size.sizeZ), dataPair(sizeof(int), gradPadding), dataPair(sizeof(int), bufferA.size.sizeW));
-			op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(kernelConvAdd, tupleGradImg, cl::NullRange, cl::NDRange(((bufferA.size.sizeX + 2 * gradPadding + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferA.size.sizeY + 2 * gradPadding) * WORK_GROUP_SIZE_X) + (WORK_GROUP_SIZE_X - ((((bufferA.size.sizeX + 2 * gradPadding + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferA.size.sizeY + 2 * gradPadding) * WORK_GROUP_SIZE_X)) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeZ + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeZ %WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y), (bufferA.size.sizeW + (2 - (bufferA.size.sizeW % 2)) % 2)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(op);
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair> tupleYTranspose(bufferB.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
-				dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeZ), dataPair(sizeof(int), bufferB.size.sizeW));
-			op = backend.AddOperation<6, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair>(kernelReorder, tupleYTranspose, cl::NullRange, cl::NDRange(((bufferB.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeY + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeY % WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y), ((bufferB.size.sizeZ * bufferB.size.sizeW) + (2 - ((bufferB.size.sizeZ * bufferB.size.sizeW) % 2)) % 2)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(op);
-		}
-
-		SizeVec NNConvOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			SizeVec buf0 = bufferList[input[0]]->size;
-			SizeVec buf1 = bufferList[input[1]]->size;
-
-			if (pad == -1)
-			{
-				if (convType == ConvType::FULL)
-					return SizeVec(buf0.sizeX + 2 * ((buf1.sizeX >> 1)), buf0.sizeY + 2 * ((buf1.sizeY >> 1)), buf1.sizeW, buf0.sizeW);
-				else if (convType == ConvType::VALID)
-					return SizeVec(buf0.sizeX - 2 * (buf1.sizeX >> 1), buf0.sizeY - 2 * (buf1.sizeY >> 1), buf1.sizeW, buf0.sizeW);
-				else
-					return SizeVec(buf0.sizeX, buf0.sizeY, buf1.sizeW, buf0.sizeW);
-			}
-			else
-				return SizeVec((buf0.sizeX - buf1.sizeX + 2 * pad + strideX) / strideX, (buf0.sizeY - buf1.sizeY + 2 * pad + strideY) / strideY, buf1.sizeW, buf0.sizeW);
-
-		}
-
-		void NNConvOp::SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
-		{
-			tmpSizes.push_back(SizeVec(bufferList[input[1]]->size.sizeX * bufferList[input[1]]->size.sizeY *bufferList[input[1]]->size.sizeZ*bufferList[input[1]]->size.sizeW));
-		}
-
-		void NNCopyInitOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ * bufferA.size.sizeW;
-
-			if (bufferC.GetCurTimeStep() == 0)
-			{
-				Tuple<BufferIdx, BufferIdx, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-					dataPair(sizeof(int), totalSize));
-				Tuple<BufferIdx, BufferIdx, dataPair> tupleGrad(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-					dataPair(sizeof(int), totalSize));
-
-				KernelIdx reluKernel = backend.GetKernelIdx("Copy");
-				KernelIdx reluKernelGrad = backend.GetKernelIdx("CopyAdd");
-
-				OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(reluKernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-				forwardOpIdx.push_back(matOp);
-				matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(reluKernelGrad, tupleGrad, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-				backwardOpIdx.push_back(matOp);
-			}
-		}
-
-		SizeVec NNCopyInitOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNReLUOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx reluKernel = backend.GetKernelIdx("ReLU");
-			KernelIdx reluKernelGrad = backend.GetKernelIdx("ReLUGrad");
-
-			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(reluKernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, dataPair>(reluKernelGrad, tupleGrad, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X)%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNReLUOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-
-		void NNTanhOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx reluKernel = backend.GetKernelIdx("Tanh");
-			KernelIdx reluKernelGrad = backend.GetKernelIdx("TanhGrad");
-
-			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(reluKernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, dataPair>(reluKernelGrad, tupleGrad, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNTanhOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNElemWiseProductOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferB = *bufferList[input[1]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair> tupleGrad2(bufferB.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx reluKernel = backend.GetKernelIdx("ElemWiseProduct");
-			KernelIdx reluKernelGrad = backend.GetKernelIdx("ElemWiseProductAdd");
-
-			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, dataPair>(reluKernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, dataPair>(reluKernelGrad, tupleGrad, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, dataPair>(reluKernelGrad, tupleGrad2, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNElemWiseProductOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNSplitOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferC.size.sizeX * bufferC.size.sizeY;
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair ,dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), static_cast<int>(bufferC.GetCurTimeStep())), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair> tupleGrad(bufferA.BackwardBuffer(), bufferC.BackwardBuffer(),
-				dataPair(sizeof(int), static_cast<int>(bufferC.GetCurTimeStep())), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			KernelIdx reluKernel = backend.GetKernelIdx("SplitData");
-			KernelIdx reluKernelGrad = backend.GetKernelIdx("SplitDataGrad");
-
-			OperationIdx  matOp = backend.AddOperation<9, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(reluKernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X)), (bufferA.size.sizeZ + 2 - (bufferA.size.sizeZ%2)), (bufferA.size.sizeW + 2 - (bufferA.size.sizeW%2))), cl::NDRange(WORK_GROUP_SIZE_X, 1, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<9, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(reluKernelGrad, tupleGrad, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X)), (bufferA.size.sizeZ + 2 - (bufferA.size.sizeZ%2)), (bufferA.size.sizeW + 2 - (bufferA.size.sizeW%2))), cl::NDRange(WORK_GROUP_SIZE_X, 1, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNSplitOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return SizeVec(w, h, bufferList[input[0]]->size.sizeZ, bufferList[input[0]]->size.sizeW);
-		}
-
-		size_t NNSplitOp::GetTimeTransform(std::vector<NNBuffer*>& bufferList)
-		{
-			SizeVec size = bufferList[input[0]]->size;
-			size_t time = ((size.sizeX + w - 1) / w) * ((size.sizeY + h - 1)/h);
-			return time;
-		}
-
-		void NNMaxPoolingOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 8;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ * bufferA.size.sizeW), dataPair(sizeof(int), stride), dataPair(sizeof(int), padX), dataPair(sizeof(int), padY), dataPair(sizeof(int), size));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ * bufferA.size.sizeW), dataPair(sizeof(int), stride), dataPair(sizeof(int), padX), dataPair(sizeof(int), padY), dataPair(sizeof(int), size));
-
-			KernelIdx maxPoolingKernel = backend.GetKernelIdx("MaxPooling");
-			KernelIdx maxPoolingKernelGrad = backend.GetKernelIdx("MaxPoolingGrad");
-
-			OperationIdx  matOp = backend.AddOperation<9, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(maxPoolingKernel, tuple, cl::NullRange, cl::NDRange((bufferC.size.sizeX + WORK_GROUP_SIZE_X - (bufferC.size.sizeX%WORK_GROUP_SIZE_X)), (bufferC.size.sizeY + WORK_GROUP_SIZE_X - (bufferC.size.sizeY%WORK_GROUP_SIZE_X)), ((bufferC.size.sizeZ*bufferC.size.sizeW) + WORK_GROUP_SIZE_X - ((bufferC.size.sizeZ*bufferC.size.sizeW )%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<10, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair>(maxPoolingKernelGrad, tupleGrad, cl::NullRange, cl::NDRange((bufferC.size.sizeX + WORK_GROUP_SIZE_X - (bufferC.size.sizeX%WORK_GROUP_SIZE_X)), (bufferC.size.sizeY + WORK_GROUP_SIZE_X - (bufferC.size.sizeY%WORK_GROUP_SIZE_X)), ((bufferC.size.sizeZ*bufferC.size.sizeW) + WORK_GROUP_SIZE_X - ((bufferC.size.sizeZ*bufferC.size.sizeW) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNMaxPoolingOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			SizeVec tmpSize = bufferList[input[0]]->size;
-			return SizeVec((tmpSize.sizeX - size + padX) / stride + 1, (tmpSize.sizeY - size + padY) / stride + 1, tmpSize.sizeZ, tmpSize.sizeW);
-		}
-
-		void NNMatTransposeOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 8;
-			const int WORK_GROUP_SIZE_Y = 8;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleGrad(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			KernelIdx reluKernel = backend.GetKernelIdx("Transpose");
-
-			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(reluKernel, tuple, cl::NullRange, cl::NDRange(((bufferA.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferA.size.sizeW + (WORK_GROUP_SIZE_Y - (bufferA.size.sizeW%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNMatTransposeOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			SizeVec sizeV = bufferList[0]->size;
-			return SizeVec(sizeV.sizeY, sizeV.sizeX, sizeV.sizeZ, sizeV.sizeW);
-		}
-
-		void NNLeastSquaresOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-			NNBuffer labelBuffer = *bufferList[input[1]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tupleGrad(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			KernelIdx kernel = backend.GetKernelIdx("MeanSquaredError");
-			KernelIdx kernelGrad = backend.GetKernelIdx("MeanSquaredErrorGrad");
-
-			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((bufferA.size.sizeW + WORK_GROUP_SIZE_X - (bufferA.size.sizeW%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(kernelGrad, tupleGrad, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNLeastSquaresOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return SizeVec(1);
-		}
-
-		void NNAddBiasOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-			NNBuffer bufferB = *bufferList[input[1]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleGradB(bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
-				dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, dataPair> tupleGradA(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(), 
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx kernel = backend.GetKernelIdx("AddToMatrix");
-			KernelIdx kernelGradB = backend.GetKernelIdx("AddToMatrixGrad");
-			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
-
-			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernelGradA, tupleGradA, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(kernelGradB, tupleGradB, cl::NullRange, cl::NDRange((bufferC.size.sizeX + (WORK_GROUP_SIZE_X - (bufferC.size.sizeX %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNAddBiasOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNAddOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-			NNBuffer bufferB = *bufferList[input[1]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW * bufferA.size.sizeY * bufferA.size.sizeZ;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(bufferC.GetCurTimeStep() + timeResult),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, dataPair> tupleGradB(bufferC.BackwardBuffer(bufferC.GetCurTimeStep() + timeResult), bufferB.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, dataPair> tupleGradA(bufferC.BackwardBuffer(bufferC.GetCurTimeStep() + timeResult), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx kernel = backend.GetKernelIdx("Add");
-			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
-
-			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernelGradA, tupleGradA, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernelGradA, tupleGradB, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNAddOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNCopyOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW * bufferA.size.sizeY * bufferA.size.sizeZ;
-
-			Tuple<BufferIdx, BufferIdx, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(bufferC.GetCurTimeStep() + timeResult),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, dataPair> tupleGradB(bufferC.BackwardBuffer(bufferC.GetCurTimeStep() + timeResult), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx kernel = backend.GetKernelIdx("Copy");
-			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
-
-			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernelGradA, tupleGradB, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNCopyOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNSubConstOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW * bufferA.size.sizeY * bufferA.size.sizeZ;
-
-			Tuple<BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				std::pair<size_t, float>(sizeof(float), co), dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, dataPair> tupleGradA(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx kernel = backend.GetKernelIdx("SubtractFromConst");
-			KernelIdx kernelGradA = backend.GetKernelIdx("SubtractFromConstGrad");
-
-			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernelGradA, tupleGradA, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNSubConstOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNAddBiasConvOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-			NNBuffer bufferB = *bufferList[input[1]];
-
-			size_t totalImageSize = bufferA.size.sizeX * bufferA.size.sizeY;
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX * bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tupleGradB(bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
-				dataPair(sizeof(int), bufferC.size.sizeX * bufferC.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeZ), dataPair(sizeof(int), bufferC.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, dataPair> tupleGradA(bufferC.BackwardBuffer(), bufferA.BackwardBuffer()
-				, dataPair(sizeof(int), totalSize));
-
-			KernelIdx kernel = backend.GetKernelIdx("AddToImageTensor");
-			KernelIdx kernelGradB = backend.GetKernelIdx("AddToImageTensorGrad");
-			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
-
-			OperationIdx  matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernelGradA, tupleGradA, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<5, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(kernelGradB, tupleGradB, cl::NullRange, cl::NDRange((bufferC.size.sizeZ + (WORK_GROUP_SIZE_X - (bufferC.size.sizeZ %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNAddBiasConvOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNCrossEntropyOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 8;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-			NNBuffer labelBuffer = *bufferList[input[1]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair> tupleGrad(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			KernelIdx kernel = backend.GetKernelIdx("CrossEntropy");
-			KernelIdx kernelGrad = backend.GetKernelIdx("CrossEntropyGrad");
-
-			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((bufferA.size.sizeW + WORK_GROUP_SIZE_X - (bufferA.size.sizeW%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair>(kernelGrad, tupleGrad, cl::NullRange, cl::NDRange((bufferA.size.sizeX + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), (bufferA.size.sizeW + (WORK_GROUP_SIZE_X - (bufferA.size.sizeW %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNCrossEntropyOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return SizeVec(1);
-		}
-
-		void NNClassificationRewardOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 8;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-			NNBuffer labelBuffer = *bufferList[input[1]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			KernelIdx kernel = backend.GetKernelIdx("CalcR");
-
-			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((bufferA.size.sizeW + WORK_GROUP_SIZE_X - (bufferA.size.sizeW%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNClassificationRewardOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return SizeVec(1);
-		}
-
-		void NNSoftMaxOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 8;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tupleGrad(bufferC.BackwardBuffer(), bufferC.ForwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeW));
-
-			KernelIdx kernel = backend.GetKernelIdx("Softmax");
-			KernelIdx kernelGrad = backend.GetKernelIdx("SoftmaxGrad");
-
-			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((bufferA.size.sizeW + WORK_GROUP_SIZE_X - (bufferA.size.sizeW%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(kernelGrad, tupleGrad, cl::NullRange, cl::NDRange((bufferA.size.sizeX + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), (bufferA.size.sizeW + (WORK_GROUP_SIZE_X - (bufferA.size.sizeW %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNSoftMaxOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-
-		void NNSigmoidOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
-		{
-			const int WORK_GROUP_SIZE_X = 64;
-
-			NNBuffer bufferA = *bufferList[input[0]];
-			NNBuffer bufferC = *bufferList[output[0]];
-
-			size_t totalSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ * bufferA.size.sizeW;
-
-			Tuple<BufferIdx, BufferIdx, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair> tupleGrad(bufferC.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
-				dataPair(sizeof(int), totalSize));
-
-			KernelIdx reluKernel = backend.GetKernelIdx("Sigmoid");
-			KernelIdx reluKernelGrad = backend.GetKernelIdx("SigmoidGrad");
-
-			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(reluKernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			forwardOpIdx.push_back(matOp);
-			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, dataPair>(reluKernelGrad, tupleGrad, cl::NullRange, cl::NDRange((totalSize + (WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			backwardOpIdx.push_back(matOp);
-		}
-
-		SizeVec NNSigmoidOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
-		{
-			return bufferList[input[0]]->size;
-		}
-	}
-}
\ No newline at end of file
+#include "NNOperations.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		BufferIdx NNOp::lossScaleBuffer = MAX_UNSIGNED_INT;
+
+		void NNOp::SetLossScaleBuffer(const BufferIdx lossScaleBuffer)
+		{
+			NNOp::lossScaleBuffer = lossScaleBuffer;
+		}
+
+		void NNOp::AddLossScaling(BackendSystem::OpenCLBackend& backend, NNBuffer& buffer)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			const int elementSize = buffer.size.sizeX * buffer.size.sizeY * buffer.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tuple(buffer.BackwardBuffer(), lossScaleBuffer, backend.BatchArg(elementSize));
+
+			KernelIdx kernel = backend.GetKernelIdx("ScaleByBuffer");
+
+			OperationIdx matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		void NNOp::AddQuantizedMatMul(BackendSystem::OpenCLBackend& backend, NNBuffer& bufferA, NNBuffer& bufferB, NNBuffer& bufferC, const size_t wA, const QuantizedBuffer& weights, const float activationScale)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+			const int WORK_GROUP_SIZE_Y = 8;
+
+			const size_t wB = bufferB.size.sizeX;
+			//Each column is padded to a multiple of four, allowing the kernel to load char4 vectors
+			const size_t wAPadded = (wA + 3) / 4 * 4;
+
+			//All time steps share the weights, therefore they are uploaded once
+			if (quantWeights == MAX_UNSIGNED_INT)
+				UploadQuantized(backend, weights, activationScale);
+
+			KernelIdx kernel = backend.GetKernelIdx("QuantMatrixMul");
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair, dataPair, std::pair<size_t, const float*>> tuple(bufferA.ForwardBuffer(), quantWeights, quantScales, bufferC.ForwardBuffer(),
+				backend.BatchArg(1), dataPair(sizeof(int), wB), dataPair(sizeof(int), wA), dataPair(sizeof(int), wAPadded), std::pair<size_t, const float*>(sizeof(float), &quantActivationScale));
+
+			backend.AddOperation<9, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair, dataPair, std::pair<size_t, const float*>>(kernel, tuple, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((wB)+(WORK_GROUP_SIZE_X - (wB) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+		}
+
+		void NNOp::SetQuantizedMatMulLayout(const QuantizedBuffer& weights)
+		{
+			//Each column has its own scale
+			const size_t wB = weights.numChannels;
+			const size_t wA = weights.values.size() / wB;
+			const size_t wAPadded = (wA + 3) / 4 * 4;
+
+			quantLayout.assign(wAPadded * wB, 0);
+			for (size_t k = 0; k < wA; ++k)
+				for (size_t col = 0; col < wB; ++col)
+					quantLayout[col * wAPadded + k] = weights.values[k * wB + col];
+		}
+
+		void NNOp::UploadQuantized(BackendSystem::OpenCLBackend& backend, const QuantizedBuffer& weights, const float activationScale)
+		{
+			SetQuantizedLayout(weights);
+			quantActivationScale = activationScale;
+
+			if (quantWeights == MAX_UNSIGNED_INT)
+			{
+				quantWeights = backend.CreateBuffer(quantLayout.size(), BackendSystem::MEM_FLAG::READ_ONLY, 1);
+				quantScales = backend.CreateBuffer(sizeof(float) * weights.scales.size(), BackendSystem::MEM_FLAG::READ_ONLY, 1);
+			}
+			backend.WriteDataBuffer(quantWeights, quantLayout.data(), 0, quantLayout.size());
+			backend.WriteDataBuffer(quantScales, weights.scales.data(), 0, sizeof(float) * weights.scales.size());
+		}
+
+		void NNOp::SetBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
+		{
+			size_t size = input.size();
+			size_t i;
+			
+			//Set the to variable in each input buffer to point on this operation
+			for (i = 0; i < size; ++i)
+			{
+				NNBuffer* localBuffer = bufferList[input[i]];
+				localBuffer->to = op;
+				bufferList[input[i]] = localBuffer;
+			}
+
+			size = output.size();
+
+			//Set the from variable in each output buffer to point on this operation
+			for (i = 0; i < size; ++i)
+			{
+				NNBuffer* localBuffer = bufferList[output[i]];
+				localBuffer->from = op;
+				bufferList[output[i]] = localBuffer;
+			}
+		}
+
+		//In most cases the default time transformation does not change the sequence length. The output has the same length as the input.
+		size_t NNOp::GetTimeTransform(std::vector<NNBuffer*>& bufferList)
+		{
+			size_t maxTime = bufferList[input[0]]->sequenceSize;
+			const size_t numinputs = input.size() - timeOffset;
+			for (size_t i = 1; i < numinputs; ++i)
+			{
+				if (bufferList[input[i]]->sequenceSize > maxTime)
+					maxTime = bufferList[input[i]]->sequenceSize - timeOffset + bufferList[input[i]]->timeOffset;
+			}
+
+			timeSteps = maxTime;
+			return maxTime;
+		}
+
+		//Distance in floats between the time steps of a buffer in its base buffer. Each sub buffer starts at a multiple of the base address alignment.
+		static int StepStride(const BackendSystem::OpenCLBackend& backend, const NNBuffer& buffer)
+		{
+			const size_t allign = backend.GetBaseAddrAllignment();
+			const size_t stepSize = buffer.size.sizeX * buffer.size.sizeY * buffer.size.sizeZ * buffer.size.sizeW * sizeof(float);
+			return static_cast<int>(allign * ((stepSize + allign - 1) / allign) / sizeof(float));
+		}
+
+		void NNMatMulOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			//The size of the work group that should be used by this function. In future a more general work group assigned should be employed.
+			const int WORK_GROUP_SIZE_X = 8;
+			const int WORK_GROUP_SIZE_Y = 8;
+
+			//Work per thread in x/y direction that each thread should perform.
+			const int WPTX = 1;
+			const int WPTY = 1;
+
+			//Store all input output buffers.
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			NNBuffer tmpBufferOBj = *bufferList[tmpBuffer[0]];
+
+			//Get the indices for the matrix multiplication kernel, matrix multiplication addition kernel (The result is added to the current buffer value) and the transpose kernel. 
+			KernelIdx matrixKernel = backend.GetKernelIdx("MatrixMul");
+			KernelIdx matrixKernelAdd = backend.GetKernelIdx("MatrixMulAdd");
+
+			KernelIdx transpose = backend.GetKernelIdx("Transpose");
+
+			//Create the tuple for the forward operation
+			//The ForwardBuffer function returns the sub buffer indice of the current time step that needs to be initalized. The backward behaves equivalent.
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
+				backend.BatchArg(1), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeX));
+	
+			//Each gradient calculation requries an transposition which will be stored in the temporary buffer.
+			Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument> tupleXTranspose(bufferA.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument> tupleXMatMul(tmpBufferOBj.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeX), backend.BatchArg(1));
+
+			const int bX = (bufferB.size.sizeX + WPTX - 1) / WPTX;
+
+			//Add operations to the graph.
+			OperationIdx  matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair>(matrixKernel, tuple, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((bX) + (WORK_GROUP_SIZE_X - (bX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+
+			const int cX = (bufferC.size.sizeX + WPTX - 1) / WPTX;
+			const int aXY = (bufferA.size.sizeX + WPTY - 1) / WPTY;
+			
+			//The backward operations must be added in oposite order, in which they should be executed, since the vector will perform the operations starting at the last operation.
+			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument>(matrixKernelAdd, tupleXMatMul, cl::NullRange, cl::NDRange(((cX)+(WORK_GROUP_SIZE_X - (cX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (aXY + (WORK_GROUP_SIZE_Y - (aXY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, BatchArgument>(transpose, tupleXTranspose, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((bufferA.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+
+			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleYTranspose(bufferB.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
+				dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair> tupleYMatMul(bufferC.BackwardBuffer(), tmpBufferOBj.ForwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(1), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeX));
+
+			const int bYX = (bufferB.size.sizeY + WPTX - 1) / WPTX;
+
+			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair>(matrixKernelAdd, tupleYMatMul, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((bYX) + (WORK_GROUP_SIZE_X - (bYX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(transpose, tupleYTranspose, cl::NullRange, cl::NDRange(((bufferB.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeY + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNMatMulOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			//Calculate the output sizes of the matrix multiplication given the input
+			return SizeVec(bufferList[input[1]]->size.sizeX, bufferList[input[0]]->size.sizeW);
+		}
+
+		void NNMatMulOp::SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
+		{
+			//The matrix multiplication needs a temporary buffer to store the results of the transposition.
+			size_t input0 = bufferList[input[0]]->size.sizeX * bufferList[input[0]]->size.sizeY *bufferList[input[0]]->size.sizeZ*bufferList[input[0]]->size.sizeW;
+			size_t input1 = bufferList[input[1]]->size.sizeX * bufferList[input[1]]->size.sizeY *bufferList[input[1]]->size.sizeZ*bufferList[input[1]]->size.sizeW;
+
+			tmpSizes.push_back(SizeVec(input0 > input1 ? input0 : input1));
+		}
+
+		bool NNMatMulOp::GetQuantizedChannels(std::vector<NNBuffer*>& bufferList, size_t& numChannels, size_t& channelStride) const
+		{
+			//Each output column has its own scale
+			numChannels = bufferList[input[1]]->size.sizeX;
+			channelStride = 1;
+			return true;
+		}
+
+		void NNMatMulOp::InstantiateQuantized(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, const QuantizedBuffer& weights, const float activationScale)
+		{
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			AddQuantizedMatMul(backend, bufferA, bufferB, bufferC, bufferA.size.sizeX, weights, activationScale);
+		}
+
+		void NNMatMulFlatOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+			const int WORK_GROUP_SIZE_Y = 8;
+
+			const int WPTX = 1;
+			const int WPTY = 1;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			//The time steps of the input are complete before the first instance runs, if they all lie in the base buffer one instance can process them.
+			if (hoistSteps && firstStep == MAX_UNSIGNED_INT)
+			{
+				firstStep = bufferC.GetCurTimeStep();
+				allSteps = bufferList[input[0]]->ContiguousTimeSteps() && bufferA.GetCurTimeStep() + bufferC.sequenceSize - firstStep <= bufferA.sequenceSize;
+			}
+			if (allSteps)
+			{
+				if (bufferC.GetCurTimeStep() == firstStep)
+					InstantiateAllSteps(backend, bufferA, bufferB, bufferC);
+				return;
+			}
+
+			NNBuffer tmpBufferOBj = *bufferList[tmpBuffer[0]];
+
+			KernelIdx matrixKernel = backend.GetKernelIdx("MatrixMul");
+			KernelIdx matrixKernelAdd = backend.GetKernelIdx("MatrixMulAdd");
+
+			KernelIdx transpose = backend.GetKernelIdx("Transpose");
+
+			const int flattenedSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
+				backend.BatchArg(1), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), flattenedSize));
+		
+
+			Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument> tupleXTranspose(bufferA.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
+				dataPair(sizeof(int), flattenedSize), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument> tupleXMatMul(tmpBufferOBj.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
+ 				dataPair(sizeof(int), flattenedSize), dataPair(sizeof(int), bufferC.size.sizeX), backend.BatchArg(1));
+
+			const int bX = (bufferB.size.sizeX + WPTX - 1) / WPTX;
+
+			OperationIdx  matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair>(matrixKernel, tuple, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((bX) + (WORK_GROUP_SIZE_X - (bX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+
+			const int cX = (bufferC.size.sizeW + WPTX - 1) / WPTX;
+			const int fY = (flattenedSize + WPTY - 1) / WPTY;
+
+			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument>(matrixKernelAdd, tupleXMatMul, cl::NullRange, cl::NDRange(((cX) + (WORK_GROUP_SIZE_X - (cX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (fY + (WORK_GROUP_SIZE_Y - (fY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, BatchArgument>(transpose, tupleXTranspose, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((flattenedSize)+(WORK_GROUP_SIZE_X - (flattenedSize) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+
+			const int bYX = (bufferB.size.sizeY + WPTX - 1) / WPTX;
+
+			Tuple<BufferIdx, BufferIdx, dataPair, dataPair> tupleYTranspose(bufferB.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
+				dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair> tupleYMatMul(bufferC.BackwardBuffer(), tmpBufferOBj.ForwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(1), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeX * bufferC.size.sizeY * bufferC.size.sizeZ));
+
+			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, BatchArgument, dataPair, dataPair>(matrixKernelAdd, tupleYMatMul, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((bYX)+(WORK_GROUP_SIZE_X - (bYX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, dataPair>(transpose, tupleYTranspose, cl::NullRange, cl::NDRange(((bufferB.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeY + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeY%WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		void NNMatMulFlatOp::InstantiateAllSteps(BackendSystem::OpenCLBackend& backend, NNBuffer& bufferA, NNBuffer& bufferB, NNBuffer& bufferC)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+			const int WORK_GROUP_SIZE_Y = 8;
+
+			const int flattenedSize = static_cast<int>(bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ);
+			const int wB = static_cast<int>(bufferB.size.sizeX);
+			const int numSteps = static_cast<int>(bufferC.sequenceSize - firstStep);
+
+			//The sub buffers are padded to the base address alignment, the kernels skip the padding using the distance between the time steps.
+			const int aStride = StepStride(backend, bufferA);
+			const int aOffset = static_cast<int>(bufferA.GetCurTimeStep()) * aStride;
+			const int cStride = StepStride(backend, bufferC);
+			const int cOffset = static_cast<int>(firstStep) * cStride;
+
+			const int bX = wB + (WORK_GROUP_SIZE_X - wB % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X;
+			const int fX = flattenedSize + (WORK_GROUP_SIZE_X - flattenedSize % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X;
+			const int fY = flattenedSize + (WORK_GROUP_SIZE_Y - flattenedSize % WORK_GROUP_SIZE_Y) % WORK_GROUP_SIZE_Y;
+
+			KernelIdx stepsKernel = backend.GetKernelIdx("MatrixMulSteps");
+			KernelIdx inputGradKernel = backend.GetKernelIdx("MatrixMulStepsInputGrad");
+			KernelIdx weightGradKernel = backend.GetKernelIdx("MatrixMulStepsWeightGrad");
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair> tuple(bufferA.BaseForwardBuffer(), bufferB.ForwardBuffer(), bufferC.BaseForwardBuffer(),
+				dataPair(sizeof(int), aOffset), dataPair(sizeof(int), aStride), dataPair(sizeof(int), cOffset), dataPair(sizeof(int), cStride), backend.BatchArg(1), dataPair(sizeof(int), wB), dataPair(sizeof(int), flattenedSize));
+
+			OperationIdx matOp = backend.AddOperation<10, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair>(stepsKernel, tuple, cl::NullRange, BatchRange(3, 1, 1, WORK_GROUP_SIZE_Y, bX, 1, numSteps), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+
+			//Added by the first time step, thereby the gradients of the outputs of all time steps are complete when they run.
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair> tupleWeightGrad(bufferA.BaseForwardBuffer(), bufferC.BaseBackwardBuffer(), bufferB.BackwardBuffer(),
+				dataPair(sizeof(int), aOffset), dataPair(sizeof(int), aStride), dataPair(sizeof(int), cOffset), dataPair(sizeof(int), cStride), backend.BatchArg(1), dataPair(sizeof(int), numSteps), dataPair(sizeof(int), wB), dataPair(sizeof(int), flattenedSize));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair> tupleInputGrad(bufferC.BaseBackwardBuffer(), bufferB.ForwardBuffer(), bufferA.BaseBackwardBuffer(),
+				dataPair(sizeof(int), cOffset), dataPair(sizeof(int), cStride), dataPair(sizeof(int), aOffset), dataPair(sizeof(int), aStride), backend.BatchArg(1), dataPair(sizeof(int), wB), dataPair(sizeof(int), flattenedSize));
+
+			matOp = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair>(weightGradKernel, tupleWeightGrad, cl::NullRange, cl::NDRange(bX, fY), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<10, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair>(inputGradKernel, tupleInputGrad, cl::NullRange, BatchRange(3, 1, 1, WORK_GROUP_SIZE_Y, fX, 1, numSteps), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNMatMulFlatOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(bufferList[input[1]]->size.sizeX, bufferList[input[0]]->size.sizeW);
+		}
+
+		void NNMatMulFlatOp::SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
+		{
+			size_t input0 = bufferList[input[0]]->size.sizeX * bufferList[input[0]]->size.sizeY *bufferList[input[0]]->size.sizeZ*bufferList[input[0]]->size.sizeW;
+			size_t input1 = bufferList[input[1]]->size.sizeX * bufferList[input[1]]->size.sizeY *bufferList[input[1]]->size.sizeZ*bufferList[input[1]]->size.sizeW;
+
+			tmpSizes.push_back(SizeVec(input0 > input1 ? input0 : input1));
+		}
+
+		bool NNMatMulFlatOp::GetQuantizedChannels(std::vector<NNBuffer*>& bufferList, size_t& numChannels, size_t& channelStride) const
+		{
+			//The int8 version replaces one instance per time step
+			if (hoistSteps)
+				return false;
+
+			numChannels = bufferList[input[1]]->size.sizeX;
+			channelStride = 1;
+			return true;
+		}
+
+		void NNMatMulFlatOp::InstantiateQuantized(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, const QuantizedBuffer& weights, const float activationScale)
+		{
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			AddQuantizedMatMul(backend, bufferA, bufferB, bufferC, bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ, weights, activationScale);
+		}
+
+		void NNConvOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+			const int WORK_GROUP_SIZE_Y = 8;
+
+			//const int WORK_GROUP_SIZE_X = 8;
+			//const int WORK_GROUP_SIZE_Y = 8;
+			//const int WORK_GROUP_SIZE_Z = 4;
+
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			NNBuffer tmpBufferOBj = *bufferList[tmpBuffer[0]];
+
+			if (pad == -1)
+				pad = ConvType::VALID == convType ? 0 : (convType == ConvType::SAME ? bufferB.size.sizeX >> 1 : bufferB.size.sizeX - 1);
+
+			KernelIdx kernel = backend.GetKernelIdx("Convolution");//, "WIDTH_KERNEL=" + std::to_string(bufferB.size.sizeX) + " HEIGHT_KERNEL=" + std::to_string(bufferB.size.sizeY) + " STRIDE_X=" + std::to_string(strideX) + " STRIDE_Y=" + std::to_string(strideY) + " TILE_WIDTH=" + std::to_string(WORK_GROUP_SIZE_X) + " TILE_HEIGHT=" + std::to_string(WORK_GROUP_SIZE_Y)); // +" TILE_DEPTH=" + std::to_string(WORK_GROUP_SIZE_Z));
+			KernelIdx kernelConvAdd = backend.GetKernelIdx("ConvolutionAdd");
+			KernelIdx kernelGradWgt = backend.GetKernelIdx("ConvolutionWeightGrad");
+			KernelIdx kernelReorder = backend.GetKernelIdx("RotateAndReorder");
+
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeZ), dataPair(sizeof(int), bufferB.size.sizeW), dataPair(sizeof(int), pad), backend.BatchArg(1));
+
+			size_t numOutputs = ((bufferC.size.sizeX + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X)*WORK_GROUP_SIZE_X * (bufferC.size.sizeY);
+
+			//size_t sizeX = ((bufferC.size.sizeX + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X)*WORK_GROUP_SIZE_X;
+			//size_t sizeY = ((bufferC.size.sizeY + WORK_GROUP_SIZE_Y - 1) / WORK_GROUP_SIZE_Y)*WORK_GROUP_SIZE_Y;
+			//size_t sizeZ = ((bufferC.size.sizeZ + WORK_GROUP_SIZE_Z - 1) / WORK_GROUP_SIZE_Z)*WORK_GROUP_SIZE_Z*bufferC.size.sizeW;
+
+			OperationIdx  op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(3, 2, 1, 2, numOutputs, (bufferB.size.sizeW + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeW %WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			//OperationIdx  op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(3, 2, 1, 2, sizeX, sizeY), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, WORK_GROUP_SIZE_Z), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+
+
+			forwardOpIdx.push_back(op);
+			//size_t tmp = ((bufferC.size.sizeX + 2 * pad + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferC.size.sizeY + 2 * pad) * WORK_GROUP_SIZE_X) + (WORK_GROUP_SIZE_X - ((((bufferC.size.sizeX + 2 * pad + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferC.size.sizeY + 2 * pad) * WORK_GROUP_SIZE_X)) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X);
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument> tupleGradWgt(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), dataPair(sizeof(int), bufferC.size.sizeZ), dataPair(sizeof(int), pad), backend.BatchArg(1));
+			op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument>(kernelGradWgt, tupleGradWgt, cl::NullRange, cl::NDRange(((bufferB.size.sizeX * bufferB.size.sizeY * bufferA.size.sizeZ) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX * bufferB.size.sizeY * bufferA.size.sizeZ) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), ((bufferB.size.sizeW) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeW) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(op);
+
+			const int gradPadding = bufferB.size.sizeX - 1 - pad;
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument> tupleGradImg(bufferC.BackwardBuffer(), tmpBufferOBj.ForwardBuffer(), bufferA.BackwardBuffer(),
+				dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeW), dataPair(sizeof(int), bufferB.size.sizeZ), dataPair(sizeof(int), gradPadding), backend.BatchArg(1));
+			op = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument>(kernelConvAdd, tupleGradImg, cl::NullRange, BatchRange(3, 2, 1, 2, ((bufferA.size.sizeX + 2 * gradPadding + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferA.size.sizeY + 2 * gradPadding) * WORK_GROUP_SIZE_X) + (WORK_GROUP_SIZE_X - ((((bufferA.size.sizeX + 2 * gradPadding + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X * (bufferA.size.sizeY + 2 * gradPadding) * WORK_GROUP_SIZE_X)) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeZ + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeZ %WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(op);
+
+			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair> tupleYTranspose(bufferB.ForwardBuffer(), tmpBufferOBj.ForwardBuffer(),
+				dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeZ), dataPair(sizeof(int), bufferB.size.sizeW));
+			op = backend.AddOperation<6, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair>(kernelReorder, tupleYTranspose, cl::NullRange, cl::NDRange(((bufferB.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferB.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X), (bufferB.size.sizeY + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeY % WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y), ((bufferB.size.sizeZ * bufferB.size.sizeW) + (2 - ((bufferB.size.sizeZ * bufferB.size.sizeW) % 2)) % 2)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(op);
+		}
+
+		SizeVec NNConvOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			SizeVec buf0 = bufferList[input[0]]->size;
+			SizeVec buf1 = bufferList[input[1]]->size;
+
+			if (pad == -1)
+			{
+				if (convType == ConvType::FULL)
+					return SizeVec(buf0.sizeX + 2 * ((buf1.sizeX >> 1)), buf0.sizeY + 2 * ((buf1.sizeY >> 1)), buf1.sizeW, buf0.sizeW);
+				else if (convType == ConvType::VALID)
+					return SizeVec(buf0.sizeX - 2 * (buf1.sizeX >> 1), buf0.sizeY - 2 * (buf1.sizeY >> 1), buf1.sizeW, buf0.sizeW);
+				else
+					return SizeVec(buf0.sizeX, buf0.sizeY, buf1.sizeW, buf0.sizeW);
+			}
+			else
+				return SizeVec((buf0.sizeX - buf1.sizeX + 2 * pad + strideX) / strideX, (buf0.sizeY - buf1.sizeY + 2 * pad + strideY) / strideY, buf1.sizeW, buf0.sizeW);
+
+		}
+
+		void NNConvOp::SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op)
+		{
+			tmpSizes.push_back(SizeVec(bufferList[input[1]]->size.sizeX * bufferList[input[1]]->size.sizeY *bufferList[input[1]]->size.sizeZ*bufferList[input[1]]->size.sizeW));
+		}
+
+		bool NNConvOp::GetQuantizedChannels(std::vector<NNBuffer*>& bufferList, size_t& numChannels, size_t& channelStride) const
+		{
+			//Each kernel has its own scale
+			const SizeVec& size = bufferList[input[1]]->size;
+			numChannels = size.sizeW;
+			channelStride = size.sizeX * size.sizeY * size.sizeZ;
+			return true;
+		}
+
+		void NNConvOp::InstantiateQuantized(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, const QuantizedBuffer& weights, const float activationScale)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+			const int WORK_GROUP_SIZE_Y = 8;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			//The kernels keep their layout
+			if (quantWeights == MAX_UNSIGNED_INT)
+				UploadQuantized(backend, weights, activationScale);
+
+			KernelIdx kernel = backend.GetKernelIdx("QuantConvolution");
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument, std::pair<size_t, const float*>> tuple(bufferA.ForwardBuffer(), quantWeights, quantScales, bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeX), dataPair(sizeof(int), bufferB.size.sizeY), dataPair(sizeof(int), bufferB.size.sizeZ), dataPair(sizeof(int), bufferB.size.sizeW), dataPair(sizeof(int), pad), backend.BatchArg(1), std::pair<size_t, const float*>(sizeof(float), &quantActivationScale));
+
+			//Same work distribution as the float convolution
+			size_t numOutputs = ((bufferC.size.sizeX + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X)*WORK_GROUP_SIZE_X * (bufferC.size.sizeY);
+
+			backend.AddOperation<13, BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument, std::pair<size_t, const float*>>(kernel, tuple, cl::NullRange, BatchRange(3, 2, 1, 2, numOutputs, (bufferB.size.sizeW + (WORK_GROUP_SIZE_Y - (bufferB.size.sizeW %WORK_GROUP_SIZE_Y)) % WORK_GROUP_SIZE_Y)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+		}
+
+		void NNCopyInitOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			if (bufferC.GetCurTimeStep() == 0)
+			{
+				Tuple<BufferIdx, BufferIdx, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+					backend.BatchArg(elementSize));
+				Tuple<BufferIdx, BufferIdx, BatchArgument> tupleGrad(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+					backend.BatchArg(elementSize));
+
+				KernelIdx reluKernel = backend.GetKernelIdx("Copy");
+				KernelIdx reluKernelGrad = backend.GetKernelIdx("CopyAdd");
+
+				OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(reluKernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+				forwardOpIdx.push_back(matOp);
+				matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(reluKernelGrad, tupleGrad, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+				backwardOpIdx.push_back(matOp);
+			}
+		}
+
+		SizeVec NNCopyInitOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNReLUOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+
+			KernelIdx reluKernel = backend.GetKernelIdx("ReLU");
+			KernelIdx reluKernelGrad = backend.GetKernelIdx("ReLUGrad");
+
+			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(reluKernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, BatchArgument>(reluKernelGrad, tupleGrad, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNReLUOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+
+		void NNTanhOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+
+			KernelIdx reluKernel = backend.GetKernelIdx("Tanh");
+			KernelIdx reluKernelGrad = backend.GetKernelIdx("TanhGrad");
+
+			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(reluKernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, BatchArgument>(reluKernelGrad, tupleGrad, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNTanhOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNElemWiseProductOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument> tupleGrad2(bufferB.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+
+			KernelIdx reluKernel = backend.GetKernelIdx("ElemWiseProduct");
+			KernelIdx reluKernelGrad = backend.GetKernelIdx("ElemWiseProductAdd");
+
+			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, BatchArgument>(reluKernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, BatchArgument>(reluKernelGrad, tupleGrad, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, BatchArgument>(reluKernelGrad, tupleGrad2, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNElemWiseProductOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNSplitOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			size_t totalSize = bufferC.size.sizeX * bufferC.size.sizeY;
+
+			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), static_cast<int>(bufferC.GetCurTimeStep())), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument> tupleGrad(bufferA.BackwardBuffer(), bufferC.BackwardBuffer(),
+				dataPair(sizeof(int), static_cast<int>(bufferC.GetCurTimeStep())), dataPair(sizeof(int), bufferC.size.sizeX), dataPair(sizeof(int), bufferC.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), backend.BatchArg(1));
+
+			KernelIdx reluKernel = backend.GetKernelIdx("SplitData");
+			KernelIdx reluKernelGrad = backend.GetKernelIdx("SplitDataGrad");
+
+			OperationIdx  matOp = backend.AddOperation<9, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument>(reluKernel, tuple, cl::NullRange, BatchRange(3, 2, 1, 2, (totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X)), (bufferA.size.sizeZ + 2 - (bufferA.size.sizeZ%2))), cl::NDRange(WORK_GROUP_SIZE_X, 1, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<9, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument>(reluKernelGrad, tupleGrad, cl::NullRange, BatchRange(3, 2, 1, 2, (totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X)), (bufferA.size.sizeZ + 2 - (bufferA.size.sizeZ%2))), cl::NDRange(WORK_GROUP_SIZE_X, 1, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNSplitOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(w, h, bufferList[input[0]]->size.sizeZ, bufferList[input[0]]->size.sizeW);
+		}
+
+		size_t NNSplitOp::GetTimeTransform(std::vector<NNBuffer*>& bufferList)
+		{
+			SizeVec size = bufferList[input[0]]->size;
+			size_t time = ((size.sizeX + w - 1) / w) * ((size.sizeY + h - 1)/h);
+			return time;
+		}
+
+		void NNMaxPoolingOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), backend.BatchArg(bufferA.size.sizeZ), dataPair(sizeof(int), stride), dataPair(sizeof(int), padX), dataPair(sizeof(int), padY), dataPair(sizeof(int), size));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair> tupleGrad(bufferA.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), bufferA.size.sizeY), backend.BatchArg(bufferA.size.sizeZ), dataPair(sizeof(int), stride), dataPair(sizeof(int), padX), dataPair(sizeof(int), padY), dataPair(sizeof(int), size));
+
+			KernelIdx maxPoolingKernel = backend.GetKernelIdx("MaxPooling");
+			KernelIdx maxPoolingKernelGrad = backend.GetKernelIdx("MaxPoolingGrad");
+
+			OperationIdx  matOp = backend.AddOperation<9, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair>(maxPoolingKernel, tuple, cl::NullRange, BatchRange(3, 2, bufferC.size.sizeZ, WORK_GROUP_SIZE_X, (bufferC.size.sizeX + WORK_GROUP_SIZE_X - (bufferC.size.sizeX%WORK_GROUP_SIZE_X)), (bufferC.size.sizeY + WORK_GROUP_SIZE_X - (bufferC.size.sizeY%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<10, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair>(maxPoolingKernelGrad, tupleGrad, cl::NullRange, BatchRange(3, 2, bufferC.size.sizeZ, WORK_GROUP_SIZE_X, (bufferC.size.sizeX + WORK_GROUP_SIZE_X - (bufferC.size.sizeX%WORK_GROUP_SIZE_X)), (bufferC.size.sizeY + WORK_GROUP_SIZE_X - (bufferC.size.sizeY%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNMaxPoolingOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			SizeVec tmpSize = bufferList[input[0]]->size;
+			return SizeVec((tmpSize.sizeX - size + padX) / stride + 1, (tmpSize.sizeY - size + padY) / stride + 1, tmpSize.sizeZ, tmpSize.sizeW);
+		}
+
+		void NNMatTransposeOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+			const int WORK_GROUP_SIZE_Y = 8;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument> tupleGrad(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+
+			KernelIdx reluKernel = backend.GetKernelIdx("Transpose");
+
+			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, BatchArgument>(reluKernel, tuple, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_Y, ((bufferA.size.sizeX) + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX) % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X)), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNMatTransposeOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			SizeVec sizeV = bufferList[0]->size;
+			return SizeVec(sizeV.sizeY, sizeV.sizeX, sizeV.sizeZ, sizeV.sizeW);
+		}
+
+		void NNLeastSquaresOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+			NNBuffer labelBuffer = *bufferList[input[1]];
+
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument, BatchArgument> tupleGrad(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(bufferA.size.sizeX), backend.BatchArg(1));
+
+			KernelIdx kernel = backend.GetKernelIdx("MeanSquaredError");
+			KernelIdx kernelGrad = backend.GetKernelIdx("MeanSquaredErrorGrad");
+
+			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, 1, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			//With mixed precision the gradient is scaled before it is propagated into buffers storing half.
+			if (lossScaleBuffer != MAX_UNSIGNED_INT)
+				AddLossScaling(backend, bufferA);
+			matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, BatchArgument, BatchArgument>(kernelGrad, tupleGrad, cl::NullRange, BatchRange(1, 0, bufferA.size.sizeX, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNLeastSquaresOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(1);
+		}
+
+		void NNAddBiasOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument> tupleGradB(bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
+				dataPair(sizeof(int), bufferC.size.sizeX), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tupleGradA(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(), 
+				backend.BatchArg(bufferA.size.sizeX));
+
+			KernelIdx kernel = backend.GetKernelIdx("AddToMatrix");
+			KernelIdx kernelGradB = backend.GetKernelIdx("AddToMatrixGrad");
+			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
+
+			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, bufferA.size.sizeX, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernelGradA, tupleGradA, cl::NullRange, BatchRange(1, 0, bufferA.size.sizeX, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernelGradB, tupleGradB, cl::NullRange, cl::NDRange((bufferC.size.sizeX + (WORK_GROUP_SIZE_X - (bufferC.size.sizeX %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNAddBiasOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNAddOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(bufferC.GetCurTimeStep() + timeResult),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tupleGradB(bufferC.BackwardBuffer(bufferC.GetCurTimeStep() + timeResult), bufferB.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tupleGradA(bufferC.BackwardBuffer(bufferC.GetCurTimeStep() + timeResult), bufferA.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+
+			KernelIdx kernel = backend.GetKernelIdx("Add");
+			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
+
+			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernelGradA, tupleGradA, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernelGradA, tupleGradB, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNAddOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNCopyOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(bufferC.GetCurTimeStep() + timeResult),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tupleGradB(bufferC.BackwardBuffer(bufferC.GetCurTimeStep() + timeResult), bufferA.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+
+			KernelIdx kernel = backend.GetKernelIdx("Copy");
+			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
+
+			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernelGradA, tupleGradB, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNCopyOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNSubConstOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, std::pair<size_t, float>, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				std::pair<size_t, float>(sizeof(float), co), backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tupleGradA(bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+
+			KernelIdx kernel = backend.GetKernelIdx("SubtractFromConst");
+			KernelIdx kernelGradA = backend.GetKernelIdx("SubtractFromConstGrad");
+
+			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, std::pair<size_t, float>, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernelGradA, tupleGradA, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNSubConstOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNAddBiasConvOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+			NNBuffer bufferB = *bufferList[input[1]];
+
+			size_t totalImageSize = bufferA.size.sizeX * bufferA.size.sizeY;
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferB.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX * bufferA.size.sizeY), dataPair(sizeof(int), bufferA.size.sizeZ), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument> tupleGradB(bufferC.BackwardBuffer(), bufferB.BackwardBuffer(),
+				dataPair(sizeof(int), bufferC.size.sizeX * bufferC.size.sizeY), dataPair(sizeof(int), bufferC.size.sizeZ), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tupleGradA(bufferC.BackwardBuffer(), bufferA.BackwardBuffer()
+				, backend.BatchArg(elementSize));
+
+			KernelIdx kernel = backend.GetKernelIdx("AddToImageTensor");
+			KernelIdx kernelGradB = backend.GetKernelIdx("AddToImageTensorGrad");
+			KernelIdx kernelGradA = backend.GetKernelIdx("CopyAdd");
+
+			OperationIdx  matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(kernelGradA, tupleGradA, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<5, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument>(kernelGradB, tupleGradB, cl::NullRange, cl::NDRange((bufferC.size.sizeZ + (WORK_GROUP_SIZE_X - (bufferC.size.sizeZ %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNAddBiasConvOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNCrossEntropyOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+			NNBuffer labelBuffer = *bufferList[input[1]];
+
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument, BatchArgument> tupleGrad(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferA.BackwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1), backend.BatchArg(1));
+
+			KernelIdx kernel = backend.GetKernelIdx("CrossEntropy");
+			KernelIdx kernelGrad = backend.GetKernelIdx("CrossEntropyGrad");
+
+			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, 1, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			if (lossScaleBuffer != MAX_UNSIGNED_INT)
+				AddLossScaling(backend, bufferA);
+			matOp = backend.AddOperation<6, BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument, BatchArgument>(kernelGrad, tupleGrad, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_X, (bufferA.size.sizeX + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNCrossEntropyOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(1);
+		}
+
+		void NNClassificationRewardOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+			NNBuffer labelBuffer = *bufferList[input[1]];
+
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+
+			KernelIdx kernel = backend.GetKernelIdx("CalcR");
+
+			OperationIdx  matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, 1, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNClassificationRewardOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(1);
+		}
+
+		void NNArgmaxOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+
+			KernelIdx kernel = backend.GetKernelIdx("Argmax");
+
+			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, 1, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNArgmaxOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(1);
+		}
+
+		void NNCountCorrectOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+			NNBuffer labelBuffer = *bufferList[input[1]];
+
+			//All time steps count into the same counter. It starts at zero.
+			if (counter == MAX_UNSIGNED_INT)
+			{
+				counter = backend.CreateBuffer(sizeof(int), BackendSystem::MEM_FLAG::READ_WRITE, 1);
+				backend.ResetBuffer(counter, sizeof(int));
+			}
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), labelBuffer.ForwardBuffer(), bufferC.ForwardBuffer(), counter,
+				dataPair(sizeof(int), bufferA.size.sizeX), dataPair(sizeof(int), static_cast<int>(k)), backend.BatchArg(1));
+
+			KernelIdx kernel = backend.GetKernelIdx("CountCorrect");
+
+			OperationIdx  matOp = backend.AddOperation<7, BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, 1, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNCountCorrectOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(1);
+		}
+
+		void NNAugmentOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			//All time steps use the same state, therefore the images of a sequence are augmented the same way.
+			if (state == MAX_UNSIGNED_INT)
+			{
+				state = backend.CreateBuffer(2 * sizeof(unsigned int), BackendSystem::MEM_FLAG::READ_WRITE, 1);
+				backend.WriteDataBuffer(state, initialState, 0, 2 * sizeof(unsigned int));
+			}
+
+			const size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+			cl_float8 limits = { { params.flipX, params.flipY, params.maxAngle, params.maxScale, params.maxShift, params.maxBrightness, params.maxContrast, params.contrastCenter } };
+
+			//The key of the generator distinguishes several augmentations with the same seed.
+			Tuple<BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, unsigned int>, std::pair<size_t, unsigned int>, dataPair, dataPair, dataPair, dataPair, std::pair<size_t, cl_float8>, std::pair<size_t, float>, BatchArgument>
+				tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(), state, std::pair<size_t, unsigned int>(sizeof(unsigned int), seed), std::pair<size_t, unsigned int>(sizeof(unsigned int), static_cast<unsigned int>(output[0])),
+				dataPair(sizeof(int), static_cast<int>(bufferA.size.sizeX)), dataPair(sizeof(int), static_cast<int>(bufferA.size.sizeY)), dataPair(sizeof(int), static_cast<int>(bufferA.size.sizeZ)),
+				dataPair(sizeof(int), params.pad), std::pair<size_t, cl_float8>(sizeof(cl_float8), limits), std::pair<size_t, float>(sizeof(float), params.fill), backend.BatchArg(static_cast<int>(elementSize)));
+			Tuple<BufferIdx> tupleStep(state);
+
+			KernelIdx kernel = backend.GetKernelIdx("Augment");
+			KernelIdx kernelStep = backend.GetKernelIdx("AugmentStep");
+
+			//The counter advances before the first time step, all time steps of a pass read the same value.
+			OperationIdx matOp;
+			if (forwardOpIdx.empty())
+			{
+				matOp = backend.AddOperation<1, BufferIdx>(kernelStep, tupleStep, cl::NullRange, cl::NDRange(1), cl::NDRange(1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+				forwardOpIdx.push_back(matOp);
+			}
+			matOp = backend.AddOperation<12, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, unsigned int>, std::pair<size_t, unsigned int>, dataPair, dataPair, dataPair, dataPair, std::pair<size_t, cl_float8>, std::pair<size_t, float>, BatchArgument>(
+				kernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNAugmentOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNDequantizeOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			const size_t channels = bufferA.size.sizeZ;
+			if (stats == MAX_UNSIGNED_INT)
+			{
+				statsData.resize(2 * channels);
+				for (size_t c = 0; c < channels; ++c)
+				{
+					statsData[c] = mean.empty() ? 0.f : mean[std::min(c, mean.size() - 1)];
+					statsData[channels + c] = stddev.empty() ? 1.f : 1.f / stddev[std::min(c, stddev.size() - 1)];
+				}
+				stats = backend.CreateBuffer(statsData.size() * sizeof(float), BackendSystem::MEM_FLAG::READ_ONLY, 1);
+				backend.WriteDataBuffer(stats, statsData.data(), 0, statsData.size() * sizeof(float));
+			}
+
+			const size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(), stats,
+				std::pair<size_t, float>(sizeof(float), scale), dataPair(sizeof(int), static_cast<int>(bufferA.size.sizeX * bufferA.size.sizeY)), dataPair(sizeof(int), static_cast<int>(channels)),
+				backend.BatchArg(static_cast<int>(elementSize)));
+
+			//The kernel reads the type the input buffer stores
+			const InputStorage storage = bufferList[input[0]]->GetInputStorage();
+			KernelIdx kernel = backend.GetKernelIdx(storage == INPUT_UINT8 ? "DequantizeUInt8" : (storage == INPUT_INT16 ? "DequantizeInt16" : (storage == INPUT_HALF ? "DequantizeHalf" : "DequantizeFloat")));
+
+			OperationIdx matOp = backend.AddOperation<7, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair, dataPair, BatchArgument>(kernel, tuple, cl::NullRange,
+				BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNDequantizeOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNAugmentOp::SetAugmentation(BackendSystem::OpenCLBackend& backend, const bool enabled)
+		{
+			//The flag is the second value of the state, the pass counter stays unchanged. Before the graph was initialized it is only stored for the creation of the state.
+			initialState[1] = enabled ? 1 : 0;
+			if (state != MAX_UNSIGNED_INT)
+				backend.WriteDataBuffer(state, &initialState[1], sizeof(unsigned int), sizeof(unsigned int));
+		}
+
+		void NNSoftMaxOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 8;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+
+			Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument> tupleGrad(bufferC.BackwardBuffer(), bufferC.ForwardBuffer(), bufferA.BackwardBuffer(),
+				dataPair(sizeof(int), bufferA.size.sizeX), backend.BatchArg(1));
+
+			KernelIdx kernel = backend.GetKernelIdx("Softmax");
+			KernelIdx kernelGrad = backend.GetKernelIdx("SoftmaxGrad");
+
+			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernel, tuple, cl::NullRange, BatchRange(1, 0, 1, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, BatchArgument>(kernelGrad, tupleGrad, cl::NullRange, BatchRange(2, 1, 1, WORK_GROUP_SIZE_X, (bufferA.size.sizeX + (WORK_GROUP_SIZE_X - (bufferA.size.sizeX %WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNSoftMaxOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNSigmoidOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			size_t elementSize = bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ;
+
+			Tuple<BufferIdx, BufferIdx, BatchArgument> tuple(bufferA.ForwardBuffer(), bufferC.ForwardBuffer(),
+				backend.BatchArg(elementSize));
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BatchArgument> tupleGrad(bufferC.ForwardBuffer(), bufferC.BackwardBuffer(), bufferA.BackwardBuffer(),
+				backend.BatchArg(elementSize));
+
+			KernelIdx reluKernel = backend.GetKernelIdx("Sigmoid");
+			KernelIdx reluKernelGrad = backend.GetKernelIdx("SigmoidGrad");
+
+			OperationIdx  matOp = backend.AddOperation<3, BufferIdx, BufferIdx, BatchArgument>(reluKernel, tuple, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			forwardOpIdx.push_back(matOp);
+			matOp = backend.AddOperation<4, BufferIdx, BufferIdx, BufferIdx, BatchArgument>(reluKernelGrad, tupleGrad, cl::NullRange, BatchRange(1, 0, elementSize, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backwardOpIdx.push_back(matOp);
+		}
+
+		SizeVec NNSigmoidOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return bufferList[input[0]]->size;
+		}
+
+		void NNGRUOp::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList)
+		{
+			const int WORK_GROUP_SIZE_X = 64;
+			//Work group size of the tiled matrix multiplications (STEP_TILE and GRU_TILE)
+			const int TILE_SIZE = 8;
+
+			NNBuffer bufferA = *bufferList[input[0]];
+			NNBuffer bufferS = *bufferList[input[1]];
+			NNBuffer bufferU = *bufferList[input[2]];
+			NNBuffer bufferW = *bufferList[input[3]];
+			NNBuffer bufferB = *bufferList[input[4]];
+			NNBuffer bufferC = *bufferList[output[0]];
+
+			const int n = static_cast<int>(bufferA.size.sizeX * bufferA.size.sizeY * bufferA.size.sizeZ);
+			const int hSize = static_cast<int>(bufferW.size.sizeY);
+			const int h3 = 3 * hSize;
+			const int maxBatch = static_cast<int>(bufferC.size.sizeW);
+			const size_t step = bufferC.GetCurTimeStep();
+
+			//The first time step creates the buffers for all time steps. The time steps of an input buffer are complete before the first step runs,
+			//therefore its projection and the gradients depending on it can be computed for all time steps at once.
+			if (gates == MAX_UNSIGNED_INT)
+			{
+				const size_t gateSize = sizeof(float) * bufferC.sequenceSize * maxBatch * h3;
+				gates = backend.CreateBuffer(gateSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+				gateGradients = backend.CreateBuffer(gateSize, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+				firstStep = step;
+				allSteps = bufferList[input[0]]->IsInput() && bufferList[input[0]]->ContiguousTimeSteps() && bufferA.GetCurTimeStep() + bufferC.sequenceSize - step <= bufferA.sequenceSize;
+
+				//The persistent kernels need the projections of all time steps before the first step runs
+				if (persistent && allSteps)
+					SelectPersistentSlice(backend, hSize);
+				else if (persistent)
+					std::cerr << "GRU: The input is not an input buffer or its time steps are not stored contiguously. One kernel per time step is used." << std::endl;
+				if (slice > 0)
+					counter = backend.CreateBuffer(sizeof(int), BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			}
+
+			const int numSteps = static_cast<int>(bufferC.sequenceSize - firstStep);
+			const int gOffset = static_cast<int>(step) * maxBatch * h3;
+			const int aStride = StepStride(backend, bufferA);
+			const int aOffset = static_cast<int>(bufferA.GetCurTimeStep()) * aStride;
+			const int sStride = StepStride(backend, bufferS);
+			const int sOffset = static_cast<int>(bufferS.GetCurTimeStep()) * sStride;
+			const int cStride = StepStride(backend, bufferC);
+			const int cOffset = static_cast<int>(step) * cStride;
+
+			//The gates of one time step are a matrix with maxBatch rows
+			const int gStride = maxBatch * h3;
+
+			const int gX = h3 + (WORK_GROUP_SIZE_X - h3 % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X;
+			const int gTileX = h3 + (TILE_SIZE - h3 % TILE_SIZE) % TILE_SIZE;
+			const int aTileX = n + (TILE_SIZE - n % TILE_SIZE) % TILE_SIZE;
+			const int hTileY = hSize + (TILE_SIZE - hSize % TILE_SIZE) % TILE_SIZE;
+
+			KernelIdx projectionKernel = backend.GetKernelIdx("MatrixMulSteps");
+			KernelIdx addBiasKernel = backend.GetKernelIdx("GRUAddBias");
+			KernelIdx stepKernel = backend.GetKernelIdx("GRUForwardStep");
+			KernelIdx stepGradKernel = backend.GetKernelIdx("GRUBackwardStep");
+			KernelIdx inputWeightKernel = backend.GetKernelIdx("MatrixMulStepsWeightGrad");
+			KernelIdx stateWeightKernel = backend.GetKernelIdx("GRURecurrentWeightGradient");
+			KernelIdx biasKernel = backend.GetKernelIdx("GRUBiasGradient");
+			KernelIdx inputGradKernel = backend.GetKernelIdx("MatrixMulStepsInputGrad");
+			KernelIdx persistentKernel = backend.GetKernelIdx("GRUPersistentForward");
+			KernelIdx persistentGradKernel = backend.GetKernelIdx("GRUPersistentBackward");
+			KernelIdx zeroKernel = backend.GetKernelIdx("SetZero");
+
+			//The persistent kernels keep 3 * slice rows or columns of the recurrent weights in local memory. The network resets the barrier counter before each pass (See GetBarrierCounter).
+			std::pair<size_t, float*> localWeights(3 * slice * hSize * sizeof(float), nullptr);
+
+			OperationIdx matOp;
+			if (!allSteps || step == firstStep)
+			{
+				//Either the base buffer starting at the current time step for all time steps or the sub buffer of the current time step.
+				Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair> tupleProjection(
+					allSteps ? bufferA.BaseForwardBuffer() : bufferA.ForwardBuffer(), bufferU.ForwardBuffer(), gates,
+					dataPair(sizeof(int), allSteps ? aOffset : 0), dataPair(sizeof(int), aStride), dataPair(sizeof(int), gOffset), dataPair(sizeof(int), gStride), backend.BatchArg(1),
+					dataPair(sizeof(int), h3), dataPair(sizeof(int), n));
+				Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument, dataPair, dataPair> tupleBias(gates, bufferB.ForwardBuffer(),
+					dataPair(sizeof(int), gOffset), backend.BatchArg(1), dataPair(sizeof(int), maxBatch), dataPair(sizeof(int), h3));
+
+				matOp = backend.AddOperation<10, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair>(projectionKernel, tupleProjection, cl::NullRange, BatchRange(3, 1, 1, TILE_SIZE, gTileX, 1, allSteps ? numSteps : 1), cl::NDRange(TILE_SIZE, TILE_SIZE, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+				forwardOpIdx.push_back(matOp);
+				matOp = backend.AddOperation<6, BufferIdx, BufferIdx, dataPair, BatchArgument, dataPair, dataPair>(addBiasKernel, tupleBias, cl::NullRange, BatchRange(3, 1, 1, 1, gX, 1, allSteps ? numSteps : 1), cl::NDRange(WORK_GROUP_SIZE_X, 1, 1), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+				forwardOpIdx.push_back(matOp);
+			}
+
+			if (slice == 0)
+			{
+				Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tupleStep(gates, bufferW.ForwardBuffer(), bufferS.ForwardBuffer(), bufferC.ForwardBuffer(), bufferS.ForwardBuffer(bufferS.GetCurTimeStep() + 1),
+					dataPair(sizeof(int), gOffset), dataPair(sizeof(int), hSize));
+
+				//One work group for each batch element
+				matOp = backend.AddOperation<7, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(stepKernel, tupleStep, cl::NullRange, BatchRange(1, 0, WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+				forwardOpIdx.push_back(matOp);
+
+				//Time steps skipped for batch elements whose sequence ended don't write their gate gradients, but the gradients of the weights read those of all time steps.
+				//Without sequence batching every time step writes the gate gradients of all batch elements.
+				if (step == firstStep && sequenceBatching)
+				{
+					const int gateSize = static_cast<int>(bufferC.sequenceSize) * maxBatch * h3;
+					const int zX = gateSize + (WORK_GROUP_SIZE_X - gateSize % WORK_GROUP_SIZE_X) % WORK_GROUP_SIZE_X;
+					Tuple<BufferIdx, dataPair> tupleZeroGradients(gateGradients, dataPair(sizeof(int), gateSize));
+
+					matOp = backend.AddOperation<2, BufferIdx, dataPair>(zeroKernel, tupleZeroGradients, cl::NullRange, cl::NDRange(zX), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+					forwardOpIdx.push_back(matOp);
+				}
+			}
+			else if (step == firstStep)
+			{
+				Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float*>, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair> tuplePersistent(
+					gates, bufferW.ForwardBuffer(), bufferS.BaseForwardBuffer(), bufferC.BaseForwardBuffer(), counter, localWeights,
+					dataPair(sizeof(int), gOffset), dataPair(sizeof(int), sOffset), dataPair(sizeof(int), sStride), dataPair(sizeof(int), cOffset), dataPair(sizeof(int), cStride), backend.BatchArg(1),
+					dataPair(sizeof(int), maxBatch), dataPair(sizeof(int), hSize), dataPair(sizeof(int), static_cast<int>(slice)), dataPair(sizeof(int), numSteps));
+
+				matOp = backend.AddOperation<16, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float*>, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair>(persistentKernel, tuplePersistent, cl::NullRange, cl::NDRange(numGroups * WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::FORWARD);
+				forwardOpIdx.push_back(matOp);
+			}
+
+			//The backward operations are added in opposite order. The gradients of the weights are added by the first time step, thereby they run after the backward pass of all time steps.
+			if (step == firstStep)
+			{
+				Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair> tupleStateWeights(bufferS.BaseForwardBuffer(), gates, gateGradients, bufferW.BackwardBuffer(),
+					dataPair(sizeof(int), sOffset), dataPair(sizeof(int), sStride), dataPair(sizeof(int), gOffset), backend.BatchArg(1), dataPair(sizeof(int), maxBatch), dataPair(sizeof(int), hSize), dataPair(sizeof(int), numSteps));
+				Tuple<BufferIdx, BufferIdx, dataPair, BatchArgument, dataPair, dataPair, dataPair> tupleBias(gateGradients, bufferB.BackwardBuffer(),
+					dataPair(sizeof(int), gOffset), backend.BatchArg(1), dataPair(sizeof(int), maxBatch), dataPair(sizeof(int), h3), dataPair(sizeof(int), numSteps));
+
+				matOp = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair>(stateWeightKernel, tupleStateWeights, cl::NullRange, cl::NDRange(gTileX, hTileY), cl::NDRange(TILE_SIZE, TILE_SIZE), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+				backwardOpIdx.push_back(matOp);
+				matOp = backend.AddOperation<7, BufferIdx, BufferIdx, dataPair, BatchArgument, dataPair, dataPair, dataPair>(biasKernel, tupleBias, cl::NullRange, cl::NDRange(gX), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+				backwardOpIdx.push_back(matOp);
+			}
+
+			if (!allSteps || step == firstStep)
+			{
+				const int steps = allSteps ? numSteps : 1;
+				Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair> tupleInputWeights(allSteps ? bufferA.BaseForwardBuffer() : bufferA.ForwardBuffer(), gateGradients, bufferU.BackwardBuffer(),
+					dataPair(sizeof(int), allSteps ? aOffset : 0), dataPair(sizeof(int), aStride), dataPair(sizeof(int), gOffset), dataPair(sizeof(int), gStride), backend.BatchArg(1), dataPair(sizeof(int), steps), dataPair(sizeof(int), h3), dataPair(sizeof(int), n));
+				Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair> tupleInput(gateGradients, bufferU.ForwardBuffer(), allSteps ? bufferA.BaseBackwardBuffer() : bufferA.BackwardBuffer(),
+					dataPair(sizeof(int), gOffset), dataPair(sizeof(int), gStride), dataPair(sizeof(int), allSteps ? aOffset : 0), dataPair(sizeof(int), aStride), backend.BatchArg(1), dataPair(sizeof(int), h3), dataPair(sizeof(int), n));
+
+				matOp = backend.AddOperation<11, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair>(inputWeightKernel, tupleInputWeights, cl::NullRange, cl::NDRange(gTileX, aTileX), cl::NDRange(TILE_SIZE, TILE_SIZE), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+				backwardOpIdx.push_back(matOp);
+				matOp = backend.AddOperation<10, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair>(inputGradKernel, tupleInput, cl::NullRange, BatchRange(3, 1, 1, TILE_SIZE, aTileX, 1, steps), cl::NDRange(TILE_SIZE, TILE_SIZE, 1), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+				backwardOpIdx.push_back(matOp);
+			}
+
+			//The gradient of the new state is read from the output and the next state sub buffer, the gradient of the previous state is added to the current state sub buffer.
+			if (slice == 0)
+			{
+				Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair> tupleStepGrad(gates, bufferW.ForwardBuffer(), bufferS.ForwardBuffer(), bufferC.BackwardBuffer(),
+					bufferS.BackwardBuffer(bufferS.GetCurTimeStep() + 1), gateGradients, bufferS.BackwardBuffer(), dataPair(sizeof(int), gOffset), dataPair(sizeof(int), hSize));
+
+				matOp = backend.AddOperation<9, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, dataPair, dataPair>(stepGradKernel, tupleStepGrad, cl::NullRange, BatchRange(1, 0, WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+				backwardOpIdx.push_back(matOp);
+			}
+			else if (step == firstStep)
+			{
+				//Added by the first time step, thereby the gradients of the outputs of all time steps are complete when it runs.
+				Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float*>, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair> tuplePersistentGrad(
+					gates, bufferW.ForwardBuffer(), bufferS.BaseForwardBuffer(), bufferC.BaseBackwardBuffer(), gateGradients, bufferS.BaseBackwardBuffer(), counter, localWeights,
+					dataPair(sizeof(int), gOffset), dataPair(sizeof(int), sOffset), dataPair(sizeof(int), sStride), dataPair(sizeof(int), cOffset), dataPair(sizeof(int), cStride), backend.BatchArg(1),
+					dataPair(sizeof(int), maxBatch), dataPair(sizeof(int), hSize), dataPair(sizeof(int), static_cast<int>(slice)), dataPair(sizeof(int), numSteps));
+
+				matOp = backend.AddOperation<18, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float*>, dataPair, dataPair, dataPair, dataPair, dataPair, BatchArgument, dataPair, dataPair, dataPair, dataPair>(persistentGradKernel, tuplePersistentGrad, cl::NullRange, cl::NDRange(numGroups * WORK_GROUP_SIZE_X), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+				backwardOpIdx.push_back(matOp);
+			}
+		}
+
+		void NNGRUOp::SelectPersistentSlice(BackendSystem::OpenCLBackend& backend, const size_t hSize)
+		{
+			//One work group per compute unit, thereby all work groups run at the same time and the global barriers can't dead lock.
+			const size_t computeUnits = backend.GetNumComputeUnits();
+			const size_t groups = computeUnits < hSize ? computeUnits : hSize;
+			const size_t values = (hSize + groups - 1) / groups;
+
+			if (3 * values * hSize * sizeof(float) > backend.GetLocalMemSize())
+			{
+				std::cerr << "GRU: The recurrent weights don't fit into the local memory of " << groups << " work groups. One kernel per time step is used." << std::endl;
+				return;
+			}
+
+			slice = values;
+			numGroups = (hSize + values - 1) / values;
+		}
+
+		SizeVec NNGRUOp::GetOutputType(std::vector<NNBuffer*>& bufferList)
+		{
+			return SizeVec(bufferList[input[3]]->size.sizeY, bufferList[input[0]]->size.sizeW);
+		}
+	}
+}
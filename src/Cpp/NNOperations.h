@@ -1,623 +1,1007 @@
-#pragma once
-
-#include <type_traits>
-
-#include "NNBuffer.h"
-
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-		//All normal operations derive from this class.
-		//Parameter initalize operations and optimizers are handled seperately.
-		
-		class NNOp
-		{
-		public:
-			std::vector<OperationIdx> forwardOpIdx;//The hardware operations needed in the forward pass of this operation
-			std::vector<OperationIdx> backwardOpIdx;//The hardware operations needed in the backward pass of this operation
-
-			std::vector<BufferIdx> input;//The buffers, which are used as input to this operation
-			std::vector<BufferIdx> output;//The buffers, which are store the computed result of this operation (In almost all cases only one)
-			std::vector<BufferIdx> tmpBuffer;//The tempoaray buffers that can be used by this operation
-			std::vector<SizeVec> tmpSizes;//The necessary sizes of each temporary buffer.
-			size_t timeOffset;//The offset at this operation runs.
-			size_t timeSteps;//The number of time steps this operation runs (Is currently determined by the output buffers)
-
-#ifdef _DEBUG
-			BufferIdx debugBuffer;
-#endif
-
-			NNOp() :forwardOpIdx(), backwardOpIdx(), input(), output(), tmpSizes(), tmpBuffer(), timeOffset(0) {};
-			
-			NNOp(const NNOp& other):
-			forwardOpIdx(other.forwardOpIdx), backwardOpIdx(other.backwardOpIdx), input(other.input),
-			output(other.output), tmpSizes(other.tmpSizes), tmpBuffer(other.tmpBuffer), timeOffset(other.timeOffset){};
-			
-			const NNOp& operator=(const NNOp& other)
-			{
-				input = other.input;
-				output = other.output;
-
-				tmpSizes = other.tmpSizes;
-				tmpBuffer = other.tmpBuffer;
-				forwardOpIdx = other.forwardOpIdx;
-				backwardOpIdx = other.backwardOpIdx;
-
-				timeOffset = other.timeOffset;
-
-				return *this;
-			}
-
-			//Lets each function create itself
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList) = 0;
-			
-			//The size of the output buffer.
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList) = 0;
-			//The number of time steps the output buffer must be long given the input. Some operations receive only an input for one time step but generate outputs at multiple time steps.
-			//(Example: seperating into windows)
-			virtual size_t GetTimeTransform(std::vector<NNBuffer*>& bufferList);
-
-			//Adds the correct from, to indices in the buffer objects used in this operation
-			virtual void SetBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
-
-			//Calculates the necessary size for each tmporary buffer. Requires the input sizes to be known
-			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op) {}
-		};
-
-		class NNMatMulOp : public NNOp
-		{
-		public:
-			NNMatMulOp(NNBufferIdx inputA, NNBufferIdx inputB) : NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			}
-
-			NNMatMulOp(const NNMatMulOp& other): NNOp(other)
-			{
-			}
-
-			const NNMatMulOp& operator=(const NNMatMulOp& other)
-			{
-				NNOp::operator=(other);
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-		
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-
-			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
-		};
-
-		//Matrix multiplication that flattens all dimensions of the input except the batch size. Allows the application of matrix multiplication on filter volumes.
-		class NNMatMulFlatOp : public NNOp
-		{
-		public:
-			NNMatMulFlatOp(NNBufferIdx inputA, NNBufferIdx inputB) : NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			}
-
-			NNMatMulFlatOp(const NNMatMulFlatOp& other) : NNOp(other)
-			{
-			}
-
-			const NNMatMulFlatOp& operator=(const NNMatMulFlatOp& other)
-			{
-				NNOp::operator=(other);
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-
-			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
-		};
-
-		class NNConvOp : public NNOp
-		{
-		public:
-
-			enum ConvType
-			{
-				FULL, SAME, VALID
-			};
-
-			NNConvOp(NNBufferIdx inputA, NNBufferIdx inputB, ConvType convType, const size_t stride_x, const size_t stride_y) : NNOp(), convType(convType), pad(-1), strideX(stride_x), strideY(stride_y)
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			}
-
-			NNConvOp(NNBufferIdx inputA, NNBufferIdx inputB, const int pad, const size_t stride_x, const size_t stride_y) : NNOp(), pad(pad), convType(ConvType::VALID), strideX(stride_x), strideY(stride_y)
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			}
-
-
-			NNConvOp(const NNConvOp& other) : NNOp(other), pad(other.pad)
-			{
-			}
-
-			const NNConvOp& operator=(const NNConvOp& other)
-			{
-				NNOp::operator=(other);
-				pad = other.pad;
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-
-			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
-
-			ConvType convType;
-			int pad;
-			size_t strideX;
-			size_t strideY;
-		};
-
-		class NNCopyInitOp : public NNOp
-		{
-		public:
-			NNCopyInitOp(NNBufferIdx inputA) :
-				NNOp()
-			{
-				input.push_back(inputA);
-			};
-
-			NNCopyInitOp(const NNCopyInitOp& other) : NNOp(other)
-			{
-			}
-
-			const NNCopyInitOp& operator=(const NNCopyInitOp& other)
-			{
-				NNOp::operator=(other);
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNReLUOp : public NNOp
-		{
-		public:
-			NNReLUOp(NNBufferIdx inputA) :
-				NNOp()
-			{
-				input.push_back(inputA);
-			};
-
-			NNReLUOp(const NNReLUOp& other) : NNOp(other)
-			{
-			}
-
-			const NNReLUOp& operator=(const NNReLUOp& other)
-			{
-				NNOp::operator=(other);
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNTanhOp : public NNOp
-		{
-		public:
-			NNTanhOp(NNBufferIdx inputA) :
-				NNOp()
-			{
-				input.push_back(inputA);
-			};
-
-			NNTanhOp(const NNTanhOp& other) : NNOp(other)
-			{
-			}
-
-			const NNTanhOp& operator=(const NNReLUOp& other)
-			{
-				NNOp::operator=(other);
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNElemWiseProductOp : public NNOp
-		{
-		public:
-			NNElemWiseProductOp(NNBufferIdx inputA, NNBufferIdx inputB) :
-				NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			};
-
-			NNElemWiseProductOp(const NNElemWiseProductOp& other) : NNOp(other)
-			{
-			}
-
-			const NNElemWiseProductOp& operator=(const NNElemWiseProductOp& other)
-			{
-				NNOp::operator=(other);
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNSplitOp : public NNOp
-		{
-		public:
-			NNSplitOp(NNBufferIdx inputA, const int w, const int h) :
-				NNOp(), w(w), h(h)
-			{
-				input.push_back(inputA);
-			};
-
-			NNSplitOp(const NNSplitOp& other) : NNOp(other), w(other.w), h(other.h)
-			{
-			}
-
-			const NNSplitOp& operator=(const NNSplitOp& other)
-			{
-				NNOp::operator=(other);
-				w = other.w;
-				h = other.h;
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-			virtual size_t GetTimeTransform(std::vector<NNBuffer*>& bufferList);
-		
-		private:
-			int w, h;
-		};
-
-		class NNMaxPoolingOp : public NNOp
-		{
-		public:
-			NNMaxPoolingOp(NNBufferIdx inputA, const int padX, const int padY, const int stride, const int size) :
-				NNOp(), padX(padX), padY(padY), stride(stride), size(size)
-			{
-				input.push_back(inputA);
-			};
-
-			NNMaxPoolingOp(const NNMaxPoolingOp& other) : 
-				NNOp(other), padX(other.padX), padY(other.padY), stride(other.stride), size(other.size)
-			{
-			}
-
-			const NNMaxPoolingOp& operator=(const NNMaxPoolingOp& other)
-			{
-				NNOp::operator=(other);
-				padX = other.padX;
-				padY = other.padY;
-				size = other.size;
-				stride = other.stride;
-				return *this;
-			}
-
-			int padX, padY, stride, size;
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNMatTransposeOp : public NNOp
-		{
-		public:
-			NNMatTransposeOp(NNBufferIdx inputA) :
-				NNOp()
-			{
-				input.push_back(inputA);
-			};
-
-			NNMatTransposeOp(const NNMatTransposeOp& other) :
-				NNOp(other)
-			{
-			}
-
-			const NNMatTransposeOp& operator=(const NNMatTransposeOp& other)
-			{
-				NNOp::operator=(other);
-
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNLeastSquaresOp : public NNOp
-		{
-		public:
-			NNLeastSquaresOp(NNBufferIdx inputA, NNBufferIdx labelY) :
-				NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(labelY);
-			};
-
-			NNLeastSquaresOp(const NNLeastSquaresOp& other) :
-				NNOp(other)
-			{
-			}
-
-			const NNLeastSquaresOp& operator=(const NNLeastSquaresOp& other)
-			{
-				NNOp::operator=(other);
-
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNAddBiasOp : public NNOp
-		{
-		public:
-			NNAddBiasOp(NNBufferIdx inputA, NNBufferIdx inputB) :
-				NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			};
-
-			NNAddBiasOp(const NNAddBiasOp& other) :
-				NNOp(other)
-			{
-			}
-
-			const NNAddBiasOp& operator=(const NNAddBiasOp& other)
-			{
-				NNOp::operator=(other);
-
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNAddOp : public NNOp
-		{
-		public:
-			NNAddOp(NNBufferIdx inputA, NNBufferIdx inputB, int timeResult = 0) :
-				NNOp(), timeResult(timeResult)
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			};
-
-			NNAddOp(const NNAddOp& other) :
-				NNOp(other), timeResult(other.timeResult)
-			{
-			}
-
-			const NNAddOp& operator=(const NNAddOp& other)
-			{
-				NNOp::operator=(other);
-				timeResult = other.timeResult;
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		private:
-			size_t timeResult;
-		};
-
-		class NNCopyOp : public NNOp
-		{
-		public:
-			NNCopyOp(NNBufferIdx inputA, int timeResult = 0) :
-				NNOp(), timeResult(timeResult)
-			{
-				input.push_back(inputA);
-			};
-
-			NNCopyOp(const NNCopyOp& other) :
-				NNOp(other), timeResult(other.timeResult)
-			{
-			}
-
-			const NNCopyOp& operator=(const NNCopyOp& other)
-			{
-				NNOp::operator=(other);
-				timeResult = other.timeResult;
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		private:
-			size_t timeResult;
-		};
-
-		class NNSubConstOp : public NNOp
-		{
-		public:
-			NNSubConstOp(NNBufferIdx inputA, const float co) :
-				NNOp(), co(co)
-			{
-				input.push_back(inputA);
-			};
-
-			NNSubConstOp(const NNSubConstOp& other) :
-				NNOp(other), co(other.co)
-			{
-			}
-
-			const NNSubConstOp& operator=(const NNSubConstOp& other)
-			{
-				NNOp::operator=(other);
-				co = other.co;
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-
-		private:
-			float co;
-		};
-
-		class NNAddBiasConvOp : public NNOp
-		{
-		public:
-			NNAddBiasConvOp(NNBufferIdx inputA, NNBufferIdx inputB) :
-				NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			};
-
-			NNAddBiasConvOp(const NNAddBiasConvOp& other) :
-				NNOp(other)
-			{
-			}
-
-			const NNAddBiasConvOp& operator=(const NNAddBiasConvOp& other)
-			{
-				NNOp::operator=(other);
-
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNCrossEntropyOp : public NNOp
-		{
-		public:
-			NNCrossEntropyOp(NNBufferIdx inputA, NNBufferIdx inputB) :
-				NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			};
-
-			NNCrossEntropyOp(const NNCrossEntropyOp& other) :
-				NNOp(other)
-			{
-			}
-
-			const NNCrossEntropyOp& operator=(const NNCrossEntropyOp& other)
-			{
-				NNOp::operator=(other);
-
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-
-		class NNClassificationRewardOp : public NNOp
-		{
-		public:
-			NNClassificationRewardOp(NNBufferIdx inputA, NNBufferIdx inputB) :
-				NNOp()
-			{
-				input.push_back(inputA);
-				input.push_back(inputB);
-			};
-
-			NNClassificationRewardOp(const NNClassificationRewardOp& other) :
-				NNOp(other)
-			{
-			}
-
-			const NNClassificationRewardOp& operator=(const NNClassificationRewardOp& other)
-			{
-				NNOp::operator=(other);
-
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNSoftMaxOp : public NNOp
-		{
-		public:
-			NNSoftMaxOp(NNBufferIdx inputA) :
-				NNOp()
-			{
-				input.push_back(inputA);
-			};
-
-			NNSoftMaxOp(const NNSoftMaxOp& other) :
-				NNOp(other)
-			{
-			}
-
-			const NNSoftMaxOp& operator=(const NNSoftMaxOp& other)
-			{
-				NNOp::operator=(other);
-
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-
-		class NNSigmoidOp : public NNOp
-		{
-		public:
-			NNSigmoidOp(NNBufferIdx inputA) :
-				NNOp()
-			{
-				input.push_back(inputA);
-			};
-
-			NNSigmoidOp(const NNSigmoidOp& other) : NNOp(other)
-			{
-			}
-
-			const NNSigmoidOp& operator=(const NNSigmoidOp& other)
-			{
-				NNOp::operator=(other);
-				return *this;
-			}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
-
-			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
-		};
-	}
+#pragma once
+
+#include <type_traits>
+
+#include "NNBuffer.h"
+
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//All normal operations derive from this class.
+		//Parameter initalize operations and optimizers are handled seperately.
+		
+		class NNOp
+		{
+		public:
+			std::vector<OperationIdx> forwardOpIdx;//The hardware operations needed in the forward pass of this operation
+			std::vector<OperationIdx> backwardOpIdx;//The hardware operations needed in the backward pass of this operation
+
+			std::vector<BufferIdx> input;//The buffers, which are used as input to this operation
+			std::vector<BufferIdx> output;//The buffers, which are store the computed result of this operation (In almost all cases only one)
+			std::vector<BufferIdx> tmpBuffer;//The tempoaray buffers that can be used by this operation
+			std::vector<SizeVec> tmpSizes;//The necessary sizes of each temporary buffer.
+			size_t timeOffset;//The offset at this operation runs.
+			size_t timeSteps;//The number of time steps this operation runs (Is currently determined by the output buffers)
+
+#ifdef _DEBUG
+			BufferIdx debugBuffer;
+#endif
+
+			NNOp() :forwardOpIdx(), backwardOpIdx(), input(), output(), tmpSizes(), tmpBuffer(), timeOffset(0), quantWeights(MAX_UNSIGNED_INT), quantScales(MAX_UNSIGNED_INT), quantActivationScale(1.f) {};
+			
+			NNOp(const NNOp& other):
+			forwardOpIdx(other.forwardOpIdx), backwardOpIdx(other.backwardOpIdx), input(other.input),
+			output(other.output), tmpSizes(other.tmpSizes), tmpBuffer(other.tmpBuffer), timeOffset(other.timeOffset),
+			quantWeights(other.quantWeights), quantScales(other.quantScales), quantLayout(other.quantLayout), quantActivationScale(other.quantActivationScale){};
+			
+			const NNOp& operator=(const NNOp& other)
+			{
+				input = other.input;
+				output = other.output;
+
+				tmpSizes = other.tmpSizes;
+				tmpBuffer = other.tmpBuffer;
+				forwardOpIdx = other.forwardOpIdx;
+				backwardOpIdx = other.backwardOpIdx;
+
+				timeOffset = other.timeOffset;
+
+				quantWeights = other.quantWeights;
+				quantScales = other.quantScales;
+				quantLayout = other.quantLayout;
+				quantActivationScale = other.quantActivationScale;
+
+				return *this;
+			}
+
+			//Lets each function create itself
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList) = 0;
+			
+			//The size of the output buffer.
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList) = 0;
+			//The number of time steps the output buffer must be long given the input. Some operations receive only an input for one time step but generate outputs at multiple time steps.
+			//(Example: seperating into windows)
+			virtual size_t GetTimeTransform(std::vector<NNBuffer*>& bufferList);
+
+			//Adds the correct from, to indices in the buffer objects used in this operation
+			virtual void SetBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
+
+			//Calculates the necessary size for each tmporary buffer. Requires the input sizes to be known
+			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op) {}
+
+			//Returns true if all kernels of the operation can read and write their inputs and outputs as half. Otherwise the buffers used by the operation keep storing float.
+			virtual bool SupportsHalfStorage() const { return false; }
+
+			//Returns true if running the forward operations of one time step again reproduces the outputs of that time step without other side effects and the operation
+			//accesses its inputs and outputs only through the sub buffers of the time step. Its outputs can then be recomputed in the backward pass (See NeuralNetwork::SetAutomaticCheckpointing).
+			virtual bool SupportsRecompute() const { return false; }
+
+			//Sets the buffer containing the loss scale used in mixed precision training. Loss operations multiply their gradient with it.
+			//All loss operations use the same scale therefore this function is static.
+			static void SetLossScaleBuffer(const BufferIdx lossScaleBuffer);
+
+			//Returns true if the operation has an int8 version. The channels of its weights (The second input) which get their own scale are described by numChannels and channelStride (See QuantizedBuffer).
+			virtual bool GetQuantizedChannels(std::vector<NNBuffer*>& bufferList, size_t& numChannels, size_t& channelStride) const { return false; }
+
+			//Adds the int8 version of the forward operation of the current time step to the forward pass. The input is quantized using activationScale.
+			//The caller exchanges it with the float operation, therefore it is not added to forwardOpIdx.
+			virtual void InstantiateQuantized(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, const QuantizedBuffer& weights, const float activationScale) {}
+
+			//Uploads the quantized weights, their scales and the activation scale read by the int8 operations. The buffers are created by the first call, later calls overwrite them
+			//(Used to quantize the parameters again after they were trained further).
+			void UploadQuantized(BackendSystem::OpenCLBackend& backend, const QuantizedBuffer& weights, const float activationScale);
+			//Returns true if InstantiateQuantized added an int8 operation.
+			bool HasQuantizedWeights() const { return quantWeights != MAX_UNSIGNED_INT; }
+
+			//Returns the buffer an operation accumulates a count into over several forward passes (See NNCountCorrectOp). MAX_UNSIGNED_INT if it has none.
+			virtual BufferIdx GetCounter() const { return MAX_UNSIGNED_INT; }
+			//Returns the int counter of the global barriers of a persistent kernel (See NNGRUOp). It must be zero before each pass. MAX_UNSIGNED_INT if it has none.
+			virtual BufferIdx GetBarrierCounter() const { return MAX_UNSIGNED_INT; }
+
+			//Enables or disables a random augmentation of the input (See NNAugmentOp). Other operations ignore it.
+			virtual void SetAugmentation(BackendSystem::OpenCLBackend& backend, const bool enabled) {}
+
+			//Returns true if the operation can read input buffers storing a compact type (See InputStorage). All other operations read float.
+			virtual bool ReadsCompactInput() const { return false; }
+
+			//Lets the first instance of the operation process all time steps of its first input, the other instances add no operations. Called before the temporary buffers are created
+			//for operations whose first input is an input buffer and whose second input is a parameter. Returns false if the operation doesn't support it.
+			virtual bool HoistTimeSteps() { return false; }
+			//Tells the operation that time steps may be skipped for some batch elements (See NeuralNetwork::SetSequenceBatching). Called before Instantiate.
+			virtual void SetSequenceBatching(const bool sequenceBatching) {}
+
+		protected:
+			//Adds an operation multiplying the gradient of the buffer with the loss scale. Must be added before the operation computing the gradient, since the backward pass runs in reverse order.
+			void AddLossScaling(BackendSystem::OpenCLBackend& backend, NNBuffer& buffer);
+
+			//Adds the int8 matrix multiplication used by the matrix multiplication operations. The weights are stored transposed with each column padded to a multiple of four.
+			void AddQuantizedMatMul(BackendSystem::OpenCLBackend& backend, NNBuffer& bufferA, NNBuffer& bufferB, NNBuffer& bufferC, const size_t wA, const QuantizedBuffer& weights, const float activationScale);
+			//Stores the weights in quantLayout in the layout read by the int8 kernel. The convolution keeps the layout of its kernels.
+			virtual void SetQuantizedLayout(const QuantizedBuffer& weights) { quantLayout = weights.values; }
+			//Layout of the matrix multiplications. Each column is stored behind each other and padded to a multiple of four.
+			void SetQuantizedMatMulLayout(const QuantizedBuffer& weights);
+
+			static BufferIdx lossScaleBuffer;
+
+			//Device copies of the quantized weights and their scales created once for all time steps. The host data must stay valid until the upload finished.
+			BufferIdx quantWeights;
+			BufferIdx quantScales;
+			std::vector<char> quantLayout;
+			float quantActivationScale; //Read each time the int8 operation runs
+		};
+
+		class NNMatMulOp : public NNOp
+		{
+		public:
+			NNMatMulOp(NNBufferIdx inputA, NNBufferIdx inputB) : NNOp()
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			}
+
+			NNMatMulOp(const NNMatMulOp& other): NNOp(other)
+			{
+			}
+
+			const NNMatMulOp& operator=(const NNMatMulOp& other)
+			{
+				NNOp::operator=(other);
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+		
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+
+			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
+
+			virtual bool GetQuantizedChannels(std::vector<NNBuffer*>& bufferList, size_t& numChannels, size_t& channelStride) const;
+
+			virtual void InstantiateQuantized(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, const QuantizedBuffer& weights, const float activationScale);
+
+		protected:
+			virtual void SetQuantizedLayout(const QuantizedBuffer& weights) { SetQuantizedMatMulLayout(weights); }
+		};
+
+		//Matrix multiplication that flattens all dimensions of the input except the batch size. Allows the application of matrix multiplication on filter volumes.
+		//If the time steps are hoisted, the first instance multiplies all time steps of the input with the weights at once and computes the gradient of the weights
+		//over all time steps with one kernel, instead of one small multiplication per time step.
+		class NNMatMulFlatOp : public NNOp
+		{
+		public:
+			NNMatMulFlatOp(NNBufferIdx inputA, NNBufferIdx inputB) : NNOp(), hoistSteps(false), allSteps(false), firstStep(MAX_UNSIGNED_INT)
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			}
+
+			NNMatMulFlatOp(const NNMatMulFlatOp& other) : NNOp(other), hoistSteps(other.hoistSteps), allSteps(other.allSteps), firstStep(other.firstStep)
+			{
+			}
+
+			const NNMatMulFlatOp& operator=(const NNMatMulFlatOp& other)
+			{
+				NNOp::operator=(other);
+				hoistSteps = other.hoistSteps;
+				allSteps = other.allSteps;
+				firstStep = other.firstStep;
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			//The kernels over all time steps only read and write float.
+			virtual bool SupportsHalfStorage() const { return !hoistSteps; }
+			virtual bool SupportsRecompute() const { return !hoistSteps; }
+
+			virtual bool HoistTimeSteps() { hoistSteps = true; return true; }
+
+			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
+
+			virtual bool GetQuantizedChannels(std::vector<NNBuffer*>& bufferList, size_t& numChannels, size_t& channelStride) const;
+
+			virtual void InstantiateQuantized(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, const QuantizedBuffer& weights, const float activationScale);
+
+		protected:
+			virtual void SetQuantizedLayout(const QuantizedBuffer& weights) { SetQuantizedMatMulLayout(weights); }
+
+		private:
+			//Adds the operations of all time steps starting at the current one.
+			void InstantiateAllSteps(BackendSystem::OpenCLBackend& backend, NNBuffer& bufferA, NNBuffer& bufferB, NNBuffer& bufferC);
+
+			bool hoistSteps; //Set by HoistTimeSteps
+			bool allSteps; //True if the first instance processes all time steps
+			size_t firstStep; //First time step the operation runs
+		};
+
+		class NNConvOp : public NNOp
+		{
+		public:
+
+			enum ConvType
+			{
+				FULL, SAME, VALID
+			};
+
+			NNConvOp(NNBufferIdx inputA, NNBufferIdx inputB, ConvType convType, const size_t stride_x, const size_t stride_y) : NNOp(), convType(convType), pad(-1), strideX(stride_x), strideY(stride_y)
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			}
+
+			NNConvOp(NNBufferIdx inputA, NNBufferIdx inputB, const int pad, const size_t stride_x, const size_t stride_y) : NNOp(), pad(pad), convType(ConvType::VALID), strideX(stride_x), strideY(stride_y)
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			}
+
+
+			NNConvOp(const NNConvOp& other) : NNOp(other), pad(other.pad)
+			{
+			}
+
+			const NNConvOp& operator=(const NNConvOp& other)
+			{
+				NNOp::operator=(other);
+				pad = other.pad;
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual void SetTmpBuffer(std::vector<NNBuffer*>& bufferList, OperationIdx op);
+
+			virtual bool GetQuantizedChannels(std::vector<NNBuffer*>& bufferList, size_t& numChannels, size_t& channelStride) const;
+
+			virtual void InstantiateQuantized(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, const QuantizedBuffer& weights, const float activationScale);
+
+			virtual bool SupportsRecompute() const { return true; }
+
+			ConvType convType;
+			int pad;
+			size_t strideX;
+			size_t strideY;
+		};
+
+		class NNCopyInitOp : public NNOp
+		{
+		public:
+			NNCopyInitOp(NNBufferIdx inputA) :
+				NNOp()
+			{
+				input.push_back(inputA);
+			};
+
+			NNCopyInitOp(const NNCopyInitOp& other) : NNOp(other)
+			{
+			}
+
+			const NNCopyInitOp& operator=(const NNCopyInitOp& other)
+			{
+				NNOp::operator=(other);
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+		};
+
+		class NNReLUOp : public NNOp
+		{
+		public:
+			NNReLUOp(NNBufferIdx inputA) :
+				NNOp()
+			{
+				input.push_back(inputA);
+			};
+
+			NNReLUOp(const NNReLUOp& other) : NNOp(other)
+			{
+			}
+
+			const NNReLUOp& operator=(const NNReLUOp& other)
+			{
+				NNOp::operator=(other);
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNTanhOp : public NNOp
+		{
+		public:
+			NNTanhOp(NNBufferIdx inputA) :
+				NNOp()
+			{
+				input.push_back(inputA);
+			};
+
+			NNTanhOp(const NNTanhOp& other) : NNOp(other)
+			{
+			}
+
+			const NNTanhOp& operator=(const NNReLUOp& other)
+			{
+				NNOp::operator=(other);
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNElemWiseProductOp : public NNOp
+		{
+		public:
+			NNElemWiseProductOp(NNBufferIdx inputA, NNBufferIdx inputB) :
+				NNOp()
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			};
+
+			NNElemWiseProductOp(const NNElemWiseProductOp& other) : NNOp(other)
+			{
+			}
+
+			const NNElemWiseProductOp& operator=(const NNElemWiseProductOp& other)
+			{
+				NNOp::operator=(other);
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNSplitOp : public NNOp
+		{
+		public:
+			NNSplitOp(NNBufferIdx inputA, const int w, const int h) :
+				NNOp(), w(w), h(h)
+			{
+				input.push_back(inputA);
+			};
+
+			NNSplitOp(const NNSplitOp& other) : NNOp(other), w(other.w), h(other.h)
+			{
+			}
+
+			const NNSplitOp& operator=(const NNSplitOp& other)
+			{
+				NNOp::operator=(other);
+				w = other.w;
+				h = other.h;
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+			virtual size_t GetTimeTransform(std::vector<NNBuffer*>& bufferList);
+		
+		private:
+			int w, h;
+		};
+
+		class NNMaxPoolingOp : public NNOp
+		{
+		public:
+			NNMaxPoolingOp(NNBufferIdx inputA, const int padX, const int padY, const int stride, const int size) :
+				NNOp(), padX(padX), padY(padY), stride(stride), size(size)
+			{
+				input.push_back(inputA);
+			};
+
+			NNMaxPoolingOp(const NNMaxPoolingOp& other) : 
+				NNOp(other), padX(other.padX), padY(other.padY), stride(other.stride), size(other.size)
+			{
+			}
+
+			const NNMaxPoolingOp& operator=(const NNMaxPoolingOp& other)
+			{
+				NNOp::operator=(other);
+				padX = other.padX;
+				padY = other.padY;
+				size = other.size;
+				stride = other.stride;
+				return *this;
+			}
+
+			int padX, padY, stride, size;
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNMatTransposeOp : public NNOp
+		{
+		public:
+			NNMatTransposeOp(NNBufferIdx inputA) :
+				NNOp()
+			{
+				input.push_back(inputA);
+			};
+
+			NNMatTransposeOp(const NNMatTransposeOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNMatTransposeOp& operator=(const NNMatTransposeOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNLeastSquaresOp : public NNOp
+		{
+		public:
+			NNLeastSquaresOp(NNBufferIdx inputA, NNBufferIdx labelY) :
+				NNOp()
+			{
+				input.push_back(inputA);
+				input.push_back(labelY);
+			};
+
+			NNLeastSquaresOp(const NNLeastSquaresOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNLeastSquaresOp& operator=(const NNLeastSquaresOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+		};
+
+		class NNAddBiasOp : public NNOp
+		{
+		public:
+			NNAddBiasOp(NNBufferIdx inputA, NNBufferIdx inputB) :
+				NNOp()
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			};
+
+			NNAddBiasOp(const NNAddBiasOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNAddBiasOp& operator=(const NNAddBiasOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNAddOp : public NNOp
+		{
+		public:
+			NNAddOp(NNBufferIdx inputA, NNBufferIdx inputB, int timeResult = 0) :
+				NNOp(), timeResult(timeResult)
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			};
+
+			NNAddOp(const NNAddOp& other) :
+				NNOp(other), timeResult(other.timeResult)
+			{
+			}
+
+			const NNAddOp& operator=(const NNAddOp& other)
+			{
+				NNOp::operator=(other);
+				timeResult = other.timeResult;
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			//An addition into another time step writes outside of the sub buffers of its time step
+			virtual bool SupportsRecompute() const { return timeResult == 0; }
+		private:
+			size_t timeResult;
+		};
+
+		class NNCopyOp : public NNOp
+		{
+		public:
+			NNCopyOp(NNBufferIdx inputA, int timeResult = 0) :
+				NNOp(), timeResult(timeResult)
+			{
+				input.push_back(inputA);
+			};
+
+			NNCopyOp(const NNCopyOp& other) :
+				NNOp(other), timeResult(other.timeResult)
+			{
+			}
+
+			const NNCopyOp& operator=(const NNCopyOp& other)
+			{
+				NNOp::operator=(other);
+				timeResult = other.timeResult;
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			//A copy into another time step writes outside of the sub buffers of its time step
+			virtual bool SupportsRecompute() const { return timeResult == 0; }
+		private:
+			size_t timeResult;
+		};
+
+		class NNSubConstOp : public NNOp
+		{
+		public:
+			NNSubConstOp(NNBufferIdx inputA, const float co) :
+				NNOp(), co(co)
+			{
+				input.push_back(inputA);
+			};
+
+			NNSubConstOp(const NNSubConstOp& other) :
+				NNOp(other), co(other.co)
+			{
+			}
+
+			const NNSubConstOp& operator=(const NNSubConstOp& other)
+			{
+				NNOp::operator=(other);
+				co = other.co;
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+
+		private:
+			float co;
+		};
+
+		class NNAddBiasConvOp : public NNOp
+		{
+		public:
+			NNAddBiasConvOp(NNBufferIdx inputA, NNBufferIdx inputB) :
+				NNOp()
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			};
+
+			NNAddBiasConvOp(const NNAddBiasConvOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNAddBiasConvOp& operator=(const NNAddBiasConvOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNCrossEntropyOp : public NNOp
+		{
+		public:
+			NNCrossEntropyOp(NNBufferIdx inputA, NNBufferIdx inputB) :
+				NNOp()
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			};
+
+			NNCrossEntropyOp(const NNCrossEntropyOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNCrossEntropyOp& operator=(const NNCrossEntropyOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+		};
+
+
+		//Stores the index of the largest value of each example as int.
+		class NNArgmaxOp : public NNOp
+		{
+		public:
+			NNArgmaxOp(NNBufferIdx inputA) :
+				NNOp()
+			{
+				input.push_back(inputA);
+			};
+
+			NNArgmaxOp(const NNArgmaxOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNArgmaxOp& operator=(const NNArgmaxOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+		};
+
+		//Stores one for each example whose label is among the k largest values of the input and zero otherwise. The number of correct examples is added to a counter
+		//on the device by each forward pass, therefore a test set can be evaluated with a single read (See NeuralNetwork::ReadCorrect).
+		class NNCountCorrectOp : public NNOp
+		{
+		public:
+			NNCountCorrectOp(NNBufferIdx inputA, NNBufferIdx inputB, const size_t k) :
+				NNOp(), k(k), counter(MAX_UNSIGNED_INT)
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			};
+
+			NNCountCorrectOp(const NNCountCorrectOp& other) :
+				NNOp(other), k(other.k), counter(other.counter)
+			{
+			}
+
+			const NNCountCorrectOp& operator=(const NNCountCorrectOp& other)
+			{
+				NNOp::operator=(other);
+				k = other.k;
+				counter = other.counter;
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual BufferIdx GetCounter() const { return counter; }
+
+			size_t k;
+			BufferIdx counter; //Created once for all time steps
+		};
+
+		//Limits of the random augmentation of an image (See NNAugmentOp). All augmentations are disabled by default.
+		struct AugmentParams
+		{
+		public:
+			AugmentParams() : pad(0), flipX(0.f), flipY(0.f), maxAngle(0.f), maxScale(0.f), maxShift(0.f), maxBrightness(0.f), maxContrast(0.f), contrastCenter(0.5f), fill(0.f)
+			{}
+
+			int pad;//The image is padded by pad pixels and cropped at a random integer offset in [-pad, pad]
+			float flipX;//Probability of mirroring along x
+			float flipY;//Probability of mirroring along y
+			float maxAngle;//Rotation in radians
+			float maxScale;//Scaling by a factor in [1 - maxScale, 1 + maxScale]
+			float maxShift;//Continuous translation in pixels
+			float maxBrightness;//Offset added to all values
+			float maxContrast;//The distance to contrastCenter is scaled by a factor in [1 - maxContrast, 1 + maxContrast]
+			float contrastCenter;
+			float fill;//Value of the pixels outside of the input image
+		};
+
+		//Augments the input images (x, y, channels) on the device with random crops, flips, an affine warp sampled bilinearly and a brightness and contrast jitter.
+		//The parameters of each sample are generated on the device from the seed, the index of the sample and the number of the forward pass, therefore the augmentation
+		//needs no data from the host and a different augmentation is used in each pass. The operation has no backward pass and should directly follow the input buffer.
+		//It can be disabled for evaluation by NeuralNetwork::SetAugmentation.
+		class NNAugmentOp : public NNOp
+		{
+		public:
+			NNAugmentOp(NNBufferIdx inputA, const AugmentParams& params, const unsigned int seed) :
+				NNOp(), params(params), seed(seed), state(MAX_UNSIGNED_INT)
+			{
+				input.push_back(inputA);
+				initialState[0] = 0;
+				initialState[1] = 1;
+			};
+
+			NNAugmentOp(const NNAugmentOp& other) :
+				NNOp(other), params(other.params), seed(other.seed), state(other.state)
+			{
+				initialState[0] = other.initialState[0];
+				initialState[1] = other.initialState[1];
+			}
+
+			const NNAugmentOp& operator=(const NNAugmentOp& other)
+			{
+				NNOp::operator=(other);
+				params = other.params;
+				seed = other.seed;
+				state = other.state;
+				initialState[0] = other.initialState[0];
+				initialState[1] = other.initialState[1];
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual void SetAugmentation(BackendSystem::OpenCLBackend& backend, const bool enabled);
+
+			AugmentParams params;
+			unsigned int seed;
+			BufferIdx state; //Pass counter and enable flag, created once for all time steps
+			unsigned int initialState[2]; //Source of the uploads of the state, it must stay valid until they finished
+		};
+
+		//Converts the compact data of an input buffer (See NeuralNetwork::CreateInputBuffer) into float and normalizes it: (value * scale - mean) / stddev.
+		//mean and stddev contain one value per channel (sizeZ) or a single value used for all channels. The operation has no backward pass and should directly follow the input buffer.
+		class NNDequantizeOp : public NNOp
+		{
+		public:
+			NNDequantizeOp(NNBufferIdx inputA, const float scale, const std::vector<float>& mean, const std::vector<float>& stddev) :
+				NNOp(), scale(scale), mean(mean), stddev(stddev), stats(MAX_UNSIGNED_INT), statsData()
+			{
+				input.push_back(inputA);
+			};
+
+			NNDequantizeOp(const NNDequantizeOp& other) :
+				NNOp(other), scale(other.scale), mean(other.mean), stddev(other.stddev), stats(other.stats), statsData(other.statsData)
+			{
+			}
+
+			const NNDequantizeOp& operator=(const NNDequantizeOp& other)
+			{
+				NNOp::operator=(other);
+				scale = other.scale;
+				mean = other.mean;
+				stddev = other.stddev;
+				stats = other.stats;
+				statsData = other.statsData;
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool ReadsCompactInput() const { return true; }
+
+			float scale;
+			std::vector<float> mean;
+			std::vector<float> stddev;
+			BufferIdx stats; //Means and inverse standard deviations of the channels, created once for all time steps
+			std::vector<float> statsData; //Source of the upload of stats, it must stay valid until it finished
+		};
+
+		class NNClassificationRewardOp : public NNOp
+		{
+		public:
+			NNClassificationRewardOp(NNBufferIdx inputA, NNBufferIdx inputB) :
+				NNOp()
+			{
+				input.push_back(inputA);
+				input.push_back(inputB);
+			};
+
+			NNClassificationRewardOp(const NNClassificationRewardOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNClassificationRewardOp& operator=(const NNClassificationRewardOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+		};
+
+		class NNSoftMaxOp : public NNOp
+		{
+		public:
+			NNSoftMaxOp(NNBufferIdx inputA) :
+				NNOp()
+			{
+				input.push_back(inputA);
+			};
+
+			NNSoftMaxOp(const NNSoftMaxOp& other) :
+				NNOp(other)
+			{
+			}
+
+			const NNSoftMaxOp& operator=(const NNSoftMaxOp& other)
+			{
+				NNOp::operator=(other);
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		class NNSigmoidOp : public NNOp
+		{
+		public:
+			NNSigmoidOp(NNBufferIdx inputA) :
+				NNOp()
+			{
+				input.push_back(inputA);
+			};
+
+			NNSigmoidOp(const NNSigmoidOp& other) : NNOp(other)
+			{
+			}
+
+			const NNSigmoidOp& operator=(const NNSigmoidOp& other)
+			{
+				NNOp::operator=(other);
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual bool SupportsHalfStorage() const { return true; }
+			virtual bool SupportsRecompute() const { return true; }
+		};
+
+		//Complete GRU cell with the weights of the update, reset and candidate gate concatenated (See GRU.cl). Replaces the operations created by OPManager::GRUUnit.
+		//The input projections are one matrix multiplication, each time step runs one kernel computing the gates and the new state and one kernel for the backward pass.
+		//The new state is stored in the output and in the next sub buffer of the state. If the input is an input buffer its projection is computed for all time steps at once
+		//and the gradients of the weights are summed over all time steps by one kernel each.
+		//In persistent mode a single kernel loops over all time steps in each pass. Each work group keeps its part of the recurrent weights in local memory and the work groups
+		//synchronize between the time steps with global barriers. It requires an input buffer as input and enough compute units and local memory to hold the weights,
+		//otherwise one kernel per time step is used.
+		class NNGRUOp : public NNOp
+		{
+		public:
+			NNGRUOp(NNBufferIdx inputA, NNBufferIdx state, NNBufferIdx inputWeights, NNBufferIdx stateWeights, NNBufferIdx bias, const bool persistent) :
+				NNOp(), persistent(persistent), gates(MAX_UNSIGNED_INT), gateGradients(MAX_UNSIGNED_INT), counter(MAX_UNSIGNED_INT), firstStep(0), allSteps(false), slice(0), numGroups(0), sequenceBatching(false)
+			{
+				input.push_back(inputA);
+				input.push_back(state);
+				input.push_back(inputWeights);
+				input.push_back(stateWeights);
+				input.push_back(bias);
+			};
+
+			NNGRUOp(const NNGRUOp& other) :
+				NNOp(other), persistent(other.persistent), gates(other.gates), gateGradients(other.gateGradients), counter(other.counter), firstStep(other.firstStep), allSteps(other.allSteps),
+				slice(other.slice), numGroups(other.numGroups), sequenceBatching(other.sequenceBatching)
+			{
+			}
+
+			const NNGRUOp& operator=(const NNGRUOp& other)
+			{
+				NNOp::operator=(other);
+				persistent = other.persistent;
+				gates = other.gates;
+				gateGradients = other.gateGradients;
+				counter = other.counter;
+				firstStep = other.firstStep;
+				allSteps = other.allSteps;
+				slice = other.slice;
+				numGroups = other.numGroups;
+				sequenceBatching = other.sequenceBatching;
+
+				return *this;
+			}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList);
+
+			virtual SizeVec GetOutputType(std::vector<NNBuffer*>& bufferList);
+
+			virtual BufferIdx GetBarrierCounter() const { return counter; }
+			virtual void SetSequenceBatching(const bool sequenceBatching) { this->sequenceBatching = sequenceBatching; }
+
+			//Largest state size supported by the kernels, which keep the state of one batch element in local memory.
+			static const size_t MAX_HIDDEN = 1024;
+
+		private:
+			//Selects the number of state values of each work group of the persistent kernels. slice stays zero if they can't be used.
+			void SelectPersistentSlice(BackendSystem::OpenCLBackend& backend, const size_t hSize);
+
+			bool persistent; //Persistent mode was requested
+			//Gate activations and gradients of the gate inputs of all time steps. Created once for all time steps.
+			BufferIdx gates;
+			BufferIdx gateGradients;
+			BufferIdx counter; //Global barrier counter of the persistent kernels
+			size_t firstStep; //First time step the operation runs
+			bool allSteps; //True if the kernels not depending on the state process all time steps at once
+			size_t slice; //Number of state values of each work group of the persistent kernels (Zero if one kernel per time step is used)
+			size_t numGroups;
+			bool sequenceBatching; //Time steps may be skipped, the gate gradients are cleared before each pass
+		};
+	}
 }
\ No newline at end of file
@@ -1,59 +1,109 @@
-#include "NNOptimizer.h"
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-
-		NNOptimizer::NNOptimizer()
-		{
-		}
-
-
-		NNOptimizer::~NNOptimizer()
-		{
-		}
-
-		size_t NNOptimizer::GetNumBuffer() const
-		{
-			return 0;
-		}
-
-		void NNGradientDescent::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer)
-		{
-			KernelIdx kernel = backend.GetKernelIdx("GradientDecent");
-			NNBuffer* buffer = bufferList[weightBuffer];
-			size_t totalSize = buffer->size.sizeW*buffer->size.sizeZ*buffer->size.sizeY*buffer->size.sizeX;
-
-			const int WORK_GROUP_SIZE_X = 64;
-
-
-			Tuple<BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair> tuple(buffer->BackwardBuffer(), buffer->ForwardBuffer(),
-				std::pair<size_t, float>(sizeof(float), alpha), dataPair(sizeof(int), totalSize));
-
-
-			OperationIdx  matOp = backend.AddOperation<4, BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::UPDATE);
-		}
-
-		size_t NNAdam::GetNumBuffer() const
-		{
-			return 2;
-		}
-
-		void NNAdam::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer)
-		{
-			KernelIdx kernel = backend.GetKernelIdx("Adam");
-			NNBuffer* buffer = bufferList[weightBuffer];
-			size_t totalSize = buffer->size.sizeW*buffer->size.sizeZ*buffer->size.sizeY*buffer->size.sizeX;
-
-			const int WORK_GROUP_SIZE_X = 64;
-			//The ForwardBuffer of the weightBuffer contains the auxilary buffers at specific time step. (ForwardBuffer(0) contains the first auxilary buffer).
-			Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair, dataPair> tuple(buffer->BackwardBuffer(), buffer->ForwardBuffer(0), buffer->ForwardBuffer(1), buffer->ForwardBuffer(),
-				std::pair<size_t, float>(sizeof(float), alpha), std::pair<size_t, float>(sizeof(float), beta1), std::pair<size_t, float>(sizeof(float), beta2), std::pair<size_t, float>(sizeof(float), epsilon), dataPair(sizeof(int), totalSize), dataPair(sizeof(int), 1));
-
-
-			OperationIdx  matOp = backend.AddOperation<9, 10, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::UPDATE);
-			ops.push_back(matOp);
-		}
-	}
+#include "NNOptimizer.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+
+		NNOptimizer::NNOptimizer() :
+			gradScale(nullptr), lossScale(MAX_UNSIGNED_INT), overflow(MAX_UNSIGNED_INT), step(MAX_UNSIGNED_INT)
+		{
+		}
+
+
+		NNOptimizer::~NNOptimizer()
+		{
+		}
+
+		size_t NNOptimizer::GetNumBuffer() const
+		{
+			return 0;
+		}
+
+		void NNOptimizer::SetGradientScale(const float* gradScale)
+		{
+			this->gradScale = gradScale;
+		}
+
+		void NNOptimizer::SetLossScale(const BufferIdx lossScale, const BufferIdx overflow)
+		{
+			this->lossScale = lossScale;
+			this->overflow = overflow;
+		}
+
+		void NNOptimizer::SetStepBuffer(const BufferIdx step)
+		{
+			this->step = step;
+		}
+
+		void NNOptimizer::InstantiateOverflowCheck(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer)
+		{
+			KernelIdx kernel = backend.GetKernelIdx("CheckFinite");
+			NNBuffer* buffer = bufferList[weightBuffer];
+			size_t totalSize = buffer->size.sizeW*buffer->size.sizeZ*buffer->size.sizeY*buffer->size.sizeX;
+
+			const int WORK_GROUP_SIZE_X = 64;
+
+			Tuple<BufferIdx, BufferIdx, dataPair> tuple(buffer->BackwardBuffer(), overflow, dataPair(sizeof(int), totalSize));
+
+			backend.AddOperation<3, BufferIdx, BufferIdx, dataPair>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::UPDATE);
+		}
+
+		void NNOptimizer::InstantiateLossScaleUpdate(BackendSystem::OpenCLBackend& backend, const BufferIdx goodSteps, const int interval, const float maxScale)
+		{
+			KernelIdx kernel = backend.GetKernelIdx("UpdateLossScale");
+
+			Tuple<BufferIdx, BufferIdx, BufferIdx, dataPair, std::pair<size_t, float>> tuple(lossScale, overflow, goodSteps, dataPair(sizeof(int), interval), std::pair<size_t, float>(sizeof(float), maxScale));
+
+			backend.AddOperation<5, BufferIdx, BufferIdx, BufferIdx, dataPair, std::pair<size_t, float>>(kernel, tuple, cl::NullRange, cl::NDRange(1), cl::NDRange(1), BackendSystem::OpenCLBackend::OperationType::UPDATE);
+		}
+
+		void NNOptimizer::InstantiateStepCount(BackendSystem::OpenCLBackend& backend)
+		{
+			KernelIdx kernel = backend.GetKernelIdx("CountStep");
+
+			Tuple<BufferIdx, BufferIdx> tuple(step, overflow);
+
+			backend.AddOperation<2, BufferIdx, BufferIdx>(kernel, tuple, cl::NullRange, cl::NDRange(1), cl::NDRange(1), BackendSystem::OpenCLBackend::OperationType::UPDATE);
+		}
+
+		void NNGradientDescent::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer)
+		{
+			KernelIdx kernel = backend.GetKernelIdx("GradientDecent");
+			NNBuffer* buffer = bufferList[weightBuffer];
+			size_t totalSize = buffer->size.sizeW*buffer->size.sizeZ*buffer->size.sizeY*buffer->size.sizeX;
+
+			const int WORK_GROUP_SIZE_X = 64;
+
+
+			//The weights stay in float. The gradients are divided by the loss scale, which is one without mixed precision.
+			Tuple<BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair, std::pair<size_t, const float*>, BufferIdx, BufferIdx> tuple(buffer->BackwardBuffer(), buffer->ForwardBuffer(),
+				std::pair<size_t, float>(sizeof(float), alpha), dataPair(sizeof(int), totalSize), std::pair<size_t, const float*>(sizeof(float), gradScale), lossScale, overflow);
+
+
+			OperationIdx  matOp = backend.AddOperation<7, BufferIdx, BufferIdx, std::pair<size_t, float>, dataPair, std::pair<size_t, const float*>, BufferIdx, BufferIdx>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::UPDATE);
+		}
+
+		size_t NNAdam::GetNumBuffer() const
+		{
+			return 2;
+		}
+
+		void NNAdam::Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer)
+		{
+			KernelIdx kernel = backend.GetKernelIdx("Adam");
+			NNBuffer* buffer = bufferList[weightBuffer];
+			size_t totalSize = buffer->size.sizeW*buffer->size.sizeZ*buffer->size.sizeY*buffer->size.sizeX;
+
+			const int WORK_GROUP_SIZE_X = 64;
+			//The ForwardBuffer of the weightBuffer contains the auxilary buffers at specific time step. (ForwardBuffer(0) contains the first auxilary buffer).
+			//The step t is read from the step buffer, therefore updates skipped because of an overflow don't advance it.
+			Tuple<BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair, BufferIdx, std::pair<size_t, const float*>, BufferIdx, BufferIdx> tuple(buffer->BackwardBuffer(), buffer->ForwardBuffer(0), buffer->ForwardBuffer(1), buffer->ForwardBuffer(),
+				std::pair<size_t, float>(sizeof(float), alpha), std::pair<size_t, float>(sizeof(float), beta1), std::pair<size_t, float>(sizeof(float), beta2), std::pair<size_t, float>(sizeof(float), epsilon), dataPair(sizeof(int), totalSize), step,
+				std::pair<size_t, const float*>(sizeof(float), gradScale), lossScale, overflow);
+
+
+			OperationIdx  matOp = backend.AddOperation<13, BufferIdx, BufferIdx, BufferIdx, BufferIdx, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair, BufferIdx, std::pair<size_t, const float*>, BufferIdx, BufferIdx>(kernel, tuple, cl::NullRange, cl::NDRange((totalSize + WORK_GROUP_SIZE_X - (totalSize%WORK_GROUP_SIZE_X))), cl::NDRange(WORK_GROUP_SIZE_X), BackendSystem::OpenCLBackend::OperationType::UPDATE);
+		}
+	}
 }
\ No newline at end of file
@@ -1,55 +1,79 @@
-#pragma once
-
-#include "NNOperations.h"
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-		//All optimizers derive from this base class
-		class NNOptimizer
-		{
-		public:
-			NNOptimizer();
-			~NNOptimizer();
-
-			//Returns the necessary number of auxillary buffers.
-			virtual size_t GetNumBuffer() const;
-
-			//Instantiates the optimizer for the given weight buffer. This is performed for all weight buffers.
-			//It behaves the same as the Instantiate functions of the normal operations with the exception that the operations are added to the update path in general.
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer) = 0;
-		};
-
-		class NNGradientDescent : public NNOptimizer
-		{
-		public:
-			NNGradientDescent(const float alpha) : NNOptimizer(),
-				alpha(alpha)
-			{}
-
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer);
-		private:
-			const float alpha;
-		};
-
-		class NNAdam : public NNOptimizer
-		{
-		public:
-			NNAdam(const float alpha, const float beta1, const float beta2, const float epsilon) : NNOptimizer(),
-				alpha(alpha), beta1(beta1), beta2(beta2), epsilon(epsilon)
-			{}
-
-			virtual size_t GetNumBuffer() const;
-			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer);
-
-		private:
-			const float alpha;
-			const float beta1;
-			const float beta2;
-			const float epsilon;
-
-			std::vector<OperationIdx> ops;
-		};
-	}
+#pragma once
+
+#include "NNOperations.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//All optimizers derive from this base class
+		class NNOptimizer
+		{
+		public:
+			NNOptimizer();
+			~NNOptimizer();
+
+			//Returns the necessary number of auxillary buffers.
+			virtual size_t GetNumBuffer() const;
+
+			//Sets the factor the gradients are multiplied with before the update. It is read each time the update is executed (Used when gradients are accumulated over multiple batches).
+			void SetGradientScale(const float* gradScale);
+
+			//Sets the buffers containing the loss scale and the overflow flag. The gradients are divided by the loss scale and no update is performed while the flag is set.
+			void SetLossScale(const BufferIdx lossScale, const BufferIdx overflow);
+			//Sets the buffer counting the performed updates. Optimizers depending on the number of updates read it (Adam uses it for the bias correction).
+			void SetStepBuffer(const BufferIdx step);
+
+			//Adds an operation setting the overflow flag if the gradient of the weight buffer is not finite. Must be called for all weight buffers before Instantiate.
+			void InstantiateOverflowCheck(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer);
+
+			//Adds the operation adapting the loss scale and clearing the overflow flag. Must be called after Instantiate was called for all weight buffers.
+			//The scale is doubled after interval steps without an overflow but never exceeds maxScale.
+			void InstantiateLossScaleUpdate(BackendSystem::OpenCLBackend& backend, const BufferIdx goodSteps, const int interval, const float maxScale);
+
+			//Adds the operation counting the performed updates. Must be called after Instantiate was called for all weight buffers and before the overflow flag is cleared.
+			//Steps skipped because of an overflow are not counted.
+			void InstantiateStepCount(BackendSystem::OpenCLBackend& backend);
+
+			//Instantiates the optimizer for the given weight buffer. This is performed for all weight buffers.
+			//It behaves the same as the Instantiate functions of the normal operations with the exception that the operations are added to the update path in general.
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer) = 0;
+
+		protected:
+			const float* gradScale;
+
+			BufferIdx lossScale;
+			BufferIdx overflow;
+			BufferIdx step;
+		};
+
+		class NNGradientDescent : public NNOptimizer
+		{
+		public:
+			NNGradientDescent(const float alpha) : NNOptimizer(),
+				alpha(alpha)
+			{}
+
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer);
+		private:
+			const float alpha;
+		};
+
+		class NNAdam : public NNOptimizer
+		{
+		public:
+			NNAdam(const float alpha, const float beta1, const float beta2, const float epsilon) : NNOptimizer(),
+				alpha(alpha), beta1(beta1), beta2(beta2), epsilon(epsilon)
+			{}
+
+			virtual size_t GetNumBuffer() const;
+			virtual void Instantiate(BackendSystem::OpenCLBackend& backend, std::vector<NNBuffer*>& bufferList, NNBufferIdx weightBuffer);
+
+		private:
+			const float alpha;
+			const float beta1;
+			const float beta2;
+			const float epsilon;
+		};
+	}
 }
\ No newline at end of file
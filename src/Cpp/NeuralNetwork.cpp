@@ -1,648 +1,1963 @@
-#include "NeuralNetwork.h"
-
-#include <fstream>
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-		typedef NNOp NNOperation;
-
-		NeuralNetwork* NeuralNetwork::activeNN = nullptr;
-
-		NeuralNetwork::NeuralNetwork() :nnOperationList(), parameterBuffer(), initialized(false), graphInitiliazed(false), tmpDataMemory(nullptr), maxSize(0), optimizer(nullptr), numAuxBuffer(0),
-			nnBufferList(), maxSteps(1)
-		{
-			if (activeNN == nullptr)
-			{
-				activeNN = this;
-				OPManager::SetActiveNN(this);
-			}
-		}
-
-		NeuralNetwork::~NeuralNetwork()
-		{
-			size_t size = nnOperationList.size();
-			size_t i;
-			for (i = 0; i < size; ++i)
-				delete nnOperationList[i];
-			size = nnBufferList.size();
-			for (i = 0; i < size; ++i)
-				delete nnBufferList[i];
-			if (tmpDataMemory != nullptr)
-				delete tmpDataMemory;
-			if (optimizer != nullptr)
-				delete optimizer;
-			size = initOpList.size();
-			for (i = 0; i < size; ++i)
-				delete initOpList[i];
-		}
-
-		DeepCLError NeuralNetwork::InitSystem()
-		{
-			//Device Creation, etc...
-			DeepCLError err;
-			err = backend.InitGPU();
-			if (err != 0)
-			{
-				return err;
-			}
-
-			//Loade the different Kernel Files specified in KernelConfig
-			//This function call must contain the absolute or relativ path of the KernelConfig.txt file and the folder 
-			//which contains all kernels. In this case the KernelConfig file is contained in the kernel folder which contains all kernel files.
-			err = backend.LoadKernelFromConfig("./Kernel/KernelConfig.txt", "./Kernel/");
-			if (err != 0)
-			{
-				return err;
-			}
-		
-			initialized = true;
-
-			return 0;
-		}
-
-
-
-		NNBufferIdx NeuralNetwork::AddOperation(NNOp* operation, const size_t timeOffset)
-		{
-			NNBufferIdx c = CreateBuffer(operation->GetOutputType(nnBufferList), operation->GetTimeTransform(nnBufferList));
-
-			AddOperation(operation, c, timeOffset);
-
-			return c;
-		}
-
-		//Adds operation to the graph, given a target buffer for the result of the operation
-		NNBufferIdx NeuralNetwork::AddOperation(NNOp* operation, const NNBufferIdx result, const size_t timeOffset)
-		{
-			NNBufferIdx c = result;
-
-			operation->timeOffset = timeOffset;
-			operation->output.push_back(c);
-			operation->SetBuffer(nnBufferList, nnOperationList.size());
-
-			nnBufferList[result]->timeOffset = timeOffset;
-
-			nnOperationList.push_back(operation);
-
-			return c;
-		}
-
-		void NeuralNetwork::AddOptimizer(NNOptimizer* optimizer)
-		{
-			this->optimizer = optimizer;
-		}
-
-		NNBufferIdx NeuralNetwork::CreateInputBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t timeSteps)
-		{
-			//Creates a NNInputBuffer object used for inserting data into the graph
-			nnBufferList.push_back(new NNInputBuffer(sizeX, sizeY, sizeZ, sizeW, timeSteps));
-
-			//The maximal number the NN must be unrolled is set to the highest number of time steps necessary
-			if (timeSteps > maxSteps)
-				maxSteps = timeSteps;
-
-			NNBufferIdx idx = nnBufferList.size() - 1;
-			return idx;
-		}
-
-		
-		NNBufferIdx NeuralNetwork::CreateStateBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t timeSteps)
-		{
-			//Creates a state buffer used for storing the state of an RNN Cell
-			nnBufferList.push_back(new NNStateBuffer(sizeX, sizeY, sizeZ, sizeW, timeSteps));
-
-			if (timeSteps > maxSteps)
-				maxSteps = timeSteps;
-
-			NNBufferIdx idx = nnBufferList.size() - 1;
-			return idx;
-		}
-
-		
-		NNBufferIdx NeuralNetwork::CreateParameterBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW)
-		{
-			//Creates a buffer to store the trainable parameters
-			nnBufferList.push_back(new NNParamBuffer(sizeX, sizeY, sizeZ, sizeW));
-
-			NNBufferIdx idx = nnBufferList.size() - 1;
-			parameterBuffer.push_back(idx);
-			return idx;
-		}
-
-		NNBufferIdx NeuralNetwork::CreateBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t timeSteps)
-		{
-			//Determines if the currentn umber of maximal steps is lower than timeSteps. If this is the case update the maximal number of time steps
-			if (timeSteps > maxSteps)
-				maxSteps = timeSteps;
-
-			nnBufferList.push_back(new NNIntBuffer(sizeX, sizeY, sizeZ, sizeW, timeSteps));
-			return nnBufferList.size() - 1;
-		}
-
-		NNBufferIdx NeuralNetwork::CreateBuffer(const SizeVec size, const size_t timeSteps)
-		{
-			if (timeSteps > maxSteps)
-				maxSteps = timeSteps;
-
-			nnBufferList.push_back(new NNIntBuffer(size.sizeX, size.sizeY, size.sizeZ, size.sizeW, timeSteps));
-			return nnBufferList.size() - 1;
-		}
-
-#ifdef _DEBUG
-		void NeuralNetwork::WriteDataBufferGrad(NNBufferIdx buffer, const void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset)
-		{
-			//Writes data into the gradient part of an NNBuffer specified by buffer
-			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
-			NNBuffer* bufferData = nnBufferList[buffer];
-			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
-
-			if (totalSize + offset > bufferSize)
-			{
-				std::cout << "Error WriteDataBuffer: Out of Range" << std::endl;
-				return;
-			}
-
-			//uses backend to write into buffer
-			backend.WriteDataBuffer(bufferData->BackwardBuffer(), data, offset, totalSize * sizeof(float));
-		}
-#endif
-
-		//Functions for reading data out of buffers (forward or gradient buffer and at specific time points) using the backend
-		void NeuralNetwork::ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t time)
-		{
-			//Reads data from buffer and stores it in data using the Backend
-			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
-			NNBuffer* bufferData = nnBufferList[buffer];
-			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
-
-			if (totalSize + offset > bufferSize || time >= bufferData->sequenceSize)
-			{
-				std::cout << "Error ReadDataBuffer: Out of Range" << std::endl;
-				return;
-			}
-			auto locBuffer = bufferData->GetCompleteForwardBuffer();
-			backend.ReadDataBuffer(locBuffer[time], data, offset, totalSize * sizeof(float));
-		}
-
-		void NeuralNetwork::ReadDataBufferDirect(BufferIdx buffer, void* data, const size_t totalSize, const size_t offset)
-		{
-			NNBuffer* bufferData = nnBufferList[buffer];
-
-			backend.ReadDataBuffer(buffer, data, offset, totalSize * sizeof(float));
-		}
-
-
-		void NeuralNetwork::ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t time)
-		{
-			NNBuffer* bufferData = nnBufferList[buffer];
-			ReadDataBuffer(buffer, data, bufferData->size.sizeX, bufferData->size.sizeY, bufferData->size.sizeZ, bufferData->size.sizeW, 0, time);
-		}
-
-		void NeuralNetwork::ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t time)
-		{
-			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
-			NNBuffer* bufferData = nnBufferList[buffer];
-			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
-
-			if (totalSize + offset > bufferSize || time >= bufferData->sequenceSize)
-			{
-				std::cout << "Error ReadDataBuffer: Out of Range" << std::endl;
-				return;
-			}
-			auto locBwdBuffer = bufferData->GetCompleteBackwardBuffer();
-			backend.ReadDataBuffer(locBwdBuffer[time], data, offset, totalSize * sizeof(float));
-		}
-
-		void NeuralNetwork::ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t time)
-		{
-			NNBuffer* bufferData = nnBufferList[buffer];
-			ReadDataBufferGrad(buffer, data, bufferData->size.sizeX, bufferData->size.sizeY, bufferData->size.sizeZ, bufferData->size.sizeW, 0, time);
-		}
-
-		//Saves model into the file with path fileName
-		//Stores all buffers with indices listed in the map names.
-		void NeuralNetwork::SaveModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names)
-		{
-			std::fstream file; 
-			file.open(fileName.c_str(), std::ios::out | std::ios::binary);
-
-			//The buffers are stored in binary format into a file where each buffer is preceedet by the name choosen for the buffer
-			//Thereby each buffer can be loaded by using specified name. Only the forward version of a buffer is stored into the file
-			for (auto it = names.begin(); it != names.end(); ++it)
-				WriteBufferBinFile<float>(it->first, it->second, file);
-
-			file.close();
-		}
-
-		void NeuralNetwork::LoadModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names)
-		{
-			std::fstream file;
-			size_t lastPos = 0;
-			file.open(fileName.c_str(), std::ios::in | std::ios::binary);
-
-			//Loads the buffers with name in names into the corresponding buffers.
-			for (auto it = names.begin(); it != names.end(); ++it)
-				ReadBufferFile<float>(it->first, it->second, file);
-		}
-
-		SizeVec NeuralNetwork::GetSize(const NNBufferIdx a) const
-		{
-			//Returns the size of a buffer object
-			return nnBufferList[a]->size;
-		}
-
-#ifdef PROFILING_ENABLED
-		unsigned long long NeuralNetwork::GetTimeForward(const NNBufferIdx input, const NNBufferIdx output)
-		{
-			if (!graphInitiliazed)
-			{
-				std::cout << "Error command queue was not build!" << std::endl;
-				return NN_GRAPH_NOT_INITIALIZED;
-			}
-
-
-			//Calculates the time needed for all forward kernel to calculate the output using input
-			NNBuffer* bufferIn = nnBufferList[input];
-			NNBuffer* bufferOut = nnBufferList[output];
-
-			if (bufferIn->to != bufferOut->from)
-				return 0;
-
-			NNOp* operation = nnOperationList[bufferIn->to];
-			unsigned long long result = 0;
-
-			const size_t numOutputBuffer = operation->output.size();
-
-			bool correct = false;
-			for (size_t i = 0; i < numOutputBuffer; ++i)
-				if (operation->output[i] == output)
-					correct = true;
-
-			if (!correct)
-				return false;
-
-			//All forward operations needed to perform the forward pass of this operations are executed and the results are added
-
-			size_t operations = operation->forwardOpIdx.size();
-			for (size_t i = 0; i < operations; ++i)
-				result += backend.GetTime(operation->forwardOpIdx[i], BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			return result;
-		}
-
-		unsigned long long NeuralNetwork::GetTimeBackward(const NNBufferIdx input, const NNBufferIdx output)
-		{
-			if (!graphInitiliazed)
-			{
-				std::cout << "Error command queue was not build!" << std::endl;
-				return NN_GRAPH_NOT_INITIALIZED;
-			}
-
-
-			//Calculates the time needed for all forward kernel to calculate the output using input
-
-			NNBuffer* bufferIn = nnBufferList[input];
-			NNBuffer* bufferOut = nnBufferList[output];
-
-			if (bufferIn->to != bufferOut->from)
-				return 0;
-
-			NNOp* operation = nnOperationList[bufferIn->to];
-			unsigned long long result = 0;
-
-			const size_t numOutputBuffer = operation->output.size();
-
-			bool correct = false;
-			for (size_t i = 0; i < numOutputBuffer; ++i)
-				if (operation->output[i] == output)
-					correct = true;
-
-			if (!correct)
-				return false;
-
-			//All backend operations needed to perform the backward pass of this operations are executed and the results are added
-
-			size_t operations = operation->backwardOpIdx.size();
-			for (size_t i = 0; i < operations; ++i)
-				result += backend.GetTime(operation->backwardOpIdx[i], BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			return result;
-		}
-#endif // PROFILING_ENABLED
-
-		DeepCLError NeuralNetwork::InitliazeGraph(const size_t batchSize)
-		{
-			if (!initialized)
-			{
-				std::cout << "Error neural network system not initialized!" << std::endl;
-				return NN_SYSTEM_NOT_INITIALIZED;
-			}
-
-			//Adjust the w component of each size to be equal to the number of batch elements if necessary. (Trainable parameters are not changed by this but input, state, intermediate, etc. buffers are effected by it)
-			SetBatchSize(batchSize);
-
-			//Calculates the maximal number of needed temporary buffers and the required size. Then the necessary number of tmpBuffers is created.
-			//Operations, which need a temporary buffer will have handels to the required temporary buffers passed to them. The handles are indices into the nnBufferList vector.
-			CreateTmpBuffer();
-
-			//Creates actual OpenCL buffer objects by calling instantiate on each Buffer object
-			InstantiateBuffer();
-
-			//Create backend Operations by calling instantiate on each operations in the correct order multiple times. 
-			//(The order depends on offsets in the time and the number of times instantiate is called on the number of time steps the operation runs)
-			
-			InstantiateOperations();
-			
-			//Sets all buffers to zero.
-			ClearAllBuffer();
-
-			//Initalizes all weights using the initalize operations
-			InitalizeWeights();
-
-			//The Neural Network may no be used for inference/trainig
-			graphInitiliazed = true;
-
-			return 0;
-		}
-
-		void NeuralNetwork::SetBatchSize(const size_t batchSize)
-		{
-			size_t size = nnBufferList.size();
-			size_t i, tmpSize;
-
-			//Loop over all buffers and call SetBatchSize on them which sets the w component of the size to be equal to the batch size if it is necessary for the buffer.
-			//The parameter buffers won't do anything
-			for (i = 0; i < size; ++i)
-			{
-				NNBuffer* buffer = nnBufferList[i];
-				SizeVec sizeVec = buffer->size;
-				
-
-				buffer->SetBatchSize(batchSize);
-
-				tmpSize = sizeVec.sizeX * sizeVec.sizeY * sizeVec.sizeZ * sizeVec.sizeW;
-				if (tmpSize > maxSize)
-					maxSize = tmpSize;
-			}
-
-			tmpDataMemory = new float[maxSize];
-		}
-
-
-		void NeuralNetwork::InstantiateBuffer()
-		{
-			//Retrieve information of the needed number of auxilary buffers for the optimizer.
-			//Adam for example needs to auxilary buffers for the momentum and adaptive learning rate.
-			if (optimizer != nullptr)
-				numAuxBuffer = optimizer->GetNumBuffer();
-
-			//The number of auxilary buffers is static because for each parameter the number of auxilary buffer is equal since the number depends only on the optimizer
-			NNParamBuffer::SetNumAuxBuffer(numAuxBuffer);
-
-			size_t size = nnBufferList.size();
-			size_t i;
-
-			//Let each buffer in nnBufferList create the required number of OpenCL buffer and subbuffer objects.
-			for (i = 0; i < size; ++i)
-			{
-				nnBufferList[i]->Instantiate(backend);
-			}
-		}
-
-
-		void NeuralNetwork::CreateTmpBuffer()
-		{
-			size_t size = nnOperationList.size();
-			size_t tmpSize;
-			size_t currentTmpBufferSize = 0;
-			size_t i, j;
-
-			NNOperation* op;
-
-			std::vector<size_t> tmpBufferSize;
-
-			//Calculate the necessary number of buffers for each operation
-			for (i = 0; i < size; ++i)
-			{
-				op = nnOperationList[i];
-				op->SetTmpBuffer(nnBufferList, i);
-
-				tmpSize = op->tmpSizes.size();
-
-				//Check if the required number of tmpBuffers is bigger as the current number of tmpBuffers
-				if (currentTmpBufferSize < tmpSize)
-				{
-					//Add the necessary number of tmpBuffers
-					size_t numToAdd = tmpSize - currentTmpBufferSize;
-					for (j = 0; j < numToAdd ; ++j)
-					{
-						SizeVec opSize = op->tmpSizes[currentTmpBufferSize++];
-						tmpBufferSize.push_back(opSize.sizeX * opSize.sizeY * opSize.sizeZ * opSize.sizeW);
-					}
-				}
-
-				//Calculate if the currently available tmp buffers are big enough if not increase the size
-				for (j = 0; j < tmpSize; ++j)
-				{
-					size_t totalSize = tmpBufferSize[j];
-					size_t totalTmpSize = op->tmpSizes[j].sizeX * op->tmpSizes[j].sizeY * op->tmpSizes[j].sizeZ * op->tmpSizes[j].sizeW;
-					tmpBufferSize[j] = totalSize < totalTmpSize ? totalTmpSize : totalSize;
-				}
-			}
-
-			size = tmpBufferSize.size();
-
-			//Add the tmpBuffers to the nnBufferList
-			for (i = 0; i < size; ++i)
-			{
-				nnBufferList.push_back(new NNTmpBuffer(tmpBufferSize[i], 1, 1, 1));
-			}
-			size_t tmpBufferIdx = nnBufferList.size() - size;
-
-			size = nnOperationList.size();
-
-			//Pass the indices of the tmpBuffers to each operation
-			for (i = 0; i < size; ++i)
-			{
-				op = nnOperationList[i];
-
-				tmpSize = op->tmpSizes.size();
-				for (j = 0; j < tmpSize; ++j)
-				{
-					op->tmpBuffer.push_back(tmpBufferIdx + j);
-				}
-			}
-		}
-
-		void NeuralNetwork::InstantiateOperations()
-		{
-			size_t size = nnOperationList.size();
-			size_t i, j, k;
-
-
-			//The maximal number of steps is determined by the buffer with the longest length.
-			//Iterate over the maximal number of time steps to instantiate each operation the number of times necessary.
-			size_t outputTime;
-			NNOp* operation;
-			for (j = 0; j < maxSteps; ++j)
-			{
-				//Iterate over all operations in the graph
-				for (i = 0; i < size; ++i)
-				{
-					//The number of time steps an operation runs is determined by the number of time steps of the output.
-					//In most cases(all) operations only have one output
-					//In principle all time steps in the output must be equal.
-					//At the moment there are no exceptions.
-
-					//Determine the number of time steps the operation must be executed.
-					outputTime = 0;
-					operation = nnOperationList[i];
-					for (k = 0; k < operation->output.size(); ++k)
-					{
-						if (nnBufferList[operation->output[k]]->sequenceSize > outputTime)
-							outputTime = nnBufferList[operation->output[k]]->sequenceSize;
-					}
-
-					//Each operation has an associated offset allowing, for example a loss, to be computed at an specific time step. The operation is only executed when the offset is smaller  or equal than the current time step.
-					if (j < outputTime && operation->timeOffset <= j)
-						nnOperationList[i]->Instantiate(backend, nnBufferList);
-				}
-				//Each buffer contains a time step variable, which allows the hardware sub buffer of the current time step to be automatically returned.
-				UpdateBufferTime();
-			}
-
-			//Set all Buffer times to zero.
-			ResetBufferTime();
-
-			//The optimizer must be instantiate as well.
-			if (optimizer != nullptr)
-			{
-				size = parameterBuffer.size();
-
-				for (i = 0; i < size; ++i)
-				{
-					//The optimizer will add auxilary buffers to the parameter buffers.
-					optimizer->Instantiate(backend, nnBufferList, parameterBuffer[i]);
-				}
-			}
-		}
-
-		void NeuralNetwork::AddWeightInitializer(InitOp* initOp)
-		{
-			//The initOps stored in initOpList will be used in IntializeWeights
-			initOpList.push_back(initOp);
-		}
-
-		void NeuralNetwork::InitalizeWeights()
-		{
-
-			//Calls instantiate on each initOperation therby allowing each init operation to initalize its buffers.
-			size_t size = initOpList.size();
-
-			for (size_t i = 0; i < size; ++i)
-				initOpList[i]->Instantiate(nnBufferList, backend);
-		}
-
-		DeepCLError NeuralNetwork::Backward()
-		{
-			//Calculate the backward pass of the Neural Network.
-			//Results only in non-zero results if forward pass was performed beforehand
-			if (!graphInitiliazed)
-			{
-				std::cout << "Error command queue was not build!" << std::endl;
-				return NN_GRAPH_NOT_INITIALIZED;
-			}
-
-			backend.Run(BackendSystem::OpenCLBackend::OperationType::BACKWARD);
-			
-			
-			return 0;
-		}
-
-		DeepCLError NeuralNetwork::BatchDone()
-		{
-			//Calcualte update operations (Performing optimizer update etc.)
-			if (!graphInitiliazed)
-			{
-				std::cout << "Error command queue was not build!" << std::endl;
-				return NN_GRAPH_NOT_INITIALIZED;
-			}
-
-			backend.Run(BackendSystem::OpenCLBackend::OperationType::UPDATE);
-
-			//Set the backward buffers to zero.
-			ClearBackwardBuffer();
-			
-			return 0;
-		}
-
-		DeepCLError NeuralNetwork::Forward()
-		{
-			//Calculate the forward pass of the NN
-			if (!graphInitiliazed)
-			{
-				std::cout << "Error command queue was not build!" << std::endl;
-				return NN_GRAPH_NOT_INITIALIZED;
-			}
-			backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
-			return 0;
-		}
-
-		void NeuralNetwork::ClearBackwardBuffer()
-		{
-			size_t size = nnBufferList.size();
-
-			//Set all backward buffers to zero.
-			for (size_t i = 0; i < size; ++i)
-				nnBufferList[i]->Reset(backend);
-		}
-
-		void NeuralNetwork::UpdateBufferTime()
-		{
-			size_t size = nnBufferList.size();
-			
-			//Increase the buffer time. This way the next sub buffer is retrieved when accessing the current forward and backward buffer in the buffer. Only increased if necessary (Example for state buffers)
-			for (size_t i = 0; i < size; ++i)
-			{
-				nnBufferList[i]->UpdateStep();
-			}
-		}
-
-		void NeuralNetwork::ResetBufferTime()
-		{
-			//Set the time variable in each buffer to zero (This determines which sub buffer will be returned by some buffers)
-			size_t size = nnBufferList.size();
-
-			//The reset function all sets the backward buffer to zero
-			for (size_t i = 0; i < size; ++i)
-			{
-				nnBufferList[i]->Reset();
-			}
-		}
-
-		void NeuralNetwork::ClearAllBuffer()
-		{
-			size_t size = nnBufferList.size();
-
-			std::vector<BufferIdx> bwdBuffer;
-
-			for (size_t i = 0; i < size; ++i)
-			{
-				NNBuffer* buffer = nnBufferList[i];
-
-				//Set all backward sub buffers to zero
-				bwdBuffer = buffer->GetCompleteBackwardBuffer();
-				for (size_t j = 0; j < bwdBuffer.size(); ++j)
-				{
-					if (bwdBuffer[j] != MAX_UNSIGNED_INT)
-						backend.ResetBuffer(bwdBuffer[j], buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW * sizeof(float));
-				}
-
-				//Set all forward sub buffers to zero
-				bwdBuffer = buffer->GetCompleteForwardBuffer();
-				for (size_t j = 0; j < bwdBuffer.size(); ++j)
-					backend.ResetBuffer(bwdBuffer[j], buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW * sizeof(float));
-			}
-		}
-	}
+#include "NeuralNetwork.h"
+
+#include <fstream>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <cstring>
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		typedef NNOp NNOperation;
+
+		//Upper bound of the loss scale.
+		const float MAX_LOSS_SCALE = 16777216.f;
+
+		//Converts a value read from a buffer storing half into float.
+		static float HalfToFloat(const cl_half value)
+		{
+			const int exponent = (value >> 10) & 0x1f;
+			const unsigned int mantissa = value & 0x3ff;
+
+			float result;
+			if (exponent == 0)
+				result = std::ldexp(static_cast<float>(mantissa), -24);
+			else if (exponent == 31)
+				result = mantissa == 0 ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+			else
+				result = std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+
+			return (value & 0x8000) ? -result : result;
+		}
+
+		NeuralNetwork* NeuralNetwork::activeNN = nullptr;
+
+		NeuralNetwork::NeuralNetwork() :nnOperationList(), parameterBuffer(), initialized(false), graphInitiliazed(false), tmpDataMemory(nullptr), maxSize(0), optimizer(nullptr), numAuxBuffer(0),
+			nnBufferList(), maxSteps(1), gradScale(1.f), numMicroBatches(0), parameterAccumulate(false), prefetchedBatch(0),
+			mixedPrecision(false), sequenceBatching(false), automaticCheckpointing(false), recomputedMemory(0), scratchMemory(0), lossScale(1.f), lossScaleInterval(0), lossScaleBuffer(MAX_UNSIGNED_INT), overflowBuffer(MAX_UNSIGNED_INT), goodStepsBuffer(MAX_UNSIGNED_INT), stepBuffer(MAX_UNSIGNED_INT),
+			quantized(false), stepRecorded(false), checkpointWriter(nullptr), gradientCompression(COMPRESSION_NONE), compressionDensity(0.01f), gradientCompressor(nullptr),
+			gradientPositions(), gradientPositionOps(MAX_UNSIGNED_INT)
+		{
+			if (activeNN == nullptr)
+			{
+				activeNN = this;
+				OPManager::SetActiveNN(this);
+			}
+		}
+
+		NeuralNetwork::~NeuralNetwork()
+		{
+			//The checkpoint thread reads the buffers of the backend
+			if (checkpointWriter != nullptr)
+				delete checkpointWriter;
+			size_t size = nnOperationList.size();
+			size_t i;
+			for (i = 0; i < size; ++i)
+				delete nnOperationList[i];
+			size = nnBufferList.size();
+			for (i = 0; i < size; ++i)
+				delete nnBufferList[i];
+			if (tmpDataMemory != nullptr)
+				delete tmpDataMemory;
+			if (optimizer != nullptr)
+				delete optimizer;
+			if (gradientCompressor != nullptr)
+				delete gradientCompressor;
+			size = initOpList.size();
+			for (i = 0; i < size; ++i)
+				delete initOpList[i];
+			//The operations exchanged with the backend are owned by the network
+			size = exchangedOps.size();
+			for (i = 0; i < size; ++i)
+				delete exchangedOps[i].second;
+		}
+
+		DeepCLError NeuralNetwork::InitSystem()
+		{
+			//Device Creation, etc...
+			DeepCLError err;
+			err = backend.InitGPU();
+			if (err != 0)
+			{
+				return err;
+			}
+
+			return LoadKernels();
+		}
+
+		DeepCLError NeuralNetwork::InitSystem(const cl::Device& device)
+		{
+			DeepCLError err;
+			err = backend.InitDevice(device);
+			if (err != 0)
+			{
+				return err;
+			}
+
+			return LoadKernels();
+		}
+
+		DeepCLError NeuralNetwork::LoadKernels()
+		{
+			DeepCLError err;
+			//Loade the different Kernel Files specified in KernelConfig
+			//This function call must contain the absolute or relativ path of the KernelConfig.txt file and the folder 
+			//which contains all kernels. In this case the KernelConfig file is contained in the kernel folder which contains all kernel files.
+			err = backend.LoadKernelFromConfig("./Kernel/KernelConfig.txt", "./Kernel/");
+			if (err != 0)
+			{
+				return err;
+			}
+		
+			initialized = true;
+
+			return 0;
+		}
+
+
+
+		NNBufferIdx NeuralNetwork::AddOperation(NNOp* operation, const size_t timeOffset)
+		{
+			NNBufferIdx c = CreateBuffer(operation->GetOutputType(nnBufferList), operation->GetTimeTransform(nnBufferList));
+
+			AddOperation(operation, c, timeOffset);
+
+			return c;
+		}
+
+		//Adds operation to the graph, given a target buffer for the result of the operation
+		NNBufferIdx NeuralNetwork::AddOperation(NNOp* operation, const NNBufferIdx result, const size_t timeOffset)
+		{
+			NNBufferIdx c = result;
+
+			operation->timeOffset = timeOffset;
+			operation->output.push_back(c);
+			operation->SetBuffer(nnBufferList, nnOperationList.size());
+
+			nnBufferList[result]->timeOffset = timeOffset;
+
+			nnOperationList.push_back(operation);
+
+			return c;
+		}
+
+		void NeuralNetwork::AddOptimizer(NNOptimizer* optimizer)
+		{
+			this->optimizer = optimizer;
+		}
+
+		NNBufferIdx NeuralNetwork::CreateInputBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t timeSteps, const size_t numSlots,
+			const InputStorage storage)
+		{
+			//Creates a NNInputBuffer object used for inserting data into the graph
+			NNInputBuffer* inputBuffer = new NNInputBuffer(sizeX, sizeY, sizeZ, sizeW, timeSteps, 0, numSlots, storage);
+			nnBufferList.push_back(inputBuffer);
+
+			//The maximal number the NN must be unrolled is set to the highest number of time steps necessary
+			if (timeSteps > maxSteps)
+				maxSteps = timeSteps;
+
+			NNBufferIdx idx = nnBufferList.size() - 1;
+
+			//Buffers with multiple slots are switched to the prefetched slot at the beginning of Forward()
+			if (numSlots > 1)
+				slotInputBuffer[idx] = inputBuffer;
+
+			return idx;
+		}
+
+		
+		NNBufferIdx NeuralNetwork::CreateStateBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t timeSteps, const bool carryState)
+		{
+			//Creates a state buffer used for storing the state of an RNN Cell
+			NNStateBuffer* stateBuffer = new NNStateBuffer(sizeX, sizeY, sizeZ, sizeW, timeSteps, 0, carryState);
+			nnBufferList.push_back(stateBuffer);
+			if (carryState)
+				carriedStates.push_back(stateBuffer);
+
+			if (timeSteps > maxSteps)
+				maxSteps = timeSteps;
+
+			NNBufferIdx idx = nnBufferList.size() - 1;
+			return idx;
+		}
+
+		
+		NNBufferIdx NeuralNetwork::CreateParameterBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW)
+		{
+			//Creates a buffer to store the trainable parameters
+			nnBufferList.push_back(new NNParamBuffer(sizeX, sizeY, sizeZ, sizeW));
+
+			NNBufferIdx idx = nnBufferList.size() - 1;
+			parameterBuffer.push_back(idx);
+			return idx;
+		}
+
+		NNBufferIdx NeuralNetwork::CreateBuffer(const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t timeSteps)
+		{
+			//Determines if the currentn umber of maximal steps is lower than timeSteps. If this is the case update the maximal number of time steps
+			if (timeSteps > maxSteps)
+				maxSteps = timeSteps;
+
+			nnBufferList.push_back(new NNIntBuffer(sizeX, sizeY, sizeZ, sizeW, timeSteps));
+			return nnBufferList.size() - 1;
+		}
+
+		NNBufferIdx NeuralNetwork::CreateBuffer(const SizeVec size, const size_t timeSteps)
+		{
+			if (timeSteps > maxSteps)
+				maxSteps = timeSteps;
+
+			nnBufferList.push_back(new NNIntBuffer(size.sizeX, size.sizeY, size.sizeZ, size.sizeW, timeSteps));
+			return nnBufferList.size() - 1;
+		}
+
+#ifdef _DEBUG
+		void NeuralNetwork::WriteDataBufferGrad(NNBufferIdx buffer, const void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset)
+		{
+			//Writes data into the gradient part of an NNBuffer specified by buffer
+			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
+			NNBuffer* bufferData = nnBufferList[buffer];
+			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
+
+			if (totalSize + offset > bufferSize)
+			{
+				std::cout << "Error WriteDataBuffer: Out of Range" << std::endl;
+				return;
+			}
+
+			//uses backend to write into buffer
+			backend.WriteDataBuffer(bufferData->BackwardBuffer(), data, offset, totalSize * sizeof(float));
+		}
+#endif
+
+		//Functions for reading data out of buffers (forward or gradient buffer and at specific time points) using the backend
+		void NeuralNetwork::ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t time)
+		{
+			//Reads data from buffer and stores it in data using the Backend
+			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
+			NNBuffer* bufferData = nnBufferList[buffer];
+			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
+
+			if (totalSize + offset > bufferSize || time >= bufferData->sequenceSize)
+			{
+				std::cout << "Error ReadDataBuffer: Out of Range" << std::endl;
+				return;
+			}
+			auto locBuffer = bufferData->GetCompleteForwardBuffer();
+			if (bufferData->IsHalfStorage())
+				ReadHalfBuffer(locBuffer[time], data, offset, totalSize);
+			else
+				backend.ReadDataBuffer(locBuffer[time], data, offset, totalSize * sizeof(float));
+		}
+
+		void NeuralNetwork::ReadDataBufferDirect(BufferIdx buffer, void* data, const size_t totalSize, const size_t offset)
+		{
+			NNBuffer* bufferData = nnBufferList[buffer];
+
+			backend.ReadDataBuffer(buffer, data, offset, totalSize * sizeof(float));
+		}
+
+
+		void NeuralNetwork::ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t time)
+		{
+			NNBuffer* bufferData = nnBufferList[buffer];
+			ReadDataBuffer(buffer, data, bufferData->size.sizeX, bufferData->size.sizeY, bufferData->size.sizeZ, bufferData->size.sizeW, 0, time);
+		}
+
+		void NeuralNetwork::ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t time)
+		{
+			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
+			NNBuffer* bufferData = nnBufferList[buffer];
+			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
+
+			if (totalSize + offset > bufferSize || time >= bufferData->sequenceSize)
+			{
+				std::cout << "Error ReadDataBuffer: Out of Range" << std::endl;
+				return;
+			}
+			auto locBwdBuffer = bufferData->GetCompleteBackwardBuffer();
+			if (bufferData->IsHalfStorage())
+				ReadHalfBuffer(locBwdBuffer[time], data, offset, totalSize);
+			else
+				backend.ReadDataBuffer(locBwdBuffer[time], data, offset, totalSize * sizeof(float));
+		}
+
+		void NeuralNetwork::ReadHalfBuffer(BufferIdx buffer, void* data, const size_t offset, const size_t totalSize)
+		{
+			//The values are converted into float after the read finished.
+			std::vector<cl_half> halfData(totalSize);
+			backend.ReadDataBuffer(buffer, halfData.data(), offset, totalSize * sizeof(cl_half));
+			FinishTransfers();
+
+			float* floatData = reinterpret_cast<float*>(data);
+			for (size_t i = 0; i < totalSize; ++i)
+				floatData[i] = HalfToFloat(halfData[i]);
+		}
+
+		void NeuralNetwork::FinishTransfers()
+		{
+			cl::Event readEvent;
+			backend.EnqueueMarker(&readEvent);
+			readEvent.wait();
+		}
+
+		void NeuralNetwork::ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t time)
+		{
+			NNBuffer* bufferData = nnBufferList[buffer];
+			ReadDataBufferGrad(buffer, data, bufferData->size.sizeX, bufferData->size.sizeY, bufferData->size.sizeZ, bufferData->size.sizeW, 0, time);
+		}
+
+		//Saves model into the file with path fileName
+		//Stores all buffers with indices listed in the map names.
+		DeepCLError NeuralNetwork::SaveModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names, const bool quantized)
+		{
+			//Only the forward version of a buffer is stored into the file. All buffers are read before the file is written.
+			ModelFileWriter writer;
+			std::vector<std::vector<float>> values;
+			values.reserve(names.size());
+			for (auto it = names.begin(); it != names.end(); ++it)
+			{
+				const SizeVec& size = nnBufferList[it->first]->size;
+				auto quantIt = quantizedParameter.find(it->first);
+				if (quantized && quantIt != quantizedParameter.end())
+				{
+					writer.AddQuantizedTensor(it->second, quantIt->second, size);
+					continue;
+				}
+
+				values.push_back(std::vector<float>(size.sizeX * size.sizeY * size.sizeZ * size.sizeW));
+				ReadDataBuffer(it->first, values.back().data(), 0);
+				writer.AddTensor(it->second, values.back().data(), size);
+			}
+			FinishTransfers();
+
+			return writer.Write(fileName);
+		}
+
+		DeepCLError NeuralNetwork::LoadModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names)
+		{
+			//Files written before the tensor table was introduced contain each name followed by the values.
+			if (!ModelFileReader::IsModelFile(fileName))
+			{
+				std::fstream file;
+				file.open(fileName.c_str(), std::ios::in | std::ios::binary);
+				if (!file.is_open())
+				{
+					std::cerr << "Error model file: " << fileName << " could not be opened" << std::endl;
+					return NN_MODEL_FILE_ERROR;
+				}
+
+				//Loads the buffers with name in names into the corresponding buffers.
+				for (auto it = names.begin(); it != names.end(); ++it)
+					ReadBufferFile<float>(it->first, it->second, file);
+				FinishTransfers();
+				return 0;
+			}
+
+			ModelFileReader reader;
+			DeepCLError err = reader.Open(fileName);
+			if (err != 0)
+				return err;
+
+			//Int8 tensors are converted into float before the upload, the remaining tensors are uploaded from the mapping.
+			std::vector<std::vector<float>> dequantized;
+			for (auto it = names.begin(); it != names.end(); ++it)
+			{
+				const ModelTensorEntry* entry = reader.Find(it->second);
+				if (entry == nullptr)
+				{
+					std::cerr << "name: " << it->second << " not found in file" << std::endl;
+					err = NN_MODEL_FILE_ERROR;
+					continue;
+				}
+
+				const SizeVec& size = nnBufferList[it->first]->size;
+				const size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW;
+				//Each channel contains at least one value. Bounding the number of channels read from the file keeps the size computed from it from overflowing.
+				const bool validChannels = entry->channelStride > 0 && entry->numChannels > 0 && entry->numChannels <= totalSize;
+				const size_t expectedSize = entry->dataType == MODEL_INT8 ? static_cast<size_t>(entry->numChannels) * sizeof(float) + totalSize : totalSize * sizeof(float);
+				if (entry->shape[0] != size.sizeX || entry->shape[1] != size.sizeY || entry->shape[2] != size.sizeZ || entry->shape[3] != size.sizeW
+					|| !validChannels || entry->size != expectedSize)
+				{
+					std::cerr << "Error model file: " << it->second << " does not match the size of the buffer" << std::endl;
+					err = NN_MODEL_FILE_ERROR;
+					continue;
+				}
+				if (!reader.VerifyChecksum(*entry))
+				{
+					std::cerr << "Error model file: checksum of " << it->second << " does not match" << std::endl;
+					err = NN_MODEL_FILE_ERROR;
+					continue;
+				}
+
+				const char* payload = reader.Payload(*entry);
+				if (entry->dataType == MODEL_INT8)
+				{
+					const float* scales = reinterpret_cast<const float*>(payload);
+					const char* quantValues = payload + entry->numChannels * sizeof(float);
+					dequantized.push_back(std::vector<float>(totalSize));
+					for (size_t e = 0; e < totalSize; ++e)
+						dequantized.back()[e] = quantValues[e] * scales[(e / entry->channelStride) % entry->numChannels];
+					WriteDataBuffer<float>(it->first, dequantized.back().data(), size.sizeX, size.sizeY, size.sizeZ, size.sizeW);
+				}
+				else
+					WriteDataBuffer<float>(it->first, reinterpret_cast<const float*>(payload), size.sizeX, size.sizeY, size.sizeZ, size.sizeW);
+			}
+
+			//The mapping must stay valid until the uploads finished.
+			FinishTransfers();
+			return err;
+		}
+
+		DeepCLError NeuralNetwork::SaveCheckpoint(const std::string& fileName, const unsigned long long dataPosition)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+			//The snapshot buffers are created once for all parameters, auxiliary buffers and the state of the loss scaling.
+			if (checkpointWriter == nullptr)
+			{
+				checkpointWriter = new CheckpointWriter(backend);
+				for (size_t i = 0; i < parameterBuffer.size(); ++i)
+				{
+					NNBuffer* buffer = nnBufferList[parameterBuffer[i]];
+					std::ostringstream name;
+					name << "param" << i;
+					checkpointWriter->AddTensor(name.str(), buffer->ForwardBuffer(), buffer->size);
+
+					for (size_t j = 0; j < numAuxBuffer; ++j)
+					{
+						std::ostringstream auxName;
+						auxName << name.str() << "/aux" << j;
+						checkpointWriter->AddTensor(auxName.str(), buffer->ForwardBuffer(j), buffer->size);
+					}
+				}
+				checkpointWriter->AddBlob("state/lossScale", lossScaleBuffer, sizeof(float));
+				checkpointWriter->AddBlob("state/goodSteps", goodStepsBuffer, sizeof(int));
+				checkpointWriter->AddBlob("state/step", stepBuffer, sizeof(int));
+			}
+
+			std::vector<std::pair<std::string, std::string>> hostBlobs;
+			hostBlobs.push_back(std::pair<std::string, std::string>("state/training", std::string(reinterpret_cast<const char*>(&dataPosition), sizeof(dataPosition))));
+
+			//Waits only if the previous checkpoint is still being written.
+			checkpointWriter->Write(fileName, hostBlobs);
+			return 0;
+		}
+
+		DeepCLError NeuralNetwork::WaitForCheckpoint()
+		{
+			return checkpointWriter != nullptr ? checkpointWriter->Wait() : 0;
+		}
+
+		const char* NeuralNetwork::FindCheckpointBlob(const ModelFileReader& reader, const std::string& name, const size_t size) const
+		{
+			const ModelTensorEntry* entry = reader.Find(name);
+			if (entry == nullptr)
+			{
+				std::cerr << "name: " << name << " not found in file" << std::endl;
+				return nullptr;
+			}
+			if (entry->size != size)
+			{
+				std::cerr << "Error model file: " << name << " does not have the expected size" << std::endl;
+				return nullptr;
+			}
+			if (!reader.VerifyChecksum(*entry))
+			{
+				std::cerr << "Error model file: checksum of " << name << " does not match" << std::endl;
+				return nullptr;
+			}
+			return reader.Payload(*entry);
+		}
+
+		bool NeuralNetwork::ReadCheckpointTensor(const ModelFileReader& reader, const std::string& name, const SizeVec& shape, std::vector<float>& values) const
+		{
+			const ModelTensorEntry* entry = reader.Find(name);
+			if (entry == nullptr)
+			{
+				std::cerr << "name: " << name << " not found in file" << std::endl;
+				return false;
+			}
+
+			const size_t totalSize = shape.sizeX * shape.sizeY * shape.sizeZ * shape.sizeW;
+			if ((entry->dataType != MODEL_FLOAT32 && entry->dataType != MODEL_FLOAT32_PACKED) || (entry->dataType == MODEL_FLOAT32 && entry->size != totalSize * sizeof(float))
+				|| entry->shape[0] != shape.sizeX || entry->shape[1] != shape.sizeY || entry->shape[2] != shape.sizeZ || entry->shape[3] != shape.sizeW)
+			{
+				std::cerr << "Error model file: " << name << " does not match the size of the buffer" << std::endl;
+				return false;
+			}
+			if (!reader.VerifyChecksum(*entry))
+			{
+				std::cerr << "Error model file: checksum of " << name << " does not match" << std::endl;
+				return false;
+			}
+
+			values.resize(totalSize);
+			if (entry->dataType == MODEL_FLOAT32)
+				std::memcpy(values.data(), reader.Payload(*entry), totalSize * sizeof(float));
+			else if (!UnpackFloats(reader.Payload(*entry), static_cast<size_t>(entry->size), values.data(), totalSize))
+			{
+				std::cerr << "Error model file: " << name << " could not be unpacked" << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		DeepCLError NeuralNetwork::LoadCheckpoint(const std::string& fileName, unsigned long long& dataPosition)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (quantized)
+			{
+				std::cout << "Error the graph uses the int8 operations!" << std::endl;
+				return NN_GRAPH_QUANTIZED;
+			}
+
+			//The file may be the one still being written.
+			WaitForCheckpoint();
+
+			ModelFileReader reader;
+			DeepCLError err = reader.Open(fileName);
+			if (err != 0)
+				return err;
+
+			//All tensors are unpacked and checked before anything is uploaded, therefore a damaged checkpoint leaves the training state unchanged.
+			std::vector<std::pair<BufferIdx, std::vector<float>>> uploads;
+			uploads.reserve(parameterBuffer.size() * (numAuxBuffer + 1));
+			for (size_t i = 0; i < parameterBuffer.size() && err == 0; ++i)
+			{
+				NNBuffer* buffer = nnBufferList[parameterBuffer[i]];
+				std::ostringstream name;
+				name << "param" << i;
+
+				uploads.push_back(std::pair<BufferIdx, std::vector<float>>(buffer->ForwardBuffer(), std::vector<float>()));
+				if (!ReadCheckpointTensor(reader, name.str(), buffer->size, uploads.back().second))
+					err = NN_MODEL_FILE_ERROR;
+
+				for (size_t j = 0; j < numAuxBuffer && err == 0; ++j)
+				{
+					std::ostringstream auxName;
+					auxName << name.str() << "/aux" << j;
+
+					uploads.push_back(std::pair<BufferIdx, std::vector<float>>(buffer->ForwardBuffer(j), std::vector<float>()));
+					if (!ReadCheckpointTensor(reader, auxName.str(), buffer->size, uploads.back().second))
+						err = NN_MODEL_FILE_ERROR;
+				}
+			}
+
+			const char* lossScaleData = FindCheckpointBlob(reader, "state/lossScale", sizeof(float));
+			const char* goodStepsData = FindCheckpointBlob(reader, "state/goodSteps", sizeof(int));
+			const char* stepData = FindCheckpointBlob(reader, "state/step", sizeof(int));
+			const char* stateData = FindCheckpointBlob(reader, "state/training", sizeof(unsigned long long));
+			if (err != 0 || lossScaleData == nullptr || goodStepsData == nullptr || stepData == nullptr || stateData == nullptr)
+			{
+				std::cerr << "Error model file: " << fileName << " is not a complete checkpoint of this graph" << std::endl;
+				return NN_MODEL_FILE_ERROR;
+			}
+
+			for (size_t i = 0; i < uploads.size(); ++i)
+				backend.WriteDataBuffer(uploads[i].first, uploads[i].second.data(), 0, uploads[i].second.size() * sizeof(float));
+			backend.WriteDataBuffer(lossScaleBuffer, lossScaleData, 0, sizeof(float));
+			backend.WriteDataBuffer(goodStepsBuffer, goodStepsData, 0, sizeof(int));
+			backend.WriteDataBuffer(stepBuffer, stepData, 0, sizeof(int));
+			std::memcpy(&dataPosition, stateData, sizeof(dataPosition));
+
+			//The restored parameters continue from a finished step.
+			ClearBackwardBuffer();
+			numMicroBatches = 0;
+			//Clearing the buffers carries the last state of the current run into the first time step. The restored training starts a new sequence instead.
+			for (size_t i = 0; i < carriedStates.size(); ++i)
+				carriedStates[i]->ResetState(backend, false);
+
+			//The mapping and the unpacked values must stay valid until the uploads finished.
+			FinishTransfers();
+			return 0;
+		}
+
+		SizeVec NeuralNetwork::GetSize(const NNBufferIdx a) const
+		{
+			//Returns the size of a buffer object
+			return nnBufferList[a]->size;
+		}
+
+#ifdef PROFILING_ENABLED
+		unsigned long long NeuralNetwork::GetTimeForward(const NNBufferIdx input, const NNBufferIdx output)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+
+			//Calculates the time needed for all forward kernel to calculate the output using input
+			NNBuffer* bufferIn = nnBufferList[input];
+			NNBuffer* bufferOut = nnBufferList[output];
+
+			if (bufferIn->to != bufferOut->from)
+				return 0;
+
+			NNOp* operation = nnOperationList[bufferIn->to];
+			unsigned long long result = 0;
+
+			const size_t numOutputBuffer = operation->output.size();
+
+			bool correct = false;
+			for (size_t i = 0; i < numOutputBuffer; ++i)
+				if (operation->output[i] == output)
+					correct = true;
+
+			if (!correct)
+				return false;
+
+			//All forward operations needed to perform the forward pass of this operations are executed and the results are added
+
+			size_t operations = operation->forwardOpIdx.size();
+			for (size_t i = 0; i < operations; ++i)
+				result += backend.GetTime(operation->forwardOpIdx[i], BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			return result;
+		}
+
+		unsigned long long NeuralNetwork::GetTimeBackward(const NNBufferIdx input, const NNBufferIdx output)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+
+			//Calculates the time needed for all forward kernel to calculate the output using input
+
+			NNBuffer* bufferIn = nnBufferList[input];
+			NNBuffer* bufferOut = nnBufferList[output];
+
+			if (bufferIn->to != bufferOut->from)
+				return 0;
+
+			NNOp* operation = nnOperationList[bufferIn->to];
+			unsigned long long result = 0;
+
+			const size_t numOutputBuffer = operation->output.size();
+
+			bool correct = false;
+			for (size_t i = 0; i < numOutputBuffer; ++i)
+				if (operation->output[i] == output)
+					correct = true;
+
+			if (!correct)
+				return false;
+
+			//All backend operations needed to perform the backward pass of this operations are executed and the results are added
+
+			size_t operations = operation->backwardOpIdx.size();
+			for (size_t i = 0; i < operations; ++i)
+				result += backend.GetTime(operation->backwardOpIdx[i], BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			return result;
+		}
+
+		unsigned long long NeuralNetwork::GetTimeRecompute()
+		{
+			unsigned long long result = 0;
+			for (size_t i = 0; i < recomputeOps.size(); ++i)
+				result += backend.GetTime(recomputeOps[i], BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			return result;
+		}
+#endif // PROFILING_ENABLED
+
+		DeepCLError NeuralNetwork::InitliazeGraph(const size_t batchSize)
+		{
+			if (!initialized)
+			{
+				std::cout << "Error neural network system not initialized!" << std::endl;
+				return NN_SYSTEM_NOT_INITIALIZED;
+			}
+
+			//Input buffers storing bytes, int16 or half can only be read by OP::Dequantize. Other operations would interpret the data as float.
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+			{
+				if (nnOperationList[i]->ReadsCompactInput())
+					continue;
+				for (size_t j = 0; j < nnOperationList[i]->input.size(); ++j)
+				{
+					if (nnBufferList[nnOperationList[i]->input[j]]->GetInputStorage() != INPUT_FLOAT)
+					{
+						std::cout << "Error InitliazeGraph: An input buffer storing a compact type is read by another operation than OP::Dequantize!" << std::endl;
+						return NN_INVALID_INPUT_STORAGE;
+					}
+				}
+			}
+
+			//With sequence batching the batch elements with shorter sequences don't write the last state of a chunk, the carried state would be stale.
+			if (sequenceBatching && !carriedStates.empty())
+			{
+				std::cout << "Error InitliazeGraph: State buffers carrying their state can't be used with sequence batching!" << std::endl;
+				return NN_CARRY_STATE_NOT_SUPPORTED;
+			}
+
+			//Adjust the w component of each size to be equal to the number of batch elements if necessary. (Trainable parameters are not changed by this but input, state, intermediate, etc. buffers are effected by it)
+			SetBatchSize(batchSize);
+			//Operations are created for the maximal batch size. Smaller batches can be processed using SetActiveBatch.
+			backend.SetMaxBatch(static_cast<unsigned int>(batchSize));
+
+			//The multiplications of sequence inputs with parameters don't depend on earlier time steps, they are instantiated once for all time steps.
+			HoistTimeSteps();
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+				nnOperationList[i]->SetSequenceBatching(sequenceBatching);
+
+			//Calculates the maximal number of needed temporary buffers and the required size. Then the necessary number of tmpBuffers is created.
+			//Operations, which need a temporary buffer will have handels to the required temporary buffers passed to them. The handles are indices into the nnBufferList vector.
+			CreateTmpBuffer();
+
+			//With mixed precision the intermediate buffers used only by operations supporting half store half.
+			if (mixedPrecision)
+				SelectHalfStorage();
+
+			//The recomputed activations share a scratch buffer, their sizes depend on the storage selected above.
+			PlanRecompute();
+
+			//Creates actual OpenCL buffer objects by calling instantiate on each Buffer object
+			InstantiateBuffer();
+			InstantiateLossScale();
+
+			//Create backend Operations by calling instantiate on each operations in the correct order multiple times. 
+			//(The order depends on offsets in the time and the number of times instantiate is called on the number of time steps the operation runs)
+			
+			InstantiateOperations();
+
+			//The first operation writing a gradient overwrites it. Only the remaining gradients are reset after each batch.
+			//With sequence batching the operations of a time step may be skipped, therefore all gradients are reset.
+			if (!sequenceBatching)
+				backend.BuildOverwriteFirst();
+
+			//Compute the dependencies between the operations and distribute them over the queues (Does nothing if only one queue is used).
+			backend.BuildSchedule();
+			
+			//Sets all buffers to zero.
+			ClearAllBuffer();
+
+			if (gradientCompression != COMPRESSION_NONE)
+			{
+				//The residuals are stored in the last auxiliary buffer and start at zero.
+				gradientCompressor = new GradientCompressor(backend, gradientCompression, compressionDensity);
+				for (size_t i = 0; i < parameterBuffer.size(); ++i)
+				{
+					NNBuffer* buffer = nnBufferList[parameterBuffer[i]];
+					const size_t totalSize = buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW;
+					const BufferIdx residual = gradientCompressor->Gathers() ? buffer->ForwardBuffer(numAuxBuffer - 1) : buffer->BackwardBuffer();
+					gradientCompressor->AddParameter(buffer->BackwardBuffer(), residual, totalSize);
+				}
+			}
+
+			//Without mixed precision the scale stays one.
+			float initialScale = mixedPrecision ? lossScale : 1.f;
+			backend.WriteDataBuffer(lossScaleBuffer, &initialScale, 0, sizeof(float));
+			backend.ResetBuffer(overflowBuffer, sizeof(int));
+			backend.ResetBuffer(goodStepsBuffer, sizeof(int));
+			backend.ResetBuffer(stepBuffer, sizeof(int));
+
+			//Initalizes all weights using the initalize operations
+			InitalizeWeights();
+
+			//The Neural Network may no be used for inference/trainig
+			graphInitiliazed = true;
+
+			return 0;
+		}
+
+		void NeuralNetwork::SetNumQueues(const size_t numQueues)
+		{
+			backend.SetNumQueues(numQueues);
+		}
+
+		void NeuralNetwork::SetMixedPrecision(const bool mixedPrecision, const float initialScale, const size_t interval)
+		{
+			if (graphInitiliazed)
+			{
+				std::cout << "Error SetMixedPrecision: must be called before InitliazeGraph" << std::endl;
+				return;
+			}
+
+			this->mixedPrecision = mixedPrecision;
+			lossScale = initialScale;
+			lossScaleInterval = interval;
+		}
+
+		void NeuralNetwork::SetGradientCompression(const GradientCompression compression, const float density)
+		{
+			if (graphInitiliazed)
+			{
+				std::cout << "Error SetGradientCompression: must be called before InitliazeGraph" << std::endl;
+				return;
+			}
+
+			gradientCompression = compression;
+			compressionDensity = density;
+		}
+
+		void NeuralNetwork::SetBatchSize(const size_t batchSize)
+		{
+			size_t size = nnBufferList.size();
+			size_t i, tmpSize;
+
+			//Loop over all buffers and call SetBatchSize on them which sets the w component of the size to be equal to the batch size if it is necessary for the buffer.
+			//The parameter buffers won't do anything
+			for (i = 0; i < size; ++i)
+			{
+				NNBuffer* buffer = nnBufferList[i];
+				SizeVec sizeVec = buffer->size;
+				
+
+				buffer->SetBatchSize(batchSize);
+
+				tmpSize = sizeVec.sizeX * sizeVec.sizeY * sizeVec.sizeZ * sizeVec.sizeW;
+				if (tmpSize > maxSize)
+					maxSize = tmpSize;
+			}
+
+			tmpDataMemory = new float[maxSize];
+		}
+
+
+		void NeuralNetwork::InstantiateBuffer()
+		{
+			//Retrieve information of the needed number of auxilary buffers for the optimizer.
+			//Adam for example needs to auxilary buffers for the momentum and adaptive learning rate.
+			if (optimizer != nullptr)
+				numAuxBuffer = optimizer->GetNumBuffer();
+			//The residual of the gradient compression is stored behind the buffers of the optimizer.
+			if (gradientCompression == COMPRESSION_TOPK || gradientCompression == COMPRESSION_SIGN)
+				++numAuxBuffer;
+
+			//The number of auxilary buffers is static because for each parameter the number of auxilary buffer is equal since the number depends only on the optimizer
+			NNParamBuffer::SetNumAuxBuffer(numAuxBuffer);
+
+			size_t size = nnBufferList.size();
+			size_t i;
+
+			//Let each buffer in nnBufferList create the required number of OpenCL buffer and subbuffer objects.
+			for (i = 0; i < size; ++i)
+			{
+				nnBufferList[i]->Instantiate(backend);
+			}
+		}
+
+
+		void NeuralNetwork::SelectHalfStorage()
+		{
+			size_t size = nnBufferList.size();
+			std::vector<bool> supported(size, true);
+
+			//Buffers used by an operation that can only read and write float keep storing float.
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+			{
+				NNOp* op = nnOperationList[i];
+				if (op->SupportsHalfStorage())
+					continue;
+
+				for (size_t j = 0; j < op->input.size(); ++j)
+					supported[op->input[j]] = false;
+				for (size_t j = 0; j < op->output.size(); ++j)
+					supported[op->output[j]] = false;
+			}
+
+			//Only intermediate buffers support half. Input, parameter, state and temporary buffers stay in float.
+			for (size_t i = 0; i < size; ++i)
+				nnBufferList[i]->SetHalfStorage(supported[i]);
+		}
+
+		void NeuralNetwork::InstantiateLossScale()
+		{
+			//The buffers exist even without mixed precision since the update operations always read them.
+			lossScaleBuffer = backend.CreateBuffer(sizeof(float), BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			overflowBuffer = backend.CreateBuffer(sizeof(int), BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			goodStepsBuffer = backend.CreateBuffer(sizeof(int), BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			stepBuffer = backend.CreateBuffer(sizeof(int), BackendSystem::MEM_FLAG::READ_WRITE, 1);
+
+			//The loss operations only scale their gradient with mixed precision.
+			NNOp::SetLossScaleBuffer(mixedPrecision ? lossScaleBuffer : MAX_UNSIGNED_INT);
+
+			if (optimizer != nullptr)
+			{
+				optimizer->SetLossScale(lossScaleBuffer, overflowBuffer);
+				optimizer->SetStepBuffer(stepBuffer);
+			}
+		}
+
+		void NeuralNetwork::PlanRecompute()
+		{
+			if (!automaticCheckpointing && recomputeRequests.empty())
+				return;
+
+			const size_t numOps = nnOperationList.size();
+
+			//Index of each operation instance in the order they are instantiated. The segments consist of consecutive instances.
+			std::vector<std::vector<size_t>> unitIdx(maxSteps, std::vector<size_t>(numOps, MAX_UNSIGNED_INT));
+			size_t numUnits = 0;
+			for (size_t j = 0; j < maxSteps; ++j)
+				for (size_t i = 0; i < numOps; ++i)
+					if (RunsAtStep(nnOperationList[i], j))
+						unitIdx[j][i] = numUnits++;
+			if (numUnits == 0)
+				return;
+
+			const size_t segmentLength = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(numUnits))));
+			const size_t numSegments = (numUnits + segmentLength - 1) / segmentLength;
+			unitSegment.resize(numUnits);
+			for (size_t u = 0; u < numUnits; ++u)
+				unitSegment[u] = u / segmentLength;
+			unitRecompute.assign(numUnits, false);
+
+			std::vector<std::vector<NNOperationIdx>> consumers(nnBufferList.size());
+			for (size_t i = 0; i < numOps; ++i)
+				for (size_t k = 0; k < nnOperationList[i]->input.size(); ++k)
+					consumers[nnOperationList[i]->input[k]].push_back(static_cast<NNOperationIdx>(i));
+
+			const size_t allign = backend.GetBaseAddrAllignment();
+			std::vector<size_t> segmentSize(numSegments, 0);
+			std::vector<std::pair<NNBufferIdx, std::vector<size_t>>> recomputed;
+			recomputedMemory = 0;
+
+			for (size_t b = 0; b < nnBufferList.size(); ++b)
+			{
+				NNBuffer* buffer = nnBufferList[b];
+				if (!automaticCheckpointing && std::find(recomputeRequests.begin(), recomputeRequests.end(), b) == recomputeRequests.end())
+					continue;
+				//Outputs of the graph are kept since they are read after the forward pass
+				if (!buffer->SupportsRecompute() || buffer->from == MAX_UNSIGNED_INT || buffer->timeOffset != 0 || buffer->sequenceSize != maxSteps || consumers[b].empty())
+					continue;
+
+				//The operation writing the buffer and all operations reading it must support recomputation and run at each time step inside the same segment.
+				std::vector<NNOperationIdx> users = consumers[b];
+				users.push_back(buffer->from);
+				bool supported = true;
+				for (size_t k = 0; k < users.size() && supported; ++k)
+					supported = nnOperationList[users[k]]->SupportsRecompute() && nnOperationList[users[k]]->timeOffset == 0;
+				for (size_t j = 0; j < maxSteps && supported; ++j)
+				{
+					const size_t producer = unitIdx[j][buffer->from];
+					for (size_t k = 0; k < users.size() && supported; ++k)
+						supported = producer != MAX_UNSIGNED_INT && unitIdx[j][users[k]] != MAX_UNSIGNED_INT && unitSegment[unitIdx[j][users[k]]] == unitSegment[producer];
+				}
+				if (!supported)
+					continue;
+
+				//Each time step is placed behind the activations recomputed before in the part of the scratch buffer used by its segment.
+				const size_t stepSize = allign * ((buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW * buffer->ForwardElementSize() + allign - 1) / allign);
+				std::vector<size_t> offsets(maxSteps);
+				for (size_t j = 0; j < maxSteps; ++j)
+				{
+					const size_t producer = unitIdx[j][buffer->from];
+					offsets[j] = segmentSize[unitSegment[producer]];
+					segmentSize[unitSegment[producer]] += stepSize;
+					unitRecompute[producer] = true;
+				}
+				recomputedMemory += stepSize * maxSteps;
+				recomputed.push_back(std::pair<NNBufferIdx, std::vector<size_t>>(static_cast<NNBufferIdx>(b), offsets));
+			}
+
+			if (recomputed.empty())
+			{
+				unitSegment.clear();
+				unitRecompute.clear();
+				return;
+			}
+
+			scratchMemory = *std::max_element(segmentSize.begin(), segmentSize.end());
+			BufferIdx scratch = backend.CreateBuffer(scratchMemory, BackendSystem::MEM_FLAG::READ_WRITE, 1);
+			for (size_t i = 0; i < recomputed.size(); ++i)
+				nnBufferList[recomputed[i].first]->SetRecompute(scratch, recomputed[i].second);
+		}
+
+		void NeuralNetwork::HoistTimeSteps()
+		{
+			size_t size = nnOperationList.size();
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				NNOp* op = nnOperationList[i];
+				if (op->input.size() < 2)
+					continue;
+
+				//All time steps of an input buffer are written before the forward pass
+				NNBuffer* buffer = nnBufferList[op->input[0]];
+				if (!buffer->IsInput() || buffer->sequenceSize < 2)
+					continue;
+				if (std::find(parameterBuffer.begin(), parameterBuffer.end(), op->input[1]) == parameterBuffer.end())
+					continue;
+
+				op->HoistTimeSteps();
+			}
+		}
+
+		void NeuralNetwork::CreateTmpBuffer()
+		{
+			size_t size = nnOperationList.size();
+			size_t tmpSize;
+			size_t currentTmpBufferSize = 0;
+			size_t i, j;
+
+			NNOperation* op;
+
+			std::vector<size_t> tmpBufferSize;
+
+			//Calculate the necessary number of buffers for each operation
+			for (i = 0; i < size; ++i)
+			{
+				op = nnOperationList[i];
+				op->SetTmpBuffer(nnBufferList, i);
+
+				tmpSize = op->tmpSizes.size();
+
+				//Check if the required number of tmpBuffers is bigger as the current number of tmpBuffers
+				if (currentTmpBufferSize < tmpSize)
+				{
+					//Add the necessary number of tmpBuffers
+					size_t numToAdd = tmpSize - currentTmpBufferSize;
+					for (j = 0; j < numToAdd ; ++j)
+					{
+						SizeVec opSize = op->tmpSizes[currentTmpBufferSize++];
+						tmpBufferSize.push_back(opSize.sizeX * opSize.sizeY * opSize.sizeZ * opSize.sizeW);
+					}
+				}
+
+				//Calculate if the currently available tmp buffers are big enough if not increase the size
+				for (j = 0; j < tmpSize; ++j)
+				{
+					size_t totalSize = tmpBufferSize[j];
+					size_t totalTmpSize = op->tmpSizes[j].sizeX * op->tmpSizes[j].sizeY * op->tmpSizes[j].sizeZ * op->tmpSizes[j].sizeW;
+					tmpBufferSize[j] = totalSize < totalTmpSize ? totalTmpSize : totalSize;
+				}
+			}
+
+			size = tmpBufferSize.size();
+
+			//Add the tmpBuffers to the nnBufferList
+			for (i = 0; i < size; ++i)
+			{
+				nnBufferList.push_back(new NNTmpBuffer(tmpBufferSize[i], 1, 1, 1));
+			}
+			size_t tmpBufferIdx = nnBufferList.size() - size;
+
+			size = nnOperationList.size();
+
+			//Pass the indices of the tmpBuffers to each operation
+			for (i = 0; i < size; ++i)
+			{
+				op = nnOperationList[i];
+
+				tmpSize = op->tmpSizes.size();
+				for (j = 0; j < tmpSize; ++j)
+				{
+					op->tmpBuffer.push_back(tmpBufferIdx + j);
+				}
+			}
+		}
+
+		void NeuralNetwork::InstantiateOperations()
+		{
+			size_t size = nnOperationList.size();
+			size_t i, j;
+
+			//Forward operations of each operation instance
+			std::vector<std::pair<OperationIdx, OperationIdx>> unitForward;
+
+			//The maximal number of steps is determined by the buffer with the longest length.
+			//Iterate over the maximal number of time steps to instantiate each operation the number of times necessary.
+			for (j = 0; j < maxSteps; ++j)
+			{
+				//The operations of a time step process the batch elements whose sequence didn't end before it.
+				backend.SetCurrentStep(j);
+
+				//Iterate over all operations in the graph
+				for (i = 0; i < size; ++i)
+				{
+					if (!RunsAtStep(nnOperationList[i], j))
+						continue;
+
+					//The backward pass of a segment runs after the backward pass of the following instances. The activations of the segment are recomputed before it.
+					const size_t unit = unitForward.size();
+					if (unit > 0 && unit < unitSegment.size() && unitSegment[unit] != unitSegment[unit - 1])
+					{
+						for (size_t u = unit - 1; u < unit && unitSegment[u] == unitSegment[unit - 1]; --u)
+						{
+							if (!unitRecompute[u])
+								continue;
+							OperationIdx firstCopy = backend.AddRecomputeOperations(unitForward[u].first, unitForward[u].second);
+							for (OperationIdx k = unitForward[u].first; k < unitForward[u].second; ++k)
+								recomputeOps.push_back(firstCopy++);
+						}
+					}
+
+					OperationIdx first = static_cast<OperationIdx>(backend.GetNumOperations(BackendSystem::OpenCLBackend::OperationType::FORWARD));
+					nnOperationList[i]->Instantiate(backend, nnBufferList);
+					unitForward.push_back(std::pair<OperationIdx, OperationIdx>(first, static_cast<OperationIdx>(backend.GetNumOperations(BackendSystem::OpenCLBackend::OperationType::FORWARD))));
+				}
+				//Each buffer contains a time step variable, which allows the hardware sub buffer of the current time step to be automatically returned.
+				UpdateBufferTime();
+			}
+			backend.SetCurrentStep(MAX_UNSIGNED_INT);
+
+			//Set all Buffer times to zero.
+			ResetBufferTime();
+
+			//The optimizer must be instantiate as well.
+			if (optimizer != nullptr)
+			{
+				size = parameterBuffer.size();
+
+				//The update operations read the scale of the gradients each time they are executed
+				optimizer->SetGradientScale(&gradScale);
+
+				//All gradients must be checked for overflows before the first update reads the flag.
+				if (mixedPrecision)
+				{
+					for (i = 0; i < size; ++i)
+						optimizer->InstantiateOverflowCheck(backend, nnBufferList, parameterBuffer[i]);
+				}
+
+				for (i = 0; i < size; ++i)
+				{
+					//The optimizer will add auxilary buffers to the parameter buffers.
+					optimizer->Instantiate(backend, nnBufferList, parameterBuffer[i]);
+				}
+
+				//The step is counted and the loss scale is adapted after all updates read them.
+				optimizer->InstantiateStepCount(backend);
+				if (mixedPrecision)
+					optimizer->InstantiateLossScaleUpdate(backend, goodStepsBuffer, static_cast<int>(lossScaleInterval), MAX_LOSS_SCALE);
+			}
+		}
+
+		bool NeuralNetwork::RunsAtStep(const NNOp* operation, const size_t step) const
+		{
+			//The number of time steps an operation runs is determined by the number of time steps of the output.
+			//In most cases(all) operations only have one output
+			//In principle all time steps in the output must be equal.
+			//At the moment there are no exceptions.
+
+			//Determine the number of time steps the operation must be executed.
+			size_t outputTime = 0;
+			for (size_t k = 0; k < operation->output.size(); ++k)
+			{
+				if (nnBufferList[operation->output[k]]->sequenceSize > outputTime)
+					outputTime = nnBufferList[operation->output[k]]->sequenceSize;
+			}
+
+			//Each operation has an associated offset allowing, for example a loss, to be computed at an specific time step. The operation is only executed when the offset is smaller  or equal than the current time step.
+			return step < outputTime && operation->timeOffset <= step;
+		}
+
+		DeepCLError NeuralNetwork::Calibrate()
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (quantized)
+			{
+				std::cout << "Error Calibrate: The graph uses the int8 operations!" << std::endl;
+				return NN_GRAPH_QUANTIZED;
+			}
+
+			size_t numChannels, channelStride;
+			std::vector<NNBufferIdx> calibrated;
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+			{
+				NNOp* operation = nnOperationList[i];
+				if (!operation->GetQuantizedChannels(nnBufferList, numChannels, channelStride))
+					continue;
+				if (nnBufferList[operation->input[0]]->IsRecomputed())
+				{
+					std::cout << "Error Calibrate: The input of an operation is recomputed!" << std::endl;
+					return NN_RECOMPUTE_NOT_SUPPORTED;
+				}
+
+				//Inputs shared by multiple operations are read once
+				NNBufferIdx input = operation->input[0];
+				if (std::find(calibrated.begin(), calibrated.end(), input) != calibrated.end())
+					continue;
+				calibrated.push_back(input);
+
+				//Only the active batch elements contain values of the last forward pass
+				NNBuffer* buffer = nnBufferList[input];
+				const SizeVec& size = buffer->size;
+				const size_t batch = std::min(static_cast<size_t>(backend.GetActiveBatch()), size.sizeW);
+				const size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * batch;
+
+				float& range = activationRange[input];
+				for (size_t t = 0; t < buffer->sequenceSize; ++t)
+				{
+					ReadDataBuffer(input, tmpDataMemory, size.sizeX, size.sizeY, size.sizeZ, batch, 0, t);
+					FinishTransfers();
+					for (size_t e = 0; e < totalSize; ++e)
+						range = std::max(range, std::fabs(tmpDataMemory[e]));
+				}
+			}
+
+			return 0;
+		}
+
+		void NeuralNetwork::QuantizeParameter(const NNBufferIdx buffer, const size_t numChannels, const size_t channelStride)
+		{
+			const SizeVec& size = nnBufferList[buffer]->size;
+			const size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW;
+
+			std::vector<float> values(totalSize);
+			ReadDataBuffer(buffer, values.data(), 0);
+			FinishTransfers();
+
+			QuantizedBuffer& quantBuffer = quantizedParameter[buffer];
+			quantBuffer.numChannels = numChannels;
+			quantBuffer.channelStride = channelStride;
+
+			//Symmetric quantization: The largest absolute value of each channel is mapped to 127.
+			quantBuffer.scales.assign(numChannels, 0.f);
+			for (size_t e = 0; e < totalSize; ++e)
+			{
+				float& scale = quantBuffer.scales[(e / channelStride) % numChannels];
+				scale = std::max(scale, std::fabs(values[e]));
+			}
+			for (size_t c = 0; c < numChannels; ++c)
+				quantBuffer.scales[c] = quantBuffer.scales[c] > 0.f ? quantBuffer.scales[c] / 127.f : 1.f;
+
+			quantBuffer.values.resize(totalSize);
+			for (size_t e = 0; e < totalSize; ++e)
+			{
+				float value = std::round(values[e] / quantBuffer.scales[(e / channelStride) % numChannels]);
+				quantBuffer.values[e] = static_cast<char>(std::max(-127.f, std::min(127.f, value)));
+			}
+		}
+
+		DeepCLError NeuralNetwork::Quantize()
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			const size_t size = nnOperationList.size();
+			size_t numChannels, channelStride;
+
+			//The int8 operations were already created. The parameters may have been trained since, they are quantized again and uploaded into the buffers of the int8 operations.
+			if (!exchangedOps.empty())
+			{
+				std::vector<NNBufferIdx> requantized;
+				for (size_t i = 0; i < size; ++i)
+				{
+					NNOp* operation = nnOperationList[i];
+					if (!operation->HasQuantizedWeights() || !operation->GetQuantizedChannels(nnBufferList, numChannels, channelStride))
+						continue;
+
+					//Parameters shared by multiple operations are quantized once
+					if (std::find(requantized.begin(), requantized.end(), operation->input[1]) == requantized.end())
+					{
+						QuantizeParameter(operation->input[1], numChannels, channelStride);
+						requantized.push_back(operation->input[1]);
+					}
+					const float range = activationRange[operation->input[0]];
+					operation->UploadQuantized(backend, quantizedParameter[operation->input[1]], range > 0.f ? range / 127.f : 1.f);
+				}
+
+				//The host data must stay valid until the uploads finished.
+				FinishTransfers();
+				SetQuantized(true);
+				return 0;
+			}
+
+			//Only operations whose weights are parameters can be quantized once. The parameters are quantized before any operation is created.
+			std::vector<bool> quantizable(size, false);
+			for (size_t i = 0; i < size; ++i)
+			{
+				NNOp* operation = nnOperationList[i];
+				if (!operation->GetQuantizedChannels(nnBufferList, numChannels, channelStride))
+					continue;
+				if (std::find(parameterBuffer.begin(), parameterBuffer.end(), operation->input[1]) == parameterBuffer.end())
+					continue;
+				if (activationRange.find(operation->input[0]) == activationRange.end())
+				{
+					std::cout << "Error Quantize: The graph was not calibrated!" << std::endl;
+					return NN_NOT_CALIBRATED;
+				}
+
+				quantizable[i] = true;
+				if (quantizedParameter.find(operation->input[1]) == quantizedParameter.end())
+					QuantizeParameter(operation->input[1], numChannels, channelStride);
+			}
+
+			//The int8 operations are created in the same order as the float operations. Each instance replaces the forward operation of its time step.
+			std::vector<size_t> instance(size, 0);
+			for (size_t j = 0; j < maxSteps; ++j)
+			{
+				backend.SetCurrentStep(j);
+				for (size_t i = 0; i < size; ++i)
+				{
+					NNOp* operation = nnOperationList[i];
+					if (!RunsAtStep(operation, j))
+						continue;
+
+					if (quantizable[i])
+					{
+						const float range = activationRange[operation->input[0]];
+						operation->InstantiateQuantized(backend, nnBufferList, quantizedParameter[operation->input[1]], range > 0.f ? range / 127.f : 1.f);
+
+						BackendSystem::BaseOperation* quantOp = backend.PopOperation(BackendSystem::OpenCLBackend::OperationType::FORWARD);
+						OperationIdx opIdx = operation->forwardOpIdx[instance[i]];
+						exchangedOps.push_back(std::pair<OperationIdx, BackendSystem::BaseOperation*>(opIdx, backend.ExchangeOperation(opIdx, BackendSystem::OpenCLBackend::OperationType::FORWARD, quantOp)));
+					}
+					++instance[i];
+				}
+				UpdateBufferTime();
+			}
+			backend.SetCurrentStep(MAX_UNSIGNED_INT);
+			ResetBufferTime();
+
+			backend.BuildSchedule();
+			quantized = true;
+
+			return 0;
+		}
+
+		void NeuralNetwork::SetQuantized(const bool useQuantized)
+		{
+			if (exchangedOps.empty() || useQuantized == quantized)
+				return;
+
+			for (size_t i = 0; i < exchangedOps.size(); ++i)
+				exchangedOps[i].second = backend.ExchangeOperation(exchangedOps[i].first, BackendSystem::OpenCLBackend::OperationType::FORWARD, exchangedOps[i].second);
+
+			backend.BuildSchedule();
+			quantized = useQuantized;
+
+			//The exchange discarded the recorded step
+			if (!quantized && stepRecorded)
+				RecordTrainingStep();
+		}
+
+		DeepCLError NeuralNetwork::CompareQuantized(const NNBufferIdx output, float& maxError, float& meanError)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (exchangedOps.empty())
+			{
+				std::cout << "Error CompareQuantized: The graph was not quantized!" << std::endl;
+				return NN_GRAPH_NOT_QUANTIZED;
+			}
+
+			NNBuffer* buffer = nnBufferList[output];
+			const SizeVec& size = buffer->size;
+			const size_t batch = std::min(static_cast<size_t>(backend.GetActiveBatch()), size.sizeW);
+			const size_t stepSize = size.sizeX * size.sizeY * size.sizeZ * batch;
+			const size_t totalSize = stepSize * buffer->sequenceSize;
+
+			std::vector<float> reference(totalSize);
+			std::vector<float> result(totalSize);
+
+			//Both passes use the data currently stored in the input buffers
+			const bool useQuantized = quantized;
+			for (size_t pass = 0; pass < 2; ++pass)
+			{
+				SetQuantized(pass == 1);
+				ResetBarrierCounters();
+				backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
+
+				float* data = pass == 0 ? reference.data() : result.data();
+				for (size_t t = 0; t < buffer->sequenceSize; ++t)
+					ReadDataBuffer(output, data + t * stepSize, size.sizeX, size.sizeY, size.sizeZ, batch, 0, t);
+				FinishTransfers();
+			}
+			SetQuantized(useQuantized);
+
+			maxError = 0.f;
+			meanError = 0.f;
+			for (size_t e = 0; e < totalSize; ++e)
+			{
+				const float error = std::fabs(result[e] - reference[e]);
+				maxError = std::max(maxError, error);
+				meanError += error;
+			}
+			meanError = totalSize > 0 ? meanError / static_cast<float>(totalSize) : 0.f;
+
+			std::cout << "int8 output compared to float: max error " << maxError << " mean error " << meanError << std::endl;
+			return 0;
+		}
+
+		void NeuralNetwork::AddWeightInitializer(InitOp* initOp)
+		{
+			//The initOps stored in initOpList will be used in IntializeWeights
+			initOpList.push_back(initOp);
+		}
+
+		void NeuralNetwork::InitalizeWeights()
+		{
+
+			//Calls instantiate on each initOperation therby allowing each init operation to initalize its buffers.
+			size_t size = initOpList.size();
+
+			for (size_t i = 0; i < size; ++i)
+				initOpList[i]->Instantiate(nnBufferList, backend);
+		}
+
+		DeepCLError NeuralNetwork::Backward(const bool accumulate)
+		{
+			//Calculate the backward pass of the Neural Network.
+			//Results only in non-zero results if forward pass was performed beforehand
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (quantized)
+			{
+				std::cout << "Error the graph uses the int8 operations!" << std::endl;
+				return NN_GRAPH_QUANTIZED;
+			}
+
+			//The first batch since the last step overwrites the parameter gradients, the following batches add to them.
+			//A backward pass without accumulation discards the gradients of the previous batches.
+			if (!accumulate && numMicroBatches > 0)
+				ClearBackwardBuffer(true, false);
+			SetParameterAccumulate(accumulate && numMicroBatches > 0);
+
+			ResetBarrierCounters();
+			backend.Run(BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			
+			numMicroBatches = accumulate ? numMicroBatches + 1 : 1;
+
+			//The gradients of the activations belong only to this batch.
+			ClearBackwardBuffer(false, true);
+			
+			return 0;
+		}
+
+		void NeuralNetwork::ComputeGradientPositions()
+		{
+			//The backward pass is executed starting at the last operation. The gradient is complete after the last operation using it was executed.
+			const size_t numOps = backend.GetNumOperations(BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			std::map<BufferIdx, size_t> lastUse;
+			std::vector<BufferIdx> buffers;
+			for (size_t i = 0; i < numOps; ++i)
+			{
+				backend.GetOperationBuffers(static_cast<OperationIdx>(numOps - 1 - i), BackendSystem::OpenCLBackend::OperationType::BACKWARD, buffers);
+				for (size_t j = 0; j < buffers.size(); ++j)
+					lastUse[buffers[j]] = i;
+			}
+
+			gradientPositions.clear();
+			for (size_t p = 0; p < parameterBuffer.size(); ++p)
+			{
+				std::map<BufferIdx, size_t>::iterator it = lastUse.find(nnBufferList[parameterBuffer[p]]->BackwardBuffer());
+				gradientPositions.push_back(std::pair<size_t, size_t>(it != lastUse.end() ? it->second : 0, p));
+			}
+			std::sort(gradientPositions.begin(), gradientPositions.end());
+			gradientPositionOps = numOps;
+		}
+
+		DeepCLError NeuralNetwork::BackwardAsync(std::vector<std::pair<size_t, cl::Event>>& gradientEvents)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (quantized)
+			{
+				std::cout << "Error the graph uses the int8 operations!" << std::endl;
+				return NN_GRAPH_QUANTIZED;
+			}
+
+			if (gradientPositionOps != backend.GetNumOperations(BackendSystem::OpenCLBackend::OperationType::BACKWARD))
+				ComputeGradientPositions();
+
+			//Same as Backward() without accumulation
+			if (numMicroBatches > 0)
+				ClearBackwardBuffer(true, false);
+			SetParameterAccumulate(false);
+
+			std::vector<size_t> positions;
+			for (size_t i = 0; i < gradientPositions.size(); ++i)
+				positions.push_back(gradientPositions[i].first);
+			std::vector<cl::Event> markers;
+			ResetBarrierCounters();
+			backend.RunWithMarkers(BackendSystem::OpenCLBackend::OperationType::BACKWARD, positions, markers);
+
+			gradientEvents.clear();
+			for (size_t i = 0; i < gradientPositions.size(); ++i)
+				gradientEvents.push_back(std::pair<size_t, cl::Event>(gradientPositions[i].second, markers[i]));
+
+			//The gradients of the activations belong only to this batch.
+			ClearBackwardBuffer(false, true);
+
+			numMicroBatches = 1;
+			return 0;
+		}
+
+		void NeuralNetwork::ReadGradientAsync(const size_t parameter, float* data, const cl::Event* waitEvent, cl::Event* readEvent)
+		{
+			NNBuffer* buffer = nnBufferList[parameterBuffer[parameter]];
+			const size_t totalSize = buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW;
+			backend.ReadDataBufferAsync(buffer->BackwardBuffer(), data, 0, totalSize * sizeof(float), waitEvent, readEvent);
+		}
+
+		void NeuralNetwork::WriteGradientAsync(const size_t parameter, const float* data, cl::Event* writeEvent)
+		{
+			NNBuffer* buffer = nnBufferList[parameterBuffer[parameter]];
+			const size_t totalSize = buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW;
+			backend.WriteDataBufferAsync(buffer->BackwardBuffer(), data, 0, totalSize * sizeof(float), nullptr, writeEvent);
+		}
+
+		DeepCLError NeuralNetwork::Step(const std::vector<cl::Event>& waitEvents)
+		{
+			for (size_t i = 0; i < waitEvents.size(); ++i)
+				backend.WaitForEvent(waitEvents[i]);
+			return Step();
+		}
+
+		DeepCLError NeuralNetwork::CopyParameters(NeuralNetwork& source)
+		{
+			if (!graphInitiliazed || !source.graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (parameterBuffer.size() != source.parameterBuffer.size() || numAuxBuffer != source.numAuxBuffer)
+			{
+				std::cout << "Error CopyParameters: The graphs are different" << std::endl;
+				return NN_GRAPH_MISMATCH;
+			}
+
+			std::vector<float> values;
+			for (size_t i = 0; i < parameterBuffer.size(); ++i)
+			{
+				NNBuffer* buffer = nnBufferList[parameterBuffer[i]];
+				NNBuffer* sourceBuffer = source.nnBufferList[source.parameterBuffer[i]];
+				const size_t totalSize = buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW;
+				if (totalSize != sourceBuffer->size.sizeX * sourceBuffer->size.sizeY * sourceBuffer->size.sizeZ * sourceBuffer->size.sizeW)
+				{
+					std::cout << "Error CopyParameters: The graphs are different" << std::endl;
+					return NN_GRAPH_MISMATCH;
+				}
+
+				values.resize(totalSize);
+				for (size_t j = 0; j <= numAuxBuffer; ++j)
+				{
+					source.backend.ReadDataBuffer(j == 0 ? sourceBuffer->ForwardBuffer() : sourceBuffer->ForwardBuffer(j - 1), values.data(), 0, totalSize * sizeof(float));
+					source.FinishTransfers();
+					backend.WriteDataBuffer(j == 0 ? buffer->ForwardBuffer() : buffer->ForwardBuffer(j - 1), values.data(), 0, totalSize * sizeof(float));
+					FinishTransfers();
+				}
+			}
+			return 0;
+		}
+
+		DeepCLError NeuralNetwork::ReadParameters(std::vector<float>& values)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+			values.clear();
+			for (size_t i = 0; i < parameterBuffer.size(); ++i)
+			{
+				NNBuffer* buffer = nnBufferList[parameterBuffer[i]];
+				const size_t totalSize = buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW;
+				for (size_t j = 0; j <= numAuxBuffer; ++j)
+				{
+					values.resize(values.size() + totalSize);
+					backend.ReadDataBuffer(j == 0 ? buffer->ForwardBuffer() : buffer->ForwardBuffer(j - 1), values.data() + values.size() - totalSize, 0, totalSize * sizeof(float));
+					FinishTransfers();
+				}
+			}
+			return 0;
+		}
+
+		DeepCLError NeuralNetwork::WriteParameters(const std::vector<float>& values)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+			size_t offset = 0;
+			for (size_t i = 0; i < parameterBuffer.size(); ++i)
+			{
+				NNBuffer* buffer = nnBufferList[parameterBuffer[i]];
+				offset += buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW * (numAuxBuffer + 1);
+			}
+			if (offset != values.size())
+			{
+				std::cout << "Error WriteParameters: The number of values does not match the graph" << std::endl;
+				return NN_GRAPH_MISMATCH;
+			}
+
+			offset = 0;
+			for (size_t i = 0; i < parameterBuffer.size(); ++i)
+			{
+				NNBuffer* buffer = nnBufferList[parameterBuffer[i]];
+				const size_t totalSize = buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW;
+				for (size_t j = 0; j <= numAuxBuffer; ++j)
+				{
+					backend.WriteDataBuffer(j == 0 ? buffer->ForwardBuffer() : buffer->ForwardBuffer(j - 1), values.data() + offset, 0, totalSize * sizeof(float));
+					offset += totalSize;
+				}
+			}
+			FinishTransfers();
+			return 0;
+		}
+
+		DeepCLError NeuralNetwork::Step()
+		{
+			//Calcualte update operations (Performing optimizer update etc.)
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (quantized)
+			{
+				std::cout << "Error the graph uses the int8 operations!" << std::endl;
+				return NN_GRAPH_QUANTIZED;
+			}
+
+			//Each batch computes the mean gradient of its elements. The sum over the accumulated batches is scaled to their mean.
+			gradScale = numMicroBatches > 1 ? 1.f / static_cast<float>(numMicroBatches) : 1.f;
+
+			backend.Run(BackendSystem::OpenCLBackend::OperationType::UPDATE);
+
+			//Set the parameter gradients to zero. The gradients of the activations were already cleared after the backward pass.
+			ClearBackwardBuffer(true, false);
+
+			numMicroBatches = 0;
+			
+			return 0;
+		}
+
+		DeepCLError NeuralNetwork::BatchDone()
+		{
+			return Step();
+		}
+
+		DeepCLError NeuralNetwork::Forward()
+		{
+			//Calculate the forward pass of the NN
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+			//Use the data uploaded by Prefetch. The forward pass waits for the uploads to finish.
+			for (auto it = slotInputBuffer.begin(); it != slotInputBuffer.end(); ++it)
+				it->second->SwapSlot(backend);
+			if (prefetchedBatch > 0)
+			{
+				backend.SetActiveBatch(static_cast<unsigned int>(prefetchedBatch));
+				prefetchedBatch = 0;
+			}
+
+			ResetBarrierCounters();
+			backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			return 0;
+		}
+
+		void NeuralNetwork::ResetCorrect()
+		{
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+				if (nnOperationList[i]->GetCounter() != MAX_UNSIGNED_INT)
+					backend.ResetBuffer(nnOperationList[i]->GetCounter(), sizeof(int));
+		}
+
+		void NeuralNetwork::SetAugmentation(const bool enabled)
+		{
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+				nnOperationList[i]->SetAugmentation(backend, enabled);
+		}
+
+		DeepCLError NeuralNetwork::ReadCorrect(const NNBufferIdx correct, size_t& numCorrect)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+			{
+				NNOp* operation = nnOperationList[i];
+				if (operation->GetCounter() == MAX_UNSIGNED_INT || operation->output[0] != correct)
+					continue;
+
+				int count = 0;
+				backend.ReadDataBuffer(operation->GetCounter(), &count, 0, sizeof(int));
+				FinishTransfers();
+				numCorrect = static_cast<size_t>(count);
+				return 0;
+			}
+
+			std::cout << "Error ReadCorrect: Buffer is no result of CountCorrect" << std::endl;
+			return NN_DOES_NOT_EXIST;
+		}
+
+		void NeuralNetwork::SetActiveBatch(const size_t batchSize)
+		{
+			backend.SetActiveBatch(static_cast<unsigned int>(batchSize));
+		}
+
+		DeepCLError NeuralNetwork::RecomputeBuffer(const NNBufferIdx buffer)
+		{
+			if (graphInitiliazed)
+			{
+				std::cout << "Error RecomputeBuffer: must be called before InitliazeGraph" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (buffer >= nnBufferList.size() || !nnBufferList[buffer]->SupportsRecompute() || nnBufferList[buffer]->from == MAX_UNSIGNED_INT)
+			{
+				std::cout << "Error RecomputeBuffer: only the output of an operation can be recomputed!" << std::endl;
+				return NN_RECOMPUTE_NOT_SUPPORTED;
+			}
+
+			recomputeRequests.push_back(buffer);
+			return 0;
+		}
+
+		void NeuralNetwork::SetAutomaticCheckpointing(const bool automatic)
+		{
+			if (graphInitiliazed)
+			{
+				std::cout << "Error SetAutomaticCheckpointing: must be called before InitliazeGraph" << std::endl;
+				return;
+			}
+
+			automaticCheckpointing = automatic;
+		}
+
+		void NeuralNetwork::GetCheckpointingInfo(size_t& recomputedMemory, size_t& scratchMemory, size_t& recomputedOps) const
+		{
+			recomputedMemory = this->recomputedMemory;
+			scratchMemory = this->scratchMemory;
+			recomputedOps = recomputeOps.size();
+		}
+
+		void NeuralNetwork::ResetStates(const bool carry)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return;
+			}
+
+			for (size_t i = 0; i < carriedStates.size(); ++i)
+				carriedStates[i]->ResetState(backend, carry);
+		}
+
+		void NeuralNetwork::SetSequenceBatching(const bool sequenceBatching)
+		{
+			if (graphInitiliazed)
+			{
+				std::cout << "Error SetSequenceBatching: must be called before InitliazeGraph" << std::endl;
+				return;
+			}
+
+			this->sequenceBatching = sequenceBatching;
+		}
+
+		DeepCLError NeuralNetwork::SetSequenceLengths(const std::vector<size_t>& lengths)
+		{
+			if (!sequenceBatching)
+			{
+				std::cout << "Error SetSequenceLengths: sequence batching was not enabled!" << std::endl;
+				return NN_INVALID_SEQUENCE_LENGTHS;
+			}
+
+			//Batch element b is computed at time step t if its length is bigger than t. Sorted lengths let each time step process the first elements of the batch.
+			std::vector<unsigned int> limits;
+			for (size_t b = 0; b < lengths.size(); ++b)
+			{
+				if (b > 0 && lengths[b] > lengths[b - 1])
+				{
+					std::cout << "Error SetSequenceLengths: the lengths are not sorted in descending order!" << std::endl;
+					return NN_INVALID_SEQUENCE_LENGTHS;
+				}
+
+				const size_t length = lengths[b] < maxSteps ? lengths[b] : maxSteps;
+				if (limits.size() < length)
+					limits.resize(length, 0);
+				for (size_t t = 0; t < length; ++t)
+					++limits[t];
+			}
+			if (!lengths.empty())
+				limits.resize(maxSteps, 0);
+
+			backend.SetStepLimits(limits);
+			return 0;
+		}
+
+		DeepCLError NeuralNetwork::RecordTrainingStep()
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (quantized)
+			{
+				std::cout << "Error the graph uses the int8 operations!" << std::endl;
+				return NN_GRAPH_QUANTIZED;
+			}
+
+			//Nothing is executed while recording. The resets of ClearBackwardBuffer become part of the step.
+			//The recorded step processes a single batch, therefore the parameter gradients are overwritten.
+			SetParameterAccumulate(false);
+			backend.BeginRecording();
+			ResetBarrierCounters();
+			backend.RecordPass(BackendSystem::OpenCLBackend::OperationType::FORWARD);
+			ResetBarrierCounters();
+			backend.RecordPass(BackendSystem::OpenCLBackend::OperationType::BACKWARD);
+			backend.RecordPass(BackendSystem::OpenCLBackend::OperationType::UPDATE);
+			ClearBackwardBuffer();
+			backend.EndRecording();
+			stepRecorded = true;
+
+			return 0;
+		}
+
+		DeepCLError NeuralNetwork::TrainingStep()
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+			if (quantized)
+			{
+				std::cout << "Error the graph uses the int8 operations!" << std::endl;
+				return NN_GRAPH_QUANTIZED;
+			}
+
+			//A recorded step runs all time steps
+			if (!backend.IsRecorded() || backend.SkipsSteps())
+			{
+				Forward();
+				Backward();
+				return BatchDone();
+			}
+
+			for (auto it = slotInputBuffer.begin(); it != slotInputBuffer.end(); ++it)
+				it->second->SwapSlot(backend);
+			if (prefetchedBatch > 0)
+			{
+				backend.SetActiveBatch(static_cast<unsigned int>(prefetchedBatch));
+				prefetchedBatch = 0;
+			}
+
+			gradScale = 1.f;
+			backend.Replay();
+
+			//The host memory of the prefetched batch may be reused after this call returned
+			for (auto it = slotInputBuffer.begin(); it != slotInputBuffer.end(); ++it)
+				it->second->WaitForUpload();
+
+			return 0;
+		}
+
+		void NeuralNetwork::ClearBackwardBuffer(const bool clearParameters, const bool clearActivations)
+		{
+			size_t size = nnBufferList.size();
+
+			//Set all backward buffers to zero.
+			for (size_t i = 0; i < size; ++i)
+			{
+				bool isParameter = std::find(parameterBuffer.begin(), parameterBuffer.end(), i) != parameterBuffer.end();
+				if (isParameter ? clearParameters : clearActivations)
+					nnBufferList[i]->Reset(backend);
+			}
+		}
+
+		void NeuralNetwork::ResetBarrierCounters()
+		{
+			for (size_t i = 0; i < nnOperationList.size(); ++i)
+				if (nnOperationList[i]->GetBarrierCounter() != MAX_UNSIGNED_INT)
+					backend.ResetBuffer(nnOperationList[i]->GetBarrierCounter(), sizeof(int));
+		}
+
+		void NeuralNetwork::SetParameterAccumulate(const bool accumulate)
+		{
+			if (parameterAccumulate == accumulate)
+				return;
+			parameterAccumulate = accumulate;
+
+			size_t size = parameterBuffer.size();
+			for (size_t i = 0; i < size; ++i)
+			{
+				std::vector<BufferIdx>& bwdBuffer = nnBufferList[parameterBuffer[i]]->GetCompleteBackwardBuffer();
+				for (size_t j = 0; j < bwdBuffer.size(); ++j)
+					backend.SetAccumulate(bwdBuffer[j], accumulate);
+			}
+		}
+
+		void NeuralNetwork::UpdateBufferTime()
+		{
+			size_t size = nnBufferList.size();
+			
+			//Increase the buffer time. This way the next sub buffer is retrieved when accessing the current forward and backward buffer in the buffer. Only increased if necessary (Example for state buffers)
+			for (size_t i = 0; i < size; ++i)
+			{
+				nnBufferList[i]->UpdateStep();
+			}
+		}
+
+		void NeuralNetwork::ResetBufferTime()
+		{
+			//Set the time variable in each buffer to zero (This determines which sub buffer will be returned by some buffers)
+			size_t size = nnBufferList.size();
+
+			//The reset function all sets the backward buffer to zero
+			for (size_t i = 0; i < size; ++i)
+			{
+				nnBufferList[i]->Reset();
+			}
+		}
+
+		void NeuralNetwork::ClearAllBuffer()
+		{
+			size_t size = nnBufferList.size();
+
+			std::vector<BufferIdx> bwdBuffer;
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				NNBuffer* buffer = nnBufferList[i];
+
+				//Set all backward sub buffers to zero
+				bwdBuffer = buffer->GetCompleteBackwardBuffer();
+				for (size_t j = 0; j < bwdBuffer.size(); ++j)
+				{
+					if (bwdBuffer[j] != MAX_UNSIGNED_INT)
+						backend.ResetBuffer(bwdBuffer[j], buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW * buffer->ElementSize());
+				}
+
+				//Set all forward sub buffers to zero
+				bwdBuffer = buffer->GetCompleteForwardBuffer();
+				for (size_t j = 0; j < bwdBuffer.size(); ++j)
+					backend.ResetBuffer(bwdBuffer[j], buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ * buffer->size.sizeW * buffer->ForwardElementSize());
+			}
+		}
+	}
 }
\ No newline at end of file
@@ -1,576 +1,861 @@
-#pragma once
-
-#include <cmath>
-
-#include "OPManager.h"
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-		class NeuralNetwork
-		{
-		public:
-			NeuralNetwork();
-			~NeuralNetwork();
-
-			DeepCLError InitSystem();
-
-
-			void AddWeightInitializer(InitOp* initOp);
-			void AddOptimizer(NNOptimizer* optimizer);
-
-			NNBufferIdx AddOperation(NNOp* operation, const size_t timeOffset);
-			NNBufferIdx AddOperation(NNOp* operation, const NNBufferIdx result, const size_t timeOffset);
-
-			//Create Buffer functions create add Buffer to the Graph
-			//Returns the index of a Buffer used for Input
-			NNBufferIdx CreateInputBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t timeSteps = 1);
-			//Returns the index of a Buffer used for the State of a RNN
-			NNBufferIdx CreateStateBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t timeSteps = 1);
-			//Returns the index of a Buffer used for Parameters (Trained by the System)
-			NNBufferIdx CreateParameterBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1);
-
-			//Write Data Buffer Functions directly write the Data in data into the specified buffer.
-			template<typename T>
-			void WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0);
-			template<typename T>
-			void WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t numSubBuffer);
-#ifdef _DEBUG
-			void WriteDataBufferGrad(NNBufferIdx buffer, const void* data, const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0);
-#endif
-			//Saves the model to the File with the name fileName. The Buffers must be parameter buffers and they must be contained in the map. The map is used to map indices 
-			//to names which will then be stored in the file. The names are also used to map the loaded parameters into the specific buffer object.
-			void SaveModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names);
-			void LoadModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names);
-
-			//Read the content of the OpenCL buffer specified by buffer into host memory. The functions can be used to load different time steps or the gradient of the NNBuffer specified by buffer.
-			void ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0, const size_t = 0);
-			void ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t time = 0);
-
-			void ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0, const size_t = 0);
-			void ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t time = 0);
-
-			//Functions similar to the Read functions but this time printing the buffer into the ostream stream. This allows the output of buffers into files and to the console
-			template<typename T>
-			void PrintBuffer(NNBufferIdx buffer, const char* msg, std::ostream& stream = std::cout, const size_t time = 0);
-			template<typename T>
-			void PrintBufferGrad(NNBufferIdx buffer, const char* msg, std::ostream& stream = std::cout, const size_t time = 0);
-
-			template<typename T>
-			void PrintBuffer(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset = 0, const size_t batchOffset = 0, std::ostream& stream = std::cout, const size_t time = 0);
-			template<typename T>
-			void PrintBufferGrad(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset = 0, const size_t batchOffset = 0, std::ostream& stream = std::cout, const size_t time = 0);
-
-			template<typename T>
-			void ReadBufferFile(NNBufferIdx buffer, const char* name, std::fstream& file);
-			template<typename T>
-			void WriteBufferBinFile(NNBufferIdx buffer, const char* name, std::fstream& file);
-
-			template<typename T>
-			void PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, const size_t numImages, const size_t numBatches, const size_t imgOffset = 0, const size_t batchOffset = 0, std::ostream& stream = std::cout);
-
-			template<typename T>
-			void PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, std::ostream& stream = std::cout);
-
-			//Function Initalizes Graph. It must be called before the training can be performed and after the model was completely created.
-			//It creates all OpenCL objects via the backend. Before no OpenCL objects where created.
-			DeepCLError InitliazeGraph(const size_t batchSize);
-
-			//Forward functions allowing different types and number of inputs to be used. It executes the forward pass of the NN.
-			template<typename T1, typename T2>
-			DeepCLError Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize);
-
-			template<typename T1, typename T2>
-			DeepCLError Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize, const size_t numTimeSteps);
-
-			//Allows a variable number of inputs using Variadic Templates. The Buffer indices specify the NNInputBuffer in which the corresponding buffer data is loaded into. 
-			//The bufferIndice vector must therefore have the same number of elements as there are template arguments.
-			template<typename... T1>
-			DeepCLError Forward(std::vector<T1>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize)
-			{
-				if (!graphInitiliazed)
-				{
-					std::cout << "Error command queue was not build!" << std::endl;
-					return NN_GRAPH_NOT_INITIALIZED;
-				}
-
-				UnrollFwd<0, T1...>::apply(buffer..., bufferIndices, sizes, curBatchSize, *this);
-
-				backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
-
-				return 0;
-			}
-
-
-
-			DeepCLError Forward();
-
-			//Performs the backward pass of the Nn
-			DeepCLError Backward();
-
-			//Updates Parameters and sets all gradients to zero.
-			DeepCLError BatchDone();
-
-			//template<typename T1, typename T2>
-			//float* CalculateGradError(const NNBufferIdx a, const float epsilon, const NNBufferIdx error, const Batch<T1, T2>& batch, const size_t timeStep, float** gradBuffer, const size_t sX = 0, const size_t sY = 0, const size_t sZ = 0, const size_t sW = 0);
-
-			SizeVec GetSize(const NNBufferIdx a) const;
-
-#ifdef PROFILING_ENABLED
-			unsigned long long GetTimeForward(const NNBufferIdx input, const NNBufferIdx output);
-			unsigned long long GetTimeBackward(const NNBufferIdx input, const NNBufferIdx output);
-#endif // PROFILING_ENABLED
-
-			//Function applied on tuple elements
-			template<typename T1>
-			void UnrollForward(std::vector<T1>& curBuffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize, size_t i)
-			{
-				SizeVec tmpSize = sizes[i];
-				size_t timeSteps = 1;
-
-				if (tmpSize.sizeW > 1)
-					timeSteps = tmpSize.sizeW;
-
-				tmpSize.sizeW = curBatchSize;
-
-				if (timeSteps > 1)
-					WriteDataBuffer<T1>(bufferIndices[i], curBuffer.data(), tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW, 0, timeSteps);
-				else
-					WriteDataBuffer<T1>(bufferIndices[i], curBuffer.data(), tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
-			}
-
-		private:
-			BackendSystem::OpenCLBackend backend;
-
-			std::vector<NNBuffer*> nnBufferList; //NNBuffers contained in the Graph
-			std::vector<NNOp*> nnOperationList;  //NNOps contained in the Graph
-			std::vector<NNBufferIdx> parameterBuffer; //ParameterBuffer contained in the Graph(Intersects with nnBufferList)
-			std::vector<InitOp*> initOpList; //InitOps used to initalize the parameters
-
-			NNOptimizer* optimizer;
-			size_t numAuxBuffer; //Attitional Buffers of the optimizer(Momentum etc.)
-			size_t maxSteps; //Maximal number of time steps the RNN runs.
-
-			static NeuralNetwork* activeNN;
-
-			bool initialized; //True when InitSystem was called
-			bool graphInitiliazed;//True when the Graph was initalized
-
-			float* tmpDataMemory;
-			size_t maxSize;
-
-			NNBufferIdx CreateBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t timeSteps = 1);
-			NNBufferIdx CreateBuffer(const SizeVec size, const size_t timeSteps = 1);
-
-			void NeuralNetwork::ReadDataBufferDirect(BufferIdx buffer, void* data, const size_t totalSize, const size_t offset);
-
-			//Basic buffer for prinitng buffers
-			template<typename T>
-			void PrintBufferBase(const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, const SizeVec& size, std::ostream& stream)
-			{
-				stream << msg << std::endl;
-
-				for (size_t i = batchOffset; i < numBatches + batchOffset; ++i)
-				{
-					for (size_t l = imgOffset; l < numImages + imgOffset; ++l)
-					{
-						for (size_t j = 0; j < size.sizeY; ++j)
-						{
-							for (size_t k = 0; k < size.sizeX; ++k)
-							{
-								stream << reinterpret_cast<T*>(tmpDataMemory)[k + size.sizeX * (j + size.sizeY * (l + size.sizeZ * i))] << " ";
-							}
-							stream << std::endl;
-						}
-						stream << std::endl;
-					}
-					stream << std::endl;
-				}
-				stream << std::endl;
-			}
-
-			//Sets the w component in each buffer to the batch size where it is necessary (Not in parameter buffers since they are independent of the batch size.)
-			void SetBatchSize(const size_t batchSize);
-			//Creates the acutal OpenCL hardware buffers.
-			void InstantiateBuffer();
-			//Calcualtes the number and size of necessary temporary buffers and creates them. Than each temporary buffer is added to operations which need them.
-			void CreateTmpBuffer();
-
-			//Creates and adds the implemented operations to the backend. The operations are added to the correct pass in the backend.
-			//It also takes care of the unrolling of RNNs in time.
-			void InstantiateOperations();
-			//Perform the weight initalization operations which create some values for the parameters and transfer them to the backend.
-			void InitalizeWeights();
-
-			//Updates the timeStep variable in the buffers by one if necessary
-			void UpdateBufferTime();
-			//sets the timeStep variable in the buffers to zero.
-			void ResetBufferTime();
-
-			//Set all backward openCL hardware buffers to zero.
-			void ClearBackwardBuffer();
-			//Set all openCL hardware buffers to zero.
-			void ClearAllBuffer();
-		};
-
-		// Functions necessary to apply transfer the data into the input buffer when variadic templates are used to insert add the data to the forward pass.
-		//Terminal/base case
-		template<size_t from, class... Ts>
-		struct UnrollFwd{
-		public:
-			inline static void apply(std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSizee, NeuralNetwork& nn)
-			{
-			}
-		};
-		//Splits of one element of the variadic template and transfers the data to the into the input buffer.
-		template<size_t from, class T1, class... Ts>
-		struct UnrollFwd < from, T1, Ts... >
-		{
-		public:
-			inline static void apply(std::vector<T1>& curBuffer, std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize, NeuralNetwork& nn)
-			{
-				nn.UnrollForward<T1>(curBuffer, bufferIndices, sizes, curBatchSize, from);
-				UnrollFwd<from + 1, Ts...>::apply(buffer..., bufferIndices, sizes, curBatchSize, nn);
-			}
-		};
-
-		//Reads a buffer with name name out of the file file and stores it into buffer.
-		template<typename T>
-		void NeuralNetwork::ReadBufferFile(NNBufferIdx buffer, const char* name, std::fstream& file)
-		{
-			//Search for the beginning of the buffer with the name name.
-			std::string line;
-			bool found = false;
-			while (getline(file, line))
-			{
-				if (line.find(name)!=std::string::npos)
-				{
-					found = true;
-					break;
-				}
-			}
-			//Error if a buffer with the name was not found.
-			if (!found)
-			{
-				std::cerr << "name: " << name << " not found in file" << std::endl;
-				return;
-			}
-
-			//Read the buffer out of the file and transfer it into the OpenCL buffer buffer.
-			NNBuffer* nnBuffer = nnBufferList[buffer];
-			SizeVec bufferSizes = nnBuffer->size;
-
-			float* values = new float[bufferSizes.sizeX * bufferSizes.sizeY * bufferSizes.sizeZ * bufferSizes.sizeW];
-
-			file.read(reinterpret_cast<char*>(values), bufferSizes.sizeX * bufferSizes.sizeY * bufferSizes.sizeZ * bufferSizes.sizeW * sizeof(float));
-
-			WriteDataBuffer<float>(buffer, values, bufferSizes.sizeX, bufferSizes.sizeY, bufferSizes.sizeZ, bufferSizes.sizeW);
-			delete[] values;
-		}
-
-		//Writes the contents of the forward part of buffer into the file name under the specified name name.
-		template<typename T>
-		void NeuralNetwork::WriteBufferBinFile(NNBufferIdx buffer, const char* name, std::fstream& file)
-		{
-			//Read the buffer content.
-			SizeVec size = nnBufferList[buffer]->size;
-			ReadDataBuffer(buffer, reinterpret_cast<void*>(tmpDataMemory), 0);
-			//Write the name into the file.
-			file <<  name << std::endl;
-
-			NNBuffer* nnBuffer = nnBufferList[buffer];
-			SizeVec bufferSizes = nnBuffer->size;
-
-			char* dataPointer = reinterpret_cast<char*>(tmpDataMemory);
-			//Store the read buffer data into the file.
-			file.write(dataPointer, sizeof(T) * bufferSizes.sizeX* bufferSizes.sizeY* bufferSizes.sizeZ* bufferSizes.sizeW);
-
-			file << std::endl;
-		}
-
-		//Call the forward pass using two input buffers.
-		template<typename T1, typename T2>
-		DeepCLError NeuralNetwork::Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize)
-		{
-			if (!graphInitiliazed)
-			{
-				std::cout << "Error command queue was not build!" << std::endl;
-				return NN_GRAPH_NOT_INITIALIZED;
-			}
-
-			//Write the input into the inputBuffer
-			SizeVec tmpSize = inputSize;
-			if (tmpSize.sizeW == 1)
-				tmpSize.sizeW = curBatchSize;
-
-			WriteDataBuffer<T1>(inputBuffer, input, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
-
-			//Write the output(label) into the outputBuffer.
-			tmpSize = outputSize;
-			if (tmpSize.sizeW == 1)
-				tmpSize.sizeW = curBatchSize;
-
-			WriteDataBuffer<T2>(outputBuffer, output, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
-			
-			//Perform the forward pass.
-			backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
-
-
-			return 0;
-		}
-
-		//Call the forward pass using two input buffers. The label no contains results for the specified number of time steps.
-		template<typename T1, typename T2>
-		DeepCLError NeuralNetwork::Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize, const size_t numTimeSteps)
-		{
-			if (!graphInitiliazed)
-			{
-				std::cout << "Error command queue was not build!" << std::endl;
-				return NN_GRAPH_NOT_INITIALIZED;
-			}
-
-			SizeVec tmpSize = inputSize;
-			if (tmpSize.sizeW == 1)
-				tmpSize.sizeW = curBatchSize;
-
-			WriteDataBuffer<T1>(inputBuffer, input, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
-
-
-			tmpSize = outputSize;
-			if (tmpSize.sizeW == 1)
-				tmpSize.sizeW = curBatchSize;
-
-			WriteDataBuffer<T2>(outputBuffer, output, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW, numTimeSteps);
-
-			backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
-
-
-			return 0;
-		}
-
-		//Write some data into the by buffer specified forward buffer.
-		template<typename T>
-		void NeuralNetwork::WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset)
-		{
-			//Query the buffer and check if the sizes match.
-			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
-			NNBuffer* bufferData = nnBufferList[buffer];
-			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
-			if (totalSize + offset > bufferSize)
-			{
-				std::cout << "Error WriteDataBuffer: Out of Range" << std::endl;
-				return;
-			}
-
-			//Load the data into the corresponding buffer.
-			BufferIdx fwdBuffer = bufferData->ForwardBuffer();
-
-			backend.WriteDataBuffer(bufferData->ForwardBuffer(), data, offset, totalSize * sizeof(T));
-		}
-
-		//Writes data into multiple time steps of the forward buffer of buffer.
-		//Data must contain the data for the different time steps behind each other.
-		template<typename T>
-		void NeuralNetwork::WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t numSubBuffer)
-		{
-			//Query the buffer and check if the sizes match.
-			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
-			NNBuffer* bufferData = nnBufferList[buffer];
-			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
-
-			if (totalSize + offset > bufferSize)
-			{
-				std::cout << "Error WriteDataBuffer: Out of Range" << std::endl;
-				return;
-			}
-			//Load the data into the different corresponding buffers.
-			totalSize = sizeX * sizeY * sizeZ;
-			T* tmpData = new T[totalSize * sizeW];
-			std::vector<BufferIdx> localSubBuffer = bufferData->GetCompleteForwardBuffer();
-			const T* realPointer = reinterpret_cast<const T*>(data);
-			for (size_t i = 0; i < numSubBuffer; ++i)
-			{
-				for (size_t j = 0; j < sizeW; ++j)
-					for (size_t k = 0; k < totalSize; ++k)
-					{
-						tmpData[j * totalSize + k] = realPointer[k + i * totalSize + j * totalSize * numSubBuffer];
-					}
-				backend.WriteDataBuffer(localSubBuffer[i], tmpData, offset, totalSize *sizeW* sizeof(T));
-			}
-			delete[] tmpData;
-		}
-		
-		//Checks the gradient by calculating the numerical gradient and comparing the results.
-		//After a change to the framework an error occurs sometimes which must be fixed before this can be used relably again.
-		/*
-		template <typename T1, typename T2>
-		float* NeuralNetwork::CalculateGradError(const NNBufferIdx a, const float epsilon, const NNBufferIdx error, const Batch<T1, T2>& batch, const size_t timeStep, float** gradBuffer, const size_t sX, const size_t sY, const size_t sZ, const size_t sW)
-		{
-			NNBuffer buffer = nnBufferList[a];
-			NNBuffer errorBuffer = nnBufferList[error];
-
-			size_t size =  buffer.size.sizeX * buffer.size.sizeY * buffer.size.sizeZ * buffer.size.sizeW;
-			size_t chosenSize = (sX != 0 ? sX : buffer.size.sizeX) * (sY != 0 ? sY : buffer.size.sizeY) * (sZ != 0 ? sZ : buffer.size.sizeZ) * (sW != 0 ? sW : buffer.size.sizeW);
-
-			size_t errorSize = errorBuffer.size.sizeX * errorBuffer.size.sizeY * errorBuffer.size.sizeZ * errorBuffer.size.sizeW;
-
-			float* errorBufferFloat = new float[errorSize];
-
-			float* orgBuffer = new float[size];
-			float* changedBuffer = new float[size];
-
-			float* resultBuffer = new float[size];
-
-			ReadDataBuffer(a, orgBuffer);
-
-			size_t i, j, k, l, sum;
-
-			float sumarg;
-
-			for (size_t point = 0; point < chosenSize; ++point)
-			{
-				for (i = 0; i < buffer.size.sizeW; ++i)
-					for (j = 0; j < buffer.size.sizeZ; ++j)
-						for (k = 0; k < buffer.size.sizeY; ++k)
-							for (l = 0; l < buffer.size.sizeX; ++l)
-							{
-								changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = orgBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] + ((l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))) == point ? epsilon : 0);
-							}
-
-				
-
-				WriteDataBuffer(a, changedBuffer, buffer.size.sizeX, buffer.size.sizeY, buffer.size.sizeZ, buffer.size.sizeW);
-
-				Forward<T1, T2>(batch);
-				ReadDataBuffer(error, errorBufferFloat, timeStep);
-
-
-				sumarg = 0.f;
-				for (sum = 0; sum < errorBuffer.size.sizeW; ++sum)
-					sumarg += errorBufferFloat[sum];
-				resultBuffer[point] = sumarg / static_cast<float>(errorBuffer.size.sizeW);
-
-				for (i = 0; i < buffer.size.sizeW; ++i)
-					for (j = 0; j < buffer.size.sizeZ; ++j)
-						for (k = 0; k < buffer.size.sizeY; ++k)
-							for (l = 0; l < buffer.size.sizeX; ++l)
-							{
-								changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = orgBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] - ((l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))) == point ? epsilon : 0);
-							}
-
-				WriteDataBuffer(a, changedBuffer, buffer.size.sizeX, buffer.size.sizeY, buffer.size.sizeZ, buffer.size.sizeW);
-
-				Forward<T1, T2>(batch);
-				ReadDataBuffer(error, errorBufferFloat, timeStep);
-
-				sumarg = 0.f;
-				for (sum = 0; sum < errorBuffer.size.sizeW; ++sum)
-					sumarg += errorBufferFloat[sum];
-				resultBuffer[point] -= sumarg / static_cast<float>(errorBuffer.size.sizeW);
-
-
-				if(point%100==0)
-					std::cout << point << " ";
-			}
-
-			WriteDataBuffer(a, orgBuffer, buffer.size.sizeX, buffer.size.sizeY, buffer.size.sizeZ, buffer.size.sizeW);
-
-			Forward<T1, T2>(batch);
-			Backward();
-
-			ReadDataBufferGrad(a, changedBuffer);
-
-
-
-			for (i = 0; i < buffer.size.sizeW; ++i)
-				for (j = 0; j < buffer.size.sizeZ; ++j)
-					for (k = 0; k < buffer.size.sizeY; ++k)
-						for (l = 0; l < buffer.size.sizeX; ++l)
-						{
-							resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] / (2.f*epsilon);
-						}
-
-			for (i = 0; i < buffer.size.sizeW; ++i)
-				for (j = 0; j < buffer.size.sizeZ; ++j)
-					for (k = 0; k < buffer.size.sizeY; ++k)
-						for (l = 0; l < buffer.size.sizeX; ++l)
-						{
-							resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = abs(changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] - resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))]) / max(abs(changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))]), abs(resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))]));
-						}
-
-			delete[] errorBufferFloat;
-			delete[] orgBuffer;
-
-			*gradBuffer = changedBuffer;
-
-			std::cout << std::endl;
-
-			return resultBuffer;
-		}
-		*/
-
-		//Functions for printing buffers like the normal buffers for different time steps using time, the Momentum buffers, gradient buffers an so on.
-		//All functions read the data and then print it using a basic print function called printBufferBase.
-		template<typename T>
-		void NeuralNetwork::PrintBuffer(NNBufferIdx buffer, const char* msg, std::ostream& stream, const size_t time)
-		{
-			SizeVec size = nnBufferList[buffer]->size;
-			ReadDataBuffer(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
-
-			PrintBufferBase<T>(msg, size.sizeZ, size.sizeW, 0, 0, size, stream);
-		}
-
-		template<typename T>
-		void NeuralNetwork::PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, std::ostream& stream)
-		{
-			SizeVec size = nnBufferList[buffer]->size;
-			NNBuffer* locBuffer= reinterpret_cast<NNBuffer*>(nnBufferList[buffer]);
-			size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW;
-
-			ReadDataBufferDirect(locBuffer->ForwardBuffer(num), reinterpret_cast<void*>(tmpDataMemory), totalSize, 0);
-
-			PrintBufferBase<T>(msg, size.sizeZ, size.sizeW, 0, 0, size, stream);
-		}
-
-		template<typename T>
-		void NeuralNetwork::PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, std::ostream& stream)
-		{
-			SizeVec size = nnBufferList[buffer]->size;
-			NNBuffer* locBuffer = reinterpret_cast<NNBuffer*>(nnBufferList[buffer]);
-			size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW;
-
-			ReadDataBufferDirect(locBuffer->ForwardBuffer(num), reinterpret_cast<void*>(tmpDataMemory), totalSize, 0);
-
-			PrintBufferBase<T>(msg, numImages, numBatches, imgOffset, batchOffset, size, stream);
-		}
-
-		template<typename T>
-		void NeuralNetwork::PrintBufferGrad(NNBufferIdx buffer, const char* msg, std::ostream& stream, const size_t time)
-		{
-			SizeVec size = nnBufferList[buffer]->size;
-			ReadDataBufferGrad(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
-
-			PrintBufferBase<T>(msg, size.sizeZ, size.sizeW, 0, 0, size, stream);
-		}
-
-		template<typename T>
-		void NeuralNetwork::PrintBuffer(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, std::ostream& stream, const size_t time)
-		{
-			SizeVec size = nnBufferList[buffer]->size;
-			ReadDataBuffer(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
-
-			PrintBufferBase<T>(msg, numImages, numBatches, imgOffset, batchOffset, size, stream);
-		}
-
-		template<typename T>
-		void NeuralNetwork::PrintBufferGrad(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, std::ostream& stream, const size_t time)
-		{
-			SizeVec size = nnBufferList[buffer]->size;
-			ReadDataBufferGrad(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
-
-			PrintBufferBase<T>(msg, numImages, numBatches, imgOffset, batchOffset, size, stream);
-		}
-	}
-}
-
+#pragma once
+
+#include <cmath>
+
+#include "OPManager.h"
+#include "ModelFile.h"
+#include "CheckpointWriter.h"
+#include "GradientCompressor.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		class NeuralNetwork
+		{
+		public:
+			NeuralNetwork();
+			~NeuralNetwork();
+
+			DeepCLError InitSystem();
+			//Initalizes the system for the given device instead of asking the user (Used to create one network for each device).
+			DeepCLError InitSystem(const cl::Device& device);
+
+
+			void AddWeightInitializer(InitOp* initOp);
+			void AddOptimizer(NNOptimizer* optimizer);
+
+			NNBufferIdx AddOperation(NNOp* operation, const size_t timeOffset);
+			NNBufferIdx AddOperation(NNOp* operation, const NNBufferIdx result, const size_t timeOffset);
+
+			//Create Buffer functions create add Buffer to the Graph
+			//Returns the index of a Buffer used for Input
+			//With numSlots bigger than one the input can be filled using Prefetch while the previous batch is still processed.
+			//storage is the type of the uploaded data. Data of other types than float is uploaded as it is and must be converted by OP::Dequantize, which reduces the upload size.
+			NNBufferIdx CreateInputBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t timeSteps = 1, const size_t numSlots = 1,
+				const InputStorage storage = INPUT_FLOAT);
+			//Returns the index of a Buffer used for the State of a RNN
+			//With carryState a long sequence is processed in chunks of timeSteps steps (Truncated backpropagation through time). The last state of a chunk is copied into the first state
+			//of the next chunk when the gradients are cleared, the gradient stops at the chunk boundary. Use ResetStates at the start of a new sequence.
+			//carryState can't be combined with SetSequenceBatching, since the last state of shorter sequences is not written.
+			NNBufferIdx CreateStateBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t timeSteps = 1, const bool carryState = false);
+			//Returns the index of a Buffer used for Parameters (Trained by the System)
+			NNBufferIdx CreateParameterBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1);
+
+			//Write Data Buffer Functions directly write the Data in data into the specified buffer.
+			template<typename T>
+			void WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0);
+			template<typename T>
+			void WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t numSubBuffer);
+			//Uploads the data into the next slot of an input buffer with multiple slots using the upload queue. The data is used by the next call of Forward() without arguments.
+			//If only one time step is uploaded data must stay valid until this call of Forward() returned.
+			template<typename T>
+			void PrefetchDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t numSubBuffer = 1);
+#ifdef _DEBUG
+			void WriteDataBufferGrad(NNBufferIdx buffer, const void* data, const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0);
+#endif
+			//Saves the model to the File with the name fileName. The Buffers must be parameter buffers and they must be contained in the map. The map is used to map indices 
+			//to names which will then be stored in the file. The names are also used to map the loaded parameters into the specific buffer object.
+			//The file contains a table of all tensors followed by the aligned data (See ModelFile.h). With quantized the parameters quantized by Quantize are stored as int8.
+			DeepCLError SaveModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names, const bool quantized = false);
+			//Maps the file into memory and uploads each tensor directly from the mapping. Files written by older versions are read as well.
+			DeepCLError LoadModel(const std::string& fileName, const std::map<NNBufferIdx, char*>& names);
+
+			//Saves the complete training state: All parameters, the auxiliary buffers of the optimizer (Momentum etc.), the step of the optimizer, the loss scale
+			//and the position of the data passed as dataPosition (See BatchManager::GetNumBatches). The weight initializations depend only on the seed and the parameter index, they have no state to save.
+			//The tensors are named after the order in which the parameter buffers were created, therefore the graph loading the checkpoint must be built the same way.
+			//The buffers are copied on the device and the function returns. The file is written by a background thread, the next call waits until it finished.
+			DeepCLError SaveCheckpoint(const std::string& fileName, const unsigned long long dataPosition = 0);
+			//Waits until the last checkpoint was written and returns the result of the write.
+			DeepCLError WaitForCheckpoint();
+			//Restores the training state stored by SaveCheckpoint and returns the position of the data in dataPosition. Gradients accumulated since the last step are discarded
+			//and the carried states are set to zero (See ResetStates).
+			DeepCLError LoadCheckpoint(const std::string& fileName, unsigned long long& dataPosition);
+
+			//Read the content of the OpenCL buffer specified by buffer into host memory. The functions can be used to load different time steps or the gradient of the NNBuffer specified by buffer.
+			void ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0, const size_t = 0);
+			void ReadDataBuffer(NNBufferIdx buffer, void* data, const size_t time = 0);
+
+			void ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t offset = 0, const size_t = 0);
+			void ReadDataBufferGrad(NNBufferIdx buffer, void* data, const size_t time = 0);
+
+			//Functions similar to the Read functions but this time printing the buffer into the ostream stream. This allows the output of buffers into files and to the console
+			template<typename T>
+			void PrintBuffer(NNBufferIdx buffer, const char* msg, std::ostream& stream = std::cout, const size_t time = 0);
+			template<typename T>
+			void PrintBufferGrad(NNBufferIdx buffer, const char* msg, std::ostream& stream = std::cout, const size_t time = 0);
+
+			template<typename T>
+			void PrintBuffer(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset = 0, const size_t batchOffset = 0, std::ostream& stream = std::cout, const size_t time = 0);
+			template<typename T>
+			void PrintBufferGrad(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset = 0, const size_t batchOffset = 0, std::ostream& stream = std::cout, const size_t time = 0);
+
+			template<typename T>
+			void ReadBufferFile(NNBufferIdx buffer, const char* name, std::fstream& file);
+			template<typename T>
+			void WriteBufferBinFile(NNBufferIdx buffer, const char* name, std::fstream& file);
+
+			template<typename T>
+			void PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, const size_t numImages, const size_t numBatches, const size_t imgOffset = 0, const size_t batchOffset = 0, std::ostream& stream = std::cout);
+
+			template<typename T>
+			void PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, std::ostream& stream = std::cout);
+
+			//Sets the number of OpenCL queues the operations are distributed over. Independent operations (Like the gates of a GRU) can then run concurrently.
+			//Must be called before InitliazeGraph.
+			void SetNumQueues(const size_t numQueues);
+
+			//Stores the activations and their gradients as half if all operations using them support it. The parameters and the updates stay in float.
+			//The loss is scaled to keep small gradients representable. The scale starts at initialScale, is halved when the gradients overflow (The update is skipped)
+			//and doubled after interval steps without an overflow. Must be called before InitliazeGraph.
+			void SetMixedPrecision(const bool mixedPrecision, const float initialScale = 32768.f, const size_t interval = 2000);
+
+			//Compresses the gradients exchanged by a DistributedTrainer. Top-k compression sends the fraction density of the values of each gradient.
+			//Top-k and sign compression store the values not sent in an additional auxiliary buffer of each parameter. Must be called before InitliazeGraph.
+			void SetGradientCompression(const GradientCompression compression, const float density = 0.01f);
+			//Returns nullptr if no compression was set.
+			GradientCompressor* GetGradientCompressor() { return gradientCompressor; }
+
+			//Records the range of the inputs of operations with an int8 version using the values of the last forward pass.
+			//Must be called after Forward() for each batch of the calibration data.
+			DeepCLError Calibrate();
+			//Quantizes the parameters used by operations with an int8 version (One scale per output channel) and exchanges their forward operations with the int8 versions.
+			//The inputs are quantized using the calibrated ranges. Afterwards only the forward pass can be performed.
+			//Calling it again after the float operations were restored quantizes the current parameters and ranges again.
+			DeepCLError Quantize();
+			//Switches between the int8 and the float forward operations after Quantize was called. A step recorded by RecordTrainingStep is recorded again when the float operations are restored.
+			void SetQuantized(const bool useQuantized);
+			//Runs the forward pass on the data in the input buffers using the float and the int8 operations and returns the maximal and mean absolute difference of the output.
+			DeepCLError CompareQuantized(const NNBufferIdx output, float& maxError, float& meanError);
+
+			//Function Initalizes Graph. It must be called before the training can be performed and after the model was completely created.
+			//It creates all OpenCL objects via the backend. Before no OpenCL objects where created.
+			DeepCLError InitliazeGraph(const size_t batchSize);
+
+			//Forward functions allowing different types and number of inputs to be used. It executes the forward pass of the NN.
+			template<typename T1, typename T2>
+			DeepCLError Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize);
+
+			template<typename T1, typename T2>
+			DeepCLError Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize, const size_t numTimeSteps);
+
+			//Allows a variable number of inputs using Variadic Templates. The Buffer indices specify the NNInputBuffer in which the corresponding buffer data is loaded into. 
+			//The bufferIndice vector must therefore have the same number of elements as there are template arguments.
+			template<typename... T1>
+			DeepCLError Forward(std::vector<T1>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize)
+			{
+				if (!graphInitiliazed)
+				{
+					std::cout << "Error command queue was not build!" << std::endl;
+					return NN_GRAPH_NOT_INITIALIZED;
+				}
+
+				UnrollFwd<0, T1...>::apply(buffer..., bufferIndices, sizes, curBatchSize, *this);
+
+				backend.SetActiveBatch(static_cast<unsigned int>(curBatchSize));
+				backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
+
+				return 0;
+			}
+
+
+
+			//Uploads the data of the next batch into the input buffers without running the forward pass. Works like the variadic Forward function.
+			//The input buffers must have been created with more than one slot. The data is used by the next call of Forward().
+			template<typename... T1>
+			DeepCLError Prefetch(std::vector<T1>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize)
+			{
+				if (!graphInitiliazed)
+				{
+					std::cout << "Error command queue was not build!" << std::endl;
+					return NN_GRAPH_NOT_INITIALIZED;
+				}
+
+				UnrollPre<0, T1...>::apply(buffer..., bufferIndices, sizes, curBatchSize, *this);
+				prefetchedBatch = curBatchSize;
+
+				return 0;
+			}
+
+			//Sets the number of batch elements processed by the following passes. It must not be bigger than the batch size passed to InitliazeGraph.
+			//Only the first batch elements of each buffer are computed, the graph and a recorded step don't need to be created again.
+			void SetActiveBatch(const size_t batchSize);
+
+			//Allows batches of sequences with different lengths (See SetSequenceLengths). The first operation writing a gradient adds to it instead of overwriting it,
+			//since it may belong to a skipped time step. Must be called before InitliazeGraph. State buffers carrying their state are not supported.
+			void SetSequenceBatching(const bool sequenceBatching);
+			//Sets the number of valid time steps of each batch element for the following passes. The lengths must be sorted in descending order (See Batch::lengths).
+			//Each time step only computes the batch elements whose sequence didn't end, the time steps behind the longest sequence are skipped.
+			//The outputs of a batch element are only valid up to its length. An empty vector processes all time steps of all batch elements again.
+			DeepCLError SetSequenceLengths(const std::vector<size_t>& lengths);
+
+			//Activation recomputation (Gradient checkpointing). The forward pass is split into about sqrt(N) segments of its N operation instances (One for each operation and time step).
+			//The forward sub buffers of intermediate buffers used only inside one segment are placed in a scratch buffer shared by all segments, therefore each segment overwrites
+			//the activations of the previous one. The forward operations of a segment are run again before its backward pass. RecomputeBuffer selects the output of an operation,
+			//with automatic checkpointing all buffers supporting it are recomputed. Both must be called before InitliazeGraph.
+			DeepCLError RecomputeBuffer(const NNBufferIdx buffer);
+			void SetAutomaticCheckpointing(const bool automatic);
+			//Returns the bytes the recomputed activations need without recomputation, the bytes of the scratch buffer replacing them and the number of forward operations
+			//added to the backward pass. The activations of a recomputed buffer can only be read for the time steps of the last segment.
+			void GetCheckpointingInfo(size_t& recomputedMemory, size_t& scratchMemory, size_t& recomputedOps) const;
+
+			//Sets the first state of all state buffers carrying their state to zero (Start of a new sequence). With carry set the last state of the previous chunk is copied
+			//instead, this is only necessary after a chunk processed without backward pass (Inference on a long sequence).
+			void ResetStates(const bool carry = false);
+
+			//Performs the forward pass using the data currently in the input buffers. Input buffers with prefetched data are switched to the new slot before.
+			DeepCLError Forward();
+
+			//Evaluation on the device (See OP::CountCorrect). ResetCorrect sets the counters of all CountCorrect operations to zero, each following forward pass adds
+			//the correct examples of its batch. ReadCorrect reads the counter of the operation with the result buffer correct, it is the only read of an evaluation.
+			void ResetCorrect();
+			DeepCLError ReadCorrect(const NNBufferIdx correct, size_t& numCorrect);
+
+			//Enables or disables all augmentation operations (See OP::Augment). Disabled augmentations copy their input, which is used for evaluation. They are enabled after creation.
+			void SetAugmentation(const bool enabled);
+
+			//Performs the backward pass of the Nn
+			//With accumulate set the parameter gradients are added to the gradients of the previous batches since the last Step(). This allows an effective batch size bigger
+			//than the batch size of the graph. The remaining gradients are set to zero after each pass, therefore the next batch can be processed directly.
+			DeepCLError Backward(const bool accumulate = false);
+
+			//Updates Parameters using the mean of the gradients accumulated since the last step and sets all gradients to zero.
+			DeepCLError Step();
+
+			//Updates Parameters and sets all gradients to zero. (Same as Step())
+			DeepCLError BatchDone();
+
+			//Records the forward pass, the backward pass and the update including the reset of the gradients. TrainingStep replays the recorded commands
+			//without setting the kernel arguments of each operation again. Must be called after InitliazeGraph and again after operations were added.
+			DeepCLError RecordTrainingStep();
+
+			//Performs Forward(), Backward() and BatchDone() using the recorded step. The function returns once the commands were enqueued.
+			//Input buffers with prefetched data are switched to the new slot before. Without a recorded step the passes are run one after another.
+			DeepCLError TrainingStep();
+
+			//Functions used to exchange the parameter gradients between networks containing the same graph (See DataParallelTrainer).
+			//Enqueues the backward pass without waiting for it. Returns the index of each parameter buffer (In the order of their creation) together with an event
+			//finishing once its gradient is complete. The parameters are ordered by the time their gradients are complete.
+			DeepCLError BackwardAsync(std::vector<std::pair<size_t, cl::Event>>& gradientEvents);
+			size_t GetNumParameters() const { return parameterBuffer.size(); }
+			NNBufferIdx GetParameterBuffer(const size_t parameter) const { return parameterBuffer[parameter]; }
+			//Reads the gradient of a parameter using the download queue after waitEvent finished and writes it using the upload queue.
+			void ReadGradientAsync(const size_t parameter, float* data, const cl::Event* waitEvent, cl::Event* readEvent);
+			void WriteGradientAsync(const size_t parameter, const float* data, cl::Event* writeEvent);
+			//Updates the parameters after the events finished. (Same as Step())
+			DeepCLError Step(const std::vector<cl::Event>& waitEvents);
+			//Copies the parameters and the auxiliary buffers of source into this network. Both must contain the same graph.
+			DeepCLError CopyParameters(NeuralNetwork& source);
+			//Reads the parameters and the auxiliary buffers into one vector or writes them from it (Used to send them to other processes, see DistributedTrainer).
+			DeepCLError ReadParameters(std::vector<float>& values);
+			DeepCLError WriteParameters(const std::vector<float>& values);
+
+			//template<typename T1, typename T2>
+			//float* CalculateGradError(const NNBufferIdx a, const float epsilon, const NNBufferIdx error, const Batch<T1, T2>& batch, const size_t timeStep, float** gradBuffer, const size_t sX = 0, const size_t sY = 0, const size_t sZ = 0, const size_t sW = 0);
+
+			SizeVec GetSize(const NNBufferIdx a) const;
+
+#ifdef PROFILING_ENABLED
+			unsigned long long GetTimeForward(const NNBufferIdx input, const NNBufferIdx output);
+			unsigned long long GetTimeBackward(const NNBufferIdx input, const NNBufferIdx output);
+			//Time the recomputed forward operations took in the last backward pass
+			unsigned long long GetTimeRecompute();
+#endif // PROFILING_ENABLED
+
+			//Function applied on tuple elements
+			template<typename T1>
+			void UnrollForward(std::vector<T1>& curBuffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize, size_t i)
+			{
+				SizeVec tmpSize = sizes[i];
+				size_t timeSteps = 1;
+
+				if (tmpSize.sizeW > 1)
+					timeSteps = tmpSize.sizeW;
+
+				tmpSize.sizeW = curBatchSize;
+
+				if (timeSteps > 1)
+					WriteDataBuffer<T1>(bufferIndices[i], curBuffer.data(), tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW, 0, timeSteps);
+				else
+					WriteDataBuffer<T1>(bufferIndices[i], curBuffer.data(), tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
+			}
+
+			//Function applied on tuple elements when prefetching
+			template<typename T1>
+			void UnrollPrefetch(std::vector<T1>& curBuffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize, size_t i)
+			{
+				SizeVec tmpSize = sizes[i];
+				size_t timeSteps = 1;
+
+				if (tmpSize.sizeW > 1)
+					timeSteps = tmpSize.sizeW;
+
+				tmpSize.sizeW = curBatchSize;
+
+				PrefetchDataBuffer<T1>(bufferIndices[i], curBuffer.data(), tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW, timeSteps);
+			}
+
+		private:
+			BackendSystem::OpenCLBackend backend;
+
+			std::vector<NNBuffer*> nnBufferList; //NNBuffers contained in the Graph
+			std::vector<NNOp*> nnOperationList;  //NNOps contained in the Graph
+			std::vector<NNBufferIdx> parameterBuffer; //ParameterBuffer contained in the Graph(Intersects with nnBufferList)
+			std::vector<InitOp*> initOpList; //InitOps used to initalize the parameters
+			std::map<NNBufferIdx, NNInputBuffer*> slotInputBuffer; //Input buffers with more than one slot (Intersects with nnBufferList)
+			std::vector<NNStateBuffer*> carriedStates; //State buffers carrying their state to the next chunk (Intersects with nnBufferList)
+
+			NNOptimizer* optimizer;
+			size_t numAuxBuffer; //Attitional Buffers of the optimizer(Momentum etc.)
+			size_t maxSteps; //Maximal number of time steps the RNN runs.
+
+			static NeuralNetwork* activeNN;
+
+			bool initialized; //True when InitSystem was called
+			bool graphInitiliazed;//True when the Graph was initalized
+
+			float* tmpDataMemory;
+			size_t maxSize;
+
+			float gradScale; //Factor the optimizer multiplies the gradients with. Read by the update operations each time they are executed.
+			size_t numMicroBatches; //Number of backward passes since the last step
+			bool parameterAccumulate; //True if the first operations writing the parameter gradients add to them
+			size_t prefetchedBatch; //Number of batch elements uploaded by the last Prefetch (Zero if it was already used)
+
+			bool mixedPrecision; //True if activations are stored as half and the loss is scaled
+			bool sequenceBatching; //True if time steps can be skipped (See SetSequenceBatching)
+			bool automaticCheckpointing; //True if all buffers supporting it are recomputed (See SetAutomaticCheckpointing)
+			std::vector<NNBufferIdx> recomputeRequests; //Buffers selected by RecomputeBuffer
+			std::vector<size_t> unitSegment; //Segment of each operation instance in the order they are instantiated (Empty if nothing is recomputed)
+			std::vector<bool> unitRecompute; //True if the operation instance writes a recomputed buffer
+			std::vector<OperationIdx> recomputeOps; //Backward operations running forward operations again
+			size_t recomputedMemory; //Bytes of the recomputed forward sub buffers and of the scratch buffer containing them
+			size_t scratchMemory;
+			float lossScale; //Initial loss scale. The current scale only exists on the device.
+			size_t lossScaleInterval; //Number of steps without overflow after which the loss scale is doubled
+			BufferIdx lossScaleBuffer; //Buffers containing the loss scale, the overflow flag and the number of steps since the last change of the scale
+			BufferIdx overflowBuffer;
+			BufferIdx goodStepsBuffer;
+			BufferIdx stepBuffer; //Number of performed updates, steps skipped because of an overflow are not counted
+
+			std::map<NNBufferIdx, float> activationRange; //Maximal absolute value of the inputs of operations with an int8 version seen during calibration
+			std::map<NNBufferIdx, QuantizedBuffer> quantizedParameter; //Parameters used by the int8 operations
+			std::vector<std::pair<OperationIdx, BackendSystem::BaseOperation*>> exchangedOps; //Forward operations exchanged by Quantize and the operations currently not used by the backend
+			bool quantized; //True if the forward pass uses the int8 operations
+			bool stepRecorded; //True if RecordTrainingStep was called. Exchanging operations discards the recorded step, it is recorded again once the float operations are restored
+
+			CheckpointWriter* checkpointWriter; //Created by the first call of SaveCheckpoint
+
+			GradientCompression gradientCompression;
+			float compressionDensity;
+			GradientCompressor* gradientCompressor; //Created by InitliazeGraph if a compression was set
+
+			std::vector<std::pair<size_t, size_t>> gradientPositions; //Position in the backward pass after which the gradient of each parameter is complete (Sorted by position)
+			size_t gradientPositionOps; //Number of backward operations when the positions were computed
+
+			NNBufferIdx CreateBuffer(const size_t sizeX, const size_t sizeY = 1, const size_t sizeZ = 1, const size_t sizeW = 1, const size_t timeSteps = 1);
+			NNBufferIdx CreateBuffer(const SizeVec size, const size_t timeSteps = 1);
+
+			//Loads the kernels after the backend was initalized.
+			DeepCLError LoadKernels();
+			//Computes the position of the last operation of the backward pass writing the gradient of each parameter.
+			void ComputeGradientPositions();
+
+			void NeuralNetwork::ReadDataBufferDirect(BufferIdx buffer, void* data, const size_t totalSize, const size_t offset);
+			//Reads totalSize elements of a buffer storing half and converts them into float.
+			void ReadHalfBuffer(BufferIdx buffer, void* data, const size_t offset, const size_t totalSize);
+			//Waits until the enqueued reads and writes finished. Transfers are not blocking in release builds.
+			void FinishTransfers();
+
+			//Basic buffer for prinitng buffers
+			template<typename T>
+			void PrintBufferBase(const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, const SizeVec& size, std::ostream& stream)
+			{
+				stream << msg << std::endl;
+
+				for (size_t i = batchOffset; i < numBatches + batchOffset; ++i)
+				{
+					for (size_t l = imgOffset; l < numImages + imgOffset; ++l)
+					{
+						for (size_t j = 0; j < size.sizeY; ++j)
+						{
+							for (size_t k = 0; k < size.sizeX; ++k)
+							{
+								stream << reinterpret_cast<T*>(tmpDataMemory)[k + size.sizeX * (j + size.sizeY * (l + size.sizeZ * i))] << " ";
+							}
+							stream << std::endl;
+						}
+						stream << std::endl;
+					}
+					stream << std::endl;
+				}
+				stream << std::endl;
+			}
+
+			//Sets the w component in each buffer to the batch size where it is necessary (Not in parameter buffers since they are independent of the batch size.)
+			void SetBatchSize(const size_t batchSize);
+			//Creates the acutal OpenCL hardware buffers.
+			void InstantiateBuffer();
+			//Lets each intermediate buffer store half if all operations reading or writing it support half.
+			void SelectHalfStorage();
+			//Splits the operation instances into segments and places the forward sub buffers of the recomputed buffers in a scratch buffer. Must be called before InstantiateBuffer.
+			void PlanRecompute();
+			//Creates the buffers used for loss scaling. They are passed to the optimizer even without mixed precision.
+			void InstantiateLossScale();
+			//Lets operations multiplying a sequence input buffer with a parameter process all time steps with their first instance.
+			void HoistTimeSteps();
+			//Calcualtes the number and size of necessary temporary buffers and creates them. Than each temporary buffer is added to operations which need them.
+			void CreateTmpBuffer();
+
+			//Creates and adds the implemented operations to the backend. The operations are added to the correct pass in the backend.
+			//It also takes care of the unrolling of RNNs in time.
+			void InstantiateOperations();
+			//Returns true if the operation is executed at the time step.
+			bool RunsAtStep(const NNOp* operation, const size_t step) const;
+			//Quantizes the parameter buffer to int8 using one scale for each channel.
+			void QuantizeParameter(const NNBufferIdx buffer, const size_t numChannels, const size_t channelStride);
+			//Returns the payload of a checkpoint blob if it exists, has the expected size and its checksum matches. Otherwise a nullptr.
+			const char* FindCheckpointBlob(const ModelFileReader& reader, const std::string& name, const size_t size) const;
+			//Unpacks a checkpoint tensor into values if it exists, has the shape of the buffer and its checksum matches.
+			bool ReadCheckpointTensor(const ModelFileReader& reader, const std::string& name, const SizeVec& shape, std::vector<float>& values) const;
+			//Perform the weight initalization operations which create some values for the parameters and transfer them to the backend.
+			void InitalizeWeights();
+
+			//Updates the timeStep variable in the buffers by one if necessary
+			void UpdateBufferTime();
+			//sets the timeStep variable in the buffers to zero.
+			void ResetBufferTime();
+
+			//Set all backward openCL hardware buffers to zero. The gradients of the parameters and of the remaining buffers can be cleared separately.
+			void ClearBackwardBuffer(const bool clearParameters = true, const bool clearActivations = true);
+
+			//Sets the barrier counters of the persistent kernels to zero. Called before each pass.
+			void ResetBarrierCounters();
+
+			//Switches the first operations writing the parameter gradients between overwriting and accumulating.
+			void SetParameterAccumulate(const bool accumulate);
+			//Set all openCL hardware buffers to zero.
+			void ClearAllBuffer();
+		};
+
+		// Functions necessary to apply transfer the data into the input buffer when variadic templates are used to insert add the data to the forward pass.
+		//Terminal/base case
+		template<size_t from, class... Ts>
+		struct UnrollFwd{
+		public:
+			inline static void apply(std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSizee, NeuralNetwork& nn)
+			{
+			}
+		};
+		//Splits of one element of the variadic template and transfers the data to the into the input buffer.
+		template<size_t from, class T1, class... Ts>
+		struct UnrollFwd < from, T1, Ts... >
+		{
+		public:
+			inline static void apply(std::vector<T1>& curBuffer, std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize, NeuralNetwork& nn)
+			{
+				nn.UnrollForward<T1>(curBuffer, bufferIndices, sizes, curBatchSize, from);
+				UnrollFwd<from + 1, Ts...>::apply(buffer..., bufferIndices, sizes, curBatchSize, nn);
+			}
+		};
+
+		//Terminal/base case for prefetching
+		template<size_t from, class... Ts>
+		struct UnrollPre{
+		public:
+			inline static void apply(std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSizee, NeuralNetwork& nn)
+			{
+			}
+		};
+		//Splits of one element of the variadic template and uploads the data into the next slot of the input buffer.
+		template<size_t from, class T1, class... Ts>
+		struct UnrollPre < from, T1, Ts... >
+		{
+		public:
+			inline static void apply(std::vector<T1>& curBuffer, std::vector<Ts>&... buffer, std::vector<NNBufferIdx>& bufferIndices, std::vector<SizeVec>& sizes, const size_t curBatchSize, NeuralNetwork& nn)
+			{
+				nn.UnrollPrefetch<T1>(curBuffer, bufferIndices, sizes, curBatchSize, from);
+				UnrollPre<from + 1, Ts...>::apply(buffer..., bufferIndices, sizes, curBatchSize, nn);
+			}
+		};
+
+		//Reads a buffer with name name out of the file file and stores it into buffer.
+		template<typename T>
+		void NeuralNetwork::ReadBufferFile(NNBufferIdx buffer, const char* name, std::fstream& file)
+		{
+			//Search for the beginning of the buffer with the name name.
+			std::string line;
+			bool found = false;
+			while (getline(file, line))
+			{
+				if (line.find(name)!=std::string::npos)
+				{
+					found = true;
+					break;
+				}
+			}
+			//Error if a buffer with the name was not found.
+			if (!found)
+			{
+				std::cerr << "name: " << name << " not found in file" << std::endl;
+				return;
+			}
+
+			//Read the buffer out of the file and transfer it into the OpenCL buffer buffer.
+			NNBuffer* nnBuffer = nnBufferList[buffer];
+			SizeVec bufferSizes = nnBuffer->size;
+
+			float* values = new float[bufferSizes.sizeX * bufferSizes.sizeY * bufferSizes.sizeZ * bufferSizes.sizeW];
+
+			file.read(reinterpret_cast<char*>(values), bufferSizes.sizeX * bufferSizes.sizeY * bufferSizes.sizeZ * bufferSizes.sizeW * sizeof(float));
+
+			WriteDataBuffer<float>(buffer, values, bufferSizes.sizeX, bufferSizes.sizeY, bufferSizes.sizeZ, bufferSizes.sizeW);
+			delete[] values;
+		}
+
+		//Writes the contents of the forward part of buffer into the file name under the specified name name.
+		template<typename T>
+		void NeuralNetwork::WriteBufferBinFile(NNBufferIdx buffer, const char* name, std::fstream& file)
+		{
+			//Read the buffer content.
+			SizeVec size = nnBufferList[buffer]->size;
+			ReadDataBuffer(buffer, reinterpret_cast<void*>(tmpDataMemory), 0);
+			//Write the name into the file.
+			file <<  name << std::endl;
+
+			NNBuffer* nnBuffer = nnBufferList[buffer];
+			SizeVec bufferSizes = nnBuffer->size;
+
+			char* dataPointer = reinterpret_cast<char*>(tmpDataMemory);
+			//Store the read buffer data into the file.
+			file.write(dataPointer, sizeof(T) * bufferSizes.sizeX* bufferSizes.sizeY* bufferSizes.sizeZ* bufferSizes.sizeW);
+
+			file << std::endl;
+		}
+
+		//Call the forward pass using two input buffers.
+		template<typename T1, typename T2>
+		DeepCLError NeuralNetwork::Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+			//Write the input into the inputBuffer
+			SizeVec tmpSize = inputSize;
+			if (tmpSize.sizeW == 1)
+				tmpSize.sizeW = curBatchSize;
+
+			WriteDataBuffer<T1>(inputBuffer, input, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
+
+			//Write the output(label) into the outputBuffer.
+			tmpSize = outputSize;
+			if (tmpSize.sizeW == 1)
+				tmpSize.sizeW = curBatchSize;
+
+			WriteDataBuffer<T2>(outputBuffer, output, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
+			
+			//Perform the forward pass only for the batch elements that were written.
+			backend.SetActiveBatch(static_cast<unsigned int>(curBatchSize));
+			backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
+
+
+			return 0;
+		}
+
+		//Call the forward pass using two input buffers. The label no contains results for the specified number of time steps.
+		template<typename T1, typename T2>
+		DeepCLError NeuralNetwork::Forward(T1* input, NNBufferIdx inputBuffer, T2* output, NNBufferIdx outputBuffer, const SizeVec& inputSize, const SizeVec& outputSize, const size_t curBatchSize, const size_t numTimeSteps)
+		{
+			if (!graphInitiliazed)
+			{
+				std::cout << "Error command queue was not build!" << std::endl;
+				return NN_GRAPH_NOT_INITIALIZED;
+			}
+
+			SizeVec tmpSize = inputSize;
+			if (tmpSize.sizeW == 1)
+				tmpSize.sizeW = curBatchSize;
+
+			WriteDataBuffer<T1>(inputBuffer, input, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW);
+
+
+			tmpSize = outputSize;
+			if (tmpSize.sizeW == 1)
+				tmpSize.sizeW = curBatchSize;
+
+			WriteDataBuffer<T2>(outputBuffer, output, tmpSize.sizeX, tmpSize.sizeY, tmpSize.sizeZ, tmpSize.sizeW, numTimeSteps);
+
+			backend.SetActiveBatch(static_cast<unsigned int>(curBatchSize));
+			backend.Run(BackendSystem::OpenCLBackend::OperationType::FORWARD);
+
+
+			return 0;
+		}
+
+		//Write some data into the by buffer specified forward buffer.
+		template<typename T>
+		void NeuralNetwork::WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset)
+		{
+			//Query the buffer and check if the sizes match.
+			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
+			NNBuffer* bufferData = nnBufferList[buffer];
+			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
+			if (totalSize + offset > bufferSize)
+			{
+				std::cout << "Error WriteDataBuffer: Out of Range" << std::endl;
+				return;
+			}
+			if (bufferData->GetInputStorage() != InputStorageOf<T>::storage)
+			{
+				std::cout << "Error WriteDataBuffer: Type doesn't match the storage of the input buffer" << std::endl;
+				return;
+			}
+
+			//Load the data into the corresponding buffer.
+			BufferIdx fwdBuffer = bufferData->ForwardBuffer();
+
+			backend.WriteDataBuffer(bufferData->ForwardBuffer(), data, offset, totalSize * sizeof(T));
+		}
+
+		//Writes data into multiple time steps of the forward buffer of buffer.
+		//Data must contain the data for the different time steps behind each other.
+		template<typename T>
+		void NeuralNetwork::WriteDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t offset, const size_t numSubBuffer)
+		{
+			//Query the buffer and check if the sizes match.
+			size_t totalSize = sizeW * sizeZ * sizeY * sizeX;
+			NNBuffer* bufferData = nnBufferList[buffer];
+			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
+
+			if (totalSize + offset > bufferSize)
+			{
+				std::cout << "Error WriteDataBuffer: Out of Range" << std::endl;
+				return;
+			}
+			if (bufferData->GetInputStorage() != InputStorageOf<T>::storage)
+			{
+				std::cout << "Error WriteDataBuffer: Type doesn't match the storage of the input buffer" << std::endl;
+				return;
+			}
+			//Load the data into the different corresponding buffers.
+			totalSize = sizeX * sizeY * sizeZ;
+			T* tmpData = new T[totalSize * sizeW];
+			std::vector<BufferIdx> localSubBuffer = bufferData->GetCompleteForwardBuffer();
+			const T* realPointer = reinterpret_cast<const T*>(data);
+			for (size_t i = 0; i < numSubBuffer; ++i)
+			{
+				for (size_t j = 0; j < sizeW; ++j)
+					for (size_t k = 0; k < totalSize; ++k)
+					{
+						tmpData[j * totalSize + k] = realPointer[k + i * totalSize + j * totalSize * numSubBuffer];
+					}
+				backend.WriteDataBuffer(localSubBuffer[i], tmpData, offset, totalSize *sizeW* sizeof(T));
+			}
+			delete[] tmpData;
+		}
+		
+		//Uploads data into the next slot of the input buffer buffer.
+		//Data must contain the data for the different time steps behind each other for each batch element.
+		template<typename T>
+		void NeuralNetwork::PrefetchDataBuffer(NNBufferIdx buffer, const T* data, const size_t sizeX, const size_t sizeY, const size_t sizeZ, const size_t sizeW, const size_t numSubBuffer)
+		{
+			std::map<NNBufferIdx, NNInputBuffer*>::iterator it = slotInputBuffer.find(buffer);
+			if (it == slotInputBuffer.end())
+			{
+				std::cout << "Error PrefetchDataBuffer: Buffer is no input buffer with multiple slots" << std::endl;
+				return;
+			}
+
+			//Query the buffer and check if the sizes match.
+			NNInputBuffer* bufferData = it->second;
+			size_t bufferSize = bufferData->size.sizeW * bufferData->size.sizeZ * bufferData->size.sizeY * bufferData->size.sizeX;
+			if (sizeW * sizeZ * sizeY * sizeX > bufferSize || numSubBuffer > bufferData->sequenceSize)
+			{
+				std::cout << "Error PrefetchDataBuffer: Out of Range" << std::endl;
+				return;
+			}
+			if (bufferData->GetInputStorage() != InputStorageOf<T>::storage)
+			{
+				std::cout << "Error PrefetchDataBuffer: Type doesn't match the storage of the input buffer" << std::endl;
+				return;
+			}
+
+			bufferData->Prefetch(backend, data, sizeX * sizeY * sizeZ * sizeof(T), sizeW, numSubBuffer);
+		}
+
+		//Checks the gradient by calculating the numerical gradient and comparing the results.
+		//After a change to the framework an error occurs sometimes which must be fixed before this can be used relably again.
+		/*
+		template <typename T1, typename T2>
+		float* NeuralNetwork::CalculateGradError(const NNBufferIdx a, const float epsilon, const NNBufferIdx error, const Batch<T1, T2>& batch, const size_t timeStep, float** gradBuffer, const size_t sX, const size_t sY, const size_t sZ, const size_t sW)
+		{
+			NNBuffer buffer = nnBufferList[a];
+			NNBuffer errorBuffer = nnBufferList[error];
+
+			size_t size =  buffer.size.sizeX * buffer.size.sizeY * buffer.size.sizeZ * buffer.size.sizeW;
+			size_t chosenSize = (sX != 0 ? sX : buffer.size.sizeX) * (sY != 0 ? sY : buffer.size.sizeY) * (sZ != 0 ? sZ : buffer.size.sizeZ) * (sW != 0 ? sW : buffer.size.sizeW);
+
+			size_t errorSize = errorBuffer.size.sizeX * errorBuffer.size.sizeY * errorBuffer.size.sizeZ * errorBuffer.size.sizeW;
+
+			float* errorBufferFloat = new float[errorSize];
+
+			float* orgBuffer = new float[size];
+			float* changedBuffer = new float[size];
+
+			float* resultBuffer = new float[size];
+
+			ReadDataBuffer(a, orgBuffer);
+
+			size_t i, j, k, l, sum;
+
+			float sumarg;
+
+			for (size_t point = 0; point < chosenSize; ++point)
+			{
+				for (i = 0; i < buffer.size.sizeW; ++i)
+					for (j = 0; j < buffer.size.sizeZ; ++j)
+						for (k = 0; k < buffer.size.sizeY; ++k)
+							for (l = 0; l < buffer.size.sizeX; ++l)
+							{
+								changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = orgBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] + ((l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))) == point ? epsilon : 0);
+							}
+
+				
+
+				WriteDataBuffer(a, changedBuffer, buffer.size.sizeX, buffer.size.sizeY, buffer.size.sizeZ, buffer.size.sizeW);
+
+				Forward<T1, T2>(batch);
+				ReadDataBuffer(error, errorBufferFloat, timeStep);
+
+
+				sumarg = 0.f;
+				for (sum = 0; sum < errorBuffer.size.sizeW; ++sum)
+					sumarg += errorBufferFloat[sum];
+				resultBuffer[point] = sumarg / static_cast<float>(errorBuffer.size.sizeW);
+
+				for (i = 0; i < buffer.size.sizeW; ++i)
+					for (j = 0; j < buffer.size.sizeZ; ++j)
+						for (k = 0; k < buffer.size.sizeY; ++k)
+							for (l = 0; l < buffer.size.sizeX; ++l)
+							{
+								changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = orgBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] - ((l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))) == point ? epsilon : 0);
+							}
+
+				WriteDataBuffer(a, changedBuffer, buffer.size.sizeX, buffer.size.sizeY, buffer.size.sizeZ, buffer.size.sizeW);
+
+				Forward<T1, T2>(batch);
+				ReadDataBuffer(error, errorBufferFloat, timeStep);
+
+				sumarg = 0.f;
+				for (sum = 0; sum < errorBuffer.size.sizeW; ++sum)
+					sumarg += errorBufferFloat[sum];
+				resultBuffer[point] -= sumarg / static_cast<float>(errorBuffer.size.sizeW);
+
+
+				if(point%100==0)
+					std::cout << point << " ";
+			}
+
+			WriteDataBuffer(a, orgBuffer, buffer.size.sizeX, buffer.size.sizeY, buffer.size.sizeZ, buffer.size.sizeW);
+
+			Forward<T1, T2>(batch);
+			Backward();
+
+			ReadDataBufferGrad(a, changedBuffer);
+
+
+
+			for (i = 0; i < buffer.size.sizeW; ++i)
+				for (j = 0; j < buffer.size.sizeZ; ++j)
+					for (k = 0; k < buffer.size.sizeY; ++k)
+						for (l = 0; l < buffer.size.sizeX; ++l)
+						{
+							resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] / (2.f*epsilon);
+						}
+
+			for (i = 0; i < buffer.size.sizeW; ++i)
+				for (j = 0; j < buffer.size.sizeZ; ++j)
+					for (k = 0; k < buffer.size.sizeY; ++k)
+						for (l = 0; l < buffer.size.sizeX; ++l)
+						{
+							resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] = abs(changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))] - resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))]) / max(abs(changedBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))]), abs(resultBuffer[l + buffer.size.sizeX * (k + buffer.size.sizeY * (j + buffer.size.sizeZ * i))]));
+						}
+
+			delete[] errorBufferFloat;
+			delete[] orgBuffer;
+
+			*gradBuffer = changedBuffer;
+
+			std::cout << std::endl;
+
+			return resultBuffer;
+		}
+		*/
+
+		//Functions for printing buffers like the normal buffers for different time steps using time, the Momentum buffers, gradient buffers an so on.
+		//All functions read the data and then print it using a basic print function called printBufferBase.
+		template<typename T>
+		void NeuralNetwork::PrintBuffer(NNBufferIdx buffer, const char* msg, std::ostream& stream, const size_t time)
+		{
+			SizeVec size = nnBufferList[buffer]->size;
+			ReadDataBuffer(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
+
+			PrintBufferBase<T>(msg, size.sizeZ, size.sizeW, 0, 0, size, stream);
+		}
+
+		template<typename T>
+		void NeuralNetwork::PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, std::ostream& stream)
+		{
+			SizeVec size = nnBufferList[buffer]->size;
+			NNBuffer* locBuffer= reinterpret_cast<NNBuffer*>(nnBufferList[buffer]);
+			size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW;
+
+			ReadDataBufferDirect(locBuffer->ForwardBuffer(num), reinterpret_cast<void*>(tmpDataMemory), totalSize, 0);
+
+			PrintBufferBase<T>(msg, size.sizeZ, size.sizeW, 0, 0, size, stream);
+		}
+
+		template<typename T>
+		void NeuralNetwork::PrintMomentumBuffer(NNBufferIdx buffer, const char* msg, const size_t num, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, std::ostream& stream)
+		{
+			SizeVec size = nnBufferList[buffer]->size;
+			NNBuffer* locBuffer = reinterpret_cast<NNBuffer*>(nnBufferList[buffer]);
+			size_t totalSize = size.sizeX * size.sizeY * size.sizeZ * size.sizeW;
+
+			ReadDataBufferDirect(locBuffer->ForwardBuffer(num), reinterpret_cast<void*>(tmpDataMemory), totalSize, 0);
+
+			PrintBufferBase<T>(msg, numImages, numBatches, imgOffset, batchOffset, size, stream);
+		}
+
+		template<typename T>
+		void NeuralNetwork::PrintBufferGrad(NNBufferIdx buffer, const char* msg, std::ostream& stream, const size_t time)
+		{
+			SizeVec size = nnBufferList[buffer]->size;
+			ReadDataBufferGrad(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
+
+			PrintBufferBase<T>(msg, size.sizeZ, size.sizeW, 0, 0, size, stream);
+		}
+
+		template<typename T>
+		void NeuralNetwork::PrintBuffer(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, std::ostream& stream, const size_t time)
+		{
+			SizeVec size = nnBufferList[buffer]->size;
+			ReadDataBuffer(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
+
+			PrintBufferBase<T>(msg, numImages, numBatches, imgOffset, batchOffset, size, stream);
+		}
+
+		template<typename T>
+		void NeuralNetwork::PrintBufferGrad(NNBufferIdx buffer, const char* msg, const size_t numImages, const size_t numBatches, const size_t imgOffset, const size_t batchOffset, std::ostream& stream, const size_t time)
+		{
+			SizeVec size = nnBufferList[buffer]->size;
+			ReadDataBufferGrad(buffer, reinterpret_cast<void*>(tmpDataMemory), time);
+
+			PrintBufferBase<T>(msg, numImages, numBatches, imgOffset, batchOffset, size, stream);
+		}
+	}
+}
+
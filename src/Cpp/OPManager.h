@@ -1,88 +1,101 @@
-#pragma once
-
-#include "NNOptimizer.h"
-#include "WeightInitOp.h"
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-		class NeuralNetwork;
-
-		class OPManager
-		{
-		public:
-			OPManager();
-			~OPManager();
-
-			//Allows the creation of different Functions.
-			static NNBufferIdx Multiply(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
-			static NNBufferIdx MultiplyFlattened(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
-			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const NNConvOp::ConvType convType, const size_t timeOffset = 0);
-			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const int pad, const size_t timeOffset = 0);
-			static NNBufferIdx MultiplyElemWise(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
-
-			static NNBufferIdx ReLU(const NNBufferIdx a, const size_t timeOffset = 0);
-			static NNBufferIdx Sigmoid(const NNBufferIdx a, const size_t timeOffset = 0);
-			static NNBufferIdx Tanh(const NNBufferIdx a, const size_t timeOffset = 0);
-			static NNBufferIdx Softmax(const NNBufferIdx input, const size_t timeOffset = 0);
-			//NNBufferIdx Transpose(const NNBufferIdx a);
-			static NNBufferIdx SquaredError(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
-			static NNBufferIdx CrossEntropy(const NNBufferIdx a, const NNBufferIdx label, const size_t timeOffset = 0);
-			static NNBufferIdx ClassificationReward(const NNBufferIdx a, const NNBufferIdx y, const size_t timeOffset = 0);
-			static NNBufferIdx AddBias(const NNBufferIdx input, const NNBufferIdx bias, const size_t timeOffset = 0);
-			static NNBufferIdx AddBiasConv(const NNBufferIdx input, const NNBufferIdx bias, const size_t timeOffset = 0);
-			static NNBufferIdx Add(const NNBufferIdx a, const NNBufferIdx b, const size_t timeResult = 0, const size_t timeOffset = 0);
-			static NNBufferIdx SubConst(const NNBufferIdx a, const float constant, const size_t timeOffset = 0);
-			static NNBufferIdx MaxPooling(const NNBufferIdx input, const int padX, const int padY, const int stride, const int size, const size_t timeOffset = 0);
-
-			static NNBufferIdx Split(const NNBufferIdx a, const int w, const int h, const size_t timeOffset = 0);
-
-			//Functions which allow the result buffer to be an already existing buffer but an other time step.
-			static NNBufferIdx Multiply(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx MultiplyFlattened(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const NNBufferIdx result, const NNConvOp::ConvType convType, const size_t timeOffset);
-			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const NNBufferIdx result, const int pad, const size_t timeOffset);
-			static NNBufferIdx MultiplyElemWise(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
-
-			static NNBufferIdx ReLU(const NNBufferIdx a, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx Sigmoid(const NNBufferIdx a, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx Tanh(const NNBufferIdx a, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx Softmax(const NNBufferIdx input, const NNBufferIdx result, const size_t timeOffset);
-			//NNBufferIdx Transpose(const NNBufferIdx a);
-			static NNBufferIdx SquaredError(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx CrossEntropy(const NNBufferIdx a, const NNBufferIdx label, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx AddBias(const NNBufferIdx input, const NNBufferIdx bias, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx AddBiasConv(const NNBufferIdx input, const NNBufferIdx bias, const NNBufferIdx result, const size_t timeOffset);
-			static NNBufferIdx Add(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeResult, const size_t timeOffset);
-			static NNBufferIdx SubConst(const NNBufferIdx a, const NNBufferIdx result, const float constant, const size_t timeOffset);
-			static NNBufferIdx MaxPooling(const NNBufferIdx input, const NNBufferIdx result, const int padX, const int padY, const int stride, const int size, const size_t timeOffset);
-
-			static NNBufferIdx Copy(const NNBufferIdx a, const NNBufferIdx result, const size_t timeResult, const size_t timeOffset);
-
-			static NNBufferIdx Split(const NNBufferIdx a, const NNBufferIdx result, const int w, const int h, const size_t timeOffset);
-
-			static NNBufferIdx GRUUnit(const NNBufferIdx a, const NNBufferIdx s, const NNBufferIdx Uz, const NNBufferIdx Ur, const NNBufferIdx Uh, const NNBufferIdx Wz, const NNBufferIdx Wr, const NNBufferIdx Wh, const NNBufferIdx Bz, const NNBufferIdx Br, const NNBufferIdx Bh);
-			static NNBufferIdx CopyInit(const NNBufferIdx a, const NNBufferIdx s);
-
-			//Sets the NerualNetwork object to which all operations and buffer will be added.
-			static void SetActiveNN(NeuralNetwork* nn);
-
-			//Functions for adding initlizer operations that will initalize parameter buffers.
-			static void InitWeightUniformRnd(const NNBufferIdx w, const float minValue, const float maxValue);
-			static void InitWeightUniform(const NNBufferIdx w, const float value);
-			static void InitWeightNormalRnd(const NNBufferIdx w, const float mean = 0.0f, const float stddev = 1.0f);
-			static void InitWeightTruncatedNormalRnd(const NNBufferIdx w, const float mean = 0.0f, const float stddev = 1.0f);
-			static void InitWeightTruncatedNormalXavier(const NNBufferIdx w, const float mean = 0.0f);
-
-		private:
-			//The NeuralNetwork object to which the operations and buffers will be added
-			static NeuralNetwork* activeNN;
-		};
-	}
-
-	typedef NNSystem::OPManager OP;
-}
-
-
-#include "NeuralNetwork.h"
+#pragma once
+
+#include "NNOptimizer.h"
+#include "WeightInitOp.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		class NeuralNetwork;
+
+		class OPManager
+		{
+		public:
+			OPManager();
+			~OPManager();
+
+			//Allows the creation of different Functions.
+			static NNBufferIdx Multiply(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
+			static NNBufferIdx MultiplyFlattened(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
+			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const NNConvOp::ConvType convType, const size_t timeOffset = 0);
+			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const int pad, const size_t timeOffset = 0);
+			static NNBufferIdx MultiplyElemWise(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
+
+			static NNBufferIdx ReLU(const NNBufferIdx a, const size_t timeOffset = 0);
+			static NNBufferIdx Sigmoid(const NNBufferIdx a, const size_t timeOffset = 0);
+			static NNBufferIdx Tanh(const NNBufferIdx a, const size_t timeOffset = 0);
+			static NNBufferIdx Softmax(const NNBufferIdx input, const size_t timeOffset = 0);
+			//NNBufferIdx Transpose(const NNBufferIdx a);
+			static NNBufferIdx SquaredError(const NNBufferIdx a, const NNBufferIdx b, const size_t timeOffset = 0);
+			static NNBufferIdx CrossEntropy(const NNBufferIdx a, const NNBufferIdx label, const size_t timeOffset = 0);
+			static NNBufferIdx ClassificationReward(const NNBufferIdx a, const NNBufferIdx y, const size_t timeOffset = 0);
+			//Index of the largest value of each example (Stored as int).
+			static NNBufferIdx Argmax(const NNBufferIdx a, const size_t timeOffset = 0);
+			//One for each example whose label is among the k largest values of a (Top-k accuracy), zero otherwise. The number of correct examples is also counted on the device
+			//over all forward passes until NeuralNetwork::ResetCorrect is called.
+			static NNBufferIdx CountCorrect(const NNBufferIdx a, const NNBufferIdx label, const size_t k = 1, const size_t timeOffset = 0);
+			//Random augmentation of the images in a on the device (See NNAugmentOp). Should be applied directly to an input buffer.
+			static NNBufferIdx Augment(const NNBufferIdx a, const AugmentParams& params, const unsigned int seed, const size_t timeOffset = 0);
+			//Converts an input buffer storing a compact type into float and normalizes each channel (See NNDequantizeOp).
+			static NNBufferIdx Dequantize(const NNBufferIdx a, const float scale, const std::vector<float>& mean = std::vector<float>(), const std::vector<float>& stddev = std::vector<float>(), const size_t timeOffset = 0);
+			static NNBufferIdx AddBias(const NNBufferIdx input, const NNBufferIdx bias, const size_t timeOffset = 0);
+			static NNBufferIdx AddBiasConv(const NNBufferIdx input, const NNBufferIdx bias, const size_t timeOffset = 0);
+			static NNBufferIdx Add(const NNBufferIdx a, const NNBufferIdx b, const size_t timeResult = 0, const size_t timeOffset = 0);
+			static NNBufferIdx SubConst(const NNBufferIdx a, const float constant, const size_t timeOffset = 0);
+			static NNBufferIdx MaxPooling(const NNBufferIdx input, const int padX, const int padY, const int stride, const int size, const size_t timeOffset = 0);
+
+			static NNBufferIdx Split(const NNBufferIdx a, const int w, const int h, const size_t timeOffset = 0);
+
+			//Functions which allow the result buffer to be an already existing buffer but an other time step.
+			static NNBufferIdx Multiply(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx MultiplyFlattened(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const NNBufferIdx result, const NNConvOp::ConvType convType, const size_t timeOffset);
+			static NNBufferIdx Conv2d(const NNBufferIdx a, const NNBufferIdx kernel, const NNBufferIdx result, const int pad, const size_t timeOffset);
+			static NNBufferIdx MultiplyElemWise(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
+
+			static NNBufferIdx ReLU(const NNBufferIdx a, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx Sigmoid(const NNBufferIdx a, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx Tanh(const NNBufferIdx a, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx Softmax(const NNBufferIdx input, const NNBufferIdx result, const size_t timeOffset);
+			//NNBufferIdx Transpose(const NNBufferIdx a);
+			static NNBufferIdx SquaredError(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx CrossEntropy(const NNBufferIdx a, const NNBufferIdx label, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx AddBias(const NNBufferIdx input, const NNBufferIdx bias, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx AddBiasConv(const NNBufferIdx input, const NNBufferIdx bias, const NNBufferIdx result, const size_t timeOffset);
+			static NNBufferIdx Add(const NNBufferIdx a, const NNBufferIdx b, const NNBufferIdx result, const size_t timeResult, const size_t timeOffset);
+			static NNBufferIdx SubConst(const NNBufferIdx a, const NNBufferIdx result, const float constant, const size_t timeOffset);
+			static NNBufferIdx MaxPooling(const NNBufferIdx input, const NNBufferIdx result, const int padX, const int padY, const int stride, const int size, const size_t timeOffset);
+
+			static NNBufferIdx Copy(const NNBufferIdx a, const NNBufferIdx result, const size_t timeResult, const size_t timeOffset);
+
+			static NNBufferIdx Split(const NNBufferIdx a, const NNBufferIdx result, const int w, const int h, const size_t timeOffset);
+
+			static NNBufferIdx GRUUnit(const NNBufferIdx a, const NNBufferIdx s, const NNBufferIdx Uz, const NNBufferIdx Ur, const NNBufferIdx Uh, const NNBufferIdx Wz, const NNBufferIdx Wr, const NNBufferIdx Wh, const NNBufferIdx Bz, const NNBufferIdx Br, const NNBufferIdx Bh);
+			//Fused GRU cell computing the same function as GRUUnit (See NNGRUOp). U (3 * state size, flattened input size), W (3 * state size, state size) and B (3 * state size) contain the weights
+			//of the update, reset and candidate gate behind each other in each row. s must be a state buffer whose first sub buffer contains the initial state.
+			//persistent runs all time steps of a pass with one kernel keeping the recurrent weights in local memory (Intended for small state sizes).
+			static NNBufferIdx GRU(const NNBufferIdx a, const NNBufferIdx s, const NNBufferIdx U, const NNBufferIdx W, const NNBufferIdx B, const bool persistent = false, const size_t timeOffset = 0);
+			static NNBufferIdx CopyInit(const NNBufferIdx a, const NNBufferIdx s);
+
+			//Sets the NerualNetwork object to which all operations and buffer will be added.
+			static void SetActiveNN(NeuralNetwork* nn);
+
+			//Functions for adding initlizer operations that will initalize parameter buffers.
+			static void InitWeightUniformRnd(const NNBufferIdx w, const float minValue, const float maxValue);
+			static void InitWeightUniform(const NNBufferIdx w, const float value);
+			static void InitWeightNormalRnd(const NNBufferIdx w, const float mean = 0.0f, const float stddev = 1.0f);
+			static void InitWeightTruncatedNormalRnd(const NNBufferIdx w, const float mean = 0.0f, const float stddev = 1.0f);
+			static void InitWeightTruncatedNormalXavier(const NNBufferIdx w, const float mean = 0.0f);
+
+		private:
+			//The NeuralNetwork object to which the operations and buffers will be added
+			static NeuralNetwork* activeNN;
+		};
+	}
+
+	typedef NNSystem::OPManager OP;
+}
+
+
+#include "NeuralNetwork.h"
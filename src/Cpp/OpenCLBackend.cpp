@@ -1,499 +1,1672 @@
-#include "OpenCLBackend.h"
-#include "KernelLoader.h"
-#include "Defines.h"
-
-#include <algorithm>
-
-namespace DeepCL
-{
-	namespace BackendSystem
-	{
-		OpenCLBackend::OpenCLBackend() :
-			kernels(), timingEvent(), namesToSources(), kernelTypesToIdx(), needsToCreate()
-		{
-		}
-
-
-		OpenCLBackend::~OpenCLBackend()
-		{
-			//Deletion of the created memory objects.
-			//The backend has the task to destroy its operations, kernels, etc.
-			size_t i;
-			size_t size;
-			size = forwardList.size();
-			for (i = 0; i < size; ++i)
-				delete forwardList[i];
-			size = backwardList.size();
-			for (i = 0; i < size; ++i)
-				delete backwardList[i];
-			size = updateList.size();
-			for (i = 0; i < size; ++i)
-				delete updateList[i];
-			size = kernels.size();
-			for (i = 0; i < size; ++i)
-				delete kernels[i];
-		}
-
-		DeepCLError OpenCLBackend::LoadKernel(const std::string& kernelFile)
-		{
-
-			//Load kernels from file
-			std::string* kernelCode = KernelLoader::LoadKernel(kernelFile);
-			if (kernelCode->compare("ERROR") == 0)
-			{
-				delete kernelCode;
-				return -1;
-			}
-
-			size_t bracketPos;
-
-			std::vector <size_t> kernelPositions;
-
-			size_t foundPos = kernelCode->find("void kernel", 0);
-
-			//Search for all kernels contained in the file and store the beginning of the source of each kernel in kernelPositions
-			while (foundPos != std::string::npos)
-			{
-				kernelPositions.push_back(foundPos);
-				foundPos = kernelCode->find("void kernel", foundPos + 11);
-			}
-
-			//Extract the name of each Kernel Object in the file.
-			//The name and source code is then stored in namesToSources
-			size_t numKernels = kernelPositions.size();
-			std::string kernelName;
-			std::string kernelSubString;
-			for (size_t i = 0; i < numKernels; ++i)
-			{
-				bracketPos = kernelCode->find('(', kernelPositions[i]);
-				kernelName.assign(*kernelCode, (kernelPositions[i] + 12), bracketPos - (kernelPositions[i] + 12));
-				kernelSubString = kernelCode->substr(kernelPositions[i], (i + 1 < numKernels ? kernelPositions[i + 1] : kernelCode->length()) - kernelPositions[i]);
-				namesToSources.insert(std::pair<std::string, std::string>(kernelName, kernelSubString));
-			}
-
-			return 0;
-
-		}
-
-		DeepCLError OpenCLBackend::LoadKernelFromConfig(const std::string& configFilePath, const std::string& kernelPath)
-		{
-			//Load the names of all kernel files
-			std::vector<std::string>* kernelFiles = KernelLoader::LoadKernelConfig(configFilePath);
-			size_t size = kernelFiles->size();
-			if (size == 0)
-				return 1;
-			//Iterate over all kernel files and load it
-			size_t error;
-			for (size_t i = 0; i < size; ++i)
-			{
-				error = LoadKernel(kernelPath + (*kernelFiles)[i]);
-				if (error != 0)
-					return error;
-			}
-
-			return 0;
-		}
-
-		DeepCLError OpenCLBackend::InitGPU()
-		{
-			std::cout << "OpenCL Deep Learning Project" << std::endl << std::endl;
-			
-			//Retrieve all avilable Platforms
-			std::vector<cl::Platform> platforms;
-			cl::Platform::get(&platforms);
-
-			size_t platformsSize = platforms.size();
-
-			if (platformsSize == 0)
-			{
-				std::cout << "Error no OpenCL platforms found!" << std::endl;
-				system("PAUSE");
-				return -1;
-			}
-
-			std::cout << "Available platforms: " << std::endl;
-
-			for (size_t i = 0; i < platformsSize; ++i)
-			{
-				std::cout << i << " " << platforms[i].getInfo<CL_PLATFORM_NAME>() << std::endl;
-			}		
-
-			std::cout << std::endl;
-
-			std::vector<cl::Device>();
-
-			//Let user choose the Platform
-			size_t platformChoosenIdx;
-			bool platformChoosen = false;
-
-			while (!platformChoosen)
-			{
-				std::cout << "Choose platform\t";
-				std::cin >> platformChoosenIdx;
-
-				platformChoosen = platformsSize > platformChoosenIdx;
-			}
-
-			std::cout << std::endl << std::endl;
-
-			platform = platforms[platformChoosenIdx];
-
-			//query all avialbe devices
-			std::vector<cl::Device> devices;
-
-			platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
-
-			platformsSize = devices.size();
-
-			if (platformsSize == 0)
-			{
-				std::cout << "Error no OpenCL devices found!" << std::endl;
-				system("PAUSE");
-				return -1;
-			}
-
-			std::cout << "Available devices: "<< std::endl;
-
-			for (size_t i = 0; i < platformsSize; ++i)
-			{
-				std::cout << i << " " << devices[i].getInfo<CL_DEVICE_NAME>() << std::endl;
-			}
-
-			std::cout << std::endl;
-
-			platformChoosen = false;
-
-
-			//Let the user choose a device
-			while (!platformChoosen)
-			{
-				std::cout << "Choose device \t";
-				std::cin >> platformChoosenIdx;
-
-				platformChoosen = platformsSize > platformChoosenIdx;
-			}
-
-			std::cout << std::endl;
-
-			device = devices[platformChoosenIdx];
-
-			//Some meta information of the device
-			std::cout << "Choosen device: \t" << device.getInfo<CL_DEVICE_NAME>() << std::endl;
-			std::cout << "Memory on Device: \t" << device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() << std::endl;
-			std::cout << "Local Memory available on device: \t" << device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>() << std::endl << std::endl;
-			
-			baseAddrAllign = device.getInfo< CL_DEVICE_MEM_BASE_ADDR_ALIGN >();
-
-			//Create a context for the device
-			context = cl::Context({ device });
-
-
-			//Create a OpenCL commandqueue either with profiling enabled or not
-#ifdef PROFILING_ENABLED
-			comQueue = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE);
-#else 
-			comQueue = cl::CommandQueue(context, device, 0);
-#endif
-
-			return 0;
-		}
-
-
-		KernelIdx OpenCLBackend::GetKernelIdx(const std::string& fileName)
-		{
-			//Check if the kernel already exists if it does return the kernel
-			std::map<std::string, KernelIdx>::iterator it = kernelTypesToIdx.find(fileName);
-			if (it == kernelTypesToIdx.end())
-			{
-				//Check if source code for the kernel is available
-				if (namesToSources.find(fileName) == namesToSources.end())
-				{
-					std::cerr << "Error kernel: " << fileName << " does not exist" << std::endl;
-					return MAX_UNSIGNED_INT;
-				}
-
-				//create a placeholder kernel and in the kernel vector
-				KernelIdx idx = kernels.size();
-
-				//Add the kernel to needsToCreate to create the kernel at an later point
-				needsToCreate[idx] = fileName;
-				kernels.push_back(nullptr);
-				kernelTypesToIdx[fileName] = idx;
-				return idx;
-			}
-
-			return it->second;
-		}
-
-		KernelIdx OpenCLBackend::GetKernelIdx(const std::string& fileName, const std::string& compileDefines)
-		{
-			//The same as before but this time wiht additional defines for the OpenCL compiler
-			//The kernel is stored in combination with the compiler defines
-			std::map<std::string, KernelIdx>::iterator it = kernelTypesToIdx.find(fileName+compileDefines);
-			if (it == kernelTypesToIdx.end())
-			{
-				if (namesToSources.find(fileName) == namesToSources.end())
-				{
-					std::cerr << "Error kernel: " << fileName << " does not exist" << std::endl;
-					return MAX_UNSIGNED_INT;
-				}
-
-				//Extract all defines
-				std::vector<size_t> defines;
-				defines.push_back(0);
-				size_t spacePos = 0;
-				
-				while (true)
-				{
-					spacePos = compileDefines.find(" ", spacePos + 1);
-					
-					if (spacePos == std::string::npos)
-						break;
-					else
-						++spacePos;
-					defines.push_back(spacePos);
-				}
-				
-				std::string fullStrings = fileName+"!";
-
-				//Create a list of defines that can be pussed to the OpenCL compiler
-				size_t numDefines = defines.size();
-				for (size_t i = 0; i < numDefines; ++i)
-					fullStrings += "-D" + compileDefines.substr(defines[i], (i + 1 < numDefines ? defines[i + 1] -1: compileDefines.length()) - defines[i]) + " ";
-
-				//Create placeholder etc.
-				KernelIdx idx = kernels.size();
-				needsToCreate[idx] = fullStrings;
-				kernels.push_back(nullptr);
-				kernelTypesToIdx[fileName+compileDefines] = idx;
-				return idx;
-			}
-
-			return it->second;
-		}
-
-
-		void OpenCLBackend::CreateIfNecessary(const KernelIdx kernelIdx)
-		{
-			// check if Kernel needs to be created
-			std::map<KernelIdx, std::string>::iterator it = needsToCreate.find(kernelIdx);
-			if (it != needsToCreate.end())
-			{
-				//Retrieve kernel name and compile time parameters
-				std::string fileNameAdded = it->second;
-
-				size_t idx = fileNameAdded.find("!");
-				std::string kernelName;
-				std::string arguments;
-				if (idx == std::string::npos)
-				{
-					kernelName = fileNameAdded;
-					arguments = "";
-				}
-				else
-				{
-					kernelName = fileNameAdded.substr(0, idx);
-					arguments = fileNameAdded.substr(idx + 1, fileNameAdded.size() - idx);
-				}
-
-				//Compile the kernel object using the arguments
-				BuildSingleKernel(kernelName, arguments, kernelIdx);
-				//Kernel was created and doesn't need to be created anymore
-				needsToCreate.erase(kernelIdx);
-			}
-		}
-
-		void OpenCLBackend::BuildSingleKernel(const std::string& kernelName, const std::string& defineArguments, const KernelIdx kernelIdx)
-		{
-			//Create a new program with the sourcecode of kernelName
-			size_t idx = programList.size();
-			programList.push_back(cl::Program(context, namesToSources[kernelName]));
-
-			//Create Compile time arguments. Allows possible optimization to be enabled.
-			std::string compileArguments = "";//"-cl-mad-enable -cl-fast-relaxed-math ";
-			compileArguments += defineArguments;
-
-			//Compile program
-			if (programList[idx].build({ device }, compileArguments.c_str()) != CL_SUCCESS)
-			{
-				std::cerr << "Error building: " << programList[idx].getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
-				return;
-			}
-			//Extract kernel object and store it in kernels at the correct position
-			kernels[kernelIdx] = new cl::Kernel(programList[idx], kernelName.c_str());
-		}
-
-		
-		void OpenCLBackend::Run(const OperationType opType)
-		{
-			//query the vector specified by opList (FORWARD, BACKWARD or UPDATE)
-			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
-			size_t size = opList->size();
-
-			//Stores the execution time for each operation in the corresponding pass
-#ifdef PROFILING_ENABLED
-			std::vector<cl_ulong>* opTimes = (opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime));
-#endif		
-			
-			//Run the operations in the vector starting at the end
-			if (opType == OperationType::BACKWARD)
-				RunBackward(opList, 
-#ifdef PROFILING_ENABLED
-					opTimes,
-#endif // PROFILING_ENABLED
-					size);
-
-			//Run the operations in the vector starting at the begninning
-			else
-				RunForward(opList, 
-#ifdef PROFILING_ENABLED
-					opTimes,
-#endif // PROFILING_ENABLED 
-					size);
-
-			//Wait for operations to finish (Maybe remove this statemend and wait only when absolutely necessary
-			timingEvent.wait();
-		}
-
-
-		void OpenCLBackend::RunForward(std::vector<BaseOperation*>* opList, 
-#ifdef PROFILING_ENABLED
-			std::vector<cl_ulong>* opTimes,
-#endif // PROFILING_ENABLED
-			const size_t size)
-		{
-			//Enque each operation in the openCL queue
-			for (size_t i = 0; i < size; ++i)
-			{
-				(*opList)[i]->Run(comQueue, &timingEvent, bufferList);
-
-				//Calculate the execution time of the operation(Reduces spead of execution)
-#ifdef PROFILING_ENABLED
-				cl_ulong timeStart, timeEnd;
-				timingEvent.wait();
-				timeStart = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
-				timeEnd = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
-				(*opTimes)[i] = timeEnd - timeStart;
-#endif
-			}
-#ifdef _DEBUG
-			cl_int err = comQueue.finish();
-			if (err != CL_SUCCESS)
-				std::cout << "Error in execution of commands in queue: " << err << std::endl;
-#endif // DEBUG
-		}
-
-		void OpenCLBackend::RunBackward(std::vector<BaseOperation*>* opList, 
-#ifdef PROFILING_ENABLED
-			std::vector<cl_ulong>* opTimes,
-#endif // PROFILING_ENABLED
-			const size_t size)
-		{
-			//Enqueue each operation in the OpenCL queue starting at the end
-			for (size_t i = size - 1; i < size; --i)
-			{
-				(*opList)[i]->Run(comQueue, &timingEvent, bufferList);
-
-				//Calculate the execution time of the operation(Reduces spead of execution)
-#ifdef PROFILING_ENABLED
-				cl_ulong timeStart, timeEnd;
-				timingEvent.wait();
-				timeStart = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
-				timeEnd = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
-				(*opTimes)[i] = timeEnd - timeStart;
-#endif
-			}
-
-#ifdef _DEBUG
-			cl_int err = comQueue.finish();
-			if (err != CL_SUCCESS)
-				std::cout << "Error in execution of commands in queue: " << err << std::endl;
-#endif
-		}
-
-#ifdef PROFILING_ENABLED
-		unsigned long long OpenCLBackend::GetTime( const OperationIdx opIdx, const OperationType opType)
-		{
-			//Return the time of the operation
-			std::vector<cl_ulong>* opTimes = (opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime));
-			return (*opTimes)[opIdx];
-		}
-#endif
-
-		BufferIdx OpenCLBackend::CreateBuffer(const size_t size, const MEM_FLAG memFlag, const size_t numSubBuffer)
-		{
-
-			cl_mem_flags memFlagCL = memFlag == MEM_FLAG::READ_WRITE ? CL_MEM_READ_WRITE : (memFlag == MEM_FLAG::WRITE_ONLY ? CL_MEM_WRITE_ONLY : CL_MEM_READ_ONLY);
-			size_t paddedSize = size;
-			//Calculate the correct size of the buffer including the necessary memory alignment
-			paddedSize = baseAddrAllign*((size + baseAddrAllign-1) / baseAddrAllign)*numSubBuffer;
-
-			//Create a new OpenCL buffer object and store it in the bufferList. The index of the buffer is returned at the end
-#ifdef _DEBUG
-			cl_int err;
-			bufferList.push_back(cl::Buffer(context, memFlagCL, paddedSize, nullptr, &err));
-			if (err != CL_SUCCESS)
-				std::cout << "Error create Buffer: " << err << std::endl;
-#else
-			bufferList.push_back(cl::Buffer(context, memFlagCL, paddedSize));
-#endif // DEBUG
-			return bufferList.size() - 1;
-		}
-
-	
-		BufferIdx OpenCLBackend::CreateSubBuffer(const BufferIdx bufferIdx, const size_t size, const MEM_FLAG memFlag, const size_t idxBuffer)
-		{
-			cl_mem_flags memFlagCL = memFlag == MEM_FLAG::READ_WRITE ? CL_MEM_READ_WRITE : (memFlag == MEM_FLAG::WRITE_ONLY ? CL_MEM_WRITE_ONLY : CL_MEM_READ_ONLY);
-			
-			//calculate the correct offset incorporating the necessary memory alignment
-			size_t paddOffset = baseAddrAllign*((size + baseAddrAllign-1) / baseAddrAllign) * idxBuffer;
-			cl_buffer_region region = { paddOffset, size };
-
-			//Create a sub buffer using the by bufferIdx specified OpenCL buffer
-#ifdef _DEBUG
-			cl_int err;
-			bufferList.push_back(bufferList[bufferIdx].createSubBuffer(memFlagCL, CL_BUFFER_CREATE_TYPE_REGION, static_cast<void*>(&region), &err));
-			if (err != CL_SUCCESS)
-				std::cout << "Error create SubBuffer: " << err << std::endl;
-#else
-			bufferList.push_back(bufferList[bufferIdx].createSubBuffer(memFlagCL, CL_BUFFER_CREATE_TYPE_REGION, static_cast<void*>(&region)));
-#endif // DEBUG
-			return bufferList.size() - 1;
-		}
-		
-		void OpenCLBackend::WriteDataBuffer(BufferIdx idx, const void* data, const size_t offset, const size_t size)
-		{
-#ifdef _DEBUG
-			cl_int err = comQueue.enqueueWriteBuffer((bufferList[idx]), CL_TRUE, offset, size, data);
-			if (err != CL_SUCCESS)
-				std::cout << "Error write buffer: " << err << std::endl;
-#else
-			comQueue.enqueueWriteBuffer((bufferList[idx]), CL_FALSE, offset, size, data);
-#endif // DEBUG
-		}
-
-		void OpenCLBackend::ReadDataBuffer(BufferIdx idx, void* data, const size_t offset, const size_t size)
-		{
-#ifdef _DEBUG
-			cl_int err = comQueue.enqueueReadBuffer(bufferList[idx], CL_TRUE, offset, size, data);
-			if (err != CL_SUCCESS)
-				std::cout << "Error read buffer: " << err << std::endl;
-#else
-			comQueue.enqueueReadBuffer(bufferList[idx], CL_FALSE, offset, size, data);
-#endif // DEBUG
-		}
-
-		void OpenCLBackend::ResetBuffer(BufferIdx idx, const size_t size)
-		{
-			cl_float pattern = 0;
-			//Fill Buffer with zeros. if necessary second function with arbitrary pattern can be created
-#ifdef _DEBUG
-			cl_int err = comQueue.enqueueFillBuffer<cl_float>(bufferList[idx], pattern, 0, size);
-			if (err != CL_SUCCESS)
-				std::cout << "Error read buffer: " << err << std::endl;
-#else
-			comQueue.enqueueFillBuffer(bufferList[idx], pattern, 0, size);
-#endif // DEBUG
-		}
-	}
-}
+#include "OpenCLBackend.h"
+#include "KernelLoader.h"
+#include "Defines.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace DeepCL
+{
+	namespace BackendSystem
+	{
+		OpenCLBackend::OpenCLBackend() :
+			kernels(), timingEvent(), namesToSources(), namesToHeaders(), kernelTypesToIdx(), needsToCreate(), numQueues(1), recording(false), replayPending(false), maxBatch(1), activeBatch(1),
+			stepBatch(), stepLimits(), currentStep(MAX_UNSIGNED_INT)
+		{
+			recordedSizes[0] = recordedSizes[1] = recordedSizes[2] = 0;
+#ifdef cl_khr_command_buffer
+			commandBufferSupported = false;
+#endif // cl_khr_command_buffer
+		}
+
+
+		OpenCLBackend::~OpenCLBackend()
+		{
+			//Deletion of the created memory objects.
+			//The backend has the task to destroy its operations, kernels, etc.
+			size_t i;
+			size_t size;
+			size = forwardList.size();
+			for (i = 0; i < size; ++i)
+				delete forwardList[i];
+			size = backwardList.size();
+			for (i = 0; i < size; ++i)
+				delete backwardList[i];
+			size = updateList.size();
+			for (i = 0; i < size; ++i)
+				delete updateList[i];
+			size = standaloneList.size();
+			for (i = 0; i < size; ++i)
+				delete standaloneList[i];
+			size = kernels.size();
+			for (i = 0; i < size; ++i)
+				delete kernels[i];
+#ifdef cl_khr_command_buffer
+			ReleaseCommandBuffers();
+#endif // cl_khr_command_buffer
+		}
+
+		DeepCLError OpenCLBackend::LoadKernel(const std::string& kernelFile)
+		{
+
+			//Load kernels from file
+			std::string* kernelCode = KernelLoader::LoadKernel(kernelFile);
+			if (kernelCode->compare("ERROR") == 0)
+			{
+				delete kernelCode;
+				return -1;
+			}
+
+			size_t bracketPos;
+
+			std::vector <size_t> kernelPositions;
+
+			size_t foundPos = kernelCode->find("void kernel", 0);
+
+			//Search for all kernels contained in the file and store the beginning of the source of each kernel in kernelPositions
+			while (foundPos != std::string::npos)
+			{
+				kernelPositions.push_back(foundPos);
+				foundPos = kernelCode->find("void kernel", foundPos + 11);
+			}
+
+			//Extract the name of each Kernel Object in the file.
+			//The name and source code is then stored in namesToSources
+			size_t numKernels = kernelPositions.size();
+			std::string kernelName;
+			std::string kernelSubString;
+			//Everything in front of the first kernel is placed in front of each kernel of the file when it is compiled
+			std::string fileHeader = numKernels > 0 ? kernelCode->substr(0, kernelPositions[0]) : "";
+			for (size_t i = 0; i < numKernels; ++i)
+			{
+				bracketPos = kernelCode->find('(', kernelPositions[i]);
+				kernelName.assign(*kernelCode, (kernelPositions[i] + 12), bracketPos - (kernelPositions[i] + 12));
+				kernelSubString = kernelCode->substr(kernelPositions[i], (i + 1 < numKernels ? kernelPositions[i + 1] : kernelCode->length()) - kernelPositions[i]);
+				namesToSources.insert(std::pair<std::string, std::string>(kernelName, kernelSubString));
+				namesToHeaders.insert(std::pair<std::string, std::string>(kernelName, fileHeader));
+			}
+
+			//Files without kernels contain definitions used by the other kernels.
+			if (numKernels == 0)
+				kernelPreamble += *kernelCode + "\n";
+
+			return 0;
+
+		}
+
+		DeepCLError OpenCLBackend::LoadKernelFromConfig(const std::string& configFilePath, const std::string& kernelPath)
+		{
+			//Load the names of all kernel files
+			std::vector<std::string>* kernelFiles = KernelLoader::LoadKernelConfig(configFilePath);
+			size_t size = kernelFiles->size();
+			if (size == 0)
+				return 1;
+			//Iterate over all kernel files and load it
+			size_t error;
+			for (size_t i = 0; i < size; ++i)
+			{
+				error = LoadKernel(kernelPath + (*kernelFiles)[i]);
+				if (error != 0)
+					return error;
+			}
+
+			return 0;
+		}
+
+		DeepCLError OpenCLBackend::InitGPU()
+		{
+			std::cout << "OpenCL Deep Learning Project" << std::endl << std::endl;
+			
+			//Retrieve all avilable Platforms
+			std::vector<cl::Platform> platforms;
+			cl::Platform::get(&platforms);
+
+			size_t platformsSize = platforms.size();
+
+			if (platformsSize == 0)
+			{
+				std::cout << "Error no OpenCL platforms found!" << std::endl;
+				system("PAUSE");
+				return -1;
+			}
+
+			std::cout << "Available platforms: " << std::endl;
+
+			for (size_t i = 0; i < platformsSize; ++i)
+			{
+				std::cout << i << " " << platforms[i].getInfo<CL_PLATFORM_NAME>() << std::endl;
+			}		
+
+			std::cout << std::endl;
+
+			std::vector<cl::Device>();
+
+			//Let user choose the Platform
+			size_t platformChoosenIdx;
+			bool platformChoosen = false;
+
+			while (!platformChoosen)
+			{
+				std::cout << "Choose platform\t";
+				std::cin >> platformChoosenIdx;
+
+				platformChoosen = platformsSize > platformChoosenIdx;
+			}
+
+			std::cout << std::endl << std::endl;
+
+			platform = platforms[platformChoosenIdx];
+
+			//query all avialbe devices
+			std::vector<cl::Device> devices;
+
+			platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+
+			platformsSize = devices.size();
+
+			if (platformsSize == 0)
+			{
+				std::cout << "Error no OpenCL devices found!" << std::endl;
+				system("PAUSE");
+				return -1;
+			}
+
+			std::cout << "Available devices: "<< std::endl;
+
+			for (size_t i = 0; i < platformsSize; ++i)
+			{
+				std::cout << i << " " << devices[i].getInfo<CL_DEVICE_NAME>() << std::endl;
+			}
+
+			std::cout << std::endl;
+
+			platformChoosen = false;
+
+
+			//Let the user choose a device
+			while (!platformChoosen)
+			{
+				std::cout << "Choose device \t";
+				std::cin >> platformChoosenIdx;
+
+				platformChoosen = platformsSize > platformChoosenIdx;
+			}
+
+			std::cout << std::endl;
+
+			return InitDevice(devices[platformChoosenIdx]);
+		}
+
+		DeepCLError OpenCLBackend::InitDevice(const cl::Device& device)
+		{
+			this->device = device;
+			platform = cl::Platform(device.getInfo<CL_DEVICE_PLATFORM>());
+
+			//Some meta information of the device
+			std::cout << "Choosen device: \t" << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+			std::cout << "Memory on Device: \t" << device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() << std::endl;
+			std::cout << "Local Memory available on device: \t" << device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>() << std::endl << std::endl;
+			
+			baseAddrAllign = device.getInfo< CL_DEVICE_MEM_BASE_ADDR_ALIGN >();
+			numComputeUnits = device.getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >();
+			localMemSize = device.getInfo< CL_DEVICE_LOCAL_MEM_SIZE >();
+
+			//Create a context for the device
+			context = cl::Context({ device });
+
+
+			//Create a OpenCL commandqueue either with profiling enabled or not
+#ifdef PROFILING_ENABLED
+			comQueue = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE);
+#else 
+			comQueue = cl::CommandQueue(context, device, 0);
+#endif
+			//The upload queue allows transfers to overlap with the kernels in comQueue.
+			uploadQueue = cl::CommandQueue(context, device, 0);
+			//The download queue allows background reads (Checkpoints) without delaying the kernels or the uploads.
+			downloadQueue = cl::CommandQueue(context, device, 0);
+
+			return 0;
+		}
+
+
+		KernelIdx OpenCLBackend::GetKernelIdx(const std::string& fileName)
+		{
+			//Check if the kernel already exists if it does return the kernel
+			std::map<std::string, KernelIdx>::iterator it = kernelTypesToIdx.find(fileName);
+			if (it == kernelTypesToIdx.end())
+			{
+				//Check if source code for the kernel is available
+				if (namesToSources.find(fileName) == namesToSources.end())
+				{
+					std::cerr << "Error kernel: " << fileName << " does not exist" << std::endl;
+					return MAX_UNSIGNED_INT;
+				}
+
+				//create a placeholder kernel and in the kernel vector
+				KernelIdx idx = kernels.size();
+
+				//Add the kernel to needsToCreate to create the kernel at an later point
+				needsToCreate[idx] = fileName;
+				kernels.push_back(nullptr);
+				kernelTypesToIdx[fileName] = idx;
+				kernelArgWritten.push_back(ParseWrittenArguments(namesToSources[fileName]));
+				kernelProgram.push_back(MAX_UNSIGNED_INT);
+				kernelNames.push_back(fileName);
+				kernelDefines.push_back("");
+				return idx;
+			}
+
+			return it->second;
+		}
+
+		KernelIdx OpenCLBackend::GetKernelIdx(const std::string& fileName, const std::string& compileDefines)
+		{
+			//The same as before but this time wiht additional defines for the OpenCL compiler
+			//The kernel is stored in combination with the compiler defines
+			std::map<std::string, KernelIdx>::iterator it = kernelTypesToIdx.find(fileName+compileDefines);
+			if (it == kernelTypesToIdx.end())
+			{
+				if (namesToSources.find(fileName) == namesToSources.end())
+				{
+					std::cerr << "Error kernel: " << fileName << " does not exist" << std::endl;
+					return MAX_UNSIGNED_INT;
+				}
+
+				//Extract all defines
+				std::vector<size_t> defines;
+				defines.push_back(0);
+				size_t spacePos = 0;
+				
+				while (true)
+				{
+					spacePos = compileDefines.find(" ", spacePos + 1);
+					
+					if (spacePos == std::string::npos)
+						break;
+					else
+						++spacePos;
+					defines.push_back(spacePos);
+				}
+				
+				std::string fullStrings = fileName+"!";
+
+				//Create a list of defines that can be pussed to the OpenCL compiler
+				size_t numDefines = defines.size();
+				for (size_t i = 0; i < numDefines; ++i)
+					fullStrings += "-D" + compileDefines.substr(defines[i], (i + 1 < numDefines ? defines[i + 1] -1: compileDefines.length()) - defines[i]) + " ";
+
+				//Create placeholder etc.
+				KernelIdx idx = kernels.size();
+				needsToCreate[idx] = fullStrings;
+				kernels.push_back(nullptr);
+				kernelTypesToIdx[fileName+compileDefines] = idx;
+				kernelArgWritten.push_back(ParseWrittenArguments(namesToSources[fileName]));
+				kernelProgram.push_back(MAX_UNSIGNED_INT);
+				kernelNames.push_back(fileName);
+				kernelDefines.push_back(compileDefines);
+				return idx;
+			}
+
+			return it->second;
+		}
+
+
+		void OpenCLBackend::CreateIfNecessary(const KernelIdx kernelIdx)
+		{
+			// check if Kernel needs to be created
+			std::map<KernelIdx, std::string>::iterator it = needsToCreate.find(kernelIdx);
+			if (it != needsToCreate.end())
+			{
+				//Retrieve kernel name and compile time parameters
+				std::string fileNameAdded = it->second;
+
+				size_t idx = fileNameAdded.find("!");
+				std::string kernelName;
+				std::string arguments;
+				if (idx == std::string::npos)
+				{
+					kernelName = fileNameAdded;
+					arguments = "";
+				}
+				else
+				{
+					kernelName = fileNameAdded.substr(0, idx);
+					arguments = fileNameAdded.substr(idx + 1, fileNameAdded.size() - idx);
+				}
+
+				//Compile the kernel object using the arguments
+				BuildSingleKernel(kernelName, arguments, kernelIdx);
+				//Kernel was created and doesn't need to be created anymore
+				needsToCreate.erase(kernelIdx);
+			}
+		}
+
+		void OpenCLBackend::BuildSingleKernel(const std::string& kernelName, const std::string& defineArguments, const KernelIdx kernelIdx)
+		{
+			//Create a new program with the sourcecode of kernelName
+			size_t idx = programList.size();
+			programList.push_back(cl::Program(context, kernelPreamble + namesToHeaders[kernelName] + namesToSources[kernelName]));
+
+			//Create Compile time arguments. Allows possible optimization to be enabled.
+			std::string compileArguments = "";//"-cl-mad-enable -cl-fast-relaxed-math ";
+			compileArguments += defineArguments;
+
+			//Compile program
+			if (programList[idx].build({ device }, compileArguments.c_str()) != CL_SUCCESS)
+			{
+				std::cerr << "Error building: " << programList[idx].getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+				return;
+			}
+			//Extract kernel object and store it in kernels at the correct position
+			kernels[kernelIdx] = new cl::Kernel(programList[idx], kernelName.c_str());
+			kernelProgram[kernelIdx] = idx;
+		}
+
+		
+		void OpenCLBackend::Run(const OperationType opType)
+		{
+			//query the vector specified by opList (FORWARD, BACKWARD or UPDATE)
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			size_t size = opList->size();
+
+			//Stores the execution time for each operation in the corresponding pass
+#ifdef PROFILING_ENABLED
+			std::vector<cl_ulong>* opTimes = (opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime));
+#endif		
+			
+#ifndef PROFILING_ENABLED
+			//Use the precomputed schedule if the operations are distributed over multiple queues
+			std::vector<ScheduledOperation>* schedule = (opType == OperationType::FORWARD ? &forwardSchedule : (opType == OperationType::BACKWARD ? &backwardSchedule : &updateSchedule));
+			if (numQueues > 1 && schedule->size() == size && size > 0 && !SkipsSteps())
+			{
+				RunScheduled(*schedule);
+				timingEvent.wait();
+				return;
+			}
+#endif // PROFILING_ENABLED
+
+			//Run the operations in the vector starting at the end
+			if (opType == OperationType::BACKWARD)
+				RunBackward(opList, 
+#ifdef PROFILING_ENABLED
+					opTimes,
+#endif // PROFILING_ENABLED
+					size);
+
+			//Run the operations in the vector starting at the begninning
+			else
+				RunForward(opList, 
+#ifdef PROFILING_ENABLED
+					opTimes,
+#endif // PROFILING_ENABLED 
+					size);
+
+			//Wait for operations to finish (Maybe remove this statemend and wait only when absolutely necessary
+			timingEvent.wait();
+		}
+
+
+		void OpenCLBackend::RunWithMarkers(const OperationType opType, const std::vector<size_t>& positions, std::vector<cl::Event>& markers)
+		{
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			std::vector<ScheduledOperation>* schedule = (opType == OperationType::FORWARD ? &forwardSchedule : (opType == OperationType::BACKWARD ? &backwardSchedule : &updateSchedule));
+			size_t size = opList->size();
+			markers.resize(positions.size());
+
+			if (numQueues > 1 && schedule->size() == size && size > 0 && !SkipsSteps())
+			{
+				RunScheduled(*schedule);
+				for (size_t i = 0; i < positions.size(); ++i)
+					comQueue.enqueueMarkerWithWaitList(nullptr, &markers[i]);
+				comQueue.flush();
+				return;
+			}
+
+			std::vector<OperationIdx> sequence;
+			BuildSequence(opType, sequence);
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (OperationBatch(opList, sequence[i]) > 0)
+					(*opList)[sequence[i]]->Run(comQueue, nullptr, &timingEvent, bufferList);
+				for (size_t j = 0; j < positions.size(); ++j)
+					if (positions[j] == i)
+						comQueue.enqueueMarkerWithWaitList(nullptr, &markers[j]);
+			}
+			//Positions behind the last operation (Empty pass)
+			for (size_t j = 0; j < positions.size(); ++j)
+				if (positions[j] >= size)
+					comQueue.enqueueMarkerWithWaitList(nullptr, &markers[j]);
+
+			//Start the execution while the host waits for the markers
+			comQueue.flush();
+		}
+
+		size_t OpenCLBackend::GetNumOperations(const OperationType opType) const
+		{
+			return opType == OperationType::FORWARD ? forwardList.size() : (opType == OperationType::BACKWARD ? backwardList.size() : updateList.size());
+		}
+
+		void OpenCLBackend::GetOperationBuffers(const OperationIdx opIdx, const OperationType opType, std::vector<BufferIdx>& buffers)
+		{
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			std::vector<std::pair<size_t, BufferIdx>> arguments;
+			(*opList)[opIdx]->GetBufferArguments(arguments);
+
+			buffers.clear();
+			for (size_t i = 0; i < arguments.size(); ++i)
+				buffers.push_back(arguments[i].second);
+		}
+
+		std::vector<cl::Device> OpenCLBackend::GetDevices(const cl_device_type type)
+		{
+			std::vector<cl::Device> result;
+			std::vector<cl::Platform> platforms;
+			cl::Platform::get(&platforms);
+			for (size_t i = 0; i < platforms.size(); ++i)
+			{
+				std::vector<cl::Device> devices;
+				//Platforms without a device of the type return an error
+				if (platforms[i].getDevices(type, &devices) == CL_SUCCESS)
+					result.insert(result.end(), devices.begin(), devices.end());
+			}
+			return result;
+		}
+
+		std::vector<cl::Device> OpenCLBackend::SplitByNUMA(const cl::Device& device)
+		{
+			std::vector<cl::Device> subDevices;
+			const cl_device_partition_property properties[] = { CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0 };
+			if (device.createSubDevices(properties, &subDevices) != CL_SUCCESS || subDevices.empty())
+				subDevices.assign(1, device);
+			return subDevices;
+		}
+
+		void OpenCLBackend::RunForward(std::vector<BaseOperation*>* opList, 
+#ifdef PROFILING_ENABLED
+			std::vector<cl_ulong>* opTimes,
+#endif // PROFILING_ENABLED
+			const size_t size)
+		{
+			//Enque each operation in the openCL queue
+			for (size_t i = 0; i < size; ++i)
+			{
+				//Time steps behind the longest sequence of the batch are skipped
+				if (OperationBatch(opList, i) == 0)
+					continue;
+				(*opList)[i]->Run(comQueue, nullptr, &timingEvent, bufferList);
+
+				//Calculate the execution time of the operation(Reduces spead of execution)
+#ifdef PROFILING_ENABLED
+				cl_ulong timeStart, timeEnd;
+				timingEvent.wait();
+				timeStart = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+				timeEnd = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+				(*opTimes)[i] = timeEnd - timeStart;
+#endif
+			}
+#ifdef _DEBUG
+			cl_int err = comQueue.finish();
+			if (err != CL_SUCCESS)
+				std::cout << "Error in execution of commands in queue: " << err << std::endl;
+#endif // DEBUG
+		}
+
+		void OpenCLBackend::RunBackward(std::vector<BaseOperation*>* opList, 
+#ifdef PROFILING_ENABLED
+			std::vector<cl_ulong>* opTimes,
+#endif // PROFILING_ENABLED
+			const size_t size)
+		{
+			//Enqueue each operation in the OpenCL queue starting at the end
+			for (size_t i = size - 1; i < size; --i)
+			{
+				if (OperationBatch(opList, i) == 0)
+					continue;
+				(*opList)[i]->Run(comQueue, nullptr, &timingEvent, bufferList);
+
+				//Calculate the execution time of the operation(Reduces spead of execution)
+#ifdef PROFILING_ENABLED
+				cl_ulong timeStart, timeEnd;
+				timingEvent.wait();
+				timeStart = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+				timeEnd = timingEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+				(*opTimes)[i] = timeEnd - timeStart;
+#endif
+			}
+
+#ifdef _DEBUG
+			cl_int err = comQueue.finish();
+			if (err != CL_SUCCESS)
+				std::cout << "Error in execution of commands in queue: " << err << std::endl;
+#endif
+		}
+
+		std::vector<bool> OpenCLBackend::ParseWrittenArguments(const std::string& kernelSource)
+		{
+			std::vector<bool> written;
+
+			size_t start = kernelSource.find('(');
+			size_t end = kernelSource.find(')', start);
+			if (start == std::string::npos || end == std::string::npos)
+				return written;
+
+			//Split the argument list at each comma and check the qualifiers of each argument
+			std::string arguments = kernelSource.substr(start + 1, end - start - 1);
+			size_t argStart = 0;
+			while (argStart <= arguments.size())
+			{
+				size_t argEnd = arguments.find(',', argStart);
+				if (argEnd == std::string::npos)
+					argEnd = arguments.size();
+
+				std::string argument = arguments.substr(argStart, argEnd - argStart);
+
+				bool isGlobal = false;
+				bool isConst = false;
+
+				//Compare complete words to not confuse argument names with qualifiers
+				size_t wordStart = 0;
+				while (wordStart < argument.size())
+				{
+					while (wordStart < argument.size() && !(isalnum(argument[wordStart]) || argument[wordStart] == '_'))
+						++wordStart;
+					size_t wordEnd = wordStart;
+					while (wordEnd < argument.size() && (isalnum(argument[wordEnd]) || argument[wordEnd] == '_'))
+						++wordEnd;
+
+					std::string word = argument.substr(wordStart, wordEnd - wordStart);
+					if (word == "global" || word == "__global")
+						isGlobal = true;
+					else if (word == "const" || word == "constant" || word == "__constant")
+						isConst = true;
+
+					wordStart = wordEnd;
+				}
+
+				written.push_back(isGlobal && !isConst && argument.find('*') != std::string::npos);
+				argStart = argEnd + 1;
+			}
+
+			return written;
+		}
+
+		void OpenCLBackend::SetNumQueues(const size_t numQueues)
+		{
+			this->numQueues = numQueues > 0 ? numQueues : 1;
+		}
+
+		void OpenCLBackend::BuildSequence(const OperationType opType, std::vector<OperationIdx>& sequence)
+		{
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			size_t size = opList->size();
+
+			sequence.clear();
+			//The backward pass is executed starting at the end
+			if (opType == OperationType::BACKWARD)
+				for (size_t i = size - 1; i < size; --i)
+					sequence.push_back(i);
+			else
+				for (size_t i = 0; i < size; ++i)
+					sequence.push_back(i);
+		}
+
+		BaseOperation* OpenCLBackend::PopOperation(const OperationType opType)
+		{
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			if (opList->empty())
+				return nullptr;
+
+			BaseOperation* operation = opList->back();
+			opList->pop_back();
+			if (opType != OperationType::UPDATE)
+				(opType == OperationType::FORWARD ? forwardSteps : backwardSteps).pop_back();
+#ifdef PROFILING_ENABLED
+			std::vector<cl_ulong>* opTimes = (opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime));
+			opTimes->pop_back();
+#endif // PROFILING_ENABLED
+			return operation;
+		}
+
+		BaseOperation* OpenCLBackend::ExchangeOperation(const OperationIdx opIdx, const OperationType opType, BaseOperation* operation)
+		{
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			if (opIdx >= opList->size())
+			{
+				std::cout << "Error ExchangeOperation: Operation does not exist" << std::endl;
+				return nullptr;
+			}
+
+			//The recorded step refers to the previous operation
+			DiscardRecording();
+
+			//The operation might have been created for another batch size
+			operation->SetActiveBatch(OperationBatch(opList, opIdx));
+			BaseOperation* previous = (*opList)[opIdx];
+			(*opList)[opIdx] = operation;
+			return previous;
+		}
+
+		void OpenCLBackend::BuildSchedule()
+		{
+			if (numQueues < 2)
+				return;
+
+			//The first queue is comQueue. The additional queues are created once.
+			for (size_t i = computeQueues.size() + 1; i < numQueues; ++i)
+				computeQueues.push_back(cl::CommandQueue(context, device, 0));
+
+			BuildSchedule(OperationType::FORWARD, forwardSchedule);
+			BuildSchedule(OperationType::BACKWARD, backwardSchedule);
+			BuildSchedule(OperationType::UPDATE, updateSchedule);
+
+			size_t maxSize = forwardSchedule.size() > backwardSchedule.size() ? forwardSchedule.size() : backwardSchedule.size();
+			maxSize = maxSize > updateSchedule.size() ? maxSize : updateSchedule.size();
+			scheduleEvents.resize(maxSize);
+		}
+
+		void OpenCLBackend::BuildSchedule(const OperationType opType, std::vector<ScheduledOperation>& schedule)
+		{
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			std::vector<OperationIdx> sequence;
+			BuildSequence(opType, sequence);
+
+			schedule.clear();
+
+			//Last operation writing a buffer and the operations reading it since then.
+			std::map<BufferIdx, size_t> lastWriter;
+			std::map<BufferIdx, std::vector<size_t>> readers;
+
+			//Last operation enqueued into each queue
+			std::vector<size_t> queueTail(numQueues, MAX_UNSIGNED_INT);
+			size_t nextQueue = 0;
+
+			std::vector<std::pair<size_t, BufferIdx>> arguments;
+			std::vector<BufferIdx> overlapping;
+			size_t size = sequence.size();
+			for (size_t i = 0; i < size; ++i)
+			{
+				ScheduledOperation scheduled;
+				scheduled.operation = (*opList)[sequence[i]];
+				scheduled.opIdx = sequence[i];
+				scheduled.signalEvent = false;
+				scheduled.waitForStart = false;
+
+				arguments.clear();
+				scheduled.operation->GetBufferArguments(arguments);
+				const std::vector<bool>& written = kernelArgWritten[scheduled.operation->GetKernelIdx()];
+
+				//Read after write, write after read and write after write dependencies. A sub buffer overlaps the buffer containing it.
+				std::vector<size_t> dependencies;
+				for (size_t j = 0; j < arguments.size(); ++j)
+				{
+					bool writes = arguments[j].first >= written.size() || written[arguments[j].first];
+
+					GetOverlappingBuffers(arguments[j].second, overlapping);
+					for (size_t k = 0; k < overlapping.size(); ++k)
+					{
+						BufferIdx buffer = overlapping[k];
+						std::map<BufferIdx, size_t>::iterator writer = lastWriter.find(buffer);
+						if (writer != lastWriter.end())
+							dependencies.push_back(writer->second);
+						if (writes)
+						{
+							std::vector<size_t>& bufferReaders = readers[buffer];
+							dependencies.insert(dependencies.end(), bufferReaders.begin(), bufferReaders.end());
+						}
+					}
+				}
+
+				for (size_t j = 0; j < arguments.size(); ++j)
+				{
+					if (!(arguments[j].first >= written.size() || written[arguments[j].first]))
+						readers[arguments[j].second].push_back(i);
+				}
+				for (size_t j = 0; j < arguments.size(); ++j)
+				{
+					if (arguments[j].first >= written.size() || written[arguments[j].first])
+					{
+						lastWriter[arguments[j].second] = i;
+						readers[arguments[j].second].clear();
+					}
+				}
+
+				//Continue the chain of a dependency if it is the last operation of its queue. Otherwise use the queue that was idle the longest.
+				size_t queue = MAX_UNSIGNED_INT;
+				size_t latest = 0;
+				for (size_t j = 0; j < dependencies.size(); ++j)
+				{
+					size_t dependencyQueue = schedule[dependencies[j]].queue;
+					if (queueTail[dependencyQueue] == dependencies[j] && (queue == MAX_UNSIGNED_INT || dependencies[j] > latest))
+					{
+						queue = dependencyQueue;
+						latest = dependencies[j];
+					}
+				}
+				if (queue == MAX_UNSIGNED_INT)
+				{
+					queue = nextQueue;
+					for (size_t q = 0; q < numQueues; ++q)
+					{
+						if (queueTail[q] == MAX_UNSIGNED_INT)
+						{
+							queue = q;
+							break;
+						}
+						if (queueTail[q] < queueTail[queue])
+							queue = q;
+					}
+					nextQueue = (queue + 1) % numQueues;
+				}
+
+				//Only the latest dependency of each other queue must be waited for since the queues are in order.
+				std::vector<size_t> latestOfQueue(numQueues, MAX_UNSIGNED_INT);
+				for (size_t j = 0; j < dependencies.size(); ++j)
+				{
+					size_t dependencyQueue = schedule[dependencies[j]].queue;
+					if (dependencyQueue != queue && (latestOfQueue[dependencyQueue] == MAX_UNSIGNED_INT || latestOfQueue[dependencyQueue] < dependencies[j]))
+						latestOfQueue[dependencyQueue] = dependencies[j];
+				}
+				for (size_t q = 0; q < numQueues; ++q)
+				{
+					if (latestOfQueue[q] != MAX_UNSIGNED_INT)
+					{
+						scheduled.waitOn.push_back(latestOfQueue[q]);
+						schedule[latestOfQueue[q]].signalEvent = true;
+					}
+				}
+
+				scheduled.queue = queue;
+				scheduled.waitForStart = queue != 0 && dependencies.empty();
+				queueTail[queue] = i;
+				schedule.push_back(scheduled);
+			}
+
+			//comQueue waits for the last operation of each other queue at the end of the pass
+			for (size_t q = 1; q < numQueues; ++q)
+				if (queueTail[q] != MAX_UNSIGNED_INT)
+					schedule[queueTail[q]].signalEvent = true;
+		}
+
+		void OpenCLBackend::RunScheduled(std::vector<ScheduledOperation>& schedule)
+		{
+			//Operations on the other queues must wait for the commands enqueued into comQueue before the pass (Data transfer, etc.)
+			cl::Event startEvent;
+			comQueue.enqueueMarkerWithWaitList(nullptr, &startEvent);
+
+			std::vector<size_t> queueTail(numQueues, MAX_UNSIGNED_INT);
+			std::vector<cl::Event> waitList;
+			size_t size = schedule.size();
+			for (size_t i = 0; i < size; ++i)
+			{
+				ScheduledOperation& scheduled = schedule[i];
+				cl::CommandQueue& queue = scheduled.queue == 0 ? comQueue : computeQueues[scheduled.queue - 1];
+
+				waitList.clear();
+				for (size_t j = 0; j < scheduled.waitOn.size(); ++j)
+					waitList.push_back(scheduleEvents[scheduled.waitOn[j]]);
+				if (scheduled.waitForStart)
+					waitList.push_back(startEvent);
+
+				scheduled.operation->Run(queue, waitList.empty() ? nullptr : &waitList, scheduled.signalEvent ? &scheduleEvents[i] : nullptr, bufferList);
+				queueTail[scheduled.queue] = i;
+			}
+
+			//Let comQueue wait for all other queues. Everything enqueued afterwards sees the results of the pass.
+			waitList.clear();
+			for (size_t q = 1; q < numQueues; ++q)
+			{
+				if (queueTail[q] != MAX_UNSIGNED_INT)
+				{
+					waitList.push_back(scheduleEvents[queueTail[q]]);
+					computeQueues[q - 1].flush();
+				}
+			}
+			if (!waitList.empty())
+				comQueue.enqueueBarrierWithWaitList(&waitList);
+			comQueue.enqueueMarkerWithWaitList(nullptr, &timingEvent);
+
+#ifdef _DEBUG
+			cl_int err = comQueue.finish();
+			if (err != CL_SUCCESS)
+				std::cout << "Error in execution of commands in queue: " << err << std::endl;
+#endif // DEBUG
+		}
+
+		void OpenCLBackend::BuildOverwriteFirst()
+		{
+			std::vector<OperationIdx> sequence;
+			BuildSequence(OperationType::BACKWARD, sequence);
+
+			//Restore the kernels switched by an earlier call
+			for (size_t i = 0; i < overwriteOperations.size(); ++i)
+				overwriteOperations[i].operation->SetKernel(kernels[overwriteOperations[i].accumulateKernel], overwriteOperations[i].accumulateKernel);
+			overwriteOperations.clear();
+
+			overwrittenBuffer.assign(bufferList.size(), false);
+			accumulateBuffer.assign(bufferList.size(), false);
+
+			//Buffers accessed by an earlier operation of the backward pass
+			std::vector<bool> accessed(bufferList.size(), false);
+
+			std::vector<std::pair<size_t, BufferIdx>> arguments;
+			std::vector<BufferIdx> overlapping;
+			for (size_t i = 0; i < sequence.size(); ++i)
+			{
+				BaseOperation* operation = backwardList[sequence[i]];
+				KernelIdx kernelIdx = operation->GetKernelIdx();
+
+				arguments.clear();
+				operation->GetBufferArguments(arguments);
+				const std::vector<bool>& written = kernelArgWritten[kernelIdx];
+
+				//The variant replaces every accumulation of the kernel. Therefore each buffer written by the operation must be written the first time
+				//and must not be read by the operation itself.
+				bool overwrite = namesToSources[kernelNames[kernelIdx]].find("OVERWRITE_RESULT") != std::string::npos;
+				bool writesBuffer = false;
+				for (size_t j = 0; j < arguments.size() && overwrite; ++j)
+				{
+					bool writes = arguments[j].first >= written.size() || written[arguments[j].first];
+					if (!writes)
+						continue;
+					writesBuffer = true;
+					GetOverlappingBuffers(arguments[j].second, overlapping);
+					for (size_t k = 0; k < overlapping.size(); ++k)
+						if (accessed[overlapping[k]])
+							overwrite = false;
+					for (size_t k = 0; k < arguments.size(); ++k)
+						if (k != j && arguments[k].second == arguments[j].second)
+							overwrite = false;
+				}
+				overwrite = overwrite && writesBuffer;
+
+				if (overwrite)
+				{
+					OverwriteOperation overwriteOperation;
+					overwriteOperation.operation = operation;
+					overwriteOperation.accumulateKernel = kernelIdx;
+					overwriteOperation.overwriteKernel = GetKernelIdx(kernelNames[kernelIdx], kernelDefines[kernelIdx].empty() ? "OVERWRITE_RESULT" : kernelDefines[kernelIdx] + " OVERWRITE_RESULT");
+					CreateIfNecessary(overwriteOperation.overwriteKernel);
+					operation->SetKernel(kernels[overwriteOperation.overwriteKernel], overwriteOperation.overwriteKernel);
+
+					for (size_t j = 0; j < arguments.size(); ++j)
+					{
+						if (arguments[j].first >= written.size() || written[arguments[j].first])
+						{
+							overwrittenBuffer[arguments[j].second] = true;
+							overwriteOperation.buffers.push_back(arguments[j].second);
+						}
+					}
+					overwriteOperations.push_back(overwriteOperation);
+				}
+
+				for (size_t j = 0; j < arguments.size(); ++j)
+					accessed[arguments[j].second] = true;
+			}
+		}
+
+		bool OpenCLBackend::RequiresReset(const BufferIdx idx) const
+		{
+			return idx >= overwrittenBuffer.size() || !overwrittenBuffer[idx];
+		}
+
+		void OpenCLBackend::SetAccumulate(const BufferIdx idx, const bool accumulate)
+		{
+			if (idx >= accumulateBuffer.size() || !overwrittenBuffer[idx] || accumulateBuffer[idx] == accumulate)
+				return;
+			accumulateBuffer[idx] = accumulate;
+
+			//An operation overwrites its results only if none of the buffers it writes accumulates
+			for (size_t i = 0; i < overwriteOperations.size(); ++i)
+			{
+				OverwriteOperation& overwriteOperation = overwriteOperations[i];
+				if (std::find(overwriteOperation.buffers.begin(), overwriteOperation.buffers.end(), idx) == overwriteOperation.buffers.end())
+					continue;
+
+				bool accumulates = false;
+				for (size_t j = 0; j < overwriteOperation.buffers.size(); ++j)
+					accumulates = accumulates || accumulateBuffer[overwriteOperation.buffers[j]];
+
+				KernelIdx kernelIdx = accumulates ? overwriteOperation.accumulateKernel : overwriteOperation.overwriteKernel;
+				overwriteOperation.operation->SetKernel(kernels[kernelIdx], kernelIdx);
+			}
+		}
+
+		cl::Kernel OpenCLBackend::CloneKernel(const KernelIdx kernelIdx)
+		{
+			//A kernel object created from the same program has its own arguments
+#ifdef _DEBUG
+			cl_int err;
+			cl::Kernel kernel(programList[kernelProgram[kernelIdx]], kernelNames[kernelIdx].c_str(), &err);
+			if (err != CL_SUCCESS)
+				std::cout << "Error clone kernel: " << err << std::endl;
+			return kernel;
+#else
+			return cl::Kernel(programList[kernelProgram[kernelIdx]], kernelNames[kernelIdx].c_str());
+#endif // DEBUG
+		}
+
+		void OpenCLBackend::BeginRecording()
+		{
+			DiscardRecording();
+			recording = true;
+		}
+
+		void OpenCLBackend::DiscardRecording()
+		{
+#ifdef cl_khr_command_buffer
+			ReleaseCommandBuffers();
+#endif // cl_khr_command_buffer
+			if (replayPending)
+			{
+				replayEvent.wait();
+				replayPending = false;
+			}
+
+			recordedStep.clear();
+			for (std::map<BufferIdx, std::vector<std::pair<std::pair<size_t, size_t>, size_t>>>::iterator it = aliasUses.begin(); it != aliasUses.end(); ++it)
+				it->second.clear();
+		}
+
+		void OpenCLBackend::RecordPass(const OperationType opType)
+		{
+			std::vector<BaseOperation*>* opList = (opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList));
+			std::vector<ScheduledOperation>* schedule = (opType == OperationType::FORWARD ? &forwardSchedule : (opType == OperationType::BACKWARD ? &backwardSchedule : &updateSchedule));
+			size_t size = opList->size();
+			recordedSizes[opType == OperationType::FORWARD ? 0 : (opType == OperationType::BACKWARD ? 1 : 2)] = size;
+			if (size == 0)
+				return;
+
+			std::vector<OperationIdx> sequence;
+			BuildSequence(opType, sequence);
+
+			size_t passIdx = recordedStep.size();
+			recordedStep.push_back(RecordedPass());
+			RecordedPass& pass = recordedStep.back();
+			pass.multiQueue = numQueues > 1 && schedule->size() == size;
+
+			std::vector<std::pair<size_t, BufferIdx>> arguments;
+			for (size_t i = 0; i < size; ++i)
+			{
+				LaunchEntry entry;
+				entry.operation = (*opList)[sequence[i]];
+				entry.offset = entry.operation->GetOffset();
+				entry.globalSize = entry.operation->GetGlobalSize();
+				entry.localSize = entry.operation->GetLocalSize();
+				entry.dynamic = entry.operation->IsDynamic();
+				entry.usesAlias = false;
+				entry.resetBuffer = MAX_UNSIGNED_INT;
+				entry.resetSize = 0;
+				entry.copySource = MAX_UNSIGNED_INT;
+
+				if (pass.multiQueue)
+				{
+					entry.queue = (*schedule)[i].queue;
+					entry.waitOn = (*schedule)[i].waitOn;
+					entry.waitForStart = (*schedule)[i].waitForStart;
+					entry.signalEvent = (*schedule)[i].signalEvent;
+				}
+				else
+				{
+					entry.queue = 0;
+					entry.waitForStart = false;
+					entry.signalEvent = false;
+				}
+
+				//Dynamic operations set their arguments each time they are launched
+				if (!entry.dynamic)
+				{
+					entry.kernel = CloneKernel(entry.operation->GetKernelIdx());
+					entry.operation->SetArguments(&entry.kernel, bufferList);
+
+					arguments.clear();
+					entry.operation->GetBufferArguments(arguments);
+					for (size_t j = 0; j < arguments.size(); ++j)
+					{
+						std::map<BufferIdx, std::vector<std::pair<std::pair<size_t, size_t>, size_t>>>::iterator it = aliasUses.find(arguments[j].second);
+						if (it != aliasUses.end())
+						{
+							it->second.push_back(std::pair<std::pair<size_t, size_t>, size_t>(std::pair<size_t, size_t>(passIdx, i), arguments[j].first));
+							entry.usesAlias = true;
+						}
+					}
+				}
+
+				pass.entries.push_back(entry);
+			}
+		}
+
+		void OpenCLBackend::EndRecording()
+		{
+			recording = false;
+#ifdef cl_khr_command_buffer
+			//Command buffers can't contain the events used to synchronize multiple queues
+			if (numQueues < 2 && LoadCommandBufferFunctions())
+				CreateCommandBuffers();
+#endif // cl_khr_command_buffer
+		}
+
+		bool OpenCLBackend::IsRecorded() const
+		{
+			return !recordedStep.empty() && recordedSizes[0] == forwardList.size() && recordedSizes[1] == backwardList.size() && recordedSizes[2] == updateList.size();
+		}
+
+		void OpenCLBackend::Launch(LaunchEntry& entry, cl::CommandQueue& queue, const std::vector<cl::Event>* waitList, cl::Event* event)
+		{
+			if (entry.operation == nullptr && entry.copySource != MAX_UNSIGNED_INT)
+			{
+#ifdef _DEBUG
+				cl_int err = queue.enqueueCopyBuffer(bufferList[entry.copySource], bufferList[entry.resetBuffer], 0, 0, entry.resetSize, waitList, event);
+				if (err != CL_SUCCESS)
+					std::cout << "Error copy buffer: " << err << std::endl;
+#else
+				queue.enqueueCopyBuffer(bufferList[entry.copySource], bufferList[entry.resetBuffer], 0, 0, entry.resetSize, waitList, event);
+#endif // DEBUG
+			}
+			else if (entry.operation == nullptr)
+			{
+				FillZero(queue, entry.resetBuffer, entry.resetSize, waitList, event);
+			}
+			else if (entry.dynamic)
+				entry.operation->Run(queue, waitList, event, bufferList);
+			else
+			{
+#ifdef _DEBUG
+				cl_int err = queue.enqueueNDRangeKernel(entry.kernel, entry.offset, entry.globalSize, entry.localSize, waitList, event);
+				if (err != CL_SUCCESS)
+					std::cout << "Error enqueueNDRangeKernel: " << err << std::endl;
+#else
+				queue.enqueueNDRangeKernel(entry.kernel, entry.offset, entry.globalSize, entry.localSize, waitList, event);
+#endif // DEBUG
+			}
+		}
+
+		void OpenCLBackend::Replay()
+		{
+			//Limit the number of steps in flight to one. The host can prepare the next batch while the step is executed.
+			if (replayPending)
+				replayEvent.wait();
+
+			size_t flatIdx = 0;
+			std::vector<cl::Event> waitList;
+			for (size_t p = 0; p < recordedStep.size(); ++p)
+			{
+				RecordedPass& pass = recordedStep[p];
+				size_t size = pass.entries.size();
+
+				if (!pass.multiQueue)
+				{
+					for (size_t i = 0; i < size; ++i, ++flatIdx)
+					{
+#ifdef cl_khr_command_buffer
+						//Entries contained in a command buffer are enqueued together with the first entry of the command buffer
+						if (!entryCommandBuffer.empty() && entryCommandBuffer[flatIdx] != MAX_UNSIGNED_INT)
+						{
+							if (flatIdx == 0 || entryCommandBuffer[flatIdx - 1] != entryCommandBuffer[flatIdx])
+							{
+								cl_int err = enqueueCommandBuffer(0, nullptr, commandBuffers[entryCommandBuffer[flatIdx]], 0, nullptr, nullptr);
+								if (err != CL_SUCCESS)
+									std::cout << "Error enqueue command buffer: " << err << std::endl;
+							}
+							continue;
+						}
+#endif // cl_khr_command_buffer
+						Launch(pass.entries[i], comQueue, nullptr, nullptr);
+					}
+					continue;
+				}
+
+				//Same synchronization as RunScheduled
+				cl::Event startEvent;
+				comQueue.enqueueMarkerWithWaitList(nullptr, &startEvent);
+
+				std::vector<size_t> queueTail(numQueues, MAX_UNSIGNED_INT);
+				for (size_t i = 0; i < size; ++i, ++flatIdx)
+				{
+					LaunchEntry& entry = pass.entries[i];
+					cl::CommandQueue& queue = entry.queue == 0 ? comQueue : computeQueues[entry.queue - 1];
+
+					waitList.clear();
+					for (size_t j = 0; j < entry.waitOn.size(); ++j)
+						waitList.push_back(scheduleEvents[entry.waitOn[j]]);
+					if (entry.waitForStart)
+						waitList.push_back(startEvent);
+
+					Launch(entry, queue, waitList.empty() ? nullptr : &waitList, entry.signalEvent ? &scheduleEvents[i] : nullptr);
+					queueTail[entry.queue] = i;
+				}
+
+				waitList.clear();
+				for (size_t q = 1; q < numQueues; ++q)
+				{
+					if (queueTail[q] != MAX_UNSIGNED_INT)
+					{
+						waitList.push_back(scheduleEvents[queueTail[q]]);
+						computeQueues[q - 1].flush();
+					}
+				}
+				if (!waitList.empty())
+					comQueue.enqueueBarrierWithWaitList(&waitList);
+			}
+
+			comQueue.enqueueMarkerWithWaitList(nullptr, &replayEvent);
+			comQueue.flush();
+			replayPending = true;
+			timingEvent = replayEvent;
+
+#ifdef _DEBUG
+			cl_int err = comQueue.finish();
+			if (err != CL_SUCCESS)
+				std::cout << "Error in execution of commands in queue: " << err << std::endl;
+#endif // DEBUG
+		}
+
+#ifdef cl_khr_command_buffer
+		bool OpenCLBackend::LoadCommandBufferFunctions()
+		{
+			if (commandBufferSupported)
+				return true;
+
+			std::string extensions = device.getInfo<CL_DEVICE_EXTENSIONS>();
+			if (extensions.find("cl_khr_command_buffer") == std::string::npos)
+				return false;
+
+			cl_platform_id platformId = platform();
+			createCommandBuffer = reinterpret_cast<clCreateCommandBufferKHR_fn>(clGetExtensionFunctionAddressForPlatform(platformId, "clCreateCommandBufferKHR"));
+			commandNDRangeKernel = reinterpret_cast<clCommandNDRangeKernelKHR_fn>(clGetExtensionFunctionAddressForPlatform(platformId, "clCommandNDRangeKernelKHR"));
+			finalizeCommandBuffer = reinterpret_cast<clFinalizeCommandBufferKHR_fn>(clGetExtensionFunctionAddressForPlatform(platformId, "clFinalizeCommandBufferKHR"));
+			enqueueCommandBuffer = reinterpret_cast<clEnqueueCommandBufferKHR_fn>(clGetExtensionFunctionAddressForPlatform(platformId, "clEnqueueCommandBufferKHR"));
+			releaseCommandBuffer = reinterpret_cast<clReleaseCommandBufferKHR_fn>(clGetExtensionFunctionAddressForPlatform(platformId, "clReleaseCommandBufferKHR"));
+
+			commandBufferSupported = createCommandBuffer != nullptr && commandNDRangeKernel != nullptr && finalizeCommandBuffer != nullptr
+				&& enqueueCommandBuffer != nullptr && releaseCommandBuffer != nullptr;
+			return commandBufferSupported;
+		}
+
+		void OpenCLBackend::CreateCommandBuffers()
+		{
+			cl_command_queue queueHandle = comQueue();
+			cl_command_buffer_khr current = nullptr;
+			cl_sync_point_khr lastSyncPoint = 0;
+			cl_int err;
+
+			entryCommandBuffer.clear();
+			for (size_t p = 0; p < recordedStep.size(); ++p)
+			{
+				RecordedPass& pass = recordedStep[p];
+				for (size_t i = 0; i < pass.entries.size(); ++i)
+				{
+					LaunchEntry& entry = pass.entries[i];
+					//Resets, dynamic entries and entries using an alias are enqueued directly and end the current command buffer
+					if (entry.operation == nullptr || entry.dynamic || entry.usesAlias)
+					{
+						if (current != nullptr)
+						{
+							finalizeCommandBuffer(current);
+							current = nullptr;
+						}
+						entryCommandBuffer.push_back(MAX_UNSIGNED_INT);
+						continue;
+					}
+
+					if (current == nullptr)
+					{
+						current = createCommandBuffer(1, &queueHandle, nullptr, &err);
+						if (err != CL_SUCCESS)
+						{
+							std::cout << "Error create command buffer: " << err << std::endl;
+							ReleaseCommandBuffers();
+							return;
+						}
+						commandBuffers.push_back(current);
+					}
+
+					//The commands are chained using sync points to keep the order of the passes
+					const size_t* offset = entry.offset.dimensions() == 0 ? nullptr : static_cast<const size_t*>(entry.offset);
+					const size_t* localSize = entry.localSize.dimensions() == 0 ? nullptr : static_cast<const size_t*>(entry.localSize);
+					bool first = entryCommandBuffer.empty() || entryCommandBuffer.back() != commandBuffers.size() - 1;
+					cl_sync_point_khr syncPoint;
+					err = commandNDRangeKernel(current, nullptr, nullptr, entry.kernel(), static_cast<cl_uint>(entry.globalSize.dimensions()), offset, static_cast<const size_t*>(entry.globalSize), localSize,
+						first ? 0 : 1, first ? nullptr : &lastSyncPoint, &syncPoint, nullptr);
+					if (err != CL_SUCCESS)
+					{
+						std::cout << "Error record command: " << err << std::endl;
+						ReleaseCommandBuffers();
+						return;
+					}
+					lastSyncPoint = syncPoint;
+					entryCommandBuffer.push_back(commandBuffers.size() - 1);
+				}
+			}
+			if (current != nullptr)
+				finalizeCommandBuffer(current);
+		}
+
+		void OpenCLBackend::ReleaseCommandBuffers()
+		{
+			for (size_t i = 0; i < commandBuffers.size(); ++i)
+				releaseCommandBuffer(commandBuffers[i]);
+			commandBuffers.clear();
+			entryCommandBuffer.clear();
+		}
+#endif // cl_khr_command_buffer
+
+#ifdef PROFILING_ENABLED
+		unsigned long long OpenCLBackend::GetTime( const OperationIdx opIdx, const OperationType opType)
+		{
+			//Return the time of the operation
+			std::vector<cl_ulong>* opTimes = (opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime));
+			return (*opTimes)[opIdx];
+		}
+#endif
+
+		BufferIdx OpenCLBackend::CreateBuffer(const size_t size, const MEM_FLAG memFlag, const size_t numSubBuffer)
+		{
+
+			cl_mem_flags memFlagCL = memFlag == MEM_FLAG::READ_WRITE ? CL_MEM_READ_WRITE : (memFlag == MEM_FLAG::WRITE_ONLY ? CL_MEM_WRITE_ONLY : CL_MEM_READ_ONLY);
+			size_t paddedSize = size;
+			//Calculate the correct size of the buffer including the necessary memory alignment
+			paddedSize = baseAddrAllign*((size + baseAddrAllign-1) / baseAddrAllign)*numSubBuffer;
+
+			//Create a new OpenCL buffer object and store it in the bufferList. The index of the buffer is returned at the end
+#ifdef _DEBUG
+			cl_int err;
+			bufferList.push_back(cl::Buffer(context, memFlagCL, paddedSize, nullptr, &err));
+			if (err != CL_SUCCESS)
+				std::cout << "Error create Buffer: " << err << std::endl;
+#else
+			bufferList.push_back(cl::Buffer(context, memFlagCL, paddedSize));
+#endif // DEBUG
+			return bufferList.size() - 1;
+		}
+
+	
+		BufferIdx OpenCLBackend::CreateSubBuffer(const BufferIdx bufferIdx, const size_t size, const MEM_FLAG memFlag, const size_t idxBuffer)
+		{
+			cl_mem_flags memFlagCL = memFlag == MEM_FLAG::READ_WRITE ? CL_MEM_READ_WRITE : (memFlag == MEM_FLAG::WRITE_ONLY ? CL_MEM_WRITE_ONLY : CL_MEM_READ_ONLY);
+			
+			//calculate the correct offset incorporating the necessary memory alignment
+			size_t paddOffset = baseAddrAllign*((size + baseAddrAllign-1) / baseAddrAllign) * idxBuffer;
+			cl_buffer_region region = { paddOffset, size };
+
+			//Create a sub buffer using the by bufferIdx specified OpenCL buffer
+#ifdef _DEBUG
+			cl_int err;
+			bufferList.push_back(bufferList[bufferIdx].createSubBuffer(memFlagCL, CL_BUFFER_CREATE_TYPE_REGION, static_cast<void*>(&region), &err));
+			if (err != CL_SUCCESS)
+				std::cout << "Error create SubBuffer: " << err << std::endl;
+#else
+			bufferList.push_back(bufferList[bufferIdx].createSubBuffer(memFlagCL, CL_BUFFER_CREATE_TYPE_REGION, static_cast<void*>(&region)));
+#endif // DEBUG
+			parentBuffer[bufferList.size() - 1] = bufferIdx;
+			subBuffers[bufferIdx].push_back(bufferList.size() - 1);
+			return bufferList.size() - 1;
+		}
+
+		BufferIdx OpenCLBackend::CreateSubBufferAt(const BufferIdx bufferIdx, const size_t offset, const size_t size, const MEM_FLAG memFlag)
+		{
+			cl_mem_flags memFlagCL = memFlag == MEM_FLAG::READ_WRITE ? CL_MEM_READ_WRITE : (memFlag == MEM_FLAG::WRITE_ONLY ? CL_MEM_WRITE_ONLY : CL_MEM_READ_ONLY);
+			cl_buffer_region region = { offset, size };
+
+#ifdef _DEBUG
+			cl_int err;
+			bufferList.push_back(bufferList[bufferIdx].createSubBuffer(memFlagCL, CL_BUFFER_CREATE_TYPE_REGION, static_cast<void*>(&region), &err));
+			if (err != CL_SUCCESS)
+				std::cout << "Error create SubBuffer: " << err << std::endl;
+#else
+			bufferList.push_back(bufferList[bufferIdx].createSubBuffer(memFlagCL, CL_BUFFER_CREATE_TYPE_REGION, static_cast<void*>(&region)));
+#endif // DEBUG
+			parentBuffer[bufferList.size() - 1] = bufferIdx;
+			subBuffers[bufferIdx].push_back(bufferList.size() - 1);
+			sharedBuffers.insert(bufferIdx);
+			return bufferList.size() - 1;
+		}
+
+		void OpenCLBackend::GetOverlappingBuffers(const BufferIdx idx, std::vector<BufferIdx>& overlapping) const
+		{
+			overlapping.clear();
+			overlapping.push_back(idx);
+
+			std::map<BufferIdx, BufferIdx>::const_iterator parent = parentBuffer.find(idx);
+			if (parent != parentBuffer.end())
+				overlapping.push_back(parent->second);
+
+			std::map<BufferIdx, std::vector<BufferIdx>>::const_iterator subs = subBuffers.find(idx);
+			if (subs != subBuffers.end())
+				overlapping.insert(overlapping.end(), subs->second.begin(), subs->second.end());
+
+			//The regions of the sub buffers of a shared buffer are not tracked, each of them might overlap the others.
+			if (parent != parentBuffer.end() && sharedBuffers.count(parent->second) > 0)
+			{
+				const std::vector<BufferIdx>& siblings = subBuffers.find(parent->second)->second;
+				for (size_t i = 0; i < siblings.size(); ++i)
+					if (siblings[i] != idx)
+						overlapping.push_back(siblings[i]);
+			}
+		}
+		
+		void OpenCLBackend::WriteDataBuffer(BufferIdx idx, const void* data, const size_t offset, const size_t size)
+		{
+#ifdef _DEBUG
+			cl_int err = comQueue.enqueueWriteBuffer((bufferList[idx]), CL_TRUE, offset, size, data);
+			if (err != CL_SUCCESS)
+				std::cout << "Error write buffer: " << err << std::endl;
+#else
+			comQueue.enqueueWriteBuffer((bufferList[idx]), CL_FALSE, offset, size, data);
+#endif // DEBUG
+		}
+
+		BufferIdx OpenCLBackend::CreateBufferAlias(const BufferIdx bufferIdx)
+		{
+			//cl::Buffer objects are reference counted therefore the copy refers to the same memory object
+			bufferList.push_back(bufferList[bufferIdx]);
+			aliasUses[bufferList.size() - 1];
+			return bufferList.size() - 1;
+		}
+
+		void OpenCLBackend::BindBuffer(const BufferIdx alias, const BufferIdx bufferIdx)
+		{
+			bufferList[alias] = bufferList[bufferIdx];
+
+			//Recorded kernels had their arguments set once. Update the arguments referring to the alias.
+			std::map<BufferIdx, std::vector<std::pair<std::pair<size_t, size_t>, size_t>>>::iterator it = aliasUses.find(alias);
+			if (it == aliasUses.end())
+				return;
+			std::vector<std::pair<std::pair<size_t, size_t>, size_t>>& uses = it->second;
+			for (size_t i = 0; i < uses.size(); ++i)
+				recordedStep[uses[i].first.first].entries[uses[i].first.second].kernel.setArg(uses[i].second, bufferList[alias]);
+		}
+
+		void OpenCLBackend::SetHalfStorage(const BufferIdx bufferIdx)
+		{
+			if (halfBuffer.size() <= bufferIdx)
+				halfBuffer.resize(bufferIdx + 1, false);
+			halfBuffer[bufferIdx] = true;
+		}
+
+		void OpenCLBackend::SelectStorage(BaseOperation* operation)
+		{
+			KernelIdx kernelIdx = operation->GetKernelIdx();
+
+			std::vector<std::pair<size_t, BufferIdx>> arguments;
+			operation->GetBufferArguments(arguments);
+
+			//Each argument storing half is passed as define to the compiler. The arithmetic of the kernel stays in float.
+			std::string defines = kernelDefines[kernelIdx];
+			bool usesHalf = false;
+			for (size_t i = 0; i < arguments.size(); ++i)
+			{
+				if (!IsHalfStorage(arguments[i].second))
+					continue;
+
+				usesHalf = true;
+				if (!defines.empty())
+					defines += " ";
+				defines += "HALF_ARG" + std::to_string(arguments[i].first);
+			}
+
+			if (usesHalf)
+			{
+				if (namesToSources[kernelNames[kernelIdx]].find("STORAGE") == std::string::npos)
+					std::cerr << "Error kernel: " << kernelNames[kernelIdx] << " does not support half buffers" << std::endl;
+				else
+					kernelIdx = GetKernelIdx(kernelNames[kernelIdx], defines);
+			}
+
+			CreateIfNecessary(kernelIdx);
+			operation->SetKernel(kernels[kernelIdx], kernelIdx);
+		}
+
+		void OpenCLBackend::SetMaxBatch(const unsigned int maxBatch)
+		{
+			this->maxBatch = maxBatch;
+			activeBatch = maxBatch;
+		}
+
+		void OpenCLBackend::SetActiveBatch(unsigned int activeBatch)
+		{
+			if (activeBatch > maxBatch)
+			{
+				std::cout << "Error SetActiveBatch: Batch size bigger than the batch size the graph was created for" << std::endl;
+				activeBatch = maxBatch;
+			}
+			if (activeBatch == 0 || activeBatch == this->activeBatch)
+				return;
+			this->activeBatch = activeBatch;
+
+			UpdateBatchOperations();
+		}
+
+		OperationIdx OpenCLBackend::AddRecomputeOperations(const OperationIdx first, const OperationIdx last)
+		{
+			OperationIdx firstCopy = static_cast<OperationIdx>(backwardList.size());
+			for (size_t i = last - 1; i >= first && i < last; --i)
+			{
+				backwardList.push_back(forwardList[i]->Clone());
+				backwardSteps.push_back(forwardSteps[i]);
+#ifdef PROFILING_ENABLED
+				backwardTime.push_back(0);
+#endif // PROFILING_ENABLED
+			}
+			return firstCopy;
+		}
+
+		void OpenCLBackend::SetCurrentStep(const size_t step)
+		{
+			currentStep = step;
+			while (step != MAX_UNSIGNED_INT && stepBatch.size() <= step)
+				stepBatch.push_back(stepBatch.size() < stepLimits.size() && stepLimits[stepBatch.size()] < activeBatch ? stepLimits[stepBatch.size()] : activeBatch);
+		}
+
+		void OpenCLBackend::SetStepLimits(const std::vector<unsigned int>& limits)
+		{
+			stepLimits = limits;
+			UpdateBatchOperations();
+		}
+
+		bool OpenCLBackend::SkipsSteps() const
+		{
+			for (size_t t = 0; t < stepBatch.size(); ++t)
+				if (stepBatch[t] == 0)
+					return true;
+			return false;
+		}
+
+		unsigned int OpenCLBackend::OperationBatch(const std::vector<BaseOperation*>* opList, const size_t opIdx) const
+		{
+			const std::vector<size_t>* steps = opList == &forwardList ? &forwardSteps : (opList == &backwardList ? &backwardSteps : nullptr);
+			if (steps == nullptr || opIdx >= steps->size() || (*steps)[opIdx] >= stepBatch.size())
+				return activeBatch;
+			return stepBatch[(*steps)[opIdx]];
+		}
+
+		void OpenCLBackend::UpdateBatchOperations()
+		{
+			//The BatchArg arguments read the number of batch elements of their time step each time they are set
+			for (size_t t = 0; t < stepBatch.size(); ++t)
+				stepBatch[t] = t < stepLimits.size() && stepLimits[t] < activeBatch ? stepLimits[t] : activeBatch;
+
+			std::vector<BaseOperation*>* opLists[3] = { &forwardList, &backwardList, &updateList };
+			for (size_t l = 0; l < 3; ++l)
+				for (size_t i = 0; i < opLists[l]->size(); ++i)
+					(*opLists[l])[i]->SetActiveBatch(OperationBatch(opLists[l], i));
+
+			//Recorded kernels had their arguments set once. Set the arguments of the entries depending on the batch size again. Dynamic entries are run using the operation itself.
+			for (size_t p = 0; p < recordedStep.size(); ++p)
+			{
+				std::vector<LaunchEntry>& entries = recordedStep[p].entries;
+				for (size_t i = 0; i < entries.size(); ++i)
+				{
+					LaunchEntry& entry = entries[i];
+					if (entry.operation == nullptr || entry.dynamic || !entry.operation->DependsOnBatch())
+						continue;
+					entry.operation->SetArguments(&entry.kernel, bufferList);
+					entry.globalSize = entry.operation->GetGlobalSize();
+				}
+			}
+
+#ifdef cl_khr_command_buffer
+			//The commands stored in a command buffer can't be changed. They are recorded again once the replayed step finished.
+			if (!commandBuffers.empty())
+			{
+				if (replayPending)
+					replayEvent.wait();
+				ReleaseCommandBuffers();
+				CreateCommandBuffers();
+			}
+#endif // cl_khr_command_buffer
+		}
+
+		void OpenCLBackend::WriteDataBufferAsync(BufferIdx idx, const void* data, const size_t offset, const size_t size, const cl::Event* waitEvent, cl::Event* uploadEvent)
+		{
+			std::vector<cl::Event> waitList;
+			if (waitEvent != nullptr)
+				waitList.push_back(*waitEvent);
+
+#ifdef _DEBUG
+			cl_int err = uploadQueue.enqueueWriteBuffer(bufferList[idx], CL_FALSE, offset, size, data, waitList.empty() ? nullptr : &waitList, uploadEvent);
+			if (err != CL_SUCCESS)
+				std::cout << "Error write buffer async: " << err << std::endl;
+#else
+			uploadQueue.enqueueWriteBuffer(bufferList[idx], CL_FALSE, offset, size, data, waitList.empty() ? nullptr : &waitList, uploadEvent);
+#endif // DEBUG
+			//Start the transfer immediately instead of waiting for the next synchronization
+			uploadQueue.flush();
+		}
+
+		void OpenCLBackend::WaitForEvent(const cl::Event& event)
+		{
+			std::vector<cl::Event> waitList(1, event);
+#ifdef _DEBUG
+			cl_int err = comQueue.enqueueBarrierWithWaitList(&waitList);
+			if (err != CL_SUCCESS)
+				std::cout << "Error enqueue barrier: " << err << std::endl;
+#else
+			comQueue.enqueueBarrierWithWaitList(&waitList);
+#endif // DEBUG
+		}
+
+		void OpenCLBackend::EnqueueMarker(cl::Event* event)
+		{
+#ifdef _DEBUG
+			cl_int err = comQueue.enqueueMarkerWithWaitList(nullptr, event);
+			if (err != CL_SUCCESS)
+				std::cout << "Error enqueue marker: " << err << std::endl;
+#else
+			comQueue.enqueueMarkerWithWaitList(nullptr, event);
+#endif // DEBUG
+		}
+
+		void OpenCLBackend::ReadDataBuffer(BufferIdx idx, void* data, const size_t offset, const size_t size)
+		{
+#ifdef _DEBUG
+			cl_int err = comQueue.enqueueReadBuffer(bufferList[idx], CL_TRUE, offset, size, data);
+			if (err != CL_SUCCESS)
+				std::cout << "Error read buffer: " << err << std::endl;
+#else
+			comQueue.enqueueReadBuffer(bufferList[idx], CL_FALSE, offset, size, data);
+#endif // DEBUG
+		}
+
+		void OpenCLBackend::ReadDataBufferAsync(BufferIdx idx, void* data, const size_t offset, const size_t size, const cl::Event* waitEvent, cl::Event* readEvent)
+		{
+			ReadDataBufferAsync(bufferList[idx], data, offset, size, waitEvent, readEvent);
+		}
+
+		void OpenCLBackend::ReadDataBufferAsync(const cl::Buffer& buffer, void* data, const size_t offset, const size_t size, const cl::Event* waitEvent, cl::Event* readEvent)
+		{
+			std::vector<cl::Event> waitList;
+			if (waitEvent != nullptr)
+				waitList.push_back(*waitEvent);
+
+#ifdef _DEBUG
+			cl_int err = downloadQueue.enqueueReadBuffer(buffer, CL_FALSE, offset, size, data, waitList.empty() ? nullptr : &waitList, readEvent);
+			if (err != CL_SUCCESS)
+				std::cout << "Error read buffer async: " << err << std::endl;
+#else
+			downloadQueue.enqueueReadBuffer(buffer, CL_FALSE, offset, size, data, waitList.empty() ? nullptr : &waitList, readEvent);
+#endif // DEBUG
+			downloadQueue.flush();
+		}
+
+		void OpenCLBackend::RunOperation(const OperationIdx opIdx, const cl::Event* waitEvent, cl::Event* event)
+		{
+			std::vector<cl::Event> waitList;
+			if (waitEvent != nullptr)
+				waitList.push_back(*waitEvent);
+
+			standaloneList[opIdx]->Run(downloadQueue, waitList.empty() ? nullptr : &waitList, event, bufferList);
+			downloadQueue.flush();
+		}
+
+		void OpenCLBackend::CopyBuffer(BufferIdx src, BufferIdx dst, const size_t size)
+		{
+			//While a step is recorded the copy is appended to the launch table like a reset
+			if (recording)
+			{
+				RecordReset(dst, size, src);
+				return;
+			}
+
+#ifdef _DEBUG
+			cl_int err = comQueue.enqueueCopyBuffer(bufferList[src], bufferList[dst], 0, 0, size);
+			if (err != CL_SUCCESS)
+				std::cout << "Error copy buffer: " << err << std::endl;
+#else
+			comQueue.enqueueCopyBuffer(bufferList[src], bufferList[dst], 0, 0, size);
+#endif // DEBUG
+		}
+
+		void OpenCLBackend::RecordReset(BufferIdx idx, const size_t size, BufferIdx source)
+		{
+			if (recordedStep.empty() || (!recordedStep.back().entries.empty() && recordedStep.back().entries.back().operation != nullptr))
+			{
+				recordedStep.push_back(RecordedPass());
+				recordedStep.back().multiQueue = false;
+			}
+
+			LaunchEntry entry;
+			entry.operation = nullptr;
+			entry.dynamic = false;
+			entry.usesAlias = false;
+			entry.resetBuffer = idx;
+			entry.resetSize = size;
+			entry.copySource = source;
+			entry.queue = 0;
+			entry.waitForStart = false;
+			entry.signalEvent = false;
+			recordedStep.back().entries.push_back(entry);
+		}
+
+		void OpenCLBackend::ResetBuffer(BufferIdx idx, const size_t size)
+		{
+			//While a step is recorded the reset is appended to the launch table instead
+			if (recording)
+			{
+				RecordReset(idx, size, MAX_UNSIGNED_INT);
+				return;
+			}
+
+			FillZero(comQueue, idx, size, nullptr, nullptr);
+		}
+
+		void OpenCLBackend::FillZero(cl::CommandQueue& queue, BufferIdx idx, const size_t size, const std::vector<cl::Event>* waitList, cl::Event* event)
+		{
+			//The size of a fill must be a multiple of the pattern size. Compact input buffers (uint8, int16, half) may have any size and are filled byte wise.
+#ifdef _DEBUG
+			cl_int err;
+			if (size % sizeof(cl_float) == 0)
+				err = queue.enqueueFillBuffer<cl_float>(bufferList[idx], 0.f, 0, size, waitList, event);
+			else
+				err = queue.enqueueFillBuffer<cl_uchar>(bufferList[idx], 0, 0, size, waitList, event);
+			if (err != CL_SUCCESS)
+				std::cout << "Error fill buffer: " << err << std::endl;
+#else
+			if (size % sizeof(cl_float) == 0)
+				queue.enqueueFillBuffer<cl_float>(bufferList[idx], 0.f, 0, size, waitList, event);
+			else
+				queue.enqueueFillBuffer<cl_uchar>(bufferList[idx], 0, 0, size, waitList, event);
+#endif // DEBUG
+		}
+	}
+}
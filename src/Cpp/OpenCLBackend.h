@@ -1,216 +1,563 @@
-#pragma once
-
-#include <vector>
-#include <memory>
-#include <map>
-
-#include "Operation.h"
-
-namespace DeepCL
-{
-	namespace BackendSystem
-	{
-
-		//Class for Interacting with OpenCL (Creating OpenCL Buffer, Kernel, etc.)
-		//It also handles the execution of each different Pass(Forward, Backward, Update)
-		class OpenCLBackend
-		{
-		public:
-			OpenCLBackend();
-			~OpenCLBackend();
-
-			//Used to describe the type of the operation
-			enum OperationType
-			{
-				FORWARD, BACKWARD, UPDATE
-			};
-
-			//Needs to be run in order to Initalize OpenCL:
-			//Quering and selecting a vendor/device.
-			//Loading the Code out of kernel files
-			DeepCLError InitGPU();
-
-			//Loads a specific kernel File
-			DeepCLError LoadKernel(const std::string& kernelFolder);
-
-			//Loads kernels using a kernel config file. The kernels must be contained in the path specified by kernelPath.
-			DeepCLError LoadKernelFromConfig(const std::string& configFilePath, const std::string& kernelPath);
-
-			//Return the index of a specific Kernel object stored in kernels.
-			KernelIdx GetKernelIdx(const std::string& fileName);
-			//Returns the index of a specific Kernel object stored in kernels, allowing additional kernel defines.
-			KernelIdx GetKernelIdx(const std::string& fileName, const std::string& compileDefines);
-
-			//Adds an operation to the specific Operation vector defined by opType
-			template<size_t Tsize, class... Ts>
-			OperationIdx AddOperation(const KernelIdx kernel,
-				const Tuple<Ts...> tuple,
-				const cl::NDRange offset,
-				const cl::NDRange globalSize,
-				const cl::NDRange localSize, const OperationType opType);
-
-			//Adds an increment operation to the specific Operation vector defined by opType
-			template<size_t idx, size_t Tsize, class... Ts>
-			OperationIdx AddOperation(const KernelIdx kernel,
-				const Tuple<Ts...> tuple,
-				const cl::NDRange offset,
-				const cl::NDRange globalSize,
-				const cl::NDRange localSize, const OperationType opType);
-
-			//Runs a specific kernel objects using the in tuple defined parameters
-			template<size_t Tsize, class... Ts>
-			void RunKernel(const KernelIdx kernel, const Tuple<Ts...> tuple, const cl::NDRange offset, const cl::NDRange globalSize, const cl::NDRange localSize);
-			
-			//Executes one of the three passes specified by opType.
-			void Run(const OperationType opType);
-
-			//Returns the time a specific operation takes in the specified pass.
-#ifdef PROFILING_ENABLED
-			unsigned long long GetTime(const OperationIdx opIdx, const OperationType opType);
-#endif // PROFILING_ENABLED
-
-			//Creates a buffer which inclues padding to allow the specified number of sub buffers
-			BufferIdx CreateBuffer(const size_t size, const MEM_FLAG memFlag, const size_t numSubBuffer);
-
-			//Creates a subbuffer in the by bufferIdx specified buffer. 
-			BufferIdx CreateSubBuffer(const BufferIdx bufferIdx, const size_t size, const MEM_FLAG memFlag, const size_t idxBuffer);
-			//Write data into an arbitrary buffer
-			void WriteDataBuffer(BufferIdx idx, const void* data, const size_t offset, const size_t size);
-			//Read the content of a specified buffer into data
-			void ReadDataBuffer(BufferIdx idx, void* data, const size_t offset, const size_t size);
-			//Set the specified buffer to zero.
-			void ResetBuffer(BufferIdx idx, const size_t size);
-
-			//Returns the alilgnment needed when creating subbuffers
-			cl_uint GetBaseAddrAllignment()const { return baseAddrAllign; }
-
-		private:
-
-			//Vector contains pointer on all kernel objects avialable (Some may not be initalized directly)
-			std::vector<cl::Kernel*> kernels;
-
-			//Contains the name of a kernel and the corresponding source code
-			std::map < std::string, std::string> namesToSources;
-
-			//Allows the retrival of the kernel index using the name of it
-			std::map < std::string, KernelIdx> kernelTypesToIdx;
-
-			//Contains kernel objects with the corresponding compile time arguments that must be created
-			std::map < KernelIdx, std::string> needsToCreate;
-
-			//List of OpenCL program objects
-			std::vector<cl::Program> programList;
-
-			//Checks if kernel needs to be created(contained in needsToCreate) and does so if it is the case using BuildSingleKernel
-			void CreateIfNecessary(const KernelIdx kernelIdx);
-
-			//Builds a single kernel from source
-			void BuildSingleKernel(const std::string& fileName, const std::string& defineArguments, const KernelIdx kernelIdx);
-
-			//Runs all kernels in opList from start to end
-			void RunForward(std::vector<BaseOperation*>* opList, 
-#ifdef PROFILING_ENABLED
-				std::vector<cl_ulong>* opTimes,
-#endif // PROFILING_ENABLED
-				 const size_t);
-
-			//Runs all kernels in opList from end to start
-			void RunBackward(std::vector<BaseOperation*>* opList, 
-#ifdef PROFILING_ENABLED
-				std::vector<cl_ulong>* opTimes,
-#endif // PROFILING_ENABLED
-				const size_t);
-
-			//Stores the chosen platform
-			cl::Platform platform;
-
-			//Stores the chosen device
-			cl::Device device;
-			
-			//Stores the created context
-			cl::Context context;
-
-			//Stores the comQueue used by the whole backend.
-			cl::CommandQueue comQueue;
-
-			//Vector of operations for the forward pass
-			std::vector<BaseOperation*> forwardList;
-
-			//Vector of operations for the backward pass
-			std::vector<BaseOperation*> backwardList;
-
-			//Vector of operations for the update pass
-			std::vector<BaseOperation*> updateList;
-
-			//Vectors to store operation times
-#ifdef PROFILING_ENABLED
-			std::vector<cl_ulong> forwardTime;
-			std::vector<cl_ulong> backwardTime;
-			std::vector<cl_ulong> updateTime;
-#endif
-
-			//The necessary alignment for sub buffers
-			cl_uint baseAddrAllign;
-
-			//List of all used OpenCL Buffers (Normal and Sub Buffers)
-			std::vector<cl::Buffer> bufferList;
-
-			//Event to calculate the timing information
-			cl::Event timingEvent;
-		};
-
-		template<size_t Tsize, class... Ts>
-		OperationIdx OpenCLBackend::AddOperation(const KernelIdx kernel,
-			const Tuple<Ts...> tuple,
-			const cl::NDRange offset,
-			const cl::NDRange globalSize,
-			const cl::NDRange localSize, const OperationType opType)
-		{
-
-			//If the kernel was not created before it gets created now
-			CreateIfNecessary(kernel);
-
-			//Create and Add operation to the vector of the corresponding pass
-			Operation<Tsize, Ts...>* operation = new Operation<Tsize, Ts...>((kernels[kernel]), tuple, offset, globalSize, localSize);
-
-			std::vector<BaseOperation*>* opList = opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList);
-			opList->push_back(operation);
-#ifdef PROFILING_ENABLED
-			std::vector<cl_ulong>* opTimes = opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime);
-			opTimes->push_back(0);
-#endif // PROFILING_ENABLED
-			return opList->size() - 1;
-		}
-
-
-		template<size_t idx, size_t Tsize, class... Ts>
-		OperationIdx OpenCLBackend::AddOperation(const KernelIdx kernel,
-			const Tuple<Ts...> tuple,
-			const cl::NDRange offset,
-			const cl::NDRange globalSize,
-			const cl::NDRange localSize, const OperationType opType)
-		{
-			CreateIfNecessary(kernel);
-			
-			//Create an operation that increments the variable at index every time step
-			IncrementOperation<idx, Tsize, Ts...>* operation = new IncrementOperation<idx, Tsize, Ts...>((kernels[kernel]), tuple, offset, globalSize, localSize);
-
-			std::vector<BaseOperation*>* opList = opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList);
-			opList->push_back(operation);
-#ifdef PROFILING_ENABLED
-			std::vector<cl_ulong>* opTimes = opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime);
-			opTimes->push_back(0);
-#endif // PROFILING_ENABLED
-			return opList->size() - 1;
-		}
-
-		//Run a specific kernel object
-		template<size_t Tsize, class... Ts>
-		void OpenCLBackend::RunKernel(const KernelIdx kernel, const Tuple<Ts...> tuple, const cl::NDRange offset, const cl::NDRange globalSize, const cl::NDRange localSize)
-		{
-			Operation<Tsize, Ts...>* operation = new Operation<Tsize, Ts...>(kernel[kernel], tuple, offset, globalSize, localSize);
-			operation->Run(comQueue, &timingEvent, bufferList);
-		}
-	}
-}
-
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <map>
+#include <set>
+
+#include "Operation.h"
+
+namespace DeepCL
+{
+	namespace BackendSystem
+	{
+
+		//Entry of the precomputed execution order of a pass when the operations are distributed over multiple queues.
+		struct ScheduledOperation
+		{
+			BaseOperation* operation;
+
+			//Index of the operation in the vector of its pass (Used for the profiling information)
+			OperationIdx opIdx;
+
+			//Queue the operation is enqueued into
+			size_t queue;
+
+			//Indices (in the schedule) of operations on other queues the operation must wait for.
+			std::vector<size_t> waitOn;
+
+			//True if the operation has no dependency inside the pass but runs on another queue than comQueue. It must wait for the commands enqueued into comQueue before the pass.
+			bool waitForStart;
+
+			//True if another operation waits for this operation
+			bool signalEvent;
+		};
+
+		//Operation switched to the kernel variant overwriting its results and the buffers it overwrites.
+		struct OverwriteOperation
+		{
+			BaseOperation* operation;
+			KernelIdx accumulateKernel;
+			KernelIdx overwriteKernel;
+			std::vector<BufferIdx> buffers;
+		};
+
+		//Entry of a recorded step. Either a kernel launch or the reset of a buffer.
+		struct LaunchEntry
+		{
+			//Kernel object only used by this entry. The arguments are set once when the step is recorded.
+			cl::Kernel kernel;
+
+			//Operation the entry was recorded from (nullptr for buffer resets and copies)
+			BaseOperation* operation;
+
+			cl::NDRange offset;
+			cl::NDRange globalSize;
+			cl::NDRange localSize;
+
+			//Dynamic entries change their arguments each run (For example the time step of Adam) and are executed using the operation itself.
+			bool dynamic;
+
+			//True if the entry refers to a buffer alias which might be rebound between runs.
+			bool usesAlias;
+
+			//Buffer and size in bytes of a reset entry. If copySource is set the buffer is copied from copySource instead of being set to zero.
+			BufferIdx resetBuffer;
+			size_t resetSize;
+			BufferIdx copySource;
+
+			//Synchronization information copied from the schedule (See ScheduledOperation)
+			size_t queue;
+			std::vector<size_t> waitOn;
+			bool waitForStart;
+			bool signalEvent;
+		};
+
+		//All entries of one recorded pass. A pass starts after the previous pass finished.
+		struct RecordedPass
+		{
+			std::vector<LaunchEntry> entries;
+			bool multiQueue;
+		};
+
+		//Class for Interacting with OpenCL (Creating OpenCL Buffer, Kernel, etc.)
+		//It also handles the execution of each different Pass(Forward, Backward, Update)
+		class OpenCLBackend
+		{
+		public:
+			OpenCLBackend();
+			~OpenCLBackend();
+
+			//Used to describe the type of the operation
+			enum OperationType
+			{
+				FORWARD, BACKWARD, UPDATE
+			};
+
+			//Needs to be run in order to Initalize OpenCL:
+			//Quering and selecting a vendor/device.
+			//Loading the Code out of kernel files
+			DeepCLError InitGPU();
+			//Creates the context and the queues for the device without asking the user (Used when multiple devices are trained at once).
+			DeepCLError InitDevice(const cl::Device& device);
+
+			//Returns the devices of the given type of all platforms.
+			static std::vector<cl::Device> GetDevices(const cl_device_type type = CL_DEVICE_TYPE_ALL);
+			//Splits a device (In general a CPU) into one sub device for each NUMA node. Returns the device itself if it can't be split.
+			static std::vector<cl::Device> SplitByNUMA(const cl::Device& device);
+
+			//Loads a specific kernel File
+			DeepCLError LoadKernel(const std::string& kernelFolder);
+
+			//Loads kernels using a kernel config file. The kernels must be contained in the path specified by kernelPath.
+			DeepCLError LoadKernelFromConfig(const std::string& configFilePath, const std::string& kernelPath);
+
+			//Return the index of a specific Kernel object stored in kernels.
+			KernelIdx GetKernelIdx(const std::string& fileName);
+			//Returns the index of a specific Kernel object stored in kernels, allowing additional kernel defines.
+			KernelIdx GetKernelIdx(const std::string& fileName, const std::string& compileDefines);
+
+			//Adds an operation to the specific Operation vector defined by opType
+			template<size_t Tsize, class... Ts>
+			OperationIdx AddOperation(const KernelIdx kernel,
+				const Tuple<Ts...> tuple,
+				const cl::NDRange offset,
+				const cl::NDRange globalSize,
+				const cl::NDRange localSize, const OperationType opType);
+
+			//Adds an increment operation to the specific Operation vector defined by opType
+			template<size_t idx, size_t Tsize, class... Ts>
+			OperationIdx AddOperation(const KernelIdx kernel,
+				const Tuple<Ts...> tuple,
+				const cl::NDRange offset,
+				const cl::NDRange globalSize,
+				const cl::NDRange localSize, const OperationType opType);
+
+			//Adds an operation whose global work size depends on the active batch size. The global work size is computed for the current active batch size.
+			template<size_t Tsize, class... Ts>
+			OperationIdx AddOperation(const KernelIdx kernel,
+				const Tuple<Ts...> tuple,
+				const cl::NDRange offset,
+				const BatchRange& globalSize,
+				const cl::NDRange localSize, const OperationType opType);
+
+			//Adds an operation which is not part of a pass. It is only executed by RunOperation (Used for kernels run on demand like the compression of gradients).
+			template<size_t Tsize, class... Ts>
+			OperationIdx AddStandaloneOperation(const KernelIdx kernel,
+				const Tuple<Ts...> tuple,
+				const cl::NDRange offset,
+				const cl::NDRange globalSize,
+				const cl::NDRange localSize);
+			//Enqueues a standalone operation into the download queue after waitEvent finished (if waitEvent is not a nullptr). It can run while the compute queue executes a pass
+			//and reads enqueued afterwards wait for it. event (if not a nullptr) finishes with the operation.
+			void RunOperation(const OperationIdx opIdx, const cl::Event* waitEvent, cl::Event* event);
+
+			//Removes the operation added last to the pass and returns it. The operation is not deleted, the caller takes ownership.
+			BaseOperation* PopOperation(const OperationType opType);
+			//Puts operation at the position opIdx of the pass and returns the operation stored there before. The backend takes ownership of operation, the caller of the returned one.
+			//A recorded step is discarded. BuildSchedule must be called again after the operations were exchanged.
+			BaseOperation* ExchangeOperation(const OperationIdx opIdx, const OperationType opType, BaseOperation* operation);
+
+			//Enqueues the operations of the pass without waiting for them. After the operation at positions[i] of the execution order a marker is enqueued into markers[i].
+			//With multiple queues the markers are enqueued after the complete pass.
+			void RunWithMarkers(const OperationType opType, const std::vector<size_t>& positions, std::vector<cl::Event>& markers);
+			//Returns the number of operations in the pass and the buffers passed to an operation.
+			size_t GetNumOperations(const OperationType opType) const;
+			void GetOperationBuffers(const OperationIdx opIdx, const OperationType opType, std::vector<BufferIdx>& buffers);
+
+			//Sets the number of batch elements the operations are created for. The active batch size is set to the same value.
+			void SetMaxBatch(const unsigned int maxBatch);
+			//Sets the number of batch elements processed by the following passes (At most the maximal batch size). The arguments created with BatchArg
+			//and the global work sizes specified by a BatchRange follow the new value. A recorded step is updated without being recorded again.
+			void SetActiveBatch(unsigned int activeBatch);
+			unsigned int GetActiveBatch() const { return activeBatch; }
+			//Returns a kernel argument set to perElement times the active batch size (The number of batch elements of the current time step, see SetCurrentStep).
+			BatchArgument BatchArg(const int perElement) const { return BatchArgument(perElement, currentStep < stepBatch.size() ? &stepBatch[currentStep] : &activeBatch); }
+
+			//Appends copies of the forward operations first to last - 1 to the backward pass. Since the backward pass runs in reverse order they are added in reverse order and
+			//run in the order of the forward pass. The copies belong to the time steps of the original operations. Returns the index of the first added operation.
+			OperationIdx AddRecomputeOperations(const OperationIdx first, const OperationIdx last);
+
+			//Sets the time step the operations added afterwards to the forward and backward pass belong to. MAX_UNSIGNED_INT for operations not belonging to a time step.
+			//The BatchArg arguments and BatchRange work sizes of an operation follow the number of batch elements of its time step.
+			void SetCurrentStep(const size_t step);
+			//Limits the number of batch elements processed at time step t to limits[t] (At most the active batch size). An empty vector removes the limits.
+			//The batch elements must be sorted by their sequence length. Operations of time steps without batch elements are skipped.
+			void SetStepLimits(const std::vector<unsigned int>& limits);
+			//Returns true if the operations of a time step are skipped. Such passes are run in order on a single queue and can't be replayed.
+			bool SkipsSteps() const;
+
+			//Runs a specific kernel objects using the in tuple defined parameters
+			template<size_t Tsize, class... Ts>
+			void RunKernel(const KernelIdx kernel, const Tuple<Ts...> tuple, const cl::NDRange offset, const cl::NDRange globalSize, const cl::NDRange localSize);
+			
+			//Executes one of the three passes specified by opType.
+			void Run(const OperationType opType);
+
+			//Determines for each buffer written in the backward pass if the first operation writing it can overwrite its content instead of adding to it.
+			//Those operations are switched to the kernel variant compiled with OVERWRITE_RESULT and the buffer doesn't need to be reset after each batch.
+			//Must be called after all operations were added and before a step is recorded.
+			void BuildOverwriteFirst();
+			//Returns false if the buffer is completely overwritten by the first operation of the backward pass writing it.
+			bool RequiresReset(const BufferIdx idx) const;
+			//Lets the first operation writing the buffer add to its content instead of overwriting it (Used to accumulate gradients over multiple batches).
+			void SetAccumulate(const BufferIdx idx, const bool accumulate);
+
+			//Starts recording a step. The passes recorded with RecordPass and the buffers reset using ResetBuffer are stored in a launch table instead of being executed.
+			void BeginRecording();
+			//Appends the operations of the pass to the recorded step using the schedule of the pass if multiple queues are used.
+			void RecordPass(const OperationType opType);
+			//Finishes the recording. If the device supports cl_khr_command_buffer the static parts of the step are stored in command buffers.
+			void EndRecording();
+			//Enqueues the recorded step. It only waits for the previously replayed step to finish, the commands are executed asynchronously.
+			void Replay();
+			//Returns true if a step was recorded and no operation was added since then.
+			bool IsRecorded() const;
+
+			//Sets the number of queues the operations are distributed over. Must be called before BuildSchedule. With one queue all operations run in order on comQueue.
+			void SetNumQueues(const size_t numQueues);
+
+			//Computes the dependencies between the operations of each pass using the buffers they read and write. Independent operations are distributed over the available queues
+			//and synchronized using events. Must be called after all operations were added.
+			void BuildSchedule();
+
+			//Returns the time a specific operation takes in the specified pass.
+#ifdef PROFILING_ENABLED
+			unsigned long long GetTime(const OperationIdx opIdx, const OperationType opType);
+#endif // PROFILING_ENABLED
+
+			//Creates a buffer which inclues padding to allow the specified number of sub buffers
+			BufferIdx CreateBuffer(const size_t size, const MEM_FLAG memFlag, const size_t numSubBuffer);
+
+			//Creates a subbuffer in the by bufferIdx specified buffer. 
+			BufferIdx CreateSubBuffer(const BufferIdx bufferIdx, const size_t size, const MEM_FLAG memFlag, const size_t idxBuffer);
+			//Creates a sub buffer of size bytes starting offset bytes into the buffer. The offset must be a multiple of the base address alignment.
+			//Sub buffers created this way may overlap each other, therefore the schedule treats all of them as overlapping.
+			BufferIdx CreateSubBufferAt(const BufferIdx bufferIdx, const size_t offset, const size_t size, const MEM_FLAG memFlag);
+			//Creates an additional index referring to the same OpenCL buffer as bufferIdx. Operations using the alias can be redirected to another buffer with BindBuffer.
+			BufferIdx CreateBufferAlias(const BufferIdx bufferIdx);
+			//Lets the alias refer to the OpenCL buffer specified by bufferIdx. Since the arguments are set each time an operation is run no operation needs to be recreated.
+			void BindBuffer(const BufferIdx alias, const BufferIdx bufferIdx);
+			//Marks the buffer as storing half instead of float. Operations added afterwards using the buffer execute a variant of their kernel compiled with HALF_ARGn for the argument.
+			void SetHalfStorage(const BufferIdx bufferIdx);
+			bool IsHalfStorage(const BufferIdx bufferIdx) const { return bufferIdx < halfBuffer.size() && halfBuffer[bufferIdx]; }
+
+			//Write data into an arbitrary buffer
+			void WriteDataBuffer(BufferIdx idx, const void* data, const size_t offset, const size_t size);
+			//Write data into an arbitrary buffer using the upload queue. The transfer starts after waitEvent finished (if waitEvent is not a nullptr) and signals uploadEvent when it is done.
+			//The data must stay valid until uploadEvent finished.
+			void WriteDataBufferAsync(BufferIdx idx, const void* data, const size_t offset, const size_t size, const cl::Event* waitEvent, cl::Event* uploadEvent);
+			//All commands enqueued afterwards into the compute queue wait until event finished.
+			void WaitForEvent(const cl::Event& event);
+			//Enqueues a marker into the compute queue. event finishes after all commands enqueued before finished.
+			void EnqueueMarker(cl::Event* event);
+			//Read the content of a specified buffer into data
+			void ReadDataBuffer(BufferIdx idx, void* data, const size_t offset, const size_t size);
+			//Read the content of a buffer using the download queue. The transfer starts after waitEvent finished (if waitEvent is not a nullptr) and signals readEvent when it is done.
+			//Can be called from a different thread than the one running the passes as long as no buffers are created at the same time.
+			void ReadDataBufferAsync(BufferIdx idx, void* data, const size_t offset, const size_t size, const cl::Event* waitEvent, cl::Event* readEvent);
+			//Same as above for a handle returned by GetBuffer. Can be called from a different thread while buffers are created.
+			void ReadDataBufferAsync(const cl::Buffer& buffer, void* data, const size_t offset, const size_t size, const cl::Event* waitEvent, cl::Event* readEvent);
+			//Returns a copy of the handle of a buffer. The copy stays valid when the list of buffers grows.
+			cl::Buffer GetBuffer(BufferIdx idx) const { return bufferList[idx]; }
+			//Copies the first size bytes of src into dst using the compute queue.
+			void CopyBuffer(BufferIdx src, BufferIdx dst, const size_t size);
+			//Set the specified buffer to zero.
+			void ResetBuffer(BufferIdx idx, const size_t size);
+
+			//Returns the alilgnment needed when creating subbuffers
+			cl_uint GetBaseAddrAllignment()const { return baseAddrAllign; }
+			//Returns the number of compute units and the size in bytes of the local memory of the device. Needed by kernels whose work groups must all run at the same time.
+			cl_uint GetNumComputeUnits() const { return numComputeUnits; }
+			cl_ulong GetLocalMemSize() const { return localMemSize; }
+
+		private:
+
+			//Vector contains pointer on all kernel objects avialable (Some may not be initalized directly)
+			std::vector<cl::Kernel*> kernels;
+
+			//Contains the name of a kernel and the corresponding source code
+			std::map < std::string, std::string> namesToSources;
+
+			//Source of the kernel files without kernels (Storage macros etc.). It is placed in front of the source of each kernel.
+			std::string kernelPreamble;
+
+			//Contains the name of a kernel and the source in front of the first kernel of its file (Defines and helper functions shared by the kernels of the file).
+			std::map < std::string, std::string> namesToHeaders;
+
+			//Allows the retrival of the kernel index using the name of it
+			std::map < std::string, KernelIdx> kernelTypesToIdx;
+
+			//Contains kernel objects with the corresponding compile time arguments that must be created
+			std::map < KernelIdx, std::string> needsToCreate;
+
+			//List of OpenCL program objects
+			std::vector<cl::Program> programList;
+
+			//Checks if kernel needs to be created(contained in needsToCreate) and does so if it is the case using BuildSingleKernel
+			void CreateIfNecessary(const KernelIdx kernelIdx);
+
+			//Builds a single kernel from source
+			void BuildSingleKernel(const std::string& fileName, const std::string& defineArguments, const KernelIdx kernelIdx);
+
+			//Lets the operation execute the variant of its kernel matching the storage of its buffer arguments and creates the kernel if necessary.
+			void SelectStorage(BaseOperation* operation);
+
+			//Returns for each argument of the kernel if it is a buffer that might be written. Every global pointer that is not declared const is assumed to be written.
+			static std::vector<bool> ParseWrittenArguments(const std::string& kernelSource);
+
+			//Returns the indices of the operations of the pass in the order they are executed.
+			void BuildSequence(const OperationType opType, std::vector<OperationIdx>& sequence);
+
+			//Computes the schedule of a single pass.
+			void BuildSchedule(const OperationType opType, std::vector<ScheduledOperation>& schedule);
+
+			//Returns the buffer itself, the buffer containing it if it is a sub buffer and its sub buffers. Operations accessing any of them depend on each other.
+			void GetOverlappingBuffers(const BufferIdx idx, std::vector<BufferIdx>& overlapping) const;
+
+			//Enqueues the operations of a pass using the schedule computed by BuildSchedule.
+			void RunScheduled(std::vector<ScheduledOperation>& schedule);
+
+			//Enqueues a single entry of a recorded step.
+			void Launch(LaunchEntry& entry, cl::CommandQueue& queue, const std::vector<cl::Event>* waitList, cl::Event* event);
+
+			//Sets the first size bytes of the buffer to zero.
+			void FillZero(cl::CommandQueue& queue, BufferIdx idx, const size_t size, const std::vector<cl::Event>* waitList, cl::Event* event);
+
+			//Appends a reset (source is MAX_UNSIGNED_INT) or a copy from source to the recorded step.
+			void RecordReset(BufferIdx idx, const size_t size, BufferIdx source);
+
+			//Creates a new kernel object from the program of kernelIdx.
+			cl::Kernel CloneKernel(const KernelIdx kernelIdx);
+
+			//Runs all kernels in opList from start to end
+			void RunForward(std::vector<BaseOperation*>* opList, 
+#ifdef PROFILING_ENABLED
+				std::vector<cl_ulong>* opTimes,
+#endif // PROFILING_ENABLED
+				 const size_t);
+
+			//Runs all kernels in opList from end to start
+			void RunBackward(std::vector<BaseOperation*>* opList, 
+#ifdef PROFILING_ENABLED
+				std::vector<cl_ulong>* opTimes,
+#endif // PROFILING_ENABLED
+				const size_t);
+
+			//Stores the chosen platform
+			cl::Platform platform;
+
+			//Stores the chosen device
+			cl::Device device;
+			
+			//Stores the created context
+			cl::Context context;
+
+			//Stores the comQueue used by the whole backend.
+			cl::CommandQueue comQueue;
+
+			//Second queue used to upload input data while the comQueue computes the current batch.
+			cl::CommandQueue uploadQueue;
+
+			//Third queue used to read buffers in the background.
+			cl::CommandQueue downloadQueue;
+
+			//Number of queues operations are distributed over and the additional queues (The first queue is comQueue).
+			size_t numQueues;
+			std::vector<cl::CommandQueue> computeQueues;
+
+			//For each kernel index if an argument is a buffer that is written by the kernel.
+			std::vector<std::vector<bool>> kernelArgWritten;
+
+			//For each kernel index the program, the name and the compile defines it was created with. Allows the creation of further kernel objects.
+			std::vector<size_t> kernelProgram;
+			std::vector<std::string> kernelNames;
+			std::vector<std::string> kernelDefines;
+
+			//For each buffer if it stores half instead of float.
+			std::vector<bool> halfBuffer;
+
+			//For each buffer if the first writing operation in the backward pass overwrites it and if it currently accumulates instead.
+			std::vector<bool> overwrittenBuffer;
+			std::vector<bool> accumulateBuffer;
+			std::vector<OverwriteOperation> overwriteOperations;
+
+			//The recorded step and the number of operations in each pass when it was recorded.
+			std::vector<RecordedPass> recordedStep;
+			size_t recordedSizes[3];
+			bool recording;
+			bool replayPending;
+			cl::Event replayEvent;
+			//Waits for the replayed step and releases the launch table and command buffers.
+			void DiscardRecording();
+
+			//Maximal number of batch elements and the number of batch elements processed by the passes.
+			unsigned int maxBatch;
+			unsigned int activeBatch;
+
+			//Number of batch elements processed at each time step and the limits set by SetStepLimits. A deque keeps the addresses passed to BatchArg valid.
+			std::deque<unsigned int> stepBatch;
+			std::vector<unsigned int> stepLimits;
+			size_t currentStep;
+			//Time step of each operation of the forward and backward pass (MAX_UNSIGNED_INT if it belongs to none)
+			std::vector<size_t> forwardSteps;
+			std::vector<size_t> backwardSteps;
+
+			//Returns the number of batch elements processed by the operation at position opIdx of the pass.
+			unsigned int OperationBatch(const std::vector<BaseOperation*>* opList, const size_t opIdx) const;
+			//Sets the batch size of each operation and of the recorded entries depending on it.
+			void UpdateBatchOperations();
+
+			//The buffer containing each sub buffer and the sub buffers of each buffer. Allows operations to access all time steps through the base buffer.
+			std::map<BufferIdx, BufferIdx> parentBuffer;
+			std::map<BufferIdx, std::vector<BufferIdx>> subBuffers;
+			//Buffers whose sub buffers were created with CreateSubBufferAt
+			std::set<BufferIdx> sharedBuffers;
+
+			//Buffer aliases and for each alias the recorded entries and argument positions using it.
+			std::map<BufferIdx, std::vector<std::pair<std::pair<size_t, size_t>, size_t>>> aliasUses;
+
+#ifdef cl_khr_command_buffer
+			//Command buffers containing consecutive static entries of the recorded step (Only used with a single queue)
+			//For each entry of the flattened step the index of the command buffer containing it or MAX_UNSIGNED_INT.
+			std::vector<cl_command_buffer_khr> commandBuffers;
+			std::vector<size_t> entryCommandBuffer;
+			bool commandBufferSupported;
+			clCreateCommandBufferKHR_fn createCommandBuffer;
+			clCommandNDRangeKernelKHR_fn commandNDRangeKernel;
+			clFinalizeCommandBufferKHR_fn finalizeCommandBuffer;
+			clEnqueueCommandBufferKHR_fn enqueueCommandBuffer;
+			clReleaseCommandBufferKHR_fn releaseCommandBuffer;
+
+			//Queries the extension functions. Returns false if the device doesn't support command buffers.
+			bool LoadCommandBufferFunctions();
+			//Stores runs of consecutive static entries in command buffers.
+			void CreateCommandBuffers();
+			void ReleaseCommandBuffers();
+#endif // cl_khr_command_buffer
+
+			//Schedules of the different passes and the events used to synchronize the queues.
+			std::vector<ScheduledOperation> forwardSchedule;
+			std::vector<ScheduledOperation> backwardSchedule;
+			std::vector<ScheduledOperation> updateSchedule;
+			std::vector<cl::Event> scheduleEvents;
+
+			//Vector of operations for the forward pass
+			std::vector<BaseOperation*> forwardList;
+
+			//Vector of operations for the backward pass
+			std::vector<BaseOperation*> backwardList;
+
+			//Vector of operations for the update pass
+			std::vector<BaseOperation*> updateList;
+
+			//Vector of operations executed on demand
+			std::vector<BaseOperation*> standaloneList;
+
+			//Vectors to store operation times
+#ifdef PROFILING_ENABLED
+			std::vector<cl_ulong> forwardTime;
+			std::vector<cl_ulong> backwardTime;
+			std::vector<cl_ulong> updateTime;
+#endif
+
+			//The necessary alignment for sub buffers
+			cl_uint baseAddrAllign;
+
+			cl_uint numComputeUnits;
+			cl_ulong localMemSize;
+
+			//List of all used OpenCL Buffers (Normal and Sub Buffers)
+			std::vector<cl::Buffer> bufferList;
+
+			//Event to calculate the timing information
+			cl::Event timingEvent;
+		};
+
+		template<size_t Tsize, class... Ts>
+		OperationIdx OpenCLBackend::AddOperation(const KernelIdx kernel,
+			const Tuple<Ts...> tuple,
+			const cl::NDRange offset,
+			const cl::NDRange globalSize,
+			const cl::NDRange localSize, const OperationType opType)
+		{
+
+			//Create and Add operation to the vector of the corresponding pass
+			Operation<Tsize, Ts...>* operation = new Operation<Tsize, Ts...>((kernels[kernel]), kernel, tuple, offset, globalSize, localSize);
+
+			//If the kernel was not created before it gets created now. Buffers storing half require another variant of the kernel.
+			SelectStorage(operation);
+
+			std::vector<BaseOperation*>* opList = opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList);
+			opList->push_back(operation);
+			if (opType != OperationType::UPDATE)
+				(opType == OperationType::FORWARD ? forwardSteps : backwardSteps).push_back(currentStep);
+#ifdef PROFILING_ENABLED
+			std::vector<cl_ulong>* opTimes = opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime);
+			opTimes->push_back(0);
+#endif // PROFILING_ENABLED
+			return opList->size() - 1;
+		}
+
+
+		template<size_t idx, size_t Tsize, class... Ts>
+		OperationIdx OpenCLBackend::AddOperation(const KernelIdx kernel,
+			const Tuple<Ts...> tuple,
+			const cl::NDRange offset,
+			const cl::NDRange globalSize,
+			const cl::NDRange localSize, const OperationType opType)
+		{
+			//Create an operation that increments the variable at index every time step
+			IncrementOperation<idx, Tsize, Ts...>* operation = new IncrementOperation<idx, Tsize, Ts...>((kernels[kernel]), kernel, tuple, offset, globalSize, localSize);
+			SelectStorage(operation);
+
+			std::vector<BaseOperation*>* opList = opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList);
+			opList->push_back(operation);
+			if (opType != OperationType::UPDATE)
+				(opType == OperationType::FORWARD ? forwardSteps : backwardSteps).push_back(currentStep);
+#ifdef PROFILING_ENABLED
+			std::vector<cl_ulong>* opTimes = opType == OperationType::FORWARD ? &forwardTime : (opType == OperationType::BACKWARD ? &backwardTime : &updateTime);
+			opTimes->push_back(0);
+#endif // PROFILING_ENABLED
+			return opList->size() - 1;
+		}
+
+		template<size_t Tsize, class... Ts>
+		OperationIdx OpenCLBackend::AddOperation(const KernelIdx kernel,
+			const Tuple<Ts...> tuple,
+			const cl::NDRange offset,
+			const BatchRange& globalSize,
+			const cl::NDRange localSize, const OperationType opType)
+		{
+			OperationIdx opIdx = AddOperation<Tsize, Ts...>(kernel, tuple, offset, globalSize.GetGlobalSize(currentStep < stepBatch.size() ? stepBatch[currentStep] : activeBatch), localSize, opType);
+
+			std::vector<BaseOperation*>* opList = opType == OperationType::FORWARD ? &forwardList : (opType == OperationType::BACKWARD ? &backwardList : &updateList);
+			(*opList)[opIdx]->SetBatchRange(globalSize);
+			return opIdx;
+		}
+
+		template<size_t Tsize, class... Ts>
+		OperationIdx OpenCLBackend::AddStandaloneOperation(const KernelIdx kernel,
+			const Tuple<Ts...> tuple,
+			const cl::NDRange offset,
+			const cl::NDRange globalSize,
+			const cl::NDRange localSize)
+		{
+			Operation<Tsize, Ts...>* operation = new Operation<Tsize, Ts...>((kernels[kernel]), kernel, tuple, offset, globalSize, localSize);
+			SelectStorage(operation);
+
+			standaloneList.push_back(operation);
+			return standaloneList.size() - 1;
+		}
+
+		//Run a specific kernel object
+		template<size_t Tsize, class... Ts>
+		void OpenCLBackend::RunKernel(const KernelIdx kernel, const Tuple<Ts...> tuple, const cl::NDRange offset, const cl::NDRange globalSize, const cl::NDRange localSize)
+		{
+			Operation<Tsize, Ts...>* operation = new Operation<Tsize, Ts...>(kernel[kernel], kernel, tuple, offset, globalSize, localSize);
+			operation->Run(comQueue, nullptr, &timingEvent, bufferList);
+		}
+	}
+}
+
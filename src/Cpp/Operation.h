@@ -1,242 +1,484 @@
-#pragma once
-
-#include <CL\cl.hpp>
-#include <iostream>
-
-#include "VariadicTuple.h"
-#include "Defines.h"
-
-namespace DeepCL
-{
-	namespace BackendSystem
-	{
-		//Class for stroring opencl kernels and all necessary information to perform it.
-		class BaseOperation
-		{
-		public:
-			//Function to enque(execute) the kernel of the operation
-			virtual void Run(cl::CommandQueue& queue, cl::Event* event, const std::vector<cl::Buffer>& bufferList) = 0;
-		};
-
-
-		//derived class which contains all necessary operations to execute the kernel.
-		template<size_t Tsize, class... Ts>
-		class Operation : public BaseOperation
-		{
-		public:
-			Operation(cl::Kernel* kernel, const Tuple<Ts...> parameter, const cl::NDRange offset,
-				const cl::NDRange globalSize,
-				const cl::NDRange localSize);
-			~Operation();
-
-			virtual void Run(cl::CommandQueue& queue, cl::Event* event, const std::vector<cl::Buffer>& bufferList);
-
-		protected:
-			Operation();
-			//Kernel to be executed
-			cl::Kernel* kernel;
-			
-			//Parameters, which should be used to execute the kernel
-			Tuple<Ts...> parameter;
-
-			//Work sizes parameters of the kernel
-			cl::NDRange offset;
-			cl::NDRange globalSize;
-			cl::NDRange localSize;
-
-		};
-
-		//Operation to increment an element of the tuple. The index of the element is specified by the template argument called tuple.
-		//The element that should be incremented is assumed to be a pair where the second element is incremented.
-		template<size_t idx, size_t Tsize, class... Ts>
-		class IncrementOperation : public BaseOperation
-		{
-		public:
-			IncrementOperation(cl::Kernel* kernel, const Tuple<Ts...> parameter, const cl::NDRange offset,
-				const cl::NDRange globalSize,
-				const cl::NDRange localSize);
-			~IncrementOperation();
-
-			virtual void Run(cl::CommandQueue& queue, cl::Event* event, const std::vector<cl::Buffer>& bufferList);
-
-		protected:
-			IncrementOperation();
-			cl::Kernel* kernel;
-			Tuple<Ts...> parameter;
-			cl::NDRange offset;
-			cl::NDRange globalSize;
-			cl::NDRange localSize;
-
-		};
-
-		
-		//Function to set an aribtrary object to be used in the kernel. The func function is called in a tuple loop.
-		template<class T> class SetArgument
-		{
-		public:
-			inline static void func(T arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
-			{
-#ifdef _DEBUG
-				cl_int err = kernel->setArg(i, arg);
-				if (err != CL_SUCCESS)
-					std::cout << "Error setArg: " << err << std::endl;
-#else
-				kernel->setArg(i, arg);
-#endif // DEBUG	
-			}
-		};
-
-		//Specialization to set an buffer object to be used in the kernel.
-		template<> class SetArgument<BufferIdx>
-		{
-		public:
-			inline static void func(BufferIdx arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
-			{
-#ifdef _DEBUG
-				cl_int err = kernel->setArg(i, bufferList[arg]);
-				if (err != CL_SUCCESS)
-					std::cout << "Error setArg: " << err << std::endl;
-#else
-				kernel->setArg(i, bufferList[arg]);
-#endif // DEBUG	
-			}
-		};
-
-		//Specialization to set an simple data type to the kernel. The first part of the pair contains the size of the second element. The second element is set as parameter to the kernel.
-		template <class T> class SetArgument<std::pair<size_t, T>>
-		{
-		public:
-			inline static void func(std::pair<size_t, T> arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
-			{
-
-#ifdef _DEBUG
-				cl_int err = kernel->setArg(i, arg.first, &arg.second);
-				if (err != CL_SUCCESS)
-					std::cout << "Error setArg: " << err << std::endl;
-#else
-				kernel->setArg(i, arg.first, &arg.second);
-#endif // DEBUG	
-			}
-		};
-
-		//Specialization to set an simple data type to the kernel. The first part of the pair contains the size of the data object the second element points onto. The data element the second element points onto is set as parameter to the kernel.
-		template <class T> class SetArgument < std::pair<size_t, T*> >
-		{
-		public:
-			inline static void func(std::pair<size_t, T*> arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
-			{
-#ifdef _DEBUG
-				cl_int err = kernel->setArg(i, arg.first, arg.second);
-				if (err != CL_SUCCESS)
-					std::cout << "Error setArg: " << err << std::endl;
-#else
-				kernel->setArg(i, arg.first, &arg.second);
-#endif // DEBUG	
-			}
-		};
-
-		//Constructors and descructors for the different operations. All of them set the member objects to the corresponding function parameters.
-		template<size_t Tsize, class... Ts>
-		Operation<Tsize, Ts...>::Operation(cl::Kernel* kernel, const Tuple<Ts...> tuple, const cl::NDRange offset,
-			const cl::NDRange globalSize, const cl::NDRange localSize) :
-			kernel(kernel), parameter(tuple), offset(offset), globalSize(globalSize), localSize(localSize)
-		{
-
-		}
-
-		template<size_t Tsize, class... Ts>
-		Operation<Tsize, Ts...>::~Operation()
-		{
-
-		}
-
-		template<size_t Tsize, class... Ts>
-		Operation<Tsize, Ts...>::Operation()
-		{
-
-		}
-
-		template<size_t idx, size_t Tsize, class... Ts>
-		IncrementOperation<idx, Tsize, Ts...>::IncrementOperation(cl::Kernel* kernel, const Tuple<Ts...> tuple, const cl::NDRange offset,
-			const cl::NDRange globalSize, const cl::NDRange localSize) :
-			kernel(kernel), parameter(tuple), offset(offset), globalSize(globalSize), localSize(localSize)
-		{
-
-		}
-
-
-		template<size_t idx, size_t Tsize, class... Ts>
-		inline void IncrementOperation<idx, Tsize, Ts...>::Run(cl::CommandQueue& queue, cl::Event* clEvent, const std::vector<cl::Buffer>& bufferList)
-		{
-			//Apply the SetArgument func functions recursively on the parameter
-			SetArgumentLoop<0, Tsize - 1, Ts...>::apply(parameter, kernel, bufferList);
-
-			//Enqueue the kernel to the OpenCL queue
-#ifdef _DEBUG
-			cl_int err = queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, nullptr, clEvent);
-			if (err != CL_SUCCESS)
-				std::cout << "Error enqueueNDRangeKernel: " << err << std::endl;
-
-#else
-			queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, nullptr, clEvent);
-#endif // DEBUG
-
-			//increment the specific parameter after each execution (used for the adam optimizer)
-			++get<1>(get<idx>(parameter));
-		}
-
-		template<size_t idx, size_t Tsize, class... Ts>
-		IncrementOperation<idx, Tsize, Ts...>::~IncrementOperation()
-		{
-
-		}
-
-		template<size_t idx, size_t Tsize, class... Ts>
-		IncrementOperation<idx, Tsize, Ts...>::IncrementOperation()
-		{
-
-		}
-		
-		//Call the func function on each tuple element recursivly.
-		//From is the first element of the tuple that is set and to is the last element that is set (for(from<=to))
-		template<size_t from, size_t to, class... Ts>
-		struct SetArgumentLoop
-		{
-		public:
-			inline static void apply(Tuple<Ts...> tuple, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
-			{
-				//Call the setargument function using get and elemholder to specify the template argument
-				SetArgument<ElemHolder<from, Tuple<Ts...>>::type>::func(get<from>(tuple), from, kernel, bufferList);
-				//Call the SetARgumentLoop apply function with from increased by one.
-				SetArgumentLoop<from + 1, to, Ts...>::apply(tuple, kernel, bufferList);
-			}
-		};
-
-		// Terminal case when from equals to. No more recursion takes place and the last call to SetArgument is performed.
-		template<size_t from, class... Ts>
-		struct SetArgumentLoop<from, from, Ts...> {
-		public:
-			inline static void apply(Tuple<Ts...> tuple, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
-			{
-				SetArgument<ElemHolder<from, Tuple<Ts...>>::type>::func(get<from>(tuple), from, kernel, bufferList);
-			}
-		};
-		
-		//The same as the increment operation run fucntion but without incrementing anything.
-		template<size_t Tsize, class... Ts>
-		inline void Operation<Tsize, Ts...>::Run(cl::CommandQueue& queue, cl::Event* clEvent, const std::vector<cl::Buffer>& bufferList)
-		{
-			SetArgumentLoop<0, Tsize - 1, Ts...>::apply(parameter, kernel, bufferList);
-
-#ifdef _DEBUG
-			cl_int err = queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, nullptr, clEvent);
-			if (err != CL_SUCCESS)
-				std::cout << "Error enqueueNDRangeKernel: " << err << std::endl;
-			
-#else
-			queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, nullptr, clEvent);
-#endif // DEBUG
-
-		}
-	}
+#pragma once
+
+#include <CL\cl.hpp>
+#include <iostream>
+
+#include "VariadicTuple.h"
+#include "Defines.h"
+
+namespace DeepCL
+{
+	namespace BackendSystem
+	{
+		//Checks if one of the arguments is read from host memory each time the kernel is executed (std::pair<size_t, T*>).
+		template<class... Ts>
+		struct HasHostPointer
+		{
+			static const bool value = false;
+		};
+
+		template<class T, class... Ts>
+		struct HasHostPointer<T, Ts...>
+		{
+			static const bool value = HasHostPointer<Ts...>::value;
+		};
+
+		template<class T, class... Ts>
+		struct HasHostPointer<std::pair<size_t, T*>, Ts...>
+		{
+			static const bool value = true;
+		};
+
+		//Integer kernel argument depending on the number of batch elements currently processed. The value set is perElement times the active batch size.
+		struct BatchArgument
+		{
+			BatchArgument() : perElement(0), activeBatch(nullptr) {}
+			BatchArgument(const int perElement, const unsigned int* activeBatch) : perElement(perElement), activeBatch(activeBatch) {}
+
+			int perElement;
+			const unsigned int* activeBatch;
+		};
+
+		//Checks if one of the arguments depends on the active batch size.
+		template<class... Ts>
+		struct HasBatchArgument
+		{
+			static const bool value = false;
+		};
+
+		template<class T, class... Ts>
+		struct HasBatchArgument<T, Ts...>
+		{
+			static const bool value = HasBatchArgument<Ts...>::value;
+		};
+
+		template<class... Ts>
+		struct HasBatchArgument<BatchArgument, Ts...>
+		{
+			static const bool value = true;
+		};
+
+		//Global work size of which one dimension depends on the active batch size. The size of the dimension batchDim is perElement times the active batch size
+		//rounded up to a multiple of granularity. The sizes of the other dimensions are fixed. A BatchRange with zero dimensions is not used.
+		struct BatchRange
+		{
+			BatchRange() : dims(0), batchDim(0), perElement(0), granularity(1)
+			{
+				sizes[0] = sizes[1] = sizes[2] = 1;
+			}
+
+			BatchRange(const size_t dims, const size_t batchDim, const size_t perElement, const size_t granularity, const size_t sizeX = 1, const size_t sizeY = 1, const size_t sizeZ = 1) :
+				dims(dims), batchDim(batchDim), perElement(perElement), granularity(granularity)
+			{
+				sizes[0] = sizeX;
+				sizes[1] = sizeY;
+				sizes[2] = sizeZ;
+			}
+
+			cl::NDRange GetGlobalSize(const unsigned int activeBatch) const
+			{
+				size_t global[3] = { sizes[0], sizes[1], sizes[2] };
+				const size_t total = perElement * activeBatch;
+				global[batchDim] = total + (granularity - total % granularity) % granularity;
+
+				if (dims == 1)
+					return cl::NDRange(global[0]);
+				else if (dims == 2)
+					return cl::NDRange(global[0], global[1]);
+				return cl::NDRange(global[0], global[1], global[2]);
+			}
+
+			size_t dims;
+			size_t batchDim;
+			size_t perElement;
+			size_t granularity;
+			size_t sizes[3];
+		};
+
+		//Class for stroring opencl kernels and all necessary information to perform it.
+		class BaseOperation
+		{
+		public:
+			//Function to enque(execute) the kernel of the operation. The kernel waits for the events in waitList (can be a nullptr).
+			virtual void Run(cl::CommandQueue& queue, const std::vector<cl::Event>* waitList, cl::Event* event, const std::vector<cl::Buffer>& bufferList) = 0;
+
+			//Appends the argument position and the index of each buffer used as argument of the kernel. Used to compute the dependencies between operations.
+			virtual void GetBufferArguments(std::vector<std::pair<size_t, BufferIdx>>& arguments) = 0;
+
+			//Returns the index of the kernel executed by the operation.
+			virtual KernelIdx GetKernelIdx() const = 0;
+
+			//Replaces the kernel executed by the operation with another kernel taking the same arguments (For example a variant compiled with other defines).
+			virtual void SetKernel(cl::Kernel* kernel, const KernelIdx kernelIdx) = 0;
+
+			//Sets the arguments of the operation on another kernel object created from the same kernel source. Used when the operation is recorded.
+			virtual void SetArguments(cl::Kernel* target, const std::vector<cl::Buffer>& bufferList) = 0;
+
+			//Returns true if the arguments change between runs. Such operations can't be recorded with fixed arguments.
+			virtual bool IsDynamic() const = 0;
+
+			//Work sizes of the kernel
+			virtual const cl::NDRange& GetOffset() const = 0;
+			virtual const cl::NDRange& GetGlobalSize() const = 0;
+			virtual const cl::NDRange& GetLocalSize() const = 0;
+
+			//Lets the global work size depend on the active batch size.
+			virtual void SetBatchRange(const BatchRange& batchRange) = 0;
+			//Recomputes the global work size for the active batch size. The arguments depending on it are read each time the operation is run.
+			virtual void SetActiveBatch(const unsigned int activeBatch) = 0;
+			//Returns true if the arguments or the global work size depend on the active batch size.
+			virtual bool DependsOnBatch() const = 0;
+
+			//Returns a new operation executing the same kernel with the same arguments and work sizes (Used to run forward operations again in the backward pass).
+			virtual BaseOperation* Clone() const = 0;
+		};
+
+
+		//derived class which contains all necessary operations to execute the kernel.
+		template<size_t Tsize, class... Ts>
+		class Operation : public BaseOperation
+		{
+		public:
+			Operation(cl::Kernel* kernel, const KernelIdx kernelIdx, const Tuple<Ts...> parameter, const cl::NDRange offset,
+				const cl::NDRange globalSize,
+				const cl::NDRange localSize);
+			~Operation();
+
+			virtual void Run(cl::CommandQueue& queue, const std::vector<cl::Event>* waitList, cl::Event* event, const std::vector<cl::Buffer>& bufferList);
+
+			virtual void GetBufferArguments(std::vector<std::pair<size_t, BufferIdx>>& arguments);
+
+			virtual KernelIdx GetKernelIdx() const { return kernelIdx; }
+
+			virtual void SetKernel(cl::Kernel* kernel, const KernelIdx kernelIdx) { this->kernel = kernel; this->kernelIdx = kernelIdx; }
+
+			virtual void SetArguments(cl::Kernel* target, const std::vector<cl::Buffer>& bufferList);
+
+			virtual bool IsDynamic() const { return HasHostPointer<Ts...>::value; }
+
+			virtual const cl::NDRange& GetOffset() const { return offset; }
+			virtual const cl::NDRange& GetGlobalSize() const { return globalSize; }
+			virtual const cl::NDRange& GetLocalSize() const { return localSize; }
+
+			virtual void SetBatchRange(const BatchRange& batchRange) { this->batchRange = batchRange; }
+			virtual void SetActiveBatch(const unsigned int activeBatch) { if (batchRange.dims > 0) globalSize = batchRange.GetGlobalSize(activeBatch); }
+			virtual bool DependsOnBatch() const { return batchRange.dims > 0 || HasBatchArgument<Ts...>::value; }
+
+			virtual BaseOperation* Clone() const { return new Operation<Tsize, Ts...>(*this); }
+
+		protected:
+			Operation();
+			//Kernel to be executed
+			cl::Kernel* kernel;
+			KernelIdx kernelIdx;
+			
+			//Parameters, which should be used to execute the kernel
+			Tuple<Ts...> parameter;
+
+			//Work sizes parameters of the kernel
+			cl::NDRange offset;
+			cl::NDRange globalSize;
+			cl::NDRange localSize;
+
+			//Describes how the global work size changes with the active batch size (Unused if it has no dimensions)
+			BatchRange batchRange;
+		};
+
+		//Operation to increment an element of the tuple. The index of the element is specified by the template argument called tuple.
+		//The element that should be incremented is assumed to be a pair where the second element is incremented.
+		template<size_t idx, size_t Tsize, class... Ts>
+		class IncrementOperation : public BaseOperation
+		{
+		public:
+			IncrementOperation(cl::Kernel* kernel, const KernelIdx kernelIdx, const Tuple<Ts...> parameter, const cl::NDRange offset,
+				const cl::NDRange globalSize,
+				const cl::NDRange localSize);
+			~IncrementOperation();
+
+			virtual void Run(cl::CommandQueue& queue, const std::vector<cl::Event>* waitList, cl::Event* event, const std::vector<cl::Buffer>& bufferList);
+
+			virtual void GetBufferArguments(std::vector<std::pair<size_t, BufferIdx>>& arguments);
+
+			virtual KernelIdx GetKernelIdx() const { return kernelIdx; }
+
+			virtual void SetKernel(cl::Kernel* kernel, const KernelIdx kernelIdx) { this->kernel = kernel; this->kernelIdx = kernelIdx; }
+
+			virtual void SetArguments(cl::Kernel* target, const std::vector<cl::Buffer>& bufferList);
+
+			//The incremented argument changes every run.
+			virtual bool IsDynamic() const { return true; }
+
+			virtual const cl::NDRange& GetOffset() const { return offset; }
+			virtual const cl::NDRange& GetGlobalSize() const { return globalSize; }
+			virtual const cl::NDRange& GetLocalSize() const { return localSize; }
+
+			virtual void SetBatchRange(const BatchRange& batchRange) { this->batchRange = batchRange; }
+			virtual void SetActiveBatch(const unsigned int activeBatch) { if (batchRange.dims > 0) globalSize = batchRange.GetGlobalSize(activeBatch); }
+			virtual bool DependsOnBatch() const { return batchRange.dims > 0 || HasBatchArgument<Ts...>::value; }
+
+			virtual BaseOperation* Clone() const { return new IncrementOperation<idx, Tsize, Ts...>(*this); }
+
+		protected:
+			IncrementOperation();
+			cl::Kernel* kernel;
+			KernelIdx kernelIdx;
+			Tuple<Ts...> parameter;
+			cl::NDRange offset;
+			cl::NDRange globalSize;
+			cl::NDRange localSize;
+			BatchRange batchRange;
+		};
+
+		
+		//Function to set an aribtrary object to be used in the kernel. The func function is called in a tuple loop.
+		template<class T> class SetArgument
+		{
+		public:
+			inline static void func(T arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
+			{
+#ifdef _DEBUG
+				cl_int err = kernel->setArg(i, arg);
+				if (err != CL_SUCCESS)
+					std::cout << "Error setArg: " << err << std::endl;
+#else
+				kernel->setArg(i, arg);
+#endif // DEBUG	
+			}
+		};
+
+		//Specialization to set an buffer object to be used in the kernel.
+		template<> class SetArgument<BufferIdx>
+		{
+		public:
+			inline static void func(BufferIdx arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
+			{
+#ifdef _DEBUG
+				cl_int err = kernel->setArg(i, bufferList[arg]);
+				if (err != CL_SUCCESS)
+					std::cout << "Error setArg: " << err << std::endl;
+#else
+				kernel->setArg(i, bufferList[arg]);
+#endif // DEBUG	
+			}
+		};
+
+		//Specialization to set an simple data type to the kernel. The first part of the pair contains the size of the second element. The second element is set as parameter to the kernel.
+		template <class T> class SetArgument<std::pair<size_t, T>>
+		{
+		public:
+			inline static void func(std::pair<size_t, T> arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
+			{
+
+#ifdef _DEBUG
+				cl_int err = kernel->setArg(i, arg.first, &arg.second);
+				if (err != CL_SUCCESS)
+					std::cout << "Error setArg: " << err << std::endl;
+#else
+				kernel->setArg(i, arg.first, &arg.second);
+#endif // DEBUG	
+			}
+		};
+
+		//Specialization to set an simple data type to the kernel. The first part of the pair contains the size of the data object the second element points onto. The data element the second element points onto is set as parameter to the kernel.
+		template <class T> class SetArgument < std::pair<size_t, T*> >
+		{
+		public:
+			inline static void func(std::pair<size_t, T*> arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
+			{
+#ifdef _DEBUG
+				cl_int err = kernel->setArg(i, arg.first, arg.second);
+				if (err != CL_SUCCESS)
+					std::cout << "Error setArg: " << err << std::endl;
+#else
+				kernel->setArg(i, arg.first, arg.second);
+#endif // DEBUG	
+			}
+		};
+
+		//Specialization to set an argument depending on the active batch size. The value is computed each time the argument is set.
+		template<> class SetArgument<BatchArgument>
+		{
+		public:
+			inline static void func(BatchArgument arg, const size_t i, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
+			{
+				int value = arg.perElement * static_cast<int>(*arg.activeBatch);
+#ifdef _DEBUG
+				cl_int err = kernel->setArg(i, sizeof(int), &value);
+				if (err != CL_SUCCESS)
+					std::cout << "Error setArg: " << err << std::endl;
+#else
+				kernel->setArg(i, sizeof(int), &value);
+#endif // DEBUG	
+			}
+		};
+
+		//Function to collect the buffer arguments of a kernel. The func function is called in a tuple loop. Arbitrary objects are no buffers and are ignored.
+		template<class T> class CollectBuffer
+		{
+		public:
+			inline static void func(const T& arg, const size_t i, std::vector<std::pair<size_t, BufferIdx>>& arguments)
+			{
+			}
+		};
+
+		//Specialization for buffer objects. The position and the index of the buffer are stored.
+		template<> class CollectBuffer<BufferIdx>
+		{
+		public:
+			inline static void func(const BufferIdx arg, const size_t i, std::vector<std::pair<size_t, BufferIdx>>& arguments)
+			{
+				arguments.push_back(std::pair<size_t, BufferIdx>(i, arg));
+			}
+		};
+
+		//Call the func function of CollectBuffer on each tuple element recursivly (for(from<=to)).
+		template<size_t from, size_t to, class... Ts>
+		struct CollectBufferLoop
+		{
+		public:
+			inline static void apply(Tuple<Ts...>& tuple, std::vector<std::pair<size_t, BufferIdx>>& arguments)
+			{
+				CollectBuffer<ElemHolder<from, Tuple<Ts...>>::type>::func(get<from>(tuple), from, arguments);
+				CollectBufferLoop<from + 1, to, Ts...>::apply(tuple, arguments);
+			}
+		};
+
+		//Terminal case when from equals to.
+		template<size_t from, class... Ts>
+		struct CollectBufferLoop<from, from, Ts...> {
+		public:
+			inline static void apply(Tuple<Ts...>& tuple, std::vector<std::pair<size_t, BufferIdx>>& arguments)
+			{
+				CollectBuffer<ElemHolder<from, Tuple<Ts...>>::type>::func(get<from>(tuple), from, arguments);
+			}
+		};
+
+		//Constructors and descructors for the different operations. All of them set the member objects to the corresponding function parameters.
+		template<size_t Tsize, class... Ts>
+		Operation<Tsize, Ts...>::Operation(cl::Kernel* kernel, const KernelIdx kernelIdx, const Tuple<Ts...> tuple, const cl::NDRange offset,
+			const cl::NDRange globalSize, const cl::NDRange localSize) :
+			kernel(kernel), kernelIdx(kernelIdx), parameter(tuple), offset(offset), globalSize(globalSize), localSize(localSize)
+		{
+
+		}
+
+		template<size_t Tsize, class... Ts>
+		Operation<Tsize, Ts...>::~Operation()
+		{
+
+		}
+
+		template<size_t Tsize, class... Ts>
+		Operation<Tsize, Ts...>::Operation()
+		{
+
+		}
+
+		template<size_t idx, size_t Tsize, class... Ts>
+		IncrementOperation<idx, Tsize, Ts...>::IncrementOperation(cl::Kernel* kernel, const KernelIdx kernelIdx, const Tuple<Ts...> tuple, const cl::NDRange offset,
+			const cl::NDRange globalSize, const cl::NDRange localSize) :
+			kernel(kernel), kernelIdx(kernelIdx), parameter(tuple), offset(offset), globalSize(globalSize), localSize(localSize)
+		{
+
+		}
+
+
+		template<size_t idx, size_t Tsize, class... Ts>
+		inline void IncrementOperation<idx, Tsize, Ts...>::Run(cl::CommandQueue& queue, const std::vector<cl::Event>* waitList, cl::Event* clEvent, const std::vector<cl::Buffer>& bufferList)
+		{
+			//Apply the SetArgument func functions recursively on the parameter
+			SetArgumentLoop<0, Tsize - 1, Ts...>::apply(parameter, kernel, bufferList);
+
+			//Enqueue the kernel to the OpenCL queue
+#ifdef _DEBUG
+			cl_int err = queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, waitList, clEvent);
+			if (err != CL_SUCCESS)
+				std::cout << "Error enqueueNDRangeKernel: " << err << std::endl;
+
+#else
+			queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, waitList, clEvent);
+#endif // DEBUG
+
+			//increment the specific parameter after each execution (used for the adam optimizer)
+			++get<1>(get<idx>(parameter));
+		}
+
+		template<size_t idx, size_t Tsize, class... Ts>
+		void IncrementOperation<idx, Tsize, Ts...>::GetBufferArguments(std::vector<std::pair<size_t, BufferIdx>>& arguments)
+		{
+			CollectBufferLoop<0, Tsize - 1, Ts...>::apply(parameter, arguments);
+		}
+
+		template<size_t idx, size_t Tsize, class... Ts>
+		void IncrementOperation<idx, Tsize, Ts...>::SetArguments(cl::Kernel* target, const std::vector<cl::Buffer>& bufferList)
+		{
+			SetArgumentLoop<0, Tsize - 1, Ts...>::apply(parameter, target, bufferList);
+		}
+
+		template<size_t idx, size_t Tsize, class... Ts>
+		IncrementOperation<idx, Tsize, Ts...>::~IncrementOperation()
+		{
+
+		}
+
+		template<size_t idx, size_t Tsize, class... Ts>
+		IncrementOperation<idx, Tsize, Ts...>::IncrementOperation()
+		{
+
+		}
+		
+		//Call the func function on each tuple element recursivly.
+		//From is the first element of the tuple that is set and to is the last element that is set (for(from<=to))
+		template<size_t from, size_t to, class... Ts>
+		struct SetArgumentLoop
+		{
+		public:
+			inline static void apply(Tuple<Ts...> tuple, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
+			{
+				//Call the setargument function using get and elemholder to specify the template argument
+				SetArgument<ElemHolder<from, Tuple<Ts...>>::type>::func(get<from>(tuple), from, kernel, bufferList);
+				//Call the SetARgumentLoop apply function with from increased by one.
+				SetArgumentLoop<from + 1, to, Ts...>::apply(tuple, kernel, bufferList);
+			}
+		};
+
+		// Terminal case when from equals to. No more recursion takes place and the last call to SetArgument is performed.
+		template<size_t from, class... Ts>
+		struct SetArgumentLoop<from, from, Ts...> {
+		public:
+			inline static void apply(Tuple<Ts...> tuple, cl::Kernel* kernel, const std::vector<cl::Buffer>& bufferList)
+			{
+				SetArgument<ElemHolder<from, Tuple<Ts...>>::type>::func(get<from>(tuple), from, kernel, bufferList);
+			}
+		};
+		
+		//The same as the increment operation run fucntion but without incrementing anything.
+		template<size_t Tsize, class... Ts>
+		inline void Operation<Tsize, Ts...>::Run(cl::CommandQueue& queue, const std::vector<cl::Event>* waitList, cl::Event* clEvent, const std::vector<cl::Buffer>& bufferList)
+		{
+			SetArgumentLoop<0, Tsize - 1, Ts...>::apply(parameter, kernel, bufferList);
+
+#ifdef _DEBUG
+			cl_int err = queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, waitList, clEvent);
+			if (err != CL_SUCCESS)
+				std::cout << "Error enqueueNDRangeKernel: " << err << std::endl;
+			
+#else
+			queue.enqueueNDRangeKernel(*kernel, offset, globalSize, localSize, waitList, clEvent);
+#endif // DEBUG
+
+		}
+
+		template<size_t Tsize, class... Ts>
+		void Operation<Tsize, Ts...>::GetBufferArguments(std::vector<std::pair<size_t, BufferIdx>>& arguments)
+		{
+			CollectBufferLoop<0, Tsize - 1, Ts...>::apply(parameter, arguments);
+		}
+
+		template<size_t Tsize, class... Ts>
+		void Operation<Tsize, Ts...>::SetArguments(cl::Kernel* target, const std::vector<cl::Buffer>& bufferList)
+		{
+			SetArgumentLoop<0, Tsize - 1, Ts...>::apply(parameter, target, bufferList);
+		}
+	}
 }
\ No newline at end of file
@@ -0,0 +1,458 @@
+#include "RingCommunicator.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+#ifdef _WIN32
+		typedef SOCKET NativeSocket;
+#else
+		typedef int NativeSocket;
+#endif
+		static const std::intptr_t INVALID_SOCKET_HANDLE = -1;
+		//Size of the blocks a broadcast is forwarded in
+		static const size_t BROADCAST_BLOCK_SIZE = 1 << 20;
+
+		static void CloseSocket(const std::intptr_t socketHandle)
+		{
+			if (socketHandle == INVALID_SOCKET_HANDLE)
+				return;
+#ifdef _WIN32
+			closesocket(static_cast<NativeSocket>(socketHandle));
+#else
+			close(static_cast<NativeSocket>(socketHandle));
+#endif
+		}
+
+		//Disables the delay of small messages and the blocking of send and recv.
+		static void ConfigureSocket(const std::intptr_t socketHandle)
+		{
+			int noDelay = 1;
+			setsockopt(static_cast<NativeSocket>(socketHandle), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+#ifdef _WIN32
+			u_long nonBlocking = 1;
+			ioctlsocket(static_cast<NativeSocket>(socketHandle), FIONBIO, &nonBlocking);
+#else
+			fcntl(static_cast<NativeSocket>(socketHandle), F_SETFL, fcntl(static_cast<NativeSocket>(socketHandle), F_GETFL, 0) | O_NONBLOCK);
+#endif
+		}
+
+		//Returns true if the last send or recv failed only because the socket was not ready.
+		static bool WouldBlock()
+		{
+#ifdef _WIN32
+			return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+		}
+
+		static bool SplitHost(const std::string& entry, std::string& host, std::string& port)
+		{
+			const size_t separator = entry.rfind(':');
+			if (separator == std::string::npos || separator == 0 || separator + 1 == entry.size())
+			{
+				std::cerr << "Error ring communication: " << entry << " is not of the form host:port" << std::endl;
+				return false;
+			}
+			host = entry.substr(0, separator);
+			port = entry.substr(separator + 1);
+			return true;
+		}
+
+		static float HalfToFloat(const unsigned short value)
+		{
+			const int exponent = (value >> 10) & 0x1f;
+			const unsigned int mantissa = value & 0x3ff;
+
+			float result;
+			if (exponent == 0)
+				result = std::ldexp(static_cast<float>(mantissa), -24);
+			else if (exponent == 31)
+				result = mantissa == 0 ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+			else
+				result = std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+
+			return (value & 0x8000) ? -result : result;
+		}
+
+		//Rounds to the nearest half (Ties to even). Values too large for half become infinity.
+		static unsigned short FloatToHalf(const float value)
+		{
+			unsigned int bits;
+			std::memcpy(&bits, &value, sizeof(float));
+			const unsigned short sign = static_cast<unsigned short>((bits >> 16) & 0x8000);
+			const int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+			unsigned int mantissa = bits & 0x7fffff;
+
+			if (exponent >= 31)
+			{
+				//Infinity and NaN keep their class.
+				const bool isNaN = ((bits >> 23) & 0xff) == 0xff && mantissa != 0;
+				return sign | 0x7c00 | (isNaN ? 0x200 : 0);
+			}
+			if (exponent <= 0)
+			{
+				//Subnormal half or zero
+				if (exponent < -10)
+					return sign;
+				mantissa |= 0x800000;
+				const int shift = 14 - exponent;
+				unsigned int halfMantissa = mantissa >> shift;
+				const unsigned int remainder = mantissa & ((1u << shift) - 1);
+				const unsigned int halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+					++halfMantissa;
+				return sign | static_cast<unsigned short>(halfMantissa);
+			}
+
+			unsigned int result = (static_cast<unsigned int>(exponent) << 10) | (mantissa >> 13);
+			const unsigned int remainder = mantissa & 0x1fff;
+			if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+				++result; //A carry into the exponent rounds up to the next power of two or infinity
+			return sign | static_cast<unsigned short>(result);
+		}
+
+		RingCommunicator::RingCommunicator() :
+			rank(0), numProcesses(1), left(INVALID_SOCKET_HANDLE), right(INVALID_SOCKET_HANDLE), timeoutSeconds(60), bytesSent(0), recvBuffer(), recvHalfBuffer()
+		{
+#ifdef _WIN32
+			WSADATA wsaData;
+			WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+		}
+
+		RingCommunicator::~RingCommunicator()
+		{
+			Close();
+#ifdef _WIN32
+			WSACleanup();
+#endif
+		}
+
+		void RingCommunicator::Close()
+		{
+			CloseSocket(left);
+			CloseSocket(right);
+			left = INVALID_SOCKET_HANDLE;
+			right = INVALID_SOCKET_HANDLE;
+		}
+
+		DeepCLError RingCommunicator::Connect(const std::vector<std::string>& hosts, const size_t rank, const unsigned int timeoutSeconds)
+		{
+			Close();
+			if (rank >= hosts.size())
+			{
+				std::cerr << "Error ring communication: Rank " << rank << " is not contained in the host list" << std::endl;
+				return NN_COMMUNICATION_ERROR;
+			}
+			this->rank = rank;
+			this->numProcesses = hosts.size();
+			this->timeoutSeconds = timeoutSeconds;
+			if (numProcesses == 1)
+				return 0;
+
+			const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+			std::string host, port;
+
+			//Listen on the port of the own entry before connecting, therefore the previous process can connect even if this process is still waiting for the next one.
+			if (!SplitHost(hosts[rank], host, port))
+				return NN_COMMUNICATION_ERROR;
+			addrinfo hints = {};
+			hints.ai_family = AF_INET;
+			hints.ai_socktype = SOCK_STREAM;
+			hints.ai_flags = AI_PASSIVE;
+			addrinfo* address = nullptr;
+			std::intptr_t listener = INVALID_SOCKET_HANDLE;
+			if (getaddrinfo(nullptr, port.c_str(), &hints, &address) == 0)
+			{
+				NativeSocket socketHandle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+				listener = static_cast<std::intptr_t>(socketHandle);
+				int reuse = 1;
+				if (listener != INVALID_SOCKET_HANDLE)
+					setsockopt(socketHandle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+				if (listener != INVALID_SOCKET_HANDLE && (bind(socketHandle, address->ai_addr, static_cast<int>(address->ai_addrlen)) != 0 || listen(socketHandle, 1) != 0))
+				{
+					CloseSocket(listener);
+					listener = INVALID_SOCKET_HANDLE;
+				}
+				freeaddrinfo(address);
+			}
+			if (listener == INVALID_SOCKET_HANDLE)
+			{
+				std::cerr << "Error ring communication: Could not listen on port " << port << std::endl;
+				return NN_COMMUNICATION_ERROR;
+			}
+
+			//Connect to the next process. It might not listen yet.
+			const size_t next = (rank + 1) % numProcesses;
+			if (!SplitHost(hosts[next], host, port))
+			{
+				CloseSocket(listener);
+				return NN_COMMUNICATION_ERROR;
+			}
+			hints.ai_flags = 0;
+			while (right == INVALID_SOCKET_HANDLE)
+			{
+				if (getaddrinfo(host.c_str(), port.c_str(), &hints, &address) == 0)
+				{
+					for (addrinfo* current = address; current != nullptr && right == INVALID_SOCKET_HANDLE; current = current->ai_next)
+					{
+						NativeSocket socketHandle = socket(current->ai_family, current->ai_socktype, current->ai_protocol);
+						if (static_cast<std::intptr_t>(socketHandle) == INVALID_SOCKET_HANDLE)
+							continue;
+						if (connect(socketHandle, current->ai_addr, static_cast<int>(current->ai_addrlen)) == 0)
+							right = static_cast<std::intptr_t>(socketHandle);
+						else
+							CloseSocket(static_cast<std::intptr_t>(socketHandle));
+					}
+					freeaddrinfo(address);
+				}
+
+				if (right == INVALID_SOCKET_HANDLE)
+				{
+					if (std::chrono::steady_clock::now() > deadline)
+					{
+						std::cerr << "Error ring communication: Could not connect to " << hosts[next] << std::endl;
+						CloseSocket(listener);
+						return NN_COMMUNICATION_ERROR;
+					}
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				}
+			}
+
+			//Accept the previous process.
+			fd_set acceptSet;
+			FD_ZERO(&acceptSet);
+			FD_SET(static_cast<NativeSocket>(listener), &acceptSet);
+			const long long remaining = std::chrono::duration_cast<std::chrono::seconds>(deadline - std::chrono::steady_clock::now()).count();
+			timeval timeout = {};
+			timeout.tv_sec = static_cast<long>(std::max(remaining, 1LL));
+			if (select(static_cast<int>(listener + 1), &acceptSet, nullptr, nullptr, &timeout) > 0)
+				left = static_cast<std::intptr_t>(accept(static_cast<NativeSocket>(listener), nullptr, nullptr));
+			CloseSocket(listener);
+			if (left == INVALID_SOCKET_HANDLE)
+			{
+				std::cerr << "Error ring communication: The previous process did not connect" << std::endl;
+				Close();
+				return NN_COMMUNICATION_ERROR;
+			}
+
+			ConfigureSocket(left);
+			ConfigureSocket(right);
+
+			//Each process sends its rank to the next one. This detects processes started with different host lists.
+			unsigned int ownRank = static_cast<unsigned int>(rank);
+			unsigned int previousRank = 0;
+			if (!Exchange(reinterpret_cast<const char*>(&ownRank), sizeof(ownRank), reinterpret_cast<char*>(&previousRank), sizeof(previousRank))
+				|| previousRank != (rank + numProcesses - 1) % numProcesses)
+			{
+				std::cerr << "Error ring communication: Unexpected process connected to rank " << rank << std::endl;
+				Close();
+				return NN_COMMUNICATION_ERROR;
+			}
+
+			return 0;
+		}
+
+		bool RingCommunicator::Exchange(const char* sendData, const size_t sendSize, char* recvData, const size_t recvSize)
+		{
+#ifdef MSG_NOSIGNAL
+			const int sendFlags = MSG_NOSIGNAL;
+#else
+			const int sendFlags = 0;
+#endif
+			size_t sent = 0;
+			size_t received = 0;
+			while (sent < sendSize || received < recvSize)
+			{
+				fd_set readSet, writeSet;
+				FD_ZERO(&readSet);
+				FD_ZERO(&writeSet);
+				if (received < recvSize)
+					FD_SET(static_cast<NativeSocket>(left), &readSet);
+				if (sent < sendSize)
+					FD_SET(static_cast<NativeSocket>(right), &writeSet);
+
+				timeval timeout = {};
+				timeout.tv_sec = static_cast<long>(timeoutSeconds);
+				const int ready = select(static_cast<int>(std::max(left, right) + 1), &readSet, &writeSet, nullptr, &timeout);
+				if (ready < 0 && WouldBlock())
+					continue;
+				if (ready <= 0)
+				{
+					std::cerr << "Error ring communication: " << (ready == 0 ? "Timeout" : "select failed") << " at rank " << rank << std::endl;
+					return false;
+				}
+
+				if (sent < sendSize && FD_ISSET(static_cast<NativeSocket>(right), &writeSet))
+				{
+					const int result = send(static_cast<NativeSocket>(right), sendData + sent, static_cast<int>(std::min<size_t>(sendSize - sent, INT_MAX)), sendFlags);
+					if (result > 0)
+					{
+						sent += static_cast<size_t>(result);
+						bytesSent += static_cast<unsigned long long>(result);
+					}
+					else if (!WouldBlock())
+					{
+						std::cerr << "Error ring communication: The connection to the next process was lost at rank " << rank << std::endl;
+						return false;
+					}
+				}
+
+				if (received < recvSize && FD_ISSET(static_cast<NativeSocket>(left), &readSet))
+				{
+					const int result = recv(static_cast<NativeSocket>(left), recvData + received, static_cast<int>(std::min<size_t>(recvSize - received, INT_MAX)), 0);
+					if (result > 0)
+						received += static_cast<size_t>(result);
+					else if (result == 0 || !WouldBlock())
+					{
+						std::cerr << "Error ring communication: The connection to the previous process was lost at rank " << rank << std::endl;
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		bool RingCommunicator::AllReduce(float* data, const size_t count)
+		{
+			if (numProcesses < 2)
+				return true;
+
+			const size_t n = numProcesses;
+			recvBuffer.resize((count + n - 1) / n);
+
+			//Reduce-scatter: In step s the chunk rank - s is sent and the chunk rank - s - 1 is received and added. Afterwards the chunk rank + 1 contains the complete sum.
+			for (size_t s = 0; s + 1 < n; ++s)
+			{
+				const size_t sendChunk = (rank + n - s) % n;
+				const size_t recvChunk = (rank + 2 * n - s - 1) % n;
+				const size_t sendBegin = sendChunk * count / n;
+				const size_t recvBegin = recvChunk * count / n;
+				const size_t recvCount = (recvChunk + 1) * count / n - recvBegin;
+				if (!Exchange(reinterpret_cast<const char*>(data + sendBegin), ((sendChunk + 1) * count / n - sendBegin) * sizeof(float),
+					reinterpret_cast<char*>(recvBuffer.data()), recvCount * sizeof(float)))
+					return false;
+				for (size_t i = 0; i < recvCount; ++i)
+					data[recvBegin + i] += recvBuffer[i];
+			}
+
+			//All-gather: In step s the complete chunk rank + 1 - s is sent and the complete chunk rank - s is received.
+			for (size_t s = 0; s + 1 < n; ++s)
+			{
+				const size_t sendChunk = (rank + n + 1 - s) % n;
+				const size_t recvChunk = (rank + n - s) % n;
+				const size_t sendBegin = sendChunk * count / n;
+				const size_t recvBegin = recvChunk * count / n;
+				if (!Exchange(reinterpret_cast<const char*>(data + sendBegin), ((sendChunk + 1) * count / n - sendBegin) * sizeof(float),
+					reinterpret_cast<char*>(data + recvBegin), ((recvChunk + 1) * count / n - recvBegin) * sizeof(float)))
+					return false;
+			}
+			return true;
+		}
+
+		bool RingCommunicator::AllReduceHalf(unsigned short* data, const size_t count)
+		{
+			if (numProcesses < 2)
+				return true;
+
+			const size_t n = numProcesses;
+			recvHalfBuffer.resize((count + n - 1) / n);
+
+			//Same ring as AllReduce. The partial sums travel as half, therefore every hop rounds its sum.
+			for (size_t s = 0; s + 1 < n; ++s)
+			{
+				const size_t sendChunk = (rank + n - s) % n;
+				const size_t recvChunk = (rank + 2 * n - s - 1) % n;
+				const size_t sendBegin = sendChunk * count / n;
+				const size_t recvBegin = recvChunk * count / n;
+				const size_t recvCount = (recvChunk + 1) * count / n - recvBegin;
+				if (!Exchange(reinterpret_cast<const char*>(data + sendBegin), ((sendChunk + 1) * count / n - sendBegin) * sizeof(unsigned short),
+					reinterpret_cast<char*>(recvHalfBuffer.data()), recvCount * sizeof(unsigned short)))
+					return false;
+				for (size_t i = 0; i < recvCount; ++i)
+					data[recvBegin + i] = FloatToHalf(HalfToFloat(data[recvBegin + i]) + HalfToFloat(recvHalfBuffer[i]));
+			}
+
+			for (size_t s = 0; s + 1 < n; ++s)
+			{
+				const size_t sendChunk = (rank + n + 1 - s) % n;
+				const size_t recvChunk = (rank + n - s) % n;
+				const size_t sendBegin = sendChunk * count / n;
+				const size_t recvBegin = recvChunk * count / n;
+				if (!Exchange(reinterpret_cast<const char*>(data + sendBegin), ((sendChunk + 1) * count / n - sendBegin) * sizeof(unsigned short),
+					reinterpret_cast<char*>(data + recvBegin), ((recvChunk + 1) * count / n - recvBegin) * sizeof(unsigned short)))
+					return false;
+			}
+			return true;
+		}
+
+		bool RingCommunicator::Broadcast(char* data, const size_t size, const size_t root)
+		{
+			if (numProcesses < 2)
+				return true;
+
+			//The data is forwarded around the ring in blocks, therefore all connections are used at the same time.
+			const bool receives = rank != root;
+			const bool sends = (rank + 1) % numProcesses != root;
+			for (size_t offset = 0; offset < size; offset += BROADCAST_BLOCK_SIZE)
+			{
+				const size_t blockSize = std::min(BROADCAST_BLOCK_SIZE, size - offset);
+				if (receives && !Exchange(nullptr, 0, data + offset, blockSize))
+					return false;
+				if (sends && !Exchange(data + offset, blockSize, nullptr, 0))
+					return false;
+			}
+			return true;
+		}
+
+		bool RingCommunicator::AllGather(const std::vector<char>& data, std::vector<std::vector<char>>& gathered)
+		{
+			gathered.resize(numProcesses);
+			gathered[rank] = data;
+
+			//In step s the data of process rank - s is passed on and the data of process rank - s - 1 is received. Each message starts with its size.
+			for (size_t s = 0; s + 1 < numProcesses; ++s)
+			{
+				const std::vector<char>& send = gathered[(rank + numProcesses - s) % numProcesses];
+				std::vector<char>& receive = gathered[(rank + 2 * numProcesses - s - 1) % numProcesses];
+				unsigned long long sendSize = send.size();
+				unsigned long long recvSize = 0;
+				if (!Exchange(reinterpret_cast<const char*>(&sendSize), sizeof(sendSize), reinterpret_cast<char*>(&recvSize), sizeof(recvSize)))
+					return false;
+				receive.resize(static_cast<size_t>(recvSize));
+				if (!Exchange(send.data(), send.size(), receive.data(), receive.size()))
+					return false;
+			}
+			return true;
+		}
+	}
+}
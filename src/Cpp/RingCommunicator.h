@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Defines.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Connects the processes of a distributed training into a ring over TCP. Each process is connected to the next process (right) and the previous process (left).
+		//Data is only sent to the right and received from the left, therefore each connection is used in one direction.
+		class RingCommunicator
+		{
+		public:
+			RingCommunicator();
+			~RingCommunicator();
+
+			//Rendezvous of the processes. hosts contains "host:port" of every process in the order of their ranks, each process listens on the port of its own entry.
+			//Connecting to the next process is retried until it listens or the timeout passed, therefore the processes can be started in any order.
+			DeepCLError Connect(const std::vector<std::string>& hosts, const size_t rank, const unsigned int timeoutSeconds = 60);
+			void Close();
+
+			size_t GetRank() const { return rank; }
+			size_t GetNumProcesses() const { return numProcesses; }
+
+			//Sums the values over all processes. Each process must call it with the same count. The values are split into one chunk for each process,
+			//each chunk is summed while passing once around the ring (Reduce-scatter) and the sums are passed around the ring again (All-gather).
+			bool AllReduce(float* data, const size_t count);
+			//Same as AllReduce for values stored as half. Each addition is computed in float, but the partial sum is rounded to half before it is sent on.
+			//The result therefore carries numProcesses - 1 half roundings instead of one, since sending float partial sums would double the bytes on the wire.
+			bool AllReduceHalf(unsigned short* data, const size_t count);
+			//Copies the data of the process root to all processes.
+			bool Broadcast(char* data, const size_t size, const size_t root = 0);
+			//Collects the data of all processes in the order of their ranks. The processes may send different amounts of data.
+			bool AllGather(const std::vector<char>& data, std::vector<std::vector<char>>& gathered);
+
+			//Number of bytes sent by this process (All connections).
+			unsigned long long GetBytesSent() const { return bytesSent; }
+
+		private:
+			RingCommunicator(const RingCommunicator& other);
+			const RingCommunicator& operator=(const RingCommunicator& other);
+
+			//Socket handle of the platform (SOCKET or file descriptor)
+			typedef std::intptr_t SocketHandle;
+
+			//Sends data to the right while receiving data from the left. Both sockets are non-blocking, this way neither process waits for the other to receive.
+			bool Exchange(const char* sendData, const size_t sendSize, char* recvData, const size_t recvSize);
+
+			size_t rank;
+			size_t numProcesses;
+			SocketHandle left;
+			SocketHandle right;
+			unsigned int timeoutSeconds; //Maximum time an exchange waits for the other processes
+
+			unsigned long long bytesSent;
+
+			std::vector<float> recvBuffer;
+			std::vector<unsigned short> recvHalfBuffer;
+		};
+	}
+}
@@ -1,113 +1,98 @@
-#include "WeightInitOp.h"
-
-namespace DeepCL
-{
-	namespace NNSystem
-	{
-		//Seed for the rng
-		const size_t InitOp::seed = 99;
-		std::default_random_engine InitOp::rnd(InitOp::seed);
-
-		//All Instantiate functions work essentially the same. They sample the data from some distribution and transfer it into the buffer.
-		void InitUniformRnd::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
-		{
-			NNBuffer* buffer = bufferList[w];
-
-			size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
-
-			float* data = new float[size];
-
-			//Sample different randum numbers for each element of the parameter buffer
-			for (size_t i = 0; i < size; ++i)
-				data[i] = distribution(rnd);
-
-			//Transfer the sampled data into the OpenCL buffer.
-			backend.WriteDataBuffer(buffer->ForwardBuffer(), data, 0, size * sizeof(float));
-			delete[] data;
-		}
-
-		void InitUniform::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
-		{
-			NNBuffer* buffer = bufferList[w];
-
-			size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
-
-			float* data = new float[size];
-
-			for (size_t i = 0; i < size; ++i)
-				data[i] = value;
-
-			backend.WriteDataBuffer(buffer->ForwardBuffer(), data, 0, size * sizeof(float));
-			delete[] data;
-		}
-
-		void InitNormalRnd::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
-		{
-			NNBuffer* buffer = bufferList[w];
-
-			size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
-
-			float* data = new float[size];
-
-			float tmpValue;
-
-			for (size_t i = 0; i < size; ++i)
-			{
-				tmpValue = distribution(rnd);
-				data[i] = tmpValue;
-			}
-
-			backend.WriteDataBuffer(buffer->ForwardBuffer(), data, 0, size * sizeof(float));
-			delete[] data;
-		}
-
-		void InitTruncatedNormalRnd::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
-		{
-			NNBuffer* buffer = bufferList[w];
-
-			size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
-
-			float* data = new float[size];
-
-			float tmpValue;
-
-			for (size_t i = 0; i < size; ++i)
-			{
-				tmpValue = distribution(rnd);
-				while ((tmpValue - mean) > 2.f * stddev && (tmpValue - mean) < -2.f * stddev)
-					tmpValue = distribution(rnd);
-				data[i] = tmpValue;
-
-			}
-
-			backend.WriteDataBuffer(buffer->ForwardBuffer(), data, 0, size * sizeof(float));
-			delete[] data;
-		}
-
-		void InitTruncatedNormalXavier::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
-		{
-			NNBuffer* buffer = bufferList[w];
-
-			size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
-
-			float stddev = sqrt(2.f / static_cast<float>(buffer->size.sizeY));
-			std::normal_distribution<float> distribution(mean, stddev);
-
-			float* data = new float[size];
-
-			float tmpValue;
-
-			for (size_t i = 0; i < size; ++i)
-			{
-				tmpValue = distribution(rnd);
-				while ((tmpValue - mean) > 2.f * stddev && (tmpValue - mean) < -2.f * stddev)
-					tmpValue = distribution(rnd);
-				data[i] = tmpValue;
-
-			}
-
-			backend.WriteDataBuffer(buffer->ForwardBuffer(), data, 0, size * sizeof(float));
-			delete[] data;
-		}
-	}
+#include "WeightInitOp.h"
+
+namespace DeepCL
+{
+	namespace NNSystem
+	{
+		//Seed for the rng
+		const unsigned int InitOp::seed = 99;
+
+		//Must match the define of WeightInit.cl
+		static const size_t INIT_VALUES_PER_ITEM = 4;
+		static const size_t INIT_WORK_GROUP_SIZE = 64;
+
+		//One work item samples INIT_VALUES_PER_ITEM values.
+		static cl::NDRange InitGlobalSize(const size_t size)
+		{
+			const size_t items = (size + INIT_VALUES_PER_ITEM - 1) / INIT_VALUES_PER_ITEM;
+			return cl::NDRange(((items + INIT_WORK_GROUP_SIZE - 1) / INIT_WORK_GROUP_SIZE) * INIT_WORK_GROUP_SIZE);
+		}
+
+		void InitOp::SampleUniform(NNBuffer* buffer, BackendSystem::OpenCLBackend& backend, const float minValue, const float maxValue)
+		{
+			if (op == MAX_UNSIGNED_INT)
+			{
+				const size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
+
+				Tuple<BufferIdx, std::pair<size_t, unsigned int>, std::pair<size_t, unsigned int>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair> arguments(buffer->ForwardBuffer(),
+					std::pair<size_t, unsigned int>(sizeof(unsigned int), seed), std::pair<size_t, unsigned int>(sizeof(unsigned int), static_cast<unsigned int>(w)),
+					std::pair<size_t, float>(sizeof(float), minValue), std::pair<size_t, float>(sizeof(float), maxValue), dataPair(sizeof(int), static_cast<int>(size)));
+				op = backend.AddStandaloneOperation<6, BufferIdx, std::pair<size_t, unsigned int>, std::pair<size_t, unsigned int>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair>(
+					backend.GetKernelIdx("InitUniformRnd"), arguments, cl::NullRange, InitGlobalSize(size), cl::NDRange(INIT_WORK_GROUP_SIZE));
+			}
+
+			//The parameters must be initialized before the first pass uses them.
+			cl::Event event;
+			backend.RunOperation(op, nullptr, &event);
+			backend.WaitForEvent(event);
+		}
+
+		void InitOp::SampleNormal(NNBuffer* buffer, BackendSystem::OpenCLBackend& backend, const float mean, const float stddev, const bool truncate)
+		{
+			if (op == MAX_UNSIGNED_INT)
+			{
+				const size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
+
+				Tuple<BufferIdx, std::pair<size_t, unsigned int>, std::pair<size_t, unsigned int>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair, dataPair> arguments(buffer->ForwardBuffer(),
+					std::pair<size_t, unsigned int>(sizeof(unsigned int), seed), std::pair<size_t, unsigned int>(sizeof(unsigned int), static_cast<unsigned int>(w)),
+					std::pair<size_t, float>(sizeof(float), mean), std::pair<size_t, float>(sizeof(float), stddev), dataPair(sizeof(int), truncate ? 1 : 0), dataPair(sizeof(int), static_cast<int>(size)));
+				op = backend.AddStandaloneOperation<7, BufferIdx, std::pair<size_t, unsigned int>, std::pair<size_t, unsigned int>, std::pair<size_t, float>, std::pair<size_t, float>, dataPair, dataPair>(
+					backend.GetKernelIdx("InitNormalRnd"), arguments, cl::NullRange, InitGlobalSize(size), cl::NDRange(INIT_WORK_GROUP_SIZE));
+			}
+
+			cl::Event event;
+			backend.RunOperation(op, nullptr, &event);
+			backend.WaitForEvent(event);
+		}
+
+		//The random initializations sample the data on the device directly into the buffer.
+		void InitUniformRnd::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
+		{
+			SampleUniform(bufferList[w], backend, minValue, maxValue);
+		}
+
+		void InitUniform::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
+		{
+			NNBuffer* buffer = bufferList[w];
+
+			size_t size = buffer->size.sizeW * buffer->size.sizeX * buffer->size.sizeY * buffer->size.sizeZ;
+
+			float* data = new float[size];
+
+			for (size_t i = 0; i < size; ++i)
+				data[i] = value;
+
+			backend.WriteDataBuffer(buffer->ForwardBuffer(), data, 0, size * sizeof(float));
+			delete[] data;
+		}
+
+		void InitNormalRnd::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
+		{
+			SampleNormal(bufferList[w], backend, mean, stddev, false);
+		}
+
+		//Values further than two standard deviations from the mean are sampled again.
+		void InitTruncatedNormalRnd::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
+		{
+			SampleNormal(bufferList[w], backend, mean, stddev, true);
+		}
+
+		void InitTruncatedNormalXavier::Instantiate(const std::vector<NNBuffer*>& bufferList, BackendSystem::OpenCLBackend& backend)
+		{
+			NNBuffer* buffer = bufferList[w];
+
+			float stddev = sqrt(2.f / static_cast<float>(buffer->size.sizeY));
+			SampleNormal(buffer, backend, mean, stddev, true);
+		}
+	}
 }
\ No newline at end of file
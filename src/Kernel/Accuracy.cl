@@ -0,0 +1,57 @@
+//Kernels evaluating a classifier on the device. Only the number of correct examples has to be read after a test set was processed.
+
+//Stores the index of the largest value of each row (The first one if several are equal).
+void kernel Argmax(global read_only const float* restrict A, global write_only int* restrict B, const int m, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	int maxIdx = 0;
+	float maxValue = A[i * m];
+	for (int x = 1; x < m; ++x)
+	{
+		const float value = A[i * m + x];
+		if (value > maxValue)
+		{
+			maxIdx = x;
+			maxValue = value;
+		}
+	}
+	B[i] = maxIdx;
+}
+
+//Stores one for each row where the label is among the k largest values (Equal values with a lower index are ranked higher) and zero otherwise.
+//The number of correct rows of each work group is added to counter.
+void kernel CountCorrect(global read_only const float* restrict A, global read_only const int* restrict Y, global write_only float* restrict C, global int* restrict counter, const int m, const int k, const int n)
+{
+	const int i = get_global_id(0);
+
+	__local int numCorrect;
+	if (get_local_id(0) == 0)
+		numCorrect = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (i < n)
+	{
+		const int y = Y[i];
+		const float value = A[i * m + y];
+		int rank = 0;
+		for (int x = 0; x < m; ++x)
+		{
+			const float other = A[i * m + x];
+			if (other > value || (other == value && x < y))
+				++rank;
+		}
+
+		const int correct = rank < k ? 1 : 0;
+		C[i] = (float)correct;
+		if (correct)
+			atomic_inc(&numCorrect);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (get_local_id(0) == 0 && numCorrect != 0)
+		atomic_add(counter, numCorrect);
+}
@@ -1,29 +1,33 @@
-void kernel Add(global read_only const float* restrict A, global read_only const float* restrict B, global write_only float* restrict Y, const int n)
-{
-	const int i = get_global_id(0);
-
-	if (i >= n)
-		return;
-
-	Y[i] = A[i] + B[i];
-}
-
-void kernel SubtractFromConst(global read_only const float* restrict A, global write_only float* restrict C, const float co, const int n)
-{
-	const int i = get_global_id(0);
-
-	if (i >= n)
-		return;
-
-	C[i] = co - A[i];
-}
-
-void kernel SubtractFromConstGrad(global read_only const float* restrict A, global float* restrict C, const int n)
-{
-	const int i = get_global_id(0);
-
-	if (i >= n)
-		return;
-
-	C[i] += -1.f * A[i];
-}
+void kernel Add(global read_only const STORAGE0* restrict A, global read_only const STORAGE1* restrict B, global write_only STORAGE2* restrict Y, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	STORE2(Y, i, LOAD0(A, i) + LOAD1(B, i));
+}
+
+void kernel SubtractFromConst(global read_only const STORAGE0* restrict A, global write_only STORAGE1* restrict C, const float co, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	STORE1(C, i, co - LOAD0(A, i));
+}
+
+void kernel SubtractFromConstGrad(global read_only const STORAGE0* restrict A, global STORAGE1* restrict C, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+#ifdef OVERWRITE_RESULT
+	STORE1(C, i, -1.f * LOAD0(A, i));
+#else
+	STORE1(C, i, LOAD1(C, i) - LOAD0(A, i));
+#endif
+}
@@ -0,0 +1,88 @@
+//Kernels augmenting the input images on the device (See NNAugmentOp). The parameters of each sample are generated on the device by the counter based generator Philox4x32-10 (See Philox.cl)
+//from the seed of the operation, the index of the sample and the number of the forward pass, therefore only the raw images have to be uploaded.
+//The images are stored with x as the fastest dimension followed by y and the channel.
+
+//Maps the 24 highest bits of each value to [-1, 1).
+inline float4 ToSigned(const uint4 bits)
+{
+	return convert_float4(bits >> 8) * (2.f / 16777216.f) - (float4)1.f;
+}
+
+//Reads the pixel (x, y) of a channel or value if it lies outside of the image.
+inline float Pixel(global const float* restrict A, const int x, const int y, const int w, const int h, const float value)
+{
+	return (x >= 0 && x < w && y >= 0 && y < h) ? A[y * w + x] : value;
+}
+
+//Each work item computes one value of the output. All work items of a sample generate the same parameters:
+//flip (x, y), rotation, scaling, translation by the crop offset and a continuous shift, brightness and contrast.
+//The geometric transformations are combined into one inverse mapping which is sampled bilinearly. Pixels outside of the input are set to fill.
+//state contains the number of the forward pass and a flag, if the flag is zero the input is copied unchanged.
+//limits: flipX probability, flipY probability, maxAngle, maxScale, maxShift, maxBrightness, maxContrast, contrast center
+void kernel Augment(global read_only const float* restrict A, global write_only float* restrict C, global read_only const uint* restrict state, const uint seed, const uint key,
+	const int w, const int h, const int channels, const int pad, const float8 limits, const float fill, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	if (state[1] == 0)
+	{
+		C[i] = A[i];
+		return;
+	}
+
+	const int planeSize = w * h;
+	const int x = i % w;
+	const int y = (i / w) % h;
+	const int plane = i / planeSize;
+	const uint sample = (uint)(plane / channels);
+
+	const uint2 philoxKey = (uint2)(seed, key);
+	const float4 r0 = ToSigned(Philox((uint4)(sample, state[0], 0, 0), philoxKey));
+	const float4 r1 = ToSigned(Philox((uint4)(sample, state[0], 1, 0), philoxKey));
+	const float4 r2 = ToSigned(Philox((uint4)(sample, state[0], 2, 0), philoxKey));
+
+	//r0.x and r0.y are uniform in [-1, 1), the flips happen if they are below 2 * probability - 1.
+	const float flipX = r0.x < 2.f * limits.s0 - 1.f ? -1.f : 1.f;
+	const float flipY = r0.y < 2.f * limits.s1 - 1.f ? -1.f : 1.f;
+	const float angle = r0.z * limits.s2;
+	const float scale = 1.f + r0.w * limits.s3;
+	//The crop offset is an integer in [-pad, pad]
+	const float shiftX = r1.x * limits.s4 + (float)(clamp((int)floor((r1.y * 0.5f + 0.5f) * (2 * pad + 1)), 0, 2 * pad) - pad);
+	const float shiftY = r1.z * limits.s4 + (float)(clamp((int)floor((r1.w * 0.5f + 0.5f) * (2 * pad + 1)), 0, 2 * pad) - pad);
+	const float brightness = r2.x * limits.s5;
+	const float contrast = 1.f + r2.y * limits.s6;
+
+	//Inverse mapping: remove the translation, rotate back, scale back and mirror relative to the center.
+	const float centerX = 0.5f * (float)(w - 1);
+	const float centerY = 0.5f * (float)(h - 1);
+	const float qx = (float)x - centerX - shiftX;
+	const float qy = (float)y - centerY - shiftY;
+	const float c = cos(angle) / scale;
+	const float s = sin(angle) / scale;
+	const float sx = centerX + flipX * (c * qx + s * qy);
+	const float sy = centerY + flipY * (c * qy - s * qx);
+
+	const float fx = floor(sx);
+	const float fy = floor(sy);
+	const float wx = sx - fx;
+	const float wy = sy - fy;
+	const int ix = (int)fx;
+	const int iy = (int)fy;
+
+	global const float* restrict source = A + plane * planeSize;
+	const float top = mix(Pixel(source, ix, iy, w, h, fill), Pixel(source, ix + 1, iy, w, h, fill), wx);
+	const float bottom = mix(Pixel(source, ix, iy + 1, w, h, fill), Pixel(source, ix + 1, iy + 1, w, h, fill), wx);
+	const float value = mix(top, bottom, wy);
+
+	C[i] = (value - limits.s7) * contrast + limits.s7 + brightness;
+}
+
+//Advances the number of the forward pass used by Augment. Runs before the first Augment of each forward pass.
+void kernel AugmentStep(global uint* restrict state)
+{
+	if (get_global_id(0) == 0)
+		state[0] = state[0] + 1;
+}
@@ -0,0 +1,48 @@
+//Kernels converting compact input data (See NNInputBuffer) into the float activations used by the graph (See NNDequantizeOp).
+//Each value is multiplied with scale, the mean of its channel is subtracted and the result is divided by the standard deviation of the channel.
+//stats contains the means of all channels followed by the inverse standard deviations. A channel consists of channelSize values.
+
+void kernel DequantizeUInt8(global read_only const uchar* restrict A, global write_only STORAGE1* restrict C, global read_only const float* restrict stats, const float scale, const int channelSize, const int channels, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	const int c = (i / channelSize) % channels;
+	STORE1(C, i, (convert_float(A[i]) * scale - stats[c]) * stats[channels + c]);
+}
+
+void kernel DequantizeInt16(global read_only const short* restrict A, global write_only STORAGE1* restrict C, global read_only const float* restrict stats, const float scale, const int channelSize, const int channels, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	const int c = (i / channelSize) % channels;
+	STORE1(C, i, (convert_float(A[i]) * scale - stats[c]) * stats[channels + c]);
+}
+
+void kernel DequantizeHalf(global read_only const half* restrict A, global write_only STORAGE1* restrict C, global read_only const float* restrict stats, const float scale, const int channelSize, const int channels, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	const int c = (i / channelSize) % channels;
+	STORE1(C, i, (vload_half(i, A) * scale - stats[c]) * stats[channels + c]);
+}
+
+//Only normalizes float inputs.
+void kernel DequantizeFloat(global read_only const float* restrict A, global write_only STORAGE1* restrict C, global read_only const float* restrict stats, const float scale, const int channelSize, const int channels, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	const int c = (i / channelSize) % channels;
+	STORE1(C, i, (A[i] * scale - stats[c]) * stats[channels + c]);
+}
@@ -1,43 +1,47 @@
-void kernel ElemWiseProduct(global read_only const float* restrict A, global read_only const float* restrict B, global write_only float* restrict C, const int sizeA)
-{
-#define GS 64
-
-	const int i = get_global_id(0);
-	const int tx = get_local_id(0);
-	const int sizeX = get_local_size(0);
-	const int groupId = get_group_id(0);
-
-	if (i>= sizeA)
-		return;
-
-	__local float buffer[GS];
-	__local float buffer2[GS];
-	buffer[tx] = A[groupId *sizeX + tx];
-	buffer2[tx] = B[groupId *sizeX + tx];
-
-	barrier(CLK_LOCAL_MEM_FENCE);
-
-	C[i] = (buffer[tx] * buffer2[tx]);
-}
-
-void kernel ElemWiseProductAdd(global read_only const float* restrict A, global read_only const float* restrict B, global float* restrict C, const int sizeA)
-{
-#define GS 64
-
-	const int i = get_global_id(0);
-	const int tx = get_local_id(0);
-	const int sizeX = get_local_size(0);
-	const int groupId = get_group_id(0);
-
-	if (i >= sizeA)
-		return;
-
-	__local float buffer[GS];
-	__local float buffer2[GS];
-	buffer[tx] = A[groupId *sizeX + tx];
-	buffer2[tx] = B[groupId *sizeX + tx];
-
-	barrier(CLK_LOCAL_MEM_FENCE);
-
-	C[i] += (buffer[tx] * buffer2[tx]);
+void kernel ElemWiseProduct(global read_only const STORAGE0* restrict A, global read_only const STORAGE1* restrict B, global write_only STORAGE2* restrict C, const int sizeA)
+{
+#define GS 64
+
+	const int i = get_global_id(0);
+	const int tx = get_local_id(0);
+	const int sizeX = get_local_size(0);
+	const int groupId = get_group_id(0);
+
+	if (i>= sizeA)
+		return;
+
+	__local float buffer[GS];
+	__local float buffer2[GS];
+	buffer[tx] = LOAD0(A, groupId *sizeX + tx);
+	buffer2[tx] = LOAD1(B, groupId *sizeX + tx);
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	STORE2(C, i, (buffer[tx] * buffer2[tx]));
+}
+
+void kernel ElemWiseProductAdd(global read_only const STORAGE0* restrict A, global read_only const STORAGE1* restrict B, global STORAGE2* restrict C, const int sizeA)
+{
+#define GS 64
+
+	const int i = get_global_id(0);
+	const int tx = get_local_id(0);
+	const int sizeX = get_local_size(0);
+	const int groupId = get_group_id(0);
+
+	if (i >= sizeA)
+		return;
+
+	__local float buffer[GS];
+	__local float buffer2[GS];
+	buffer[tx] = LOAD0(A, groupId *sizeX + tx);
+	buffer2[tx] = LOAD1(B, groupId *sizeX + tx);
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+#ifdef OVERWRITE_RESULT
+	STORE2(C, i, (buffer[tx] * buffer2[tx]));
+#else
+	STORE2(C, i, LOAD2(C, i) + (buffer[tx] * buffer2[tx]));
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,365 @@
+//Kernels of the fused GRU cell (See NNGRUOp). The weights of the three gates are stored behind each other in each row: U[x * 3H + g * H + j] and W[k * 3H + g * H + j]
+//with the gate order update (z), reset (r) and candidate (n). The gates of time step t and batch element b start at G[gOffset + (t * maxBatch + b) * 3H].
+//The time steps of a buffer lie stride elements apart in its base buffer, therefore the kernels over several time steps read the base buffer starting at offset.
+
+#define GRU_MAX_HIDDEN 1024
+//Work group size of the tiled GRURecurrentWeightGradient in both dimensions
+#define GRU_TILE 8
+
+inline float GRUSigmoid(const float x)
+{
+	return 1.f / (1.f + exp(-x));
+}
+
+//Global barrier of the persistent kernels. counter is zero when the kernel starts and target is the number of work groups times the number of barriers passed so far, including this one.
+//The work groups wait for each other, therefore the host starts at most one work group per compute unit.
+inline void GRUGlobalBarrier(volatile global int* counter, const int target)
+{
+	barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+	if (get_local_id(0) == 0)
+	{
+		mem_fence(CLK_GLOBAL_MEM_FENCE);
+		atomic_inc(counter);
+		while (atomic_add(counter, 0) < target)
+			;
+		mem_fence(CLK_GLOBAL_MEM_FENCE);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+}
+
+//Adds the bias of all gates to the input projections of numSteps time steps (Third dimension of the global size). The projections G = A * U are computed by MatrixMulSteps.
+void kernel GRUAddBias(global float* restrict G, global read_only const float* restrict bias, const int gOffset, const int batch, const int maxBatch, const int h3)
+{
+	const int g = get_global_id(0);
+	const int b = get_global_id(1);
+	const int t = get_global_id(2);
+
+	if (g >= h3 || b >= batch)
+		return;
+
+	G[gOffset + (t * maxBatch + b) * h3 + g] += bias[g];
+}
+
+//One time step of the GRU. Each work group computes one batch element, the previous state and the reset state stay in local memory.
+//The projected gates are replaced by the activations z, r and n which are needed by the backward pass. The new state is stored in H and in the next sub buffer of the state.
+void kernel GRUForwardStep(global float* restrict G, global read_only const float* restrict W, global read_only const float* restrict S, global write_only float* restrict H, global write_only float* restrict SNext,
+	const int gOffset, const int hSize)
+{
+	const int b = get_group_id(0);
+	const int lid = get_local_id(0);
+	const int localSize = get_local_size(0);
+	const int h3 = 3 * hSize;
+
+	__local float h[GRU_MAX_HIDDEN];
+	__local float rh[GRU_MAX_HIDDEN];
+
+	global float* gates = G + gOffset + b * h3;
+
+	for (int j = lid; j < hSize; j += localSize)
+		h[j] = S[b * hSize + j];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int j = lid; j < hSize; j += localSize)
+	{
+		float zPre = gates[j];
+		float rPre = gates[hSize + j];
+		for (int k = 0; k < hSize; ++k)
+		{
+			zPre += h[k] * W[k * h3 + j];
+			rPre += h[k] * W[k * h3 + hSize + j];
+		}
+		const float r = GRUSigmoid(rPre);
+		gates[j] = GRUSigmoid(zPre);
+		gates[hSize + j] = r;
+		rh[j] = r * h[j];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int j = lid; j < hSize; j += localSize)
+	{
+		float nPre = gates[2 * hSize + j];
+		for (int k = 0; k < hSize; ++k)
+			nPre += rh[k] * W[k * h3 + 2 * hSize + j];
+		const float n = tanh(nPre);
+		const float z = gates[j];
+		gates[2 * hSize + j] = n;
+
+		const float hNew = (1.f - z) * n + z * h[j];
+		H[b * hSize + j] = hNew;
+		SNext[b * hSize + j] = hNew;
+	}
+}
+
+//Backward pass of one time step. The gradient of the new state is the sum of the gradients of H and of the next state sub buffer.
+//Stores the gradients of the gate inputs in dG and adds the gradient of the previous state to dS.
+void kernel GRUBackwardStep(global read_only const float* restrict G, global read_only const float* restrict W, global read_only const float* restrict S, global read_only const float* restrict dH,
+	global read_only const float* restrict dSNext, global write_only float* restrict dG, global float* restrict dS, const int gOffset, const int hSize)
+{
+	const int b = get_group_id(0);
+	const int lid = get_local_id(0);
+	const int localSize = get_local_size(0);
+	const int h3 = 3 * hSize;
+
+	__local float h[GRU_MAX_HIDDEN];
+	__local float dz[GRU_MAX_HIDDEN];
+	__local float dr[GRU_MAX_HIDDEN];
+	__local float dn[GRU_MAX_HIDDEN];
+	__local float dh[GRU_MAX_HIDDEN];
+
+	const global float* gates = G + gOffset + b * h3;
+	global float* gradients = dG + gOffset + b * h3;
+
+	for (int j = lid; j < hSize; j += localSize)
+		h[j] = S[b * hSize + j];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int j = lid; j < hSize; j += localSize)
+	{
+		const float grad = dH[b * hSize + j] + dSNext[b * hSize + j];
+		const float z = gates[j];
+		const float n = gates[2 * hSize + j];
+
+		const float nGrad = grad * (1.f - z) * (1.f - n * n);
+		const float zGrad = grad * (h[j] - n) * z * (1.f - z);
+		dn[j] = nGrad;
+		dz[j] = zGrad;
+		dh[j] = grad * z;
+		gradients[j] = zGrad;
+		gradients[2 * hSize + j] = nGrad;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int k = lid; k < hSize; k += localSize)
+	{
+		float rhGrad = 0.f;
+		float hGrad = 0.f;
+		for (int j = 0; j < hSize; ++j)
+		{
+			rhGrad += dn[j] * W[k * h3 + 2 * hSize + j];
+			hGrad += dz[j] * W[k * h3 + j];
+		}
+		const float r = gates[hSize + k];
+		const float rGrad = rhGrad * h[k] * r * (1.f - r);
+		dr[k] = rGrad;
+		gradients[hSize + k] = rGrad;
+		dh[k] += rhGrad * r + hGrad;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int k = lid; k < hSize; k += localSize)
+	{
+		float hGrad = dh[k];
+		for (int j = 0; j < hSize; ++j)
+			hGrad += dr[j] * W[k * h3 + hSize + j];
+		dS[b * hSize + k] += hGrad;
+	}
+}
+
+//Adds the gradient of the recurrent weights summed over numSteps time steps, tiled like MatrixMulStepsWeightGrad. The candidate gate receives the reset state r * h instead of the previous state,
+//therefore the tiles of both are loaded and each column selects the one of its gate.
+void kernel GRURecurrentWeightGradient(global read_only const float* restrict S, global read_only const float* restrict G, global read_only const float* restrict dG, global float* restrict dW,
+	const int sOffset, const int sStride, const int gOffset, const int batch, const int maxBatch, const int hSize, const int numSteps)
+{
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+	const int g = get_global_id(0);
+	const int k = get_global_id(1);
+	const int h3 = 3 * hSize;
+	const int rows = numSteps * batch;
+
+	__local float tileS[GRU_TILE * GRU_TILE];
+	__local float tileRS[GRU_TILE * GRU_TILE];
+	__local float tileG[GRU_TILE * GRU_TILE];
+
+	const bool candidate = g >= 2 * hSize;
+	float sum = 0.f;
+	for (int i = 0; i < rows; i += GRU_TILE)
+	{
+		const int rS = i + tx;
+		const int rG = i + ty;
+		float h = 0.f;
+		float r = 0.f;
+		if (rS < rows && k < hSize)
+		{
+			h = S[sOffset + (rS / batch) * sStride + (rS % batch) * hSize + k];
+			r = G[gOffset + ((rS / batch) * maxBatch + rS % batch) * h3 + hSize + k];
+		}
+		tileS[ty * GRU_TILE + tx] = h;
+		tileRS[ty * GRU_TILE + tx] = r * h;
+		tileG[ty * GRU_TILE + tx] = rG < rows && g < h3 ? dG[gOffset + ((rG / batch) * maxBatch + rG % batch) * h3 + g] : 0.f;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		const local float* tile = candidate ? tileRS : tileS;
+		for (int j = 0; j < GRU_TILE; ++j)
+			sum += tile[ty * GRU_TILE + j] * tileG[j * GRU_TILE + tx];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (g < h3 && k < hSize)
+		dW[k * h3 + g] += sum;
+}
+
+void kernel GRUBiasGradient(global read_only const float* restrict dG, global float* restrict dBias, const int gOffset, const int batch, const int maxBatch, const int h3, const int numSteps)
+{
+	const int g = get_global_id(0);
+
+	if (g >= h3)
+		return;
+
+	float sum = 0.f;
+	for (int t = 0; t < numSteps; ++t)
+		for (int b = 0; b < batch; ++b)
+			sum += dG[gOffset + (t * maxBatch + b) * h3 + g];
+	dBias[g] += sum;
+}
+
+//Persistent version of GRUForwardStep running all time steps with one launch. Each work group computes the state values first to first + slice of all batch elements
+//and keeps the columns of W belonging to them in localW (3 * slice * hSize floats). Values written by other work groups are read through volatile pointers after a global barrier.
+void kernel GRUPersistentForward(global float* G, global read_only const float* restrict W, global float* S, global float* H, global int* counter, local float* restrict localW,
+	const int gOffset, const int sOffset, const int sStride, const int hOffset, const int hStride, const int batch, const int maxBatch, const int hSize, const int slice, const int numSteps)
+{
+	const int lid = get_local_id(0);
+	const int localSize = get_local_size(0);
+	const int numGroups = get_num_groups(0);
+	const int h3 = 3 * hSize;
+	const int first = get_group_id(0) * slice;
+	const int count = min(slice, hSize - first);
+
+	//localW[(g * slice + j) * hSize + k] = W[k * 3H + g * H + first + j]
+	for (int i = lid; i < 3 * count * hSize; i += localSize)
+	{
+		const int k = i % hSize;
+		const int g = i / hSize / count;
+		const int j = i / hSize % count;
+		localW[(g * slice + j) * hSize + k] = W[k * h3 + g * hSize + first + j];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	int target = 0;
+	for (int t = 0; t < numSteps; ++t)
+	{
+		volatile global float* gates = G + gOffset + t * maxBatch * h3;
+		volatile global const float* h = S + sOffset + t * sStride;
+
+		for (int i = lid; i < count * batch; i += localSize)
+		{
+			const int b = i / count;
+			const int j = i % count;
+			const local float* wz = localW + j * hSize;
+			const local float* wr = localW + (slice + j) * hSize;
+
+			float zPre = gates[b * h3 + first + j];
+			float rPre = gates[b * h3 + hSize + first + j];
+			for (int k = 0; k < hSize; ++k)
+			{
+				const float value = h[b * hSize + k];
+				zPre += value * wz[k];
+				rPre += value * wr[k];
+			}
+			gates[b * h3 + first + j] = GRUSigmoid(zPre);
+			gates[b * h3 + hSize + first + j] = GRUSigmoid(rPre);
+		}
+		target += numGroups;
+		GRUGlobalBarrier(counter, target);
+
+		//The candidate gate needs the reset gates of all work groups.
+		for (int i = lid; i < count * batch; i += localSize)
+		{
+			const int b = i / count;
+			const int j = i % count;
+			const local float* wn = localW + (2 * slice + j) * hSize;
+
+			float nPre = gates[b * h3 + 2 * hSize + first + j];
+			for (int k = 0; k < hSize; ++k)
+				nPre += gates[b * h3 + hSize + k] * h[b * hSize + k] * wn[k];
+			const float n = tanh(nPre);
+			const float z = gates[b * h3 + first + j];
+			gates[b * h3 + 2 * hSize + first + j] = n;
+
+			const float hNew = (1.f - z) * n + z * h[b * hSize + first + j];
+			S[sOffset + (t + 1) * sStride + b * hSize + first + j] = hNew;
+			H[hOffset + t * hStride + b * hSize + first + j] = hNew;
+		}
+		target += numGroups;
+		GRUGlobalBarrier(counter, target);
+	}
+}
+
+//Persistent version of GRUBackwardStep running all time steps in reverse order with one launch. Each work group handles the state values first to first + slice
+//and keeps the rows of W belonging to them in localW (3 * slice * hSize floats).
+void kernel GRUPersistentBackward(global read_only const float* restrict G, global read_only const float* restrict W, global read_only const float* restrict S, global read_only const float* restrict dH,
+	global float* dG, global float* dS, global int* counter, local float* restrict localW,
+	const int gOffset, const int sOffset, const int sStride, const int hOffset, const int hStride, const int batch, const int maxBatch, const int hSize, const int slice, const int numSteps)
+{
+	const int lid = get_local_id(0);
+	const int localSize = get_local_size(0);
+	const int numGroups = get_num_groups(0);
+	const int h3 = 3 * hSize;
+	const int first = get_group_id(0) * slice;
+	const int count = min(slice, hSize - first);
+
+	//localW[j * 3H + c] = W[(first + j) * 3H + c]
+	for (int i = lid; i < count * h3; i += localSize)
+		localW[i] = W[first * h3 + i];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	int target = 0;
+	for (int t = numSteps - 1; t >= 0; --t)
+	{
+		const global float* gates = G + gOffset + t * maxBatch * h3;
+		volatile global float* gradients = dG + gOffset + t * maxBatch * h3;
+		const global float* h = S + sOffset + t * sStride;
+		const global float* grad = dH + hOffset + t * hStride;
+		//The next state gradient of the own values was completed by this work item in the previous iteration.
+		const global float* dNext = dS + sOffset + (t + 1) * sStride;
+		global float* dPrev = dS + sOffset + t * sStride;
+
+		for (int i = lid; i < count * batch; i += localSize)
+		{
+			const int b = i / count;
+			const int j = first + i % count;
+			const float g = grad[b * hSize + j] + dNext[b * hSize + j];
+			const float z = gates[b * h3 + j];
+			const float n = gates[b * h3 + 2 * hSize + j];
+
+			gradients[b * h3 + j] = g * (h[b * hSize + j] - n) * z * (1.f - z);
+			gradients[b * h3 + 2 * hSize + j] = g * (1.f - z) * (1.f - n * n);
+		}
+		target += numGroups;
+		GRUGlobalBarrier(counter, target);
+
+		//The reset gate and the first part of the previous state gradient need the update and candidate gradients of all work groups.
+		for (int i = lid; i < count * batch; i += localSize)
+		{
+			const int b = i / count;
+			const int k = first + i % count;
+			const local float* w = localW + (i % count) * h3;
+
+			float rhGrad = 0.f;
+			float hGrad = 0.f;
+			for (int j = 0; j < hSize; ++j)
+			{
+				rhGrad += gradients[b * h3 + 2 * hSize + j] * w[2 * hSize + j];
+				hGrad += gradients[b * h3 + j] * w[j];
+			}
+			const float g = grad[b * hSize + k] + dNext[b * hSize + k];
+			const float r = gates[b * h3 + hSize + k];
+			gradients[b * h3 + hSize + k] = rhGrad * h[b * hSize + k] * r * (1.f - r);
+			dPrev[b * hSize + k] += g * gates[b * h3 + k] + rhGrad * r + hGrad;
+		}
+		target += numGroups;
+		GRUGlobalBarrier(counter, target);
+
+		for (int i = lid; i < count * batch; i += localSize)
+		{
+			const int b = i / count;
+			const int k = first + i % count;
+			const local float* w = localW + (i % count) * h3;
+
+			float hGrad = 0.f;
+			for (int j = 0; j < hSize; ++j)
+				hGrad += gradients[b * h3 + hSize + j] * w[hSize + j];
+			dPrev[b * hSize + k] += hGrad;
+		}
+	}
+}
@@ -0,0 +1,183 @@
+//Kernels compressing the parameter gradients before they are exchanged between processes and decompressing the exchanged gradients (See GradientCompressor).
+//Top-k and sign compression keep the part of the gradient which was not transmitted in a residual buffer and add it to the gradient of the next step (Error feedback).
+
+#define COMPRESSION_WORK_GROUP_SIZE 256
+#define TOPK_BINS 1024
+
+//Bin of a value in the histogram used to find the threshold of the top-k selection. It consists of the exponent and the two highest bits of the mantissa of the magnitude,
+//therefore the bins are ordered by the magnitude.
+inline int TopKBin(const float value)
+{
+	return (as_uint(fabs(value)) >> 21) & (TOPK_BINS - 1);
+}
+
+//Stores the weighted gradient as half.
+void kernel CompressHalf(global read_only const float* restrict gradient, global write_only half* restrict compressed, const float weight, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	vstore_half(gradient[i] * weight, i, compressed);
+}
+
+void kernel DecompressHalf(global read_only const half* restrict compressed, global write_only float* restrict gradient, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	gradient[i] = vload_half(i, compressed);
+}
+
+//Adds the weighted gradient to the residual and counts the values of the residual in each bin. Each work group builds its histogram in local memory first.
+//Clears the counter of the selected values, since the histogram is read before the selection starts.
+void kernel TopKHistogram(global read_only const float* restrict gradient, global float* restrict residual, global uint* restrict histogram, global uint* restrict selected, const float weight, const int n)
+{
+	const int i = get_global_id(0);
+	const int lid = get_local_id(0);
+
+	__local uint localHistogram[TOPK_BINS];
+	for (int b = lid; b < TOPK_BINS; b += COMPRESSION_WORK_GROUP_SIZE)
+		localHistogram[b] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (i < n)
+	{
+		const float value = gradient[i] * weight + residual[i];
+		residual[i] = value;
+		atomic_inc(&localHistogram[TopKBin(value)]);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int b = lid; b < TOPK_BINS; b += COMPRESSION_WORK_GROUP_SIZE)
+		if (localHistogram[b] != 0)
+			atomic_add(&histogram[b], localHistogram[b]);
+
+	if (i == 0)
+		selected[0] = 0;
+}
+
+//Moves the values of the residual in the bins from threshold upwards into selected. selected contains the number of values followed by capacity indices and capacity values.
+//Values which don't fit stay in the residual and are sent in a later step. The histogram is cleared for the next step.
+void kernel TopKSelect(global float* restrict residual, global uint* restrict histogram, global uint* restrict selected, const int threshold, const int capacity, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i < TOPK_BINS)
+		histogram[i] = 0;
+
+	if (i >= n)
+		return;
+
+	const float value = residual[i];
+	if (TopKBin(value) < threshold)
+		return;
+
+	const uint slot = atomic_inc(&selected[0]);
+	if (slot < capacity)
+	{
+		selected[1 + slot] = i;
+		selected[1 + capacity + slot] = as_uint(value);
+		residual[i] = 0.f;
+	}
+}
+
+void kernel SetZero(global write_only float* restrict A, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	A[i] = 0.f;
+}
+
+//Adds the selected values of all processes to the gradient. pairs contains numPairs indices followed by numPairs values. The processes can select the same index,
+//therefore the values are added atomically.
+void kernel ScatterAdd(global read_only const uint* restrict pairs, global float* restrict gradient, const int numPairs)
+{
+	const int i = get_global_id(0);
+
+	if (i >= numPairs)
+		return;
+
+	volatile global uint* target = (volatile global uint*)(gradient + pairs[i]);
+	const float value = as_float(pairs[numPairs + i]);
+	uint expected = *target;
+	uint previous;
+	while ((previous = atomic_cmpxchg(target, expected, as_uint(as_float(expected) + value))) != expected)
+		expected = previous;
+}
+
+//Adds the weighted gradient to the residual and stores the signs of the sums as bits. Bit j of word w belongs to value w * 32 + j.
+//Each work group handles COMPRESSION_WORK_GROUP_SIZE * 32 values and writes the sum of their magnitudes into partialSums. The scale is their mean.
+void kernel SignCompress(global read_only const float* restrict gradient, global float* restrict residual, global write_only uint* restrict bits, global write_only float* restrict partialSums, const float weight, const int n)
+{
+	const int lid = get_local_id(0);
+	const int group = get_group_id(0);
+	const int first = group * COMPRESSION_WORK_GROUP_SIZE * 32;
+
+	__local uint words[COMPRESSION_WORK_GROUP_SIZE];
+	__local float sums[COMPRESSION_WORK_GROUP_SIZE];
+	words[lid] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	//Neighbouring work items read neighbouring values and set the bits of the same word.
+	float sum = 0.f;
+	for (int k = 0; k < 32; ++k)
+	{
+		const int position = k * COMPRESSION_WORK_GROUP_SIZE + lid;
+		const int i = first + position;
+		if (i < n)
+		{
+			const float value = gradient[i] * weight + residual[i];
+			residual[i] = value;
+			sum += fabs(value);
+			if (value >= 0.f)
+				atomic_or(&words[position / 32], 1u << (position % 32));
+		}
+	}
+	sums[lid] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (first + lid * 32 < n)
+		bits[first / 32 + lid] = words[lid];
+
+	for (int stride = COMPRESSION_WORK_GROUP_SIZE / 2; stride > 0; stride /= 2)
+	{
+		if (lid < stride)
+			sums[lid] += sums[lid + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	if (lid == 0)
+		partialSums[group] = sums[0];
+}
+
+//Removes the transmitted part (scale times the sign) from the residual.
+void kernel SignFeedback(global float* restrict residual, global read_only const uint* restrict bits, const float scale, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	const float sign = ((bits[i / 32] >> (i % 32)) & 1) ? 1.f : -1.f;
+	residual[i] -= scale * sign;
+}
+
+//Sums the scaled signs of all processes. bits contains the words of each process behind each other.
+void kernel SignDecompress(global read_only const uint* restrict bits, global read_only const float* restrict scales, global write_only float* restrict gradient, const int numProcesses, const int numWords, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	float sum = 0.f;
+	for (int p = 0; p < numProcesses; ++p)
+		sum += ((bits[p * numWords + i / 32] >> (i % 32)) & 1) ? scales[p] : -scales[p];
+	gradient[i] = sum;
+}
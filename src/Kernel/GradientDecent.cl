@@ -1,14 +1,14 @@
-void kernel GradientDecent(global read_only float* restrict A, global float* restrict L, const float alpha, const int size)
-{
-	const int i = get_global_id(0);
-		
-	if(i >= size)
-		return;
-		
-	float a = A[i];
-	float l = L[i];
-	
-	barrier(CLK_LOCAL_MEM_FENCE);
-	
-	L[i] = l - alpha * a;
+void kernel GradientDecent(global read_only float* restrict A, global float* restrict L, const float alpha, const int size, const float gradScale, global read_only const float* restrict lossScale, global read_only const int* restrict overflow)
+{
+	const int i = get_global_id(0);
+		
+	if(i >= size || overflow[0] != 0)
+		return;
+		
+	float a = A[i] * gradScale / lossScale[0];
+	float l = L[i];
+	
+	barrier(CLK_LOCAL_MEM_FENCE);
+	
+	L[i] = l - alpha * a;
 }
\ No newline at end of file
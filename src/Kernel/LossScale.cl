@@ -0,0 +1,53 @@
+//Multiplies the gradient of a loss with the current loss scale. Small gradients thereby don't vanish when they are stored as half.
+void kernel ScaleByBuffer(global float* restrict A, global read_only const float* restrict scale, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	A[i] = A[i] * scale[0];
+}
+
+//Sets the overflow flag if an element of the gradient is not finite. All work items write the same value therefore no atomic operation is needed.
+void kernel CheckFinite(global read_only const float* restrict A, global int* restrict overflow, const int n)
+{
+	const int i = get_global_id(0);
+
+	if (i >= n)
+		return;
+
+	if (!isfinite(A[i]))
+		overflow[0] = 1;
+}
+
+//Adapts the loss scale after the update. The scale is halved if an overflow occured and doubled after interval steps without an overflow.
+//goodSteps counts the steps since the last change. The overflow flag is cleared for the next step.
+void kernel UpdateLossScale(global float* restrict scale, global int* restrict overflow, global int* restrict goodSteps, const int interval, const float maxScale)
+{
+	if (get_global_id(0) != 0)
+		return;
+
+	if (overflow[0] != 0)
+	{
+		scale[0] = fmax(scale[0] * 0.5f, 1.f);
+		goodSteps[0] = 0;
+	}
+	else if (++goodSteps[0] >= interval)
+	{
+		scale[0] = fmin(scale[0] * 2.f, maxScale);
+		goodSteps[0] = 0;
+	}
+
+	overflow[0] = 0;
+}
+
+//Counts the performed updates after all update operations read the count. Steps skipped because of an overflow are not counted.
+void kernel CountStep(global int* restrict step, global read_only const int* restrict overflow)
+{
+	if (get_global_id(0) != 0)
+		return;
+
+	if (overflow[0] == 0)
+		++step[0];
+}
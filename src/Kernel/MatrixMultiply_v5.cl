@@ -1,243 +1,353 @@
-void kernel MatrixMul(global read_only const float* restrict A, global read_only const float* restrict B, global write_only float* restrict C, const int hA, const int wB, const int wA)
-{
-
-//The size of a tile from the output that gets calculated by this work group
-#define TILE_SIZE_X_2D 8
-#define TILE_SIZE_Y_2D 8
-
-//Each thread can potentially compute the result of multiple outputs
-//This increases the total tile size.
-#define WPTY 1
-#define WPTX 1
-
-
-#define TOTAL_WPT (WPTX * WPTY)
-
-	const int tx = get_local_id(0);
-	const int ty = get_local_id(1);
-	const int lSizeX = get_local_size(0);
-	const int lSizeY = get_local_size(1);
-	
-	const int gIdX = get_group_id(0);
-	const int gIdY = get_group_id(1);
-
-	const int i = get_global_id(0);
-	const int j = get_global_id(1);
-	
-	//Registers for all results.
-	float sum[TOTAL_WPT];
-
-	for (int w = 0; w < TOTAL_WPT; ++w)
-		sum[w] = 0;
-
-	//Local memory for loading tiles into memory
-	__local float localTileA[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTY];
-	__local float localTileB[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTX];
-	
-	//Multiple tiles in the width of A are necessary.
-	//The number of those tiles might not be a multiple of the work group.
-	//Two parts are therefore used. One calculates the results for the complete loads
-	//and the second calculates the results for the remaining elements.
-	int reminder = wA%lSizeX;
-	int numTiles =  (wA-reminder) / lSizeX;
-
-	//Iterate over the x direction of the input.
-	for(int t = 0; t < numTiles; ++t)
-	{
-		//Load the tile of A into local memory.
-		for (int x = 0; x < WPTY; ++x)
-		{
-			//Calculate the y index of the loading position.
-			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
-			if (yIdx < hA)
-				localTileA[tx + (ty + lSizeY * x) * lSizeX] = A[t*lSizeX + tx + (yIdx)* wA];
-			else
-				localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
-		}
-		
-		//Load the tile of B into local memory.
-		for (int x = 0; x < WPTX; ++x)
-		{
-			//Calculate the specific x index of the loading position.
-			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
-			if (xIdx < wB)
-				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = B[(t * lSizeY + ty)*wB + (xIdx)];
-			else
-				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
-		}
-
-		//Compute the results of each output that is computed by this thread
-		barrier(CLK_LOCAL_MEM_FENCE);
-		
-		for (int k = 0; k < lSizeX; ++k)
-		{
-			for (int wY = 0; wY < WPTY; ++wY)
-			{
-				for (int wX = 0; wX < WPTX; ++wX)
-				{
-					sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
-				}
-			}
-		}
-
-		barrier(CLK_LOCAL_MEM_FENCE);
-	}
-	//The following behaves the same as before but this time the reminding pixels are used to calculate the result.
-	for (int x = 0; x < WPTY; ++x)
-	{
-		int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
-		if (yIdx < hA && tx < reminder)
-			localTileA[tx + (ty + lSizeY * x) * lSizeX] = A[numTiles*lSizeX + tx + (yIdx)* wA];
-		else
-			localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
-	}
-	for (int x = 0; x < WPTX; ++x)
-	{
-		int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
-		if (xIdx < wB && ty < reminder)
-			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = B[(numTiles * lSizeY + ty)*wB + (xIdx)];
-		else
-			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
-	}
-
-	barrier(CLK_LOCAL_MEM_FENCE);
-
-	for (int k = 0; k < reminder; ++k)
-	{
-		for (int wY = 0; wY < WPTY; ++wY)
-		{
-			for (int wX = 0; wX < WPTX; ++wX)
-			{
-				sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
-			}
-		}
-	}
-	barrier(CLK_LOCAL_MEM_FENCE);
-
-	//Store the results into local memory.
-	for (int wY = 0; wY < WPTY; ++wY)
-	{
-		for (int wX = 0; wX < WPTX; ++wX)
-		{
-			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + wX*lSizeX + tx;
-			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + wY*lSizeY + ty;
-			
-
-			if (xIdx < wB && yIdx < hA)
-				C[xIdx + (yIdx)* wB] = sum[wX + wY * WPTX];
-		}
-	}
-}
-
-//The same function as before but this time the result is added to the current content of the buffer.
-//This is necessary for the backward pass.(Implicit copies)
-void kernel MatrixMulAdd(global read_only const float* restrict A, global read_only const float* restrict B, global float* restrict C, const int hA, const int wB, const int wA)
-{
-#define TILE_SIZE_X_2D 8
-#define TILE_SIZE_Y_2D 8
-
-#define WPTY 1
-#define WPTX 1
-#define TOTAL_WPT (WPTX * WPTY)
-
-	const int tx = get_local_id(0);
-	const int ty = get_local_id(1);
-	const int lSizeX = get_local_size(0);
-	const int lSizeY = get_local_size(1);
-
-	const int gIdX = get_group_id(0);
-	const int gIdY = get_group_id(1);
-
-	const int i = get_global_id(0);
-	const int j = get_global_id(1);
-
-	float sum[TOTAL_WPT];
-
-	for (int w = 0; w < TOTAL_WPT; ++w)
-		sum[w] = 0;
-
-	__local float localTileA[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTY];
-	__local float localTileB[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTX];
-
-	int reminder = wA%lSizeX;
-	int numTiles = (wA - reminder) / lSizeX;
-
-	for (int t = 0; t < numTiles; ++t)
-	{
-		for (int x = 0; x < WPTY; ++x)
-		{
-			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
-			if (yIdx < hA)
-				localTileA[tx + (ty + lSizeY * x) * lSizeX] = A[t*lSizeX + tx + (yIdx)* wA];
-			else
-				localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
-		}
-		for (int x = 0; x < WPTX; ++x)
-		{
-			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
-			if (xIdx < wB)
-				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = B[(t * lSizeY + ty)*wB + (xIdx)];
-			else
-				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
-		}
-
-		barrier(CLK_LOCAL_MEM_FENCE);
-
-		for (int k = 0; k < lSizeX; ++k)
-		{
-			for (int wY = 0; wY < WPTY; ++wY)
-			{
-				for (int wX = 0; wX < WPTX; ++wX)
-				{
-					sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
-				}
-			}
-		}
-
-		barrier(CLK_LOCAL_MEM_FENCE);
-	}
-
-	for (int x = 0; x < WPTY; ++x)
-	{
-		int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
-		if (yIdx < hA && tx < reminder)
-			localTileA[tx + (ty + lSizeY * x) * lSizeX] = A[numTiles*lSizeX + tx + (yIdx)* wA];
-		else
-			localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
-	}
-	for (int x = 0; x < WPTX; ++x)
-	{
-		int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
-		if (xIdx < wB && ty < reminder)
-			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = B[(numTiles * lSizeY + ty)*wB + (xIdx)];
-		else
-			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
-	}
-
-	barrier(CLK_LOCAL_MEM_FENCE);
-
-	for (int k = 0; k < reminder; ++k)
-	{
-		for (int wY = 0; wY < WPTY; ++wY)
-		{
-			for (int wX = 0; wX < WPTX; ++wX)
-			{
-				sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
-			}
-		}
-	}
-	barrier(CLK_LOCAL_MEM_FENCE);
-
-	for (int wY = 0; wY < WPTY; ++wY)
-	{
-		for (int wX = 0; wX < WPTX; ++wX)
-		{
-			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + wX*lSizeX + tx;
-			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + wY*lSizeY + ty;
-
-
-			if (xIdx < wB && yIdx < hA)
-				C[xIdx + (yIdx)* wB] += sum[wX + wY * WPTX];
-		}
-	}
-}
\ No newline at end of file
+void kernel MatrixMul(global read_only const STORAGE0* restrict A, global read_only const STORAGE1* restrict B, global write_only STORAGE2* restrict C, const int hA, const int wB, const int wA)
+{
+
+//The size of a tile from the output that gets calculated by this work group
+#define TILE_SIZE_X_2D 8
+#define TILE_SIZE_Y_2D 8
+
+//Each thread can potentially compute the result of multiple outputs
+//This increases the total tile size.
+#define WPTY 1
+#define WPTX 1
+
+
+#define TOTAL_WPT (WPTX * WPTY)
+
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+	const int lSizeX = get_local_size(0);
+	const int lSizeY = get_local_size(1);
+	
+	const int gIdX = get_group_id(0);
+	const int gIdY = get_group_id(1);
+
+	const int i = get_global_id(0);
+	const int j = get_global_id(1);
+	
+	//Registers for all results.
+	float sum[TOTAL_WPT];
+
+	for (int w = 0; w < TOTAL_WPT; ++w)
+		sum[w] = 0;
+
+	//Local memory for loading tiles into memory
+	__local float localTileA[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTY];
+	__local float localTileB[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTX];
+	
+	//Multiple tiles in the width of A are necessary.
+	//The number of those tiles might not be a multiple of the work group.
+	//Two parts are therefore used. One calculates the results for the complete loads
+	//and the second calculates the results for the remaining elements.
+	int reminder = wA%lSizeX;
+	int numTiles =  (wA-reminder) / lSizeX;
+
+	//Iterate over the x direction of the input.
+	for(int t = 0; t < numTiles; ++t)
+	{
+		//Load the tile of A into local memory.
+		for (int x = 0; x < WPTY; ++x)
+		{
+			//Calculate the y index of the loading position.
+			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
+			if (yIdx < hA)
+				localTileA[tx + (ty + lSizeY * x) * lSizeX] = LOAD0(A, t*lSizeX + tx + (yIdx)* wA);
+			else
+				localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
+		}
+		
+		//Load the tile of B into local memory.
+		for (int x = 0; x < WPTX; ++x)
+		{
+			//Calculate the specific x index of the loading position.
+			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
+			if (xIdx < wB)
+				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = LOAD1(B, (t * lSizeY + ty)*wB + (xIdx));
+			else
+				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
+		}
+
+		//Compute the results of each output that is computed by this thread
+		barrier(CLK_LOCAL_MEM_FENCE);
+		
+		for (int k = 0; k < lSizeX; ++k)
+		{
+			for (int wY = 0; wY < WPTY; ++wY)
+			{
+				for (int wX = 0; wX < WPTX; ++wX)
+				{
+					sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
+				}
+			}
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	//The following behaves the same as before but this time the reminding pixels are used to calculate the result.
+	for (int x = 0; x < WPTY; ++x)
+	{
+		int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
+		if (yIdx < hA && tx < reminder)
+			localTileA[tx + (ty + lSizeY * x) * lSizeX] = LOAD0(A, numTiles*lSizeX + tx + (yIdx)* wA);
+		else
+			localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
+	}
+	for (int x = 0; x < WPTX; ++x)
+	{
+		int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
+		if (xIdx < wB && ty < reminder)
+			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = LOAD1(B, (numTiles * lSizeY + ty)*wB + (xIdx));
+		else
+			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int k = 0; k < reminder; ++k)
+	{
+		for (int wY = 0; wY < WPTY; ++wY)
+		{
+			for (int wX = 0; wX < WPTX; ++wX)
+			{
+				sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
+			}
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	//Store the results into local memory.
+	for (int wY = 0; wY < WPTY; ++wY)
+	{
+		for (int wX = 0; wX < WPTX; ++wX)
+		{
+			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + wX*lSizeX + tx;
+			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + wY*lSizeY + ty;
+			
+
+			if (xIdx < wB && yIdx < hA)
+				STORE2(C, xIdx + (yIdx)* wB, sum[wX + wY * WPTX]);
+		}
+	}
+}
+
+//The same function as before but this time the result is added to the current content of the buffer.
+//This is necessary for the backward pass.(Implicit copies)
+//Compiled with OVERWRITE_RESULT the result replaces the content of the buffer. Used by the first operation writing a gradient.
+void kernel MatrixMulAdd(global read_only const STORAGE0* restrict A, global read_only const STORAGE1* restrict B, global STORAGE2* restrict C, const int hA, const int wB, const int wA)
+{
+#define TILE_SIZE_X_2D 8
+#define TILE_SIZE_Y_2D 8
+
+#define WPTY 1
+#define WPTX 1
+#define TOTAL_WPT (WPTX * WPTY)
+
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+	const int lSizeX = get_local_size(0);
+	const int lSizeY = get_local_size(1);
+
+	const int gIdX = get_group_id(0);
+	const int gIdY = get_group_id(1);
+
+	const int i = get_global_id(0);
+	const int j = get_global_id(1);
+
+	float sum[TOTAL_WPT];
+
+	for (int w = 0; w < TOTAL_WPT; ++w)
+		sum[w] = 0;
+
+	__local float localTileA[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTY];
+	__local float localTileB[TILE_SIZE_X_2D * TILE_SIZE_Y_2D * WPTX];
+
+	int reminder = wA%lSizeX;
+	int numTiles = (wA - reminder) / lSizeX;
+
+	for (int t = 0; t < numTiles; ++t)
+	{
+		for (int x = 0; x < WPTY; ++x)
+		{
+			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
+			if (yIdx < hA)
+				localTileA[tx + (ty + lSizeY * x) * lSizeX] = LOAD0(A, t*lSizeX + tx + (yIdx)* wA);
+			else
+				localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
+		}
+		for (int x = 0; x < WPTX; ++x)
+		{
+			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
+			if (xIdx < wB)
+				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = LOAD1(B, (t * lSizeY + ty)*wB + (xIdx));
+			else
+				localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (int k = 0; k < lSizeX; ++k)
+		{
+			for (int wY = 0; wY < WPTY; ++wY)
+			{
+				for (int wX = 0; wX < WPTX; ++wX)
+				{
+					sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
+				}
+			}
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	for (int x = 0; x < WPTY; ++x)
+	{
+		int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + x*lSizeY + ty;
+		if (yIdx < hA && tx < reminder)
+			localTileA[tx + (ty + lSizeY * x) * lSizeX] = LOAD0(A, numTiles*lSizeX + tx + (yIdx)* wA);
+		else
+			localTileA[tx + (ty + lSizeY * x) * lSizeX] = 0;
+	}
+	for (int x = 0; x < WPTX; ++x)
+	{
+		int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + x*lSizeX + tx;
+		if (xIdx < wB && ty < reminder)
+			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = LOAD1(B, (numTiles * lSizeY + ty)*wB + (xIdx));
+		else
+			localTileB[tx + lSizeX * x + ty * (lSizeX*WPTX)] = 0;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int k = 0; k < reminder; ++k)
+	{
+		for (int wY = 0; wY < WPTY; ++wY)
+		{
+			for (int wX = 0; wX < WPTX; ++wX)
+			{
+				sum[wX + wY * WPTX] += localTileA[k + (ty + wY * lSizeY)*lSizeX] * localTileB[(tx + wX * lSizeX) + k*(lSizeX*WPTX)];
+			}
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int wY = 0; wY < WPTY; ++wY)
+	{
+		for (int wX = 0; wX < WPTX; ++wX)
+		{
+			int xIdx = gIdX * (WPTX*TILE_SIZE_X_2D) + wX*lSizeX + tx;
+			int yIdx = gIdY * (WPTY*TILE_SIZE_Y_2D) + wY*lSizeY + ty;
+
+
+			if (xIdx < wB && yIdx < hA)
+#ifdef OVERWRITE_RESULT
+				STORE2(C, xIdx + (yIdx)* wB, sum[wX + wY * WPTX]);
+#else
+				STORE2(C, xIdx + (yIdx)* wB, LOAD2(C, xIdx + (yIdx)* wB) + sum[wX + wY * WPTX]);
+#endif
+		}
+	}
+}
+
+//Matrix multiplications over all time steps of a sequence with the same matrix B (See NNMatMulFlatOp). The time steps of a sequence buffer lie stride elements apart
+//in its base buffer starting at offset. Each time step contains hA rows, the third dimension of the global size selects the time step.
+//C[t] = A[t] * B
+void kernel MatrixMulSteps(global read_only const float* restrict A, global read_only const float* restrict B, global write_only float* restrict C,
+	const int aOffset, const int aStride, const int cOffset, const int cStride, const int hA, const int wB, const int wA)
+{
+#define STEP_TILE 8
+
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+	const int col = get_global_id(0);
+	const int row = get_global_id(1);
+	const int t = get_global_id(2);
+
+	__local float tileA[STEP_TILE * STEP_TILE];
+	__local float tileB[STEP_TILE * STEP_TILE];
+
+	const global float* a = A + aOffset + t * aStride;
+
+	float sum = 0.f;
+	for (int k = 0; k < wA; k += STEP_TILE)
+	{
+		tileA[ty * STEP_TILE + tx] = row < hA && k + tx < wA ? a[row * wA + k + tx] : 0.f;
+		tileB[ty * STEP_TILE + tx] = k + ty < wA && col < wB ? B[(k + ty) * wB + col] : 0.f;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (int i = 0; i < STEP_TILE; ++i)
+			sum += tileA[ty * STEP_TILE + i] * tileB[i * STEP_TILE + tx];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (row < hA && col < wB)
+		C[cOffset + t * cStride + row * wB + col] = sum;
+}
+
+//Gradient of the input of all time steps: dA[t] += dC[t] * transpose(B). B is read transposed, therefore no temporary buffer is needed.
+void kernel MatrixMulStepsInputGrad(global read_only const float* restrict dC, global read_only const float* restrict B, global float* restrict dA,
+	const int cOffset, const int cStride, const int aOffset, const int aStride, const int hA, const int wB, const int wA)
+{
+#define STEP_TILE 8
+
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+	const int col = get_global_id(0);
+	const int row = get_global_id(1);
+	const int t = get_global_id(2);
+
+	__local float tileC[STEP_TILE * STEP_TILE];
+	__local float tileB[STEP_TILE * STEP_TILE];
+
+	const global float* c = dC + cOffset + t * cStride;
+
+	float sum = 0.f;
+	for (int k = 0; k < wB; k += STEP_TILE)
+	{
+		tileC[ty * STEP_TILE + tx] = row < hA && k + tx < wB ? c[row * wB + k + tx] : 0.f;
+		tileB[ty * STEP_TILE + tx] = k + ty < wB && col < wA ? B[col * wB + k + ty] : 0.f;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (int i = 0; i < STEP_TILE; ++i)
+			sum += tileC[ty * STEP_TILE + i] * tileB[i * STEP_TILE + tx];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (row < hA && col < wA)
+		dA[aOffset + t * aStride + row * wA + col] += sum;
+}
+
+//Gradient of B summed over all time steps: dB = sum over t of transpose(A[t]) * dC[t]. The rows of all time steps form the inner dimension of one matrix multiplication.
+void kernel MatrixMulStepsWeightGrad(global read_only const float* restrict A, global read_only const float* restrict dC, global float* restrict dB,
+	const int aOffset, const int aStride, const int cOffset, const int cStride, const int hA, const int numSteps, const int wB, const int wA)
+{
+#define STEP_TILE 8
+
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+	const int col = get_global_id(0);
+	const int row = get_global_id(1);
+	const int rows = numSteps * hA;
+
+	__local float tileA[STEP_TILE * STEP_TILE];
+	__local float tileC[STEP_TILE * STEP_TILE];
+
+	float sum = 0.f;
+	for (int k = 0; k < rows; k += STEP_TILE)
+	{
+		const int rA = k + tx;
+		const int rC = k + ty;
+		tileA[ty * STEP_TILE + tx] = rA < rows && row < wA ? A[aOffset + (rA / hA) * aStride + (rA % hA) * wA + row] : 0.f;
+		tileC[ty * STEP_TILE + tx] = rC < rows && col < wB ? dC[cOffset + (rC / hA) * cStride + (rC % hA) * wB + col] : 0.f;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (int i = 0; i < STEP_TILE; ++i)
+			sum += tileA[ty * STEP_TILE + i] * tileC[i * STEP_TILE + tx];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (row < wA && col < wB)
+#ifdef OVERWRITE_RESULT
+		dB[row * wB + col] = sum;
+#else
+		dB[row * wB + col] += sum;
+#endif
+}
@@ -0,0 +1,22 @@
+//Counter based random number generator Philox4x32-10 used by the kernels of WeightInit.cl and Augmentation.cl. This file contains no kernels and is placed in front of every kernel source.
+//The same counter and key always produce the same four numbers, therefore the values don't depend on the number or the order of the work items.
+
+#define PHILOX_M0 0xD2511F53
+#define PHILOX_M1 0xCD9E8D57
+#define PHILOX_W0 0x9E3779B9
+#define PHILOX_W1 0xBB67AE85
+
+//Ten rounds of Philox4x32 applied to counter with key.
+inline uint4 Philox(uint4 counter, uint2 key)
+{
+	for (int r = 0; r < 10; ++r)
+	{
+		const uint hi0 = mul_hi((uint)PHILOX_M0, counter.x);
+		const uint lo0 = PHILOX_M0 * counter.x;
+		const uint hi1 = mul_hi((uint)PHILOX_M1, counter.z);
+		const uint lo1 = PHILOX_M1 * counter.z;
+		counter = (uint4)(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);
+		key += (uint2)(PHILOX_W0, PHILOX_W1);
+	}
+	return counter;
+}
@@ -0,0 +1,155 @@
+//Kernels for the int8 inference path. Weights are stored as char with one scale per output channel.
+//The activations are quantized with the scale found during calibration when they are loaded and the products are accumulated as int.
+//The result is converted back using both scales, therefore the following operations still receive float values.
+
+#ifdef cl_khr_integer_dot_product
+#pragma OPENCL EXTENSION cl_khr_integer_dot_product : enable
+#define DOT_CHAR4(a, b) dot((a), (b))
+#else
+#define DOT_CHAR4(a, b) ((int)(a).x * (b).x + (int)(a).y * (b).y + (int)(a).z * (b).z + (int)(a).w * (b).w)
+#endif
+
+//Matrix multiplication using int8 weights. W contains the transposed weights, each column padded to wAPadded (A multiple of four) elements.
+//Each work group quantizes a tile of A into local memory once and computes the dot products on char4 vectors.
+void kernel QuantMatrixMul(global read_only const STORAGE0* restrict A, global read_only const char* restrict W, global read_only const float* restrict wScale, global write_only STORAGE3* restrict C, const int hA, const int wB, const int wA, const int wAPadded, const float aScale)
+{
+#define QTILE 8
+
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+
+	const int col = get_global_id(0);
+	const int row = get_global_id(1);
+	const int firstCol = get_group_id(0) * QTILE;
+
+	const float invScale = 1.f / aScale;
+	const int numGroups = wAPadded / 4;
+
+	__local char4 tileA[QTILE * QTILE];
+	__local char4 tileW[QTILE * QTILE];
+
+	int sum = 0;
+
+	for (int t = 0; t < numGroups; t += QTILE)
+	{
+		//Each work item quantizes four consecutive elements of a row of A.
+		const int k = (t + tx) * 4;
+		float4 a = (float4)(0.f);
+		if (row < hA)
+		{
+			a.x = k < wA ? LOAD0(A, row * wA + k) : 0.f;
+			a.y = k + 1 < wA ? LOAD0(A, row * wA + k + 1) : 0.f;
+			a.z = k + 2 < wA ? LOAD0(A, row * wA + k + 2) : 0.f;
+			a.w = k + 3 < wA ? LOAD0(A, row * wA + k + 3) : 0.f;
+		}
+		tileA[ty * QTILE + tx] = convert_char4_sat_rte(a * invScale);
+
+		//and loads four weights of a column.
+		const int wCol = firstCol + tx;
+		const int g = t + ty;
+		if (wCol < wB && g < numGroups)
+			tileW[ty * QTILE + tx] = vload4(wCol * numGroups + g, W);
+		else
+			tileW[ty * QTILE + tx] = (char4)(0);
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (int m = 0; m < QTILE; ++m)
+			sum += DOT_CHAR4(tileA[ty * QTILE + m], tileW[m * QTILE + tx]);
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (row < hA && col < wB)
+		STORE3(C, row * wB + col, (float)sum * aScale * wScale[col]);
+}
+
+//The same as Convolution but with int8 kernels. The image tile is quantized when it is loaded into local memory.
+void kernel QuantConvolution(global read_only const STORAGE0* restrict A, global read_only const char* restrict K, global read_only const float* restrict kScale, global write_only STORAGE3* restrict C, const int wA, const int hA, const int wK, const int hK, const int dK, const int numK, const int pad, const int batchSize, const float aScale)
+{
+#define WIDTH_KERNEL 3
+#define HEIGHT_KERNEL 3
+#define STRIDE_X 1
+#define STRIDE_Y 1
+#define TILE_WIDTH 8
+#define TILE_HEIGHT 8
+#define ROW_SIZE ((TILE_WIDTH-1)*STRIDE_X+WIDTH_KERNEL)
+#define ROWS_PER_LOAD 3
+#define ROWS (ROWS_PER_LOAD / WIDTH_KERNEL)
+
+	const int imageSize = wA * hA;
+	const int kernelImageSize = wK * hK;
+	const int kernelVolume = kernelImageSize*dK;
+
+	int imageOffset = imageSize;
+	int batchOffset = imageSize * dK;
+
+	const int tx = get_local_id(0);
+	const int ty = get_local_id(1);
+
+	const int i = get_global_id(0);
+	const int j = get_global_id(1);
+	const int k = get_global_id(2);
+
+	const int lSizeX = get_local_size(0);
+	const int lSizeY = get_local_size(1);
+
+	const int groupIdX = get_group_id(0);
+	const int groupIdY = get_group_id(1);
+
+	const float invScale = 1.f / aScale;
+
+	__local char kern[TILE_WIDTH * TILE_HEIGHT];
+	__local char imageTile[ROW_SIZE * ROWS];
+
+	int sum = 0;
+
+	const int outputXSize = ((wA - wK + 2 * pad) + STRIDE_X)/STRIDE_X;
+	const int outputYSize = ((hA - hK + 2 * pad) + STRIDE_Y)/STRIDE_Y;
+
+	const int imgRemainder = (wA+pad+(STRIDE_X*lSizeX)-1)/(lSizeX*STRIDE_X);
+	const int startX = (groupIdX%imgRemainder) * (lSizeX*STRIDE_X) - pad;
+	const int startY = (groupIdX/imgRemainder)*STRIDE_X - pad;
+
+	const int unrolledPos = tx + ty * lSizeX;
+
+	const int posX = ((unrolledPos)) % (ROW_SIZE);
+	const int posY = ((unrolledPos)-posX) / (ROW_SIZE);
+
+	int imgRow;
+	int img;
+	int imgCol = startX + posX;
+	int tmp;
+
+	for(int l = 0; l <kernelVolume; l += ROWS_PER_LOAD)
+	{
+		if(j < numK && l + tx < kernelVolume )
+			kern[unrolledPos] = K[j * kernelVolume + l + tx];
+
+		tmp = posY + l/WIDTH_KERNEL;
+		img = (tmp) / HEIGHT_KERNEL;
+		imgRow = startY + tmp - img * HEIGHT_KERNEL;
+
+		if (unrolledPos < (ROW_SIZE * ROWS))
+		{
+			if(imgCol >= 0 && imgCol < wA && imgRow >= 0 && imgRow < hA && k < batchSize)
+				imageTile[unrolledPos] = convert_char_sat_rte(LOAD0(A, imgCol + img * imageOffset + imgRow * wA + batchOffset * k) * invScale);
+			else
+				imageTile[unrolledPos] = 0;
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for(int m = 0; m < ROWS; ++m)
+		{
+#pragma unroll WIDTH_KERNEL
+			for(int n = 0; n < WIDTH_KERNEL; ++n)
+			{
+				sum += (int)imageTile[tx * STRIDE_X + n + m * ROW_SIZE] * kern[m * WIDTH_KERNEL + n + ty * lSizeX ];
+			}
+		}
+	}
+
+	if (j < numK && tx + (startX + pad)/STRIDE_X < outputXSize && (startY + pad)/STRIDE_Y < outputYSize && k < batchSize)
+		STORE3(C, tx + (startX + pad)/STRIDE_Y + ((startY + pad)/STRIDE_Y + outputYSize * (j + numK * k))*outputXSize, (float)sum * aScale * kScale[j]);
+}
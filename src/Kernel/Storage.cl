@@ -0,0 +1,43 @@
+//Storage of the buffer arguments. This file contains no kernels and is placed in front of every kernel source.
+//A kernel compiled with HALF_ARGn stores the buffer at argument position n as half. The values are converted to float when they are loaded
+//and back to half when they are stored, therefore all calculations are still performed in float. Only kernels using these macros support half buffers.
+
+#ifdef HALF_ARG0
+#define STORAGE0 half
+#define LOAD0(p, i) vload_half((i), (p))
+#define STORE0(p, i, v) vstore_half((v), (i), (p))
+#else
+#define STORAGE0 float
+#define LOAD0(p, i) ((p)[(i)])
+#define STORE0(p, i, v) ((p)[(i)] = (v))
+#endif
+
+#ifdef HALF_ARG1
+#define STORAGE1 half
+#define LOAD1(p, i) vload_half((i), (p))
+#define STORE1(p, i, v) vstore_half((v), (i), (p))
+#else
+#define STORAGE1 float
+#define LOAD1(p, i) ((p)[(i)])
+#define STORE1(p, i, v) ((p)[(i)] = (v))
+#endif
+
+#ifdef HALF_ARG2
+#define STORAGE2 half
+#define LOAD2(p, i) vload_half((i), (p))
+#define STORE2(p, i, v) vstore_half((v), (i), (p))
+#else
+#define STORAGE2 float
+#define LOAD2(p, i) ((p)[(i)])
+#define STORE2(p, i, v) ((p)[(i)] = (v))
+#endif
+
+#ifdef HALF_ARG3
+#define STORAGE3 half
+#define LOAD3(p, i) vload_half((i), (p))
+#define STORE3(p, i, v) vstore_half((v), (i), (p))
+#else
+#define STORAGE3 float
+#define LOAD3(p, i) ((p)[(i)])
+#define STORE3(p, i, v) ((p)[(i)] = (v))
+#endif
@@ -0,0 +1,81 @@
+//Kernels initializing the parameter buffers with random numbers on the device (See InitOp).
+//The numbers are generated by the counter based generator Philox4x32-10 (See Philox.cl). Each work item encrypts its own counter with the key of the parameter, therefore the values
+//depend only on the seed, the parameter and the position of the element and not on the number or the order of the work items.
+
+//Each work item produces four values with one evaluation of the generator.
+#define INIT_VALUES_PER_ITEM 4
+//Upper bound of the resampling rounds of the truncated normal distribution. A value is outside of two standard deviations with a probability of about 5%.
+#define INIT_MAX_ROUNDS 32
+
+//Maps the 24 highest bits of each value to (0, 1]. Zero is excluded because the Box-Muller transform takes the logarithm.
+inline float4 ToUniform(const uint4 bits)
+{
+	return convert_float4((bits >> 8) + (uint4)1) * (1.f / 16777216.f);
+}
+
+//Two pairs of uniform numbers become two pairs of independent standard normal numbers.
+inline float4 BoxMuller(const float4 u)
+{
+	const float r0 = sqrt(-2.f * log(u.x));
+	const float r1 = sqrt(-2.f * log(u.z));
+	const float a0 = 2.f * M_PI_F * u.y;
+	const float a1 = 2.f * M_PI_F * u.w;
+	return (float4)(r0 * cos(a0), r0 * sin(a0), r1 * cos(a1), r1 * sin(a1));
+}
+
+//Writes the values of a work item. The last work item may cover elements behind the end of the buffer.
+inline void StoreValues(global float* restrict W, const float4 values, const int idx, const int n)
+{
+	if (idx + INIT_VALUES_PER_ITEM <= n)
+	{
+		vstore4(values, 0, W + idx);
+		return;
+	}
+	if (idx < n)
+		W[idx] = values.x;
+	if (idx + 1 < n)
+		W[idx + 1] = values.y;
+	if (idx + 2 < n)
+		W[idx + 2] = values.z;
+}
+
+//Samples uniformly from [minValue, maxValue).
+void kernel InitUniformRnd(global float* restrict W, const uint seed, const uint parameter, const float minValue, const float maxValue, const int n)
+{
+	const int i = get_global_id(0);
+	const int idx = i * INIT_VALUES_PER_ITEM;
+
+	if (idx >= n)
+		return;
+
+	const float4 u = ToUniform(Philox((uint4)(i, 0, 0, 0), (uint2)(seed, parameter))) - (float4)(1.f / 16777216.f);
+	StoreValues(W, minValue + (maxValue - minValue) * u, idx, n);
+}
+
+//Samples from a normal distribution. If truncate is not 0 values further than two standard deviations from the mean are sampled again.
+//Every round of resampling uses the next counter of the work item, thereby the result remains independent of the other work items.
+void kernel InitNormalRnd(global float* restrict W, const uint seed, const uint parameter, const float mean, const float stddev, const int truncate, const int n)
+{
+	const int i = get_global_id(0);
+	const int idx = i * INIT_VALUES_PER_ITEM;
+
+	if (idx >= n)
+		return;
+
+	const uint2 key = (uint2)(seed, parameter);
+	float4 values = BoxMuller(ToUniform(Philox((uint4)(i, 0, 0, 0), key)));
+
+	if (truncate != 0)
+	{
+		for (uint attempt = 1; attempt < INIT_MAX_ROUNDS; ++attempt)
+		{
+			const int4 rejected = isgreater(fabs(values), (float4)2.f);
+			if (!any(rejected))
+				break;
+			values = select(values, BoxMuller(ToUniform(Philox((uint4)(i, attempt, 0, 0), key))), rejected);
+		}
+		values = clamp(values, -2.f, 2.f);
+	}
+
+	StoreValues(W, mean + stddev * values, idx, n);
+}